@@ -0,0 +1,375 @@
+/***************************************************************************
+ *   Copyright (C) 2009-2011 by Francesco Biscani                          *
+ *   bluescarni@gmail.com                                                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#ifndef PIRANHA_DEGREE_TRUNCATION_HPP
+#define PIRANHA_DEGREE_TRUNCATION_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <mutex>
+#include <set>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "config.hpp"
+#include "integer.hpp"
+#include "symbol_set.hpp"
+
+namespace piranha
+{
+
+class degree_truncation;
+
+namespace detail
+{
+
+template <typename = int>
+struct base_degree_truncation
+{
+	static std::mutex				s_mutex;
+	static degree_truncation			s_global;
+	static std::atomic<bool>			s_global_active;
+	static PIRANHA_TLS const degree_truncation	*s_override;
+};
+
+}
+
+/// Degree truncation policy.
+/**
+ * This class describes how series multiplication should discard the terms of the result exceeding a maximum degree.
+ * Three modes are available:
+ * 
+ * - 0, no truncation (the default);
+ * - 1, truncation by total degree;
+ * - 2, truncation by partial degree, i.e., the degree computed considering only a set of symbols.
+ * 
+ * The policy is honoured by the series multipliers when both operands provide the low-level method
+ * piranha::power_series::_term_ldegree() (e.g., piranha::polynomial). In such a case the terms of the operands are sorted
+ * according to their low degree, and the term-by-term multiplications that would produce only terms whose low degree exceeds the
+ * maximum degree are skipped altogether. For operands whose coefficients have a degree themselves (e.g., polynomials
+ * as coefficients), the coefficients of the terms of the result are not truncated.
+ * 
+ * The policy in effect for a multiplication is:
+ * 
+ * - the one passed to a per-call method such as piranha::power_series::truncated_multiplication(), if any, otherwise
+ * - the global policy, which can be set via set(), unset() and, with scoped semantics, piranha::degree_truncation_guard.
+ * 
+ * Note that a per-call policy affects only the outermost multiplication, whereas the global policy affects also the multiplications
+ * of the coefficients (if they are series).
+ * 
+ * The static methods of this class are thread-safe.
+ * 
+ * \section exception_safety Exception safety guarantee
+ * 
+ * This class provides the strong exception safety guarantee for all operations.
+ * 
+ * \section move_semantics Move semantics
+ * 
+ * After a move operation, the object will be left in a state equivalent to the default-constructed state.
+ * 
+ * @author Francesco Biscani (bluescarni@gmail.com)
+ */
+class degree_truncation: private detail::base_degree_truncation<>
+{
+	public:
+		/// Default constructor.
+		/**
+		 * Will construct a policy with no truncation.
+		 */
+		degree_truncation():m_mode(0),m_max_degree(0) {}
+		/// Constructor from maximum total degree.
+		/**
+		 * Will construct a policy of truncation by total degree.
+		 * 
+		 * @param[in] max_degree maximum total degree.
+		 * 
+		 * @throws unspecified any exception thrown by the copy constructor of piranha::integer.
+		 */
+		explicit degree_truncation(const integer &max_degree):m_mode(1),m_max_degree(max_degree) {}
+		/// Constructor from maximum partial degree.
+		/**
+		 * Will construct a policy of truncation by partial degree.
+		 * 
+		 * @param[in] max_degree maximum partial degree.
+		 * @param[in] names names of the symbols that will be considered in the computation of the partial degree.
+		 * 
+		 * @throws unspecified any exception thrown by the copy constructors of piranha::integer and \p std::set.
+		 */
+		explicit degree_truncation(const integer &max_degree, const std::set<std::string> &names):
+			m_mode(2),m_max_degree(max_degree),m_names(names) {}
+		/// Defaulted copy constructor.
+		degree_truncation(const degree_truncation &) = default;
+		/// Move constructor.
+		/**
+		 * @param[in] other policy to be moved.
+		 */
+		degree_truncation(degree_truncation &&other) noexcept(true):
+			m_mode(other.m_mode),m_max_degree(std::move(other.m_max_degree)),m_names(std::move(other.m_names))
+		{
+			other.m_mode = 0;
+			other.m_names.clear();
+		}
+		/// Copy assignment operator.
+		/**
+		 * @param[in] other assignment argument.
+		 * 
+		 * @return reference to \p this.
+		 * 
+		 * @throws unspecified any exception thrown by the copy constructor.
+		 */
+		degree_truncation &operator=(const degree_truncation &other)
+		{
+			if (likely(this != &other)) {
+				degree_truncation tmp(other);
+				*this = std::move(tmp);
+			}
+			return *this;
+		}
+		/// Move assignment operator.
+		/**
+		 * @param[in] other assignment argument.
+		 * 
+		 * @return reference to \p this.
+		 */
+		degree_truncation &operator=(degree_truncation &&other) noexcept(true)
+		{
+			if (likely(this != &other)) {
+				m_mode = other.m_mode;
+				m_max_degree = std::move(other.m_max_degree);
+				m_names = std::move(other.m_names);
+				other.m_mode = 0;
+				other.m_names.clear();
+			}
+			return *this;
+		}
+		/// Truncation mode.
+		/**
+		 * @return 0 if no truncation is performed, 1 for truncation by total degree, 2 for truncation by partial degree.
+		 */
+		int get_mode() const
+		{
+			return m_mode;
+		}
+		/// Maximum degree.
+		/**
+		 * @return const reference to the maximum degree (total or partial).
+		 */
+		const integer &get_max_degree() const
+		{
+			return m_max_degree;
+		}
+		/// Names of the symbols.
+		/**
+		 * @return const reference to the names of the symbols considered in the computation of the partial degree.
+		 */
+		const std::set<std::string> &get_names() const
+		{
+			return m_names;
+		}
+		/// Get the global policy.
+		/**
+		 * @return a copy of the global truncation policy.
+		 * 
+		 * @throws std::system_error in case of failure(s) by threading primitives.
+		 * @throws unspecified any exception thrown by the copy constructor.
+		 */
+		static degree_truncation get()
+		{
+			std::lock_guard<std::mutex> lock(s_mutex);
+			return s_global;
+		}
+		/// Set the global policy.
+		/**
+		 * @param[in] t the new global truncation policy.
+		 * 
+		 * @throws std::system_error in case of failure(s) by threading primitives.
+		 * @throws unspecified any exception thrown by the copy constructor.
+		 */
+		static void set(const degree_truncation &t)
+		{
+			degree_truncation tmp(t);
+			std::lock_guard<std::mutex> lock(s_mutex);
+			s_global = std::move(tmp);
+			s_global_active.store(s_global.m_mode != 0);
+		}
+		/// Disable global truncation.
+		/**
+		 * @throws std::system_error in case of failure(s) by threading primitives.
+		 */
+		static void unset()
+		{
+			std::lock_guard<std::mutex> lock(s_mutex);
+			s_global = degree_truncation{};
+			s_global_active.store(false);
+		}
+		/// Get the policy in effect for the next multiplication (low-level).
+		/**
+		 * This method is meant to be called by the series multipliers upon construction. If a per-call policy has been
+		 * set in the current thread, it will be returned and cleared. Otherwise, the global policy will be returned.
+		 * 
+		 * @return the truncation policy in effect.
+		 * 
+		 * @throws unspecified any exception thrown by get() or by the copy constructor.
+		 */
+		static degree_truncation _consume()
+		{
+			if (s_override != nullptr) {
+				const degree_truncation *ptr = s_override;
+				s_override = nullptr;
+				return *ptr;
+			}
+			if (likely(!s_global_active.load())) {
+				return degree_truncation{};
+			}
+			return get();
+		}
+		/// Set the per-call policy for the next multiplication (low-level).
+		/**
+		 * The object pointed to by \p ptr must remain valid until the next call to _consume() or _set_override() in the
+		 * current thread. Passing \p nullptr clears the per-call policy.
+		 * 
+		 * @param[in] ptr pointer to the per-call policy.
+		 */
+		static void _set_override(const degree_truncation *ptr)
+		{
+			s_override = ptr;
+		}
+	private:
+		int			m_mode;
+		integer			m_max_degree;
+		std::set<std::string>	m_names;
+};
+
+namespace detail
+{
+
+template <typename T>
+std::mutex base_degree_truncation<T>::s_mutex;
+
+template <typename T>
+degree_truncation base_degree_truncation<T>::s_global;
+
+template <typename T>
+std::atomic<bool> base_degree_truncation<T>::s_global_active(false);
+
+template <typename T>
+PIRANHA_TLS const degree_truncation *base_degree_truncation<T>::s_override = nullptr;
+
+}
+
+/// Scoped degree truncation.
+/**
+ * This class will set the global truncation policy upon construction, and restore the previous global policy upon destruction.
+ * 
+ * @author Francesco Biscani (bluescarni@gmail.com)
+ */
+class degree_truncation_guard
+{
+	public:
+		/// Constructor.
+		/**
+		 * @param[in] t the global truncation policy that will be in effect during the lifetime of the guard.
+		 * 
+		 * @throws unspecified any exception thrown by piranha::degree_truncation::get() and piranha::degree_truncation::set().
+		 */
+		explicit degree_truncation_guard(const degree_truncation &t):m_old(degree_truncation::get())
+		{
+			degree_truncation::set(t);
+		}
+		/// Deleted copy constructor.
+		degree_truncation_guard(const degree_truncation_guard &) = delete;
+		/// Deleted move constructor.
+		degree_truncation_guard(degree_truncation_guard &&) = delete;
+		/// Deleted copy assignment operator.
+		degree_truncation_guard &operator=(const degree_truncation_guard &) = delete;
+		/// Deleted move assignment operator.
+		degree_truncation_guard &operator=(degree_truncation_guard &&) = delete;
+		/// Destructor.
+		/**
+		 * Will restore the global truncation policy in effect before the construction of the guard.
+		 * Errors in the restoration will result in the termination of the program.
+		 */
+		~degree_truncation_guard() noexcept(true)
+		{
+			degree_truncation::set(m_old);
+		}
+	private:
+		const degree_truncation m_old;
+};
+
+namespace detail
+{
+
+// Check if the terms of a series type can be used in truncated multiplication.
+template <typename Series>
+class truncation_enabled
+{
+		typedef typename Series::term_type term_type;
+		template <typename S>
+		static auto test(const S *) -> decltype(integer(S::_term_ldegree(std::declval<const term_type &>(),std::declval<const symbol_set &>())),
+			integer(S::_term_ldegree(std::declval<const term_type &>(),std::declval<const symbol_set &>(),std::declval<const std::set<std::string> &>())),
+			void(),std::true_type());
+		static std::false_type test(...);
+	public:
+		static const bool value = decltype(test(static_cast<const Series *>(nullptr)))::value;
+};
+
+template <typename Series>
+const bool truncation_enabled<Series>::value;
+
+// Low degree of a term according to a truncation policy.
+template <typename Series>
+inline integer truncation_degree(const typename Series::term_type &t, const symbol_set &args, const degree_truncation &trunc)
+{
+	piranha_assert(trunc.get_mode() == 1 || trunc.get_mode() == 2);
+	return (trunc.get_mode() == 1) ? integer(Series::_term_ldegree(t,args)) : integer(Series::_term_ldegree(t,args,trunc.get_names()));
+}
+
+// Sort the vector of term pointers v in ascending low degree order. Return the sorted vector of degrees.
+template <typename Series>
+inline std::vector<integer> truncation_sort(std::vector<typename Series::term_type const *> &v, const symbol_set &args,
+	const degree_truncation &trunc)
+{
+	typedef std::pair<integer,typename Series::term_type const *> pair_type;
+	std::vector<pair_type> tmp;
+	tmp.reserve(v.size());
+	std::transform(v.begin(),v.end(),std::back_inserter(tmp),[&args,&trunc](typename Series::term_type const *ptr) {
+		return std::make_pair(truncation_degree<Series>(*ptr,args,trunc),ptr);
+	});
+	std::stable_sort(tmp.begin(),tmp.end(),[](const pair_type &p1, const pair_type &p2) {
+		return p1.first < p2.first;
+	});
+	std::vector<integer> retval;
+	retval.reserve(tmp.size());
+	for (decltype(tmp.size()) i = 0u; i < tmp.size(); ++i) {
+		v[i] = tmp[i].second;
+		retval.push_back(std::move(tmp[i].first));
+	}
+	return retval;
+}
+
+}
+
+}
+
+#endif
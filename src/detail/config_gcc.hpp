@@ -28,4 +28,15 @@
 #define likely(x) __builtin_expect((x),1)
 #define unlikely(x) __builtin_expect((x),0)
 
+// Read prefetch hint with high temporal locality.
+#define piranha_prefetch(addr) __builtin_prefetch((addr),0,3)
+
+// Thread-local storage for POD types.
+#define PIRANHA_TLS __thread
+
+// Runtime selection of SIMD kernels via CPU feature detection.
+#if defined(__x86_64__) && (__GNUC__ >= 5)
+	#define PIRANHA_X86_64_SIMD_DISPATCH
+#endif
+
 #endif
@@ -0,0 +1,154 @@
+/***************************************************************************
+ *   Copyright (C) 2009-2011 by Francesco Biscani                          *
+ *   bluescarni@gmail.com                                                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#ifndef PIRANHA_DETAIL_HYPERLOGLOG_HPP
+#define PIRANHA_DETAIL_HYPERLOGLOG_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "../config.hpp"
+
+namespace piranha { namespace detail {
+
+// HyperLogLog sketch for the estimation of the number of distinct elements in a stream of hash values. The sketch
+// uses 2 ** 14 registers, corresponding to a relative standard error of about 0.8%. As long as the number of distinct values
+// is small, the (mixed) values are stored as they are and the estimate is exact, so that the sketch is cheap to set up and to query
+// also for short streams. Sketches filled with different parts of a stream can be merged. See:
+// http://algo.inria.fr/flajolet/Publications/FlFuGaMe07.pdf
+// http://research.google.com/pubs/pub40671.html
+class hyperloglog
+{
+		typedef std::uint_least64_t value_type;
+		static const unsigned precision = 14u;
+		static const std::size_t n_registers = std::size_t(1u) << precision;
+		// Maximum number of values stored before switching to the registers.
+		static const std::size_t sparse_limit = n_registers / 8u;
+	public:
+		void add(const std::size_t &h)
+		{
+			const value_type x = mix(static_cast<value_type>(h));
+			if (m_registers.empty()) {
+				m_values.push_back(x);
+				if (m_values.size() >= sparse_limit) {
+					compact();
+				}
+			} else {
+				add_to_registers(x);
+			}
+		}
+		void merge(const hyperloglog &other)
+		{
+			if (m_registers.empty() && other.m_registers.empty()) {
+				m_values.insert(m_values.end(),other.m_values.begin(),other.m_values.end());
+				if (m_values.size() >= sparse_limit) {
+					compact();
+				}
+				return;
+			}
+			densify();
+			if (other.m_registers.empty()) {
+				for (const auto &x: other.m_values) {
+					add_to_registers(x);
+				}
+			} else {
+				std::transform(m_registers.begin(),m_registers.end(),other.m_registers.begin(),m_registers.begin(),
+					[](unsigned char a, unsigned char b) {return std::max(a,b);});
+			}
+		}
+		double estimate() const
+		{
+			if (m_registers.empty()) {
+				auto tmp(m_values);
+				std::sort(tmp.begin(),tmp.end());
+				return static_cast<double>(std::unique(tmp.begin(),tmp.end()) - tmp.begin());
+			}
+			const double m = static_cast<double>(n_registers), alpha = 0.7213 / (1. + 1.079 / m);
+			double sum = 0.;
+			std::size_t zeroes = 0u;
+			for (const auto &r: m_registers) {
+				sum += std::ldexp(1.,-static_cast<int>(r));
+				zeroes += static_cast<std::size_t>(r == 0u);
+			}
+			const double raw = alpha * m * m / sum;
+			// Small range correction via linear counting. With 64-bit hashes, there is no need for
+			// a large range correction.
+			if (raw <= 2.5 * m && zeroes) {
+				return m * std::log(m / static_cast<double>(zeroes));
+			}
+			return raw;
+		}
+	private:
+		// The hash values are mixed before use, as the hashes of keys are often far from uniform
+		// (e.g., the hash of a Kronecker monomial is its code). This is the finalizer of MurmurHash3.
+		static value_type mix(value_type x)
+		{
+			x ^= x >> 33u;
+			x *= 0xff51afd7ed558ccdull;
+			x ^= x >> 33u;
+			x *= 0xc4ceb3f99f0f1ad3ull;
+			x ^= x >> 33u;
+			return x & 0xffffffffffffffffull;
+		}
+		void add_to_registers(const value_type &x)
+		{
+			// The top bits select the register, the position of the first set bit in the remaining ones is the rank.
+			const auto idx = static_cast<std::size_t>(x >> (64u - precision));
+			const value_type top = value_type(1u) << 63u;
+			value_type w = (x << precision) & 0xffffffffffffffffull;
+			unsigned char rank = 1u;
+			// NOTE: the rank is at most 64 - precision + 1.
+			for (; rank <= 64u - precision && !(w & top); ++rank) {
+				w <<= 1u;
+			}
+			if (rank > m_registers[idx]) {
+				m_registers[idx] = rank;
+			}
+		}
+		// Remove the duplicate values, and switch to the registers if there are still too many values.
+		void compact()
+		{
+			std::sort(m_values.begin(),m_values.end());
+			m_values.erase(std::unique(m_values.begin(),m_values.end()),m_values.end());
+			if (m_values.size() >= sparse_limit / 2u) {
+				densify();
+			}
+		}
+		void densify()
+		{
+			if (!m_registers.empty()) {
+				return;
+			}
+			m_registers.resize(n_registers,0u);
+			for (const auto &x: m_values) {
+				add_to_registers(x);
+			}
+			std::vector<value_type>().swap(m_values);
+		}
+		std::vector<value_type>		m_values;
+		std::vector<unsigned char>	m_registers;
+};
+
+}}
+
+#endif
@@ -0,0 +1,177 @@
+/***************************************************************************
+ *   Copyright (C) 2009-2011 by Francesco Biscani                          *
+ *   bluescarni@gmail.com                                                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#ifndef PIRANHA_DETAIL_KEY_METADATA_HPP
+#define PIRANHA_DETAIL_KEY_METADATA_HPP
+
+#include <array>
+#include <cstddef>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "../config.hpp"
+#include "../symbol_set.hpp"
+
+// Metadata about the keys of a series (exponent bounds, degree distributions, etc.), cached by piranha::series
+// and kept up to date incrementally on insertion.
+
+namespace piranha { namespace detail {
+
+// Default implementation: no metadata is recorded.
+template <typename Key, typename = void>
+struct key_metadata
+{
+	static const bool enabled = false;
+	static const bool has_degree = false;
+	static const bool has_t_degree = false;
+	bool complete() const
+	{
+		return true;
+	}
+	void clear() {}
+	void add(const Key &, const symbol_set &) {}
+	void remove(const Key &, const symbol_set &) {}
+};
+
+template <typename Key, typename Enable>
+const bool key_metadata<Key,Enable>::enabled;
+
+template <typename Key, typename Enable>
+const bool key_metadata<Key,Enable>::has_degree;
+
+template <typename Key, typename Enable>
+const bool key_metadata<Key,Enable>::has_t_degree;
+
+// Metadata for Kronecker-packed keys. T is the exponent type, N the number
+// of degree-like properties for which the distribution over the terms is recorded.
+// The state is:
+// - m_has_bounds: if false, no key has been added since the last clear();
+// - m_min/m_max: per-variable bounds of the exponents. If m_exact is true, the bounds are attained
+//   by some key, otherwise they are only guaranteed to contain all the exponents;
+// - m_hist: number of terms for each value of the degree-like properties. They are meaningful
+//   only if m_has_hist is true (i.e., the metadata is complete).
+// NOTE: the bounds are stored in std::vector rather than in the static vectors used for unpacking,
+// as the latter would make every series object several kilobytes larger.
+template <typename T, std::size_t N>
+struct km_key_metadata
+{
+	typedef T value_type;
+	typedef std::vector<value_type> bounds_type;
+	typedef std::map<value_type,std::size_t> hist_type;
+	typedef std::array<value_type,N> degree_array;
+	static const bool enabled = true;
+	static const bool has_degree = false;
+	static const bool has_t_degree = false;
+	km_key_metadata():m_min(),m_max(),m_has_bounds(false),m_exact(true),m_hist(),m_has_hist(true) {}
+	bool complete() const
+	{
+		return m_has_hist;
+	}
+	void clear()
+	{
+		m_min.clear();
+		m_max.clear();
+		m_has_bounds = false;
+		m_exact = true;
+		for (auto &h: m_hist) {
+			h.clear();
+		}
+		m_has_hist = true;
+	}
+	// Set conservative bounds. The distributions become unavailable.
+	void set_bounds(bounds_type min, bounds_type max)
+	{
+		piranha_assert(min.size() == max.size());
+		clear();
+		m_min = std::move(min);
+		m_max = std::move(max);
+		m_has_bounds = true;
+		m_exact = false;
+		m_has_hist = false;
+	}
+	template <typename V>
+	void add_exponents(const V &v, const degree_array &d)
+	{
+		if (m_has_bounds) {
+			piranha_assert(v.size() == m_min.size());
+			for (decltype(v.size()) i = 0u; i < v.size(); ++i) {
+				if (v[i] < m_min[i]) {
+					m_min[i] = v[i];
+				}
+				if (v[i] > m_max[i]) {
+					m_max[i] = v[i];
+				}
+			}
+		} else {
+			m_min.assign(v.begin(),v.end());
+			m_max = m_min;
+			m_has_bounds = true;
+		}
+		if (m_has_hist) {
+			for (std::size_t i = 0u; i < N; ++i) {
+				++m_hist[i][d[i]];
+			}
+		}
+	}
+	// Removal cannot shrink the bounds without a full scan: they just become conservative.
+	void remove_degrees(const degree_array &d)
+	{
+		m_exact = false;
+		if (m_has_hist) {
+			for (std::size_t i = 0u; i < N; ++i) {
+				const auto it = m_hist[i].find(d[i]);
+				piranha_assert(it != m_hist[i].end() && it->second);
+				if (--(it->second) == 0u) {
+					m_hist[i].erase(it);
+				}
+			}
+		}
+	}
+	// Maximum (or minimum, if Low is true) value of the I-th property. Zero will be returned if there are no terms.
+	template <std::size_t I, bool Low>
+	value_type extremum() const
+	{
+		piranha_assert(m_has_hist);
+		if (m_hist[I].empty()) {
+			return value_type(0);
+		}
+		return Low ? m_hist[I].begin()->first : m_hist[I].rbegin()->first;
+	}
+	bounds_type		m_min;
+	bounds_type		m_max;
+	bool			m_has_bounds;
+	bool			m_exact;
+	std::array<hist_type,N>	m_hist;
+	bool			m_has_hist;
+};
+
+template <typename T, std::size_t N>
+const bool km_key_metadata<T,N>::enabled;
+
+template <typename T, std::size_t N>
+const bool km_key_metadata<T,N>::has_degree;
+
+template <typename T, std::size_t N>
+const bool km_key_metadata<T,N>::has_t_degree;
+
+}}
+
+#endif
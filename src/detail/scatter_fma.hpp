@@ -0,0 +1,170 @@
+/***************************************************************************
+ *   Copyright (C) 2009-2011 by Francesco Biscani                          *
+ *   bluescarni@gmail.com                                                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#ifndef PIRANHA_DETAIL_SCATTER_FMA_HPP
+#define PIRANHA_DETAIL_SCATTER_FMA_HPP
+
+#include <cmath>
+#include <cstddef>
+#include <type_traits>
+
+#include "../config.hpp"
+#include "../math.hpp"
+
+#if defined(PIRANHA_X86_64_SIMD_DISPATCH)
+
+#include <immintrin.h>
+
+#endif
+
+namespace piranha { namespace detail {
+
+// Scatter multiply-accumulate kernel for floating-point types: out[idx[k] + offset] += a * cf[k] for k in [0,n[, where idx and offset
+// are 64-bit signed integers.
+// The destination positions must be distinct. On x86-64, AVX2 and AVX-512 implementations are selected at runtime
+// according to the features of the CPU. The vectorised implementations always use fused multiply-add instructions,
+// whereas the generic implementation relies on math::multiply_accumulate().
+template <typename T, typename Int>
+inline void scatter_fma_generic(T *out, const Int *idx, const T *cf, const std::size_t &n, const T &a, const Int &offset)
+{
+	for (std::size_t k = 0u; k < n; ++k) {
+		math::multiply_accumulate(out[idx[k] + offset],a,cf[k]);
+	}
+}
+
+#if defined(PIRANHA_X86_64_SIMD_DISPATCH)
+
+template <typename Int>
+__attribute__((target("avx2,fma"))) inline void scatter_fma_avx2(double *out, const Int *idx, const double *cf, const std::size_t &n,
+	const double &a, const Int &offset)
+{
+	const __m256d va = _mm256_set1_pd(a);
+	const __m256i voff = _mm256_set1_epi64x(static_cast<long long>(offset));
+	std::size_t k = 0u;
+	for (; n - k >= 4u; k += 4u) {
+		// NOTE: AVX2 has gather but no scatter instructions, hence the stores are done one by one.
+		const __m256i vi = _mm256_add_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(idx + k)),voff);
+		const __m256d res = _mm256_fmadd_pd(va,_mm256_loadu_pd(cf + k),_mm256_i64gather_pd(out,vi,8));
+		alignas(32) double tmp[4u];
+		_mm256_store_pd(tmp,res);
+		for (std::size_t l = 0u; l < 4u; ++l) {
+			out[idx[k + l] + offset] = tmp[l];
+		}
+	}
+	for (; k < n; ++k) {
+		double &o = out[idx[k] + offset];
+		o = std::fma(a,cf[k],o);
+	}
+}
+
+template <typename Int>
+__attribute__((target("avx2,fma"))) inline void scatter_fma_avx2(float *out, const Int *idx, const float *cf, const std::size_t &n,
+	const float &a, const Int &offset)
+{
+	const __m128 va = _mm_set1_ps(a);
+	const __m256i voff = _mm256_set1_epi64x(static_cast<long long>(offset));
+	std::size_t k = 0u;
+	for (; n - k >= 4u; k += 4u) {
+		const __m256i vi = _mm256_add_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(idx + k)),voff);
+		const __m128 res = _mm_fmadd_ps(va,_mm_loadu_ps(cf + k),_mm256_i64gather_ps(out,vi,4));
+		alignas(16) float tmp[4u];
+		_mm_store_ps(tmp,res);
+		for (std::size_t l = 0u; l < 4u; ++l) {
+			out[idx[k + l] + offset] = tmp[l];
+		}
+	}
+	for (; k < n; ++k) {
+		float &o = out[idx[k] + offset];
+		o = std::fma(a,cf[k],o);
+	}
+}
+
+template <typename Int>
+__attribute__((target("avx512f,avx2,fma"))) inline void scatter_fma_avx512(double *out, const Int *idx, const double *cf, const std::size_t &n,
+	const double &a, const Int &offset)
+{
+	const __m512d va = _mm512_set1_pd(a);
+	const __m512i voff = _mm512_set1_epi64(static_cast<long long>(offset));
+	std::size_t k = 0u;
+	for (; n - k >= 8u; k += 8u) {
+		// NOTE: the masked gather with zero initialisation avoids spurious uninitialised value warnings in GCC.
+		const __m512i vi = _mm512_add_epi64(_mm512_loadu_si512(reinterpret_cast<const void *>(idx + k)),voff);
+		_mm512_i64scatter_pd(out,vi,_mm512_fmadd_pd(va,_mm512_loadu_pd(cf + k),_mm512_mask_i64gather_pd(_mm512_setzero_pd(),0xFF,vi,out,8)),8);
+	}
+	if (k < n) {
+		// Masked remainder.
+		const __mmask8 m = static_cast<__mmask8>((1u << (n - k)) - 1u);
+		const __m512i vi = _mm512_add_epi64(_mm512_maskz_loadu_epi64(m,reinterpret_cast<const void *>(idx + k)),voff);
+		const __m512d o = _mm512_mask_i64gather_pd(_mm512_setzero_pd(),m,vi,out,8);
+		_mm512_mask_i64scatter_pd(out,m,vi,_mm512_fmadd_pd(va,_mm512_maskz_loadu_pd(m,cf + k),o),8);
+	}
+}
+
+template <typename Int>
+__attribute__((target("avx512f,avx2,fma"))) inline void scatter_fma_avx512(float *out, const Int *idx, const float *cf, const std::size_t &n,
+	const float &a, const Int &offset)
+{
+	const __m256 va = _mm256_set1_ps(a);
+	const __m512i voff = _mm512_set1_epi64(static_cast<long long>(offset));
+	std::size_t k = 0u;
+	for (; n - k >= 8u; k += 8u) {
+		const __m512i vi = _mm512_add_epi64(_mm512_loadu_si512(reinterpret_cast<const void *>(idx + k)),voff);
+		_mm512_i64scatter_ps(out,vi,_mm256_fmadd_ps(va,_mm256_loadu_ps(cf + k),_mm512_mask_i64gather_ps(_mm256_setzero_ps(),0xFF,vi,out,4)),4);
+	}
+	for (; k < n; ++k) {
+		float &o = out[idx[k] + offset];
+		o = std::fma(a,cf[k],o);
+	}
+}
+
+#endif
+
+template <typename T, typename Int>
+struct scatter_fma_selector
+{
+	typedef void (*func_type)(T *, const Int *, const T *, const std::size_t &, const T &, const Int &);
+	static func_type select()
+	{
+#if defined(PIRANHA_X86_64_SIMD_DISPATCH)
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx512f")) {
+			return static_cast<func_type>(&scatter_fma_avx512<Int>);
+		}
+		if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+			return static_cast<func_type>(&scatter_fma_avx2<Int>);
+		}
+#endif
+		return &scatter_fma_generic<T,Int>;
+	}
+};
+
+// NOTE: the indices must be 64-bit signed integers, as required by the vectorised implementations.
+template <typename T, typename Int, typename = typename std::enable_if<(std::is_same<T,double>::value || std::is_same<T,float>::value) &&
+	std::is_integral<Int>::value && std::is_signed<Int>::value && sizeof(Int) == 8u>::type>
+inline void scatter_fma(T *out, const Int *idx, const T *cf, const std::size_t &n, const T &a, const Int &offset)
+{
+	// NOTE: the selection is performed only once, in a thread-safe way.
+	static const typename scatter_fma_selector<T,Int>::func_type func = scatter_fma_selector<T,Int>::select();
+	func(out,idx,cf,n,a,offset);
+}
+
+}}
+
+#endif
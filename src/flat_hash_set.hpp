@@ -0,0 +1,1302 @@
+/***************************************************************************
+ *   Copyright (C) 2009-2011 by Francesco Biscani                          *
+ *   bluescarni@gmail.com                                                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#ifndef PIRANHA_FLAT_HASH_SET_HPP
+#define PIRANHA_FLAT_HASH_SET_HPP
+
+#include <boost/integer_traits.hpp>
+#include <boost/iterator/iterator_facade.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "config.hpp"
+#include "debug_access.hpp"
+#include "environment.hpp"
+#include "exceptions.hpp"
+#include "hash_set.hpp"
+#include "type_traits.hpp"
+
+namespace piranha
+{
+
+/// Hash set with open addressing within groups of slots.
+/**
+ * Hash set class with the same interface as piranha::hash_set (including the low-level interface used by the series multipliers),
+ * but with a different memory layout. Each bucket of the table is a group of 8 slots with an associated control word
+ * (one byte per slot, storing 7 bits of the hash value of the element in the slot, or zero if the slot is empty).
+ * The lookup of an element compares the hash byte with all the bytes of the control word at once, and the element is compared
+ * with the stored elements only in case of a match. When all the slots of a group are occupied, further elements are stored in
+ * overflow groups linked to the bucket.
+ *
+ * The first groups of the buckets are stored as a structure of arrays: an array of control words, an array of pointers to
+ * the overflow groups and, for each slot index, an array storing the slot with that index of all the buckets. Hence, the lookup
+ * of an element accesses only a control word and a slot, and lookups in contiguous buckets (such as the insertion of the products
+ * of Kronecker monomials sorted by destination bucket) access contiguous memory.
+ *
+ * With respect to piranha::hash_set, this layout avoids a heap allocation and a pointer dereference per element, at the price
+ * of a larger memory footprint for tables with few elements per bucket. Accordingly, the maximum load factor of the table is greater than one.
+ * On the other hand, a lookup reads the slot only after the control word: for tables much larger than the last level cache,
+ * the two dependent memory accesses make the lookups slower than in piranha::hash_set.
+ *
+ * Note that the open addressing never crosses the boundaries of a bucket: as in piranha::hash_set, the low-level
+ * methods can be used concurrently on different buckets.
+ *
+ * Iterator invalidation: after a rehash operation, all iterators will be invalidated and existing references/pointers to the
+ * elements will also be invalid; after an insertion/erase operation, all existing iterators, pointers
+ * and references to the elements in the destination bucket will be invalid.
+ *
+ * The table can be selected as container for the terms of a series via piranha::series_container.
+ *
+ * \section type_requirements Type requirements
+ *
+ * - \p T must satisfy piranha::is_container_element,
+ * - \p Hash must satisfy piranha::is_hash_function_object,
+ * - \p Pred must satisfy piranha::is_equality_function_object.
+ *
+ * \section exception_safety Exception safety guarantee
+ *
+ * This class provides the strong exception safety guarantee for all operations apart from the insertion methods,
+ * which provide the following guarantee: the table will be either left in the same state as it was before the attempted
+ * insertion or it will be emptied.
+ *
+ * \section move_semantics Move semantics
+ *
+ * Move construction and move assignment will leave the moved-from object equivalent to an empty set whose hasher and
+ * equality predicate have been moved-from.
+ *
+ * @author Francesco Biscani (bluescarni@gmail.com)
+ */
+template <typename T, typename Hash = std::hash<T>, typename Pred = std::equal_to<T>>
+class flat_hash_set
+{
+		PIRANHA_TT_CHECK(is_container_element,T);
+		PIRANHA_TT_CHECK(is_hash_function_object,Hash,T);
+		PIRANHA_TT_CHECK(is_equality_function_object,Pred,T);
+		// Make friend with debug access class.
+		template <typename U>
+		friend class debug_access;
+		// NOTE: the control word is manipulated as a vector of 8 bytes via bitwise operations.
+		typedef std::uint_least64_t ctrl_type;
+		static_assert(std::numeric_limits<ctrl_type>::digits == 64,"Invalid control word type.");
+		static const unsigned group_size = 8u;
+		// The least and most significant bits of the bytes of the control word.
+		static const ctrl_type lsb_mask = 0x0101010101010101ull;
+		static const ctrl_type msb_mask = 0x8080808080808080ull;
+		static const ctrl_type low_mask = 0x7f7f7f7f7f7f7f7full;
+		// Byte of the control word for an element with a given hash value: the most significant bit is always set, the
+		// remaining bits are taken from the top of the hash value after a multiplicative mixing (the low bits of the
+		// hash value determine the bucket, and they are often the only bits set for small keys).
+		static ctrl_type hash_byte(const std::size_t &hash)
+		{
+			return static_cast<ctrl_type>(((static_cast<ctrl_type>(hash) * 0x9e3779b97f4a7c15ull) >> 57u) | 0x80u);
+		}
+		// Mask of the bytes of ctrl equal to byte. The result has the most significant bit set in the matching bytes,
+		// all the other bits are zero. There are no false positives, as the byte of an empty slot is zero.
+		static ctrl_type match(const ctrl_type &ctrl, const ctrl_type &byte)
+		{
+			const ctrl_type x = ctrl ^ (lsb_mask * byte);
+			return static_cast<ctrl_type>(~((((x & low_mask) + low_mask) | x) | low_mask));
+		}
+		// Masks of the occupied and free slots.
+		static ctrl_type occupied_slots(const ctrl_type &ctrl)
+		{
+			return ctrl & msb_mask;
+		}
+		static ctrl_type free_slots(const ctrl_type &ctrl)
+		{
+			return static_cast<ctrl_type>(~ctrl & msb_mask);
+		}
+		// Index of the first slot flagged in a nonzero mask of slots.
+		static unsigned first_slot(const ctrl_type &mask)
+		{
+			piranha_assert(mask);
+			// NOTE: isolate the lowest bit, move it to the bottom of its byte and read the index of the byte from the most
+			// significant byte of the product with a de Bruijn-like constant.
+			const ctrl_type bit = mask & (~mask + 1u);
+			return static_cast<unsigned>(static_cast<ctrl_type>((bit >> 7u) * 0x0001020304050607ull) >> 56u);
+		}
+		// Mask of the slots after slot n.
+		static ctrl_type slots_after(const unsigned &n)
+		{
+			piranha_assert(n < group_size);
+			return (n == group_size - 1u) ? ctrl_type(0u) : static_cast<ctrl_type>(~ctrl_type(0u) << (8u * (n + 1u)));
+		}
+		typedef typename std::aligned_storage<sizeof(T),alignof(T)>::type storage_type;
+		// Overflow group of slots, allocated dynamically and linked to the bucket through m_next.
+		// Overflow groups are never empty.
+		struct group
+		{
+			group():m_ctrl(0u),m_next(nullptr) {}
+			group(const group &) = delete;
+			group(group &&) = delete;
+			group &operator=(const group &) = delete;
+			group &operator=(group &&) = delete;
+			~group()
+			{
+				piranha_assert(!m_ctrl && !m_next);
+			}
+			ctrl_type	m_ctrl;
+			group		*m_next;
+			storage_type	m_slots[group_size];
+		};
+		// Reference to a group of slots: either the first group of a bucket, whose slots are stored in the slot arrays
+		// of the table with a stride equal to the number of buckets, or an overflow group.
+		struct group_ref
+		{
+			group_ref():m_ctrl(nullptr),m_next(nullptr),m_slots(nullptr),m_stride(0u) {}
+			explicit group_ref(ctrl_type *ctrl, group **next, storage_type *slots, const std::size_t &stride):
+				m_ctrl(ctrl),m_next(next),m_slots(slots),m_stride(stride)
+			{}
+			explicit group_ref(group *g):m_ctrl(&g->m_ctrl),m_next(&g->m_next),m_slots(g->m_slots),m_stride(1u) {}
+			// NOTE: see the notes in hash_set::node about the casts.
+			T *ptr(const unsigned &slot) const
+			{
+				piranha_assert(is_occupied(slot));
+				return static_cast<T *>(static_cast<void *>(m_slots + slot * m_stride));
+			}
+			bool is_occupied(const unsigned &slot) const
+			{
+				piranha_assert(slot < group_size);
+				return (*m_ctrl >> (8u * slot)) & 0x80u;
+			}
+			ctrl_type byte(const unsigned &slot) const
+			{
+				piranha_assert(slot < group_size);
+				return (*m_ctrl >> (8u * slot)) & 0xffu;
+			}
+			// Construct an element into a free slot.
+			template <typename U>
+			void construct(const unsigned &slot, U &&item, const ctrl_type &b) const
+			{
+				piranha_assert(!is_occupied(slot));
+				::new (static_cast<void *>(m_slots + slot * m_stride)) T(std::forward<U>(item));
+				*m_ctrl |= b << (8u * slot);
+			}
+			void destroy_slot(const unsigned &slot) const
+			{
+				ptr(slot)->~T();
+				*m_ctrl &= ~(ctrl_type(0xffu) << (8u * slot));
+			}
+			ctrl_type	*m_ctrl;
+			group		**m_next;
+			storage_type	*m_slots;
+			std::size_t	m_stride;
+		};
+		// Iterator within a bucket.
+		template <typename U>
+		class local_iterator_impl: public boost::iterator_facade<local_iterator_impl<U>,U,boost::forward_traversal_tag>
+		{
+				template <typename V>
+				friend class local_iterator_impl;
+				friend class flat_hash_set;
+			public:
+				local_iterator_impl():m_ref(),m_slot(0u) {}
+				explicit local_iterator_impl(const group_ref &ref, const unsigned &slot):m_ref(ref),m_slot(slot) {}
+				// Constructor from other iterator type.
+				template <typename V>
+				local_iterator_impl(const local_iterator_impl<V> &other,
+					typename std::enable_if<std::is_convertible<V *,U *>::value>::type * = nullptr):
+					m_ref(other.m_ref),m_slot(other.m_slot)
+				{}
+				// Position of the first element in the chain of groups starting from ref, or end.
+				static local_iterator_impl first(group_ref ref)
+				{
+					while (true) {
+						const ctrl_type occ = occupied_slots(*ref.m_ctrl);
+						if (occ) {
+							return local_iterator_impl(ref,first_slot(occ));
+						}
+						if (!*ref.m_next) {
+							return local_iterator_impl();
+						}
+						ref = group_ref(*ref.m_next);
+					}
+				}
+			private:
+				friend class boost::iterator_core_access;
+				// Position of the element following the one in slot.
+				static local_iterator_impl next(const group_ref &ref, const unsigned &slot)
+				{
+					const ctrl_type occ = occupied_slots(*ref.m_ctrl) & slots_after(slot);
+					if (occ) {
+						return local_iterator_impl(ref,first_slot(occ));
+					}
+					return (*ref.m_next) ? first(group_ref(*ref.m_next)) : local_iterator_impl();
+				}
+				void increment()
+				{
+					piranha_assert(m_ref.m_ctrl && m_ref.is_occupied(m_slot));
+					*this = next(m_ref,m_slot);
+				}
+				template <typename V>
+				bool equal(const local_iterator_impl<V> &other) const
+				{
+					return m_ref.m_ctrl == other.m_ref.m_ctrl && m_slot == other.m_slot;
+				}
+				U &dereference() const
+				{
+					piranha_assert(m_ref.m_ctrl && m_ref.is_occupied(m_slot));
+					return *m_ref.ptr(m_slot);
+				}
+				group_ref	m_ref;
+				unsigned	m_slot;
+		};
+		// View of a bucket, iterable via begin() and end().
+		class bucket_type
+		{
+			public:
+				typedef local_iterator_impl<T const> const_iterator;
+				explicit bucket_type(const group_ref &ref):m_ref(ref) {}
+				const_iterator begin() const
+				{
+					return const_iterator::first(m_ref);
+				}
+				const_iterator end() const
+				{
+					return const_iterator();
+				}
+				bool empty() const
+				{
+					// NOTE: the first group might be empty while the overflow groups are not.
+					return !*m_ref.m_ctrl && !*m_ref.m_next;
+				}
+			private:
+				group_ref	m_ref;
+		};
+	public:
+		/// Functor type for the calculation of hash values.
+		typedef Hash hasher;
+		/// Functor type for comparing the items in the set.
+		typedef Pred key_equal;
+		/// Key type.
+		typedef T key_type;
+		/// Size type.
+		/**
+		 * Alias for \p std::size_t.
+		 */
+		typedef std::size_t size_type;
+		/// Modification stamp type.
+		/**
+		 * Same as piranha::hash_set::stamp_type.
+		 */
+		typedef std::pair<std::uint_least64_t,std::uint_least64_t> stamp_type;
+	private:
+		template <typename Key>
+		class iterator_impl: public boost::iterator_facade<iterator_impl<Key>,Key,boost::forward_traversal_tag>
+		{
+				friend class flat_hash_set;
+				typedef typename std::conditional<std::is_const<Key>::value,flat_hash_set const,flat_hash_set>::type set_type;
+				typedef local_iterator_impl<Key> it_type;
+			public:
+				iterator_impl():m_set(nullptr),m_idx(0u),m_it() {}
+				explicit iterator_impl(set_type *set, const size_type &idx, it_type it):
+					m_set(set),m_idx(idx),m_it(it) {}
+			private:
+				friend class boost::iterator_core_access;
+				void increment()
+				{
+					piranha_assert(m_set);
+					piranha_assert(m_idx < m_set->bucket_count());
+					piranha_assert(m_it != it_type{});
+					++m_it;
+					if (m_it == it_type{}) {
+						const size_type container_size = m_set->bucket_count();
+						while (true) {
+							++m_idx;
+							if (m_idx == container_size) {
+								return;
+							}
+							m_it = it_type::first(m_set->bucket_ref(m_idx));
+							if (m_it != it_type{}) {
+								return;
+							}
+						}
+					}
+				}
+				bool equal(const iterator_impl &other) const
+				{
+					piranha_assert(m_set && other.m_set);
+					return (m_set == other.m_set && m_idx == other.m_idx && m_it == other.m_it);
+				}
+				Key &dereference() const
+				{
+					piranha_assert(m_set && m_idx < m_set->bucket_count() && m_it != it_type{});
+					return *m_it;
+				}
+			private:
+				set_type	*m_set;
+				size_type	m_idx;
+				it_type		m_it;
+		};
+		// Reference to the first group of the bucket at index idx.
+		group_ref bucket_ref(const size_type &idx) const
+		{
+			piranha_assert(idx < bucket_count());
+			return group_ref(m_ctrl + idx,m_next + idx,m_slots + idx,size_type(1u) << m_log2_size);
+		}
+		void init_from_n_buckets(const size_type &n_buckets)
+		{
+			piranha_assert(!m_ctrl && !m_next && !m_slots && !m_log2_size && !m_n_elements);
+			if (n_buckets) {
+				const size_type log2_size = get_log2_from_hint(n_buckets);
+				const size_type size = size_type(1u) << log2_size;
+				if (unlikely(size > boost::integer_traits<size_type>::const_max / group_size)) {
+					piranha_throw(std::bad_alloc,);
+				}
+				std::allocator<ctrl_type> c_alloc;
+				std::allocator<group *> n_alloc;
+				std::allocator<storage_type> s_alloc;
+				ctrl_type *new_ctrl = c_alloc.allocate(size);
+				group **new_next = nullptr;
+				storage_type *new_slots = nullptr;
+				try {
+					new_next = n_alloc.allocate(size);
+					new_slots = s_alloc.allocate(size * group_size);
+				} catch (...) {
+					if (new_next) {
+						n_alloc.deallocate(new_next,size);
+					}
+					c_alloc.deallocate(new_ctrl,size);
+					throw;
+				}
+				std::fill(new_ctrl,new_ctrl + size,ctrl_type(0u));
+				std::fill(new_next,new_next + size,static_cast<group *>(nullptr));
+				m_ctrl = new_ctrl;
+				m_next = new_next;
+				m_slots = new_slots;
+				m_log2_size = log2_size;
+			}
+		}
+		// Destroy all the elements of a bucket and its overflow groups.
+		static void destroy_bucket(const group_ref &ref)
+		{
+			ctrl_type occ = occupied_slots(*ref.m_ctrl);
+			while (occ) {
+				ref.destroy_slot(first_slot(occ));
+				occ &= occ - 1u;
+			}
+			group *g = *ref.m_next;
+			*ref.m_next = nullptr;
+			while (g) {
+				const group_ref g_ref(g);
+				occ = occupied_slots(g->m_ctrl);
+				while (occ) {
+					g_ref.destroy_slot(first_slot(occ));
+					occ &= occ - 1u;
+				}
+				group *const old = g;
+				g = g->m_next;
+				old->m_next = nullptr;
+				::delete old;
+			}
+		}
+		// Copy the content of a bucket into another, empty, bucket.
+		static void copy_bucket(const group_ref &to, const group_ref &from)
+		{
+			piranha_assert(!*to.m_ctrl && !*to.m_next);
+			try {
+				group_ref cur_to = to, cur_from = from;
+				while (true) {
+					ctrl_type occ = occupied_slots(*cur_from.m_ctrl);
+					while (occ) {
+						const unsigned slot = first_slot(occ);
+						cur_to.construct(slot,*cur_from.ptr(slot),cur_from.byte(slot));
+						occ &= occ - 1u;
+					}
+					if (!*cur_from.m_next) {
+						break;
+					}
+					std::unique_ptr<group> new_group(new group());
+					*cur_to.m_next = new_group.release();
+					cur_to = group_ref(*cur_to.m_next);
+					cur_from = group_ref(*cur_from.m_next);
+				}
+			} catch (...) {
+				destroy_bucket(to);
+				throw;
+			}
+		}
+		// Destroy all elements and deallocate the arrays.
+		void destroy_and_deallocate()
+		{
+			if (m_ctrl) {
+				const size_type size = size_type(1u) << m_log2_size;
+				for (size_type i = 0u; i < size; ++i) {
+					destroy_bucket(bucket_ref(i));
+				}
+				std::allocator<ctrl_type>().deallocate(m_ctrl,size);
+				std::allocator<group *>().deallocate(m_next,size);
+				std::allocator<storage_type>().deallocate(m_slots,size * group_size);
+			} else {
+				piranha_assert(!m_next && !m_slots && !m_log2_size && !m_n_elements);
+			}
+		}
+		// First element of the table starting from bucket idx.
+		template <typename It, typename Set>
+		static It first_from(Set *set, size_type idx)
+		{
+			typedef typename It::it_type it_type;
+			const auto b_count = set->bucket_count();
+			for (; idx < b_count; ++idx) {
+				const auto it = it_type::first(set->bucket_ref(idx));
+				if (it != it_type{}) {
+					return It(set,idx,it);
+				}
+			}
+			return It(set,b_count,it_type{});
+		}
+		// Insertion and lookup with precomputed hash byte.
+		template <typename U>
+		local_iterator_impl<T> unique_insert_impl(U &&k, const size_type &bucket_idx, const ctrl_type &byte)
+		{
+			group_ref ref = bucket_ref(bucket_idx);
+			while (true) {
+				const ctrl_type fs = free_slots(*ref.m_ctrl);
+				if (fs) {
+					const unsigned slot = first_slot(fs);
+					ref.construct(slot,std::forward<U>(k),byte);
+					return local_iterator_impl<T>(ref,slot);
+				}
+				if (!*ref.m_next) {
+					break;
+				}
+				ref = group_ref(*ref.m_next);
+			}
+			// All the groups of the bucket are full, append a new one.
+			std::unique_ptr<group> new_group(new group());
+			const group_ref new_ref(new_group.get());
+			new_ref.construct(0u,std::forward<U>(k),byte);
+			*ref.m_next = new_group.release();
+			return local_iterator_impl<T>(new_ref,0u);
+		}
+		local_iterator_impl<T const> find_impl(const key_type &k, const size_type &bucket_idx, const ctrl_type &byte) const
+		{
+			group_ref ref = bucket_ref(bucket_idx);
+			while (true) {
+				ctrl_type m = match(*ref.m_ctrl,byte);
+				while (m) {
+					const unsigned slot = first_slot(m);
+					if (m_key_equal(*ref.ptr(slot),k)) {
+						return local_iterator_impl<T const>(ref,slot);
+					}
+					m &= m - 1u;
+				}
+				if (!*ref.m_next) {
+					return local_iterator_impl<T const>();
+				}
+				ref = group_ref(*ref.m_next);
+			}
+		}
+	public:
+		/// Iterator type.
+		typedef iterator_impl<key_type const> iterator;
+		/// Const iterator type.
+		/**
+		 * Equivalent to the iterator type.
+		 */
+		typedef iterator const_iterator;
+		/// Local iterator.
+		/**
+		 * Const iterator that can be used to iterate through a single bucket.
+		 */
+		typedef local_iterator_impl<T const> local_iterator;
+		/// Default constructor.
+		/**
+		 * If not specified, it will default-initialise the hasher and the equality predicate. The resulting
+		 * hash set will be empty.
+		 *
+		 * @param[in] h hasher functor.
+		 * @param[in] k equality predicate.
+		 *
+		 * @throws unspecified any exception thrown by the copy constructors of <tt>Hash</tt> or <tt>Pred</tt>.
+		 */
+		flat_hash_set(const hasher &h = hasher(), const key_equal &k = key_equal()):
+			m_ctrl(nullptr),m_next(nullptr),m_slots(nullptr),m_log2_size(0u),m_hasher(h),m_key_equal(k),m_n_elements(0u),m_stamp(new_stamp()) {}
+		/// Constructor from number of buckets.
+		/**
+		 * Will construct a table whose number of buckets is at least equal to \p n_buckets.
+		 *
+		 * @param[in] n_buckets desired number of buckets.
+		 * @param[in] h hasher functor.
+		 * @param[in] k equality predicate.
+		 *
+		 * @throws std::bad_alloc if the desired number of buckets is greater than an implementation-defined maximum.
+		 * @throws unspecified any exception thrown by the copy constructors of <tt>Hash</tt> or <tt>Pred</tt>.
+		 */
+		explicit flat_hash_set(const size_type &n_buckets, const hasher &h = hasher(), const key_equal &k = key_equal()):
+			m_ctrl(nullptr),m_next(nullptr),m_slots(nullptr),m_log2_size(0u),m_hasher(h),m_key_equal(k),m_n_elements(0u),m_stamp(new_stamp())
+		{
+			init_from_n_buckets(n_buckets);
+		}
+		/// Copy constructor.
+		/**
+		 * @param[in] other piranha::flat_hash_set that will be copied into \p this.
+		 *
+		 * @throws unspecified any exception thrown by memory allocation errors,
+		 * the copy constructor of the stored type, <tt>Hash</tt> or <tt>Pred</tt>.
+		 */
+		flat_hash_set(const flat_hash_set &other):
+			m_ctrl(nullptr),m_next(nullptr),m_slots(nullptr),m_log2_size(0u),m_hasher(other.m_hasher),
+			m_key_equal(other.m_key_equal),m_n_elements(0u),m_stamp(new_stamp())
+		{
+			if (other.m_ctrl) {
+				init_from_n_buckets(other.bucket_count());
+				piranha_assert(m_log2_size == other.m_log2_size);
+				try {
+					const size_type size = size_type(1u) << m_log2_size;
+					for (size_type i = 0u; i < size; ++i) {
+						copy_bucket(bucket_ref(i),other.bucket_ref(i));
+					}
+				} catch (...) {
+					destroy_and_deallocate();
+					throw;
+				}
+				m_n_elements = other.m_n_elements;
+			} else {
+				piranha_assert(!other.m_log2_size && !other.m_n_elements);
+			}
+		}
+		/// Move constructor.
+		/**
+		 * After the move, \p other will have zero buckets and zero elements, and its hasher and equality predicate
+		 * will have been used to move-construct their counterparts in \p this.
+		 *
+		 * @param[in] other table to be moved.
+		 */
+		flat_hash_set(flat_hash_set &&other) noexcept(true) : m_ctrl(other.m_ctrl),m_next(other.m_next),m_slots(other.m_slots),
+			m_log2_size(other.m_log2_size),m_hasher(std::move(other.m_hasher)),m_key_equal(std::move(other.m_key_equal)),
+			m_n_elements(other.m_n_elements),m_stamp(other.m_stamp)
+		{
+			other.m_ctrl = nullptr;
+			other.m_next = nullptr;
+			other.m_slots = nullptr;
+			other.m_log2_size = 0u;
+			other.m_n_elements = 0u;
+			other.m_stamp = new_stamp();
+		}
+		/// Constructor from range.
+		/**
+		 * Create a table with a copy of a range.
+		 *
+		 * @param[in] begin begin of range.
+		 * @param[in] end end of range.
+		 * @param[in] n_buckets number of initial buckets.
+		 * @param[in] h hash functor.
+		 * @param[in] k key equality predicate.
+		 *
+		 * @throws std::bad_alloc if the desired number of buckets is greater than an implementation-defined maximum.
+		 * @throws unspecified any exception thrown by the copy constructors of <tt>Hash</tt> or <tt>Pred</tt>, or arising from
+		 * calling insert() on the elements of the range.
+		 */
+		template <typename InputIterator>
+		explicit flat_hash_set(const InputIterator &begin, const InputIterator &end, const size_type &n_buckets = 0u,
+			const hasher &h = hasher(), const key_equal &k = key_equal()):
+			m_ctrl(nullptr),m_next(nullptr),m_slots(nullptr),m_log2_size(0u),m_hasher(h),m_key_equal(k),m_n_elements(0u),m_stamp(new_stamp())
+		{
+			init_from_n_buckets(n_buckets);
+			for (auto it = begin; it != end; ++it) {
+				insert(*it);
+			}
+		}
+		/// Constructor from initializer list.
+		/**
+		 * Will insert() all the elements of the initializer list, ignoring the return value of the operation.
+		 * Hash functor and equality predicate will be default-constructed.
+		 *
+		 * @param[in] list initializer list of elements to be inserted.
+		 *
+		 * @throws std::bad_alloc if the desired number of buckets is greater than an implementation-defined maximum.
+		 * @throws unspecified any exception thrown by either insert() or of the default constructor of <tt>Hash</tt> or <tt>Pred</tt>.
+		 */
+		template <typename U>
+		explicit flat_hash_set(std::initializer_list<U> list):
+			m_ctrl(nullptr),m_next(nullptr),m_slots(nullptr),m_log2_size(0u),m_hasher(),m_key_equal(),m_n_elements(0u),m_stamp(new_stamp())
+		{
+			for (const auto &x: list) {
+				insert(x);
+			}
+		}
+		/// Destructor.
+		/**
+		 * No side effects.
+		 */
+		~flat_hash_set() noexcept(true)
+		{
+			piranha_assert(sanity_check());
+			destroy_and_deallocate();
+		}
+		/// Copy assignment operator.
+		/**
+		 * @param[in] other assignment argument.
+		 *
+		 * @return reference to \p this.
+		 *
+		 * @throws unspecified any exception thrown by the copy constructor.
+		 */
+		flat_hash_set &operator=(const flat_hash_set &other)
+		{
+			if (likely(this != &other)) {
+				flat_hash_set tmp(other);
+				*this = std::move(tmp);
+			}
+			return *this;
+		}
+		/// Move assignment operator.
+		/**
+		 * @param[in] other table to be moved into \p this.
+		 *
+		 * @return reference to \p this.
+		 */
+		flat_hash_set &operator=(flat_hash_set &&other) noexcept(true)
+		{
+			if (likely(this != &other)) {
+				destroy_and_deallocate();
+				m_ctrl = other.m_ctrl;
+				m_next = other.m_next;
+				m_slots = other.m_slots;
+				m_log2_size = other.m_log2_size;
+				m_hasher = std::move(other.m_hasher);
+				m_key_equal = std::move(other.m_key_equal);
+				m_n_elements = other.m_n_elements;
+				m_stamp = other.m_stamp;
+				other.m_ctrl = nullptr;
+				other.m_next = nullptr;
+				other.m_slots = nullptr;
+				other.m_log2_size = 0u;
+				other.m_n_elements = 0u;
+				other.m_stamp = new_stamp();
+			}
+			return *this;
+		}
+		/// Const begin iterator.
+		/**
+		 * @return flat_hash_set::const_iterator to the first element of the table, or end() if the table is empty.
+		 */
+		const_iterator begin() const
+		{
+			return first_from<const_iterator>(this,0u);
+		}
+		/// Const end iterator.
+		/**
+		 * @return flat_hash_set::const_iterator to the position past the last element of the table.
+		 */
+		const_iterator end() const
+		{
+			return const_iterator(this,bucket_count(),local_iterator{});
+		}
+		/// Begin iterator.
+		/**
+		 * @return flat_hash_set::iterator to the first element of the table, or end() if the table is empty.
+		 */
+		iterator begin()
+		{
+			return static_cast<flat_hash_set const *>(this)->begin();
+		}
+		/// End iterator.
+		/**
+		 * @return flat_hash_set::iterator to the position past the last element of the table.
+		 */
+		iterator end()
+		{
+			return static_cast<flat_hash_set const *>(this)->end();
+		}
+		/// Number of elements contained in the table.
+		/**
+		 * @return number of elements in the table.
+		 */
+		size_type size() const
+		{
+			return m_n_elements;
+		}
+		/// Test for empty table.
+		/**
+		 * @return \p true if size() returns 0, \p false otherwise.
+		 */
+		bool empty() const
+		{
+			return !size();
+		}
+		/// Number of buckets.
+		/**
+		 * @return number of buckets in the table.
+		 */
+		size_type bucket_count() const
+		{
+			return (m_ctrl) ? (size_type(1u) << m_log2_size) : size_type(0u);
+		}
+		/// Load factor.
+		/**
+		 * @return <tt>(double)size() / bucket_count()</tt>, or 0 if the table is empty.
+		 */
+		double load_factor() const
+		{
+			const auto b_count = bucket_count();
+			return (b_count) ? static_cast<double>(size()) / static_cast<double>(b_count) : 0.;
+		}
+		/// Index of destination bucket.
+		/**
+		 * Index to which \p k would belong, were it to be inserted into the table. The index of the
+		 * destination bucket is the hash value reduced modulo the bucket count.
+		 *
+		 * @param[in] k input argument.
+		 *
+		 * @return index of the destination bucket for \p k.
+		 *
+		 * @throws piranha::zero_division_error if bucket_count() returns zero.
+		 * @throws unspecified any exception thrown by _bucket().
+		 */
+		size_type bucket(const key_type &k) const
+		{
+			if (unlikely(!bucket_count())) {
+				piranha_throw(zero_division_error,"cannot calculate bucket index in an empty table");
+			}
+			return _bucket(k);
+		}
+		/// Find element.
+		/**
+		 * @param[in] k element to be located.
+		 *
+		 * @return flat_hash_set::const_iterator to <tt>k</tt>'s position in the table, or end() if \p k is not in the table.
+		 *
+		 * @throws unspecified any exception thrown by _find().
+		 */
+		const_iterator find(const key_type &k) const
+		{
+			if (unlikely(!bucket_count())) {
+				return end();
+			}
+			return _find(k,_bucket(k));
+		}
+		/// Find element.
+		/**
+		 * @param[in] k element to be located.
+		 *
+		 * @return flat_hash_set::iterator to <tt>k</tt>'s position in the table, or end() if \p k is not in the table.
+		 *
+		 * @throws unspecified any exception thrown by _find().
+		 */
+		iterator find(const key_type &k)
+		{
+			return static_cast<const flat_hash_set *>(this)->find(k);
+		}
+		/// Maximum load factor.
+		/**
+		 * @return the maximum load factor allowed before a resize.
+		 */
+		double max_load_factor() const
+		{
+			// NOTE: with 6 elements per bucket on average, about 3/4 of the slots are occupied and an overflow group is
+			// needed in roughly one bucket out of seven, if the hash values are uniformly distributed.
+			return 6.;
+		}
+		/// Insert element.
+		/**
+		 * This template is activated only if \p T and \p U are the same type, aside from cv qualifications and references.
+		 * If no other key equivalent to \p k exists in the table, the insertion is successful and returns the <tt>(it,true)</tt>
+		 * pair - where \p it is the position in the table into which the object has been inserted. Otherwise, the return value
+		 * will be <tt>(it,false)</tt> - where \p it is the position of the existing equivalent object.
+		 *
+		 * @param[in] k object that will be inserted into the table.
+		 *
+		 * @return <tt>(flat_hash_set::iterator,bool)</tt> pair containing an iterator to the newly-inserted object (or its existing
+		 * equivalent) and the result of the operation.
+		 *
+		 * @throws unspecified any exception thrown by:
+		 * - flat_hash_set::key_type's copy constructor,
+		 * - _find().
+		 * @throws std::overflow_error if a successful insertion would result in size() exceeding the maximum
+		 * value representable by type piranha::flat_hash_set::size_type.
+		 * @throws std::bad_alloc if the operation results in a resize of the table past an implementation-defined
+		 * maximum number of buckets.
+		 */
+		template <typename U>
+		std::pair<iterator,bool> insert(U &&k, typename std::enable_if<std::is_same<T,typename std::decay<U>::type>::value>::type * = nullptr)
+		{
+			auto b_count = bucket_count();
+			if (unlikely(!b_count)) {
+				_increase_size();
+				b_count = 1u;
+			}
+			const std::size_t hash = m_hasher(k);
+			const ctrl_type byte = hash_byte(hash);
+			auto bucket_idx = _bucket_from_hash(hash);
+			const auto l_it = find_impl(k,bucket_idx,byte);
+			if (l_it != local_iterator{}) {
+				return std::make_pair(iterator(this,bucket_idx,l_it),false);
+			}
+			if (unlikely(m_n_elements == boost::integer_traits<size_type>::const_max)) {
+				piranha_throw(std::overflow_error,"maximum number of elements reached");
+			}
+			if (unlikely(static_cast<double>(m_n_elements + size_type(1u)) / static_cast<double>(b_count) > max_load_factor())) {
+				_increase_size();
+				bucket_idx = _bucket_from_hash(hash);
+			}
+			const auto it_retval = iterator(this,bucket_idx,unique_insert_impl(std::forward<U>(k),bucket_idx,byte));
+			++m_n_elements;
+			++m_stamp.second;
+			return std::make_pair(it_retval,true);
+		}
+		/// Erase element.
+		/**
+		 * Erase the element to which \p it points. \p it must be a valid iterator
+		 * pointing to an element of the table.
+		 *
+		 * Erasing an element invalidates all iterators pointing to elements in the same bucket
+		 * as the erased element.
+		 *
+		 * After the operation has taken place, the size() of the table will be decreased by one.
+		 *
+		 * @param[in] it iterator to the element of the table to be removed.
+		 *
+		 * @return iterator pointing to the element following \p it pior to the element being erased, or end() if
+		 * no such element exists.
+		 */
+		iterator erase(const iterator &it)
+		{
+			piranha_assert(!empty());
+			const auto b_it = _erase(it);
+			iterator retval;
+			if (b_it == local_iterator{}) {
+				retval = first_from<iterator>(this,it.m_idx + 1u);
+			} else {
+				retval = iterator(this,it.m_idx,b_it);
+			}
+			piranha_assert(m_n_elements);
+			--m_n_elements;
+			++m_stamp.second;
+			return retval;
+		}
+		/// Remove all elements.
+		/**
+		 * After this call, size() and bucket_count() will both return zero.
+		 */
+		void clear()
+		{
+			destroy_and_deallocate();
+			m_ctrl = nullptr;
+			m_next = nullptr;
+			m_slots = nullptr;
+			m_log2_size = 0u;
+			m_n_elements = 0u;
+			++m_stamp.second;
+		}
+		/// Swap content.
+		/**
+		 * Will use \p std::swap to swap hasher and equality predicate.
+		 *
+		 * @param[in] other swap argument.
+		 *
+		 * @throws unspecified any exception thrown by swapping hasher or equality predicate via \p std::swap.
+		 */
+		void swap(flat_hash_set &other)
+		{
+			std::swap(m_ctrl,other.m_ctrl);
+			std::swap(m_next,other.m_next);
+			std::swap(m_slots,other.m_slots);
+			std::swap(m_log2_size,other.m_log2_size);
+			std::swap(m_hasher,other.m_hasher);
+			std::swap(m_key_equal,other.m_key_equal);
+			std::swap(m_n_elements,other.m_n_elements);
+			std::swap(m_stamp,other.m_stamp);
+		}
+		/// Rehash table.
+		/**
+		 * Change the number of buckets in the table to at least \p new_size. No rehash is performed
+		 * if rehashing would lead to exceeding the maximum load factor.
+		 *
+		 * @param[in] new_size new desired number of buckets.
+		 *
+		 * @throws unspecified any exception thrown by the constructor from number of buckets
+		 * or by _unique_insert().
+		 */
+		void rehash(const size_type &new_size)
+		{
+			if (!new_size) {
+				if (!size()) {
+					clear();
+				}
+				return;
+			}
+			if (static_cast<double>(size()) / static_cast<double>(new_size) > max_load_factor()) {
+				return;
+			}
+			flat_hash_set new_table(new_size,m_hasher,m_key_equal);
+			try {
+				const auto it_f = _m_end();
+				for (auto it = _m_begin(); it != it_f; ++it) {
+					const std::size_t hash = m_hasher(*it);
+					new_table.unique_insert_impl(std::move(*it),new_table._bucket_from_hash(hash),hash_byte(hash));
+				}
+			} catch (...) {
+				clear();
+				new_table.clear();
+				throw;
+			}
+			// Retain the number of elements and the stamp, as the elements did not change.
+			new_table.m_n_elements = m_n_elements;
+			new_table.m_stamp = m_stamp;
+			clear();
+			*this = std::move(new_table);
+		}
+		/// Get information on the sparsity of the table.
+		/**
+		 * @return \p std::tuple built as follows:
+		 * - position 0: total number of occupied buckets (i.e., buckets storing at least 1 item),
+		 * - position 1: maximum number of items in a single bucket.
+		 */
+		std::tuple<size_type,size_type> evaluate_sparsity() const
+		{
+			size_type n_occupied = 0u, n_max_items = 0u;
+			const auto b_count = bucket_count();
+			for (size_type i = 0u; i < b_count; ++i) {
+				const bucket_type b(bucket_ref(i));
+				if (!b.empty()) {
+					++n_occupied;
+					size_type counter = 0u;
+					for (auto l_it = b.begin(); l_it != b.end(); ++l_it) {
+						++counter;
+					}
+					if (counter > n_max_items) {
+						n_max_items = counter;
+					}
+				}
+			}
+			return std::make_tuple(n_occupied,n_max_items);
+		}
+		/** @name Low-level interface
+		 * Low-level methods and types, with the same semantics as in piranha::hash_set.
+		 */
+		//@{
+		/// Mutable iterator.
+		/**
+		 * This iterator type provides non-const access to the elements of the table. Please note that modifications
+		 * to an existing element of the table might invalidate the relation between the element and its position in the table.
+		 * After such modifications of one or more elements, the only valid operation is flat_hash_set::clear() (destruction of the
+		 * table before calling flat_hash_set::clear() will lead to assertion failures in debug mode).
+		 */
+		typedef iterator_impl<key_type> _m_iterator;
+		/// Mutable begin iterator.
+		/**
+		 * @return flat_hash_set::_m_iterator to the beginning of the table.
+		 */
+		_m_iterator _m_begin()
+		{
+			return first_from<_m_iterator>(this,0u);
+		}
+		/// Mutable end iterator.
+		/**
+		 * @return flat_hash_set::_m_iterator to the end of the table.
+		 */
+		_m_iterator _m_end()
+		{
+			return _m_iterator(this,bucket_count(),local_iterator_impl<T>{});
+		}
+		/// Insert unique element (low-level).
+		/**
+		 * This template is activated only if \p T and \p U are the same type, aside from cv qualifications and references.
+		 * The parameter \p bucket_idx is the index of the destination bucket for \p k and, for a
+		 * table with a nonzero number of buckets, must be equal to the output
+		 * of bucket() before the insertion.
+		 *
+		 * This method will not check if a key equivalent to \p k already exists in the table, it will not
+		 * update the number of elements present in the table after the insertion, it will not resize
+		 * the table in case the maximum load factor is exceeded, nor it will check
+		 * if the value of \p bucket_idx is correct.
+		 *
+		 * @param[in] k object that will be inserted into the table.
+		 * @param[in] bucket_idx destination bucket for \p k.
+		 *
+		 * @return iterator pointing to the newly-inserted element.
+		 *
+		 * @throws unspecified any exception thrown by:
+		 * - flat_hash_set::key_type's copy constructor,
+		 * - the hash functor,
+		 * - memory allocation errors.
+		 */
+		template <typename U>
+		iterator _unique_insert(U &&k, const size_type &bucket_idx,
+			typename std::enable_if<std::is_same<T,typename std::decay<U>::type>::value>::type * = nullptr)
+		{
+			piranha_assert(find(k) == end());
+			piranha_assert(bucket_idx == _bucket(k));
+			const ctrl_type byte = hash_byte(m_hasher(k));
+			return iterator(this,bucket_idx,unique_insert_impl(std::forward<U>(k),bucket_idx,byte));
+		}
+		/// Find element (low-level).
+		/**
+		 * Locate element in the table. The parameter \p bucket_idx is the index of the destination bucket for \p k and, for
+		 * a table with a nonzero number of buckets, must be equal to the output
+		 * of bucket() before the insertion. This method will not check if the value of \p bucket_idx is correct.
+		 *
+		 * @param[in] k element to be located.
+		 * @param[in] bucket_idx index of the destination bucket for \p k.
+		 *
+		 * @return flat_hash_set::iterator to <tt>k</tt>'s position in the table, or end() if \p k is not in the table.
+		 *
+		 * @throws unspecified any exception thrown by:
+		 * - the hash functor,
+		 * - the comparison functor.
+		 */
+		const_iterator _find(const key_type &k, const size_type &bucket_idx) const
+		{
+			piranha_assert(bucket_idx == _bucket(k) && bucket_idx < bucket_count());
+			const auto l_it = find_impl(k,bucket_idx,hash_byte(m_hasher(k)));
+			return (l_it == local_iterator{}) ? end() : const_iterator(this,bucket_idx,l_it);
+		}
+		/// Index of destination bucket from hash value.
+		/**
+		 * Note that this method will not check if the number of buckets is zero.
+		 *
+		 * @param[in] hash input hash value.
+		 *
+		 * @return index of the destination bucket for an object with hash value \p hash.
+		 */
+		size_type _bucket_from_hash(const std::size_t &hash) const
+		{
+			piranha_assert(bucket_count());
+			return hash % (size_type(1u) << m_log2_size);
+		}
+		/// Index of destination bucket (low-level).
+		/**
+		 * Equivalent to bucket(), with the exception that this method will not check
+		 * if the number of buckets is zero.
+		 *
+		 * @param[in] k input argument.
+		 *
+		 * @return index of the destination bucket for \p k.
+		 */
+		size_type _bucket(const key_type &k) const
+		{
+			return _bucket_from_hash(m_hasher(k));
+		}
+		/// Force update of the number of elements.
+		/**
+		 * After this call, size() will return \p new_size regardless of the true number of elements in the table.
+		 *
+		 * @param[in] new_size new table size.
+		 */
+		void _update_size(const size_type &new_size)
+		{
+			m_n_elements = new_size;
+			++m_stamp.second;
+		}
+		/// Modification stamp.
+		/**
+		 * See piranha::hash_set::_stamp().
+		 *
+		 * @return the modification stamp of the table.
+		 */
+		stamp_type _stamp() const
+		{
+			return m_stamp;
+		}
+		/// Increase bucket count.
+		/**
+		 * Increase the number of buckets to the next implementation-defined value.
+		 *
+		 * @throws std::bad_alloc if the operation results in a resize of the table past an implementation-defined
+		 * maximum number of buckets.
+		 * @throws unspecified any exception thrown by rehash().
+		 */
+		void _increase_size()
+		{
+			if (unlikely(m_log2_size >= m_n_nonzero_sizes - 1u)) {
+				piranha_throw(std::bad_alloc,);
+			}
+			piranha_assert(m_ctrl || (!m_ctrl && !m_log2_size));
+			const auto new_log2_size = (m_ctrl) ? (m_log2_size + 1u) : 0u;
+			rehash(size_type(1u) << new_log2_size);
+		}
+		/// Const reference to bucket.
+		/**
+		 * @param[in] idx index of the bucket that will be returned.
+		 *
+		 * @return a view of the bucket positioned at index \p idx, which can be used to iterate over the elements of the bucket
+		 * via its <tt>begin()</tt> and <tt>end()</tt> methods.
+		 */
+		bucket_type _get_bucket_list(const size_type &idx) const
+		{
+			return bucket_type(bucket_ref(idx));
+		}
+		/// Prefetch bucket.
+		/**
+		 * Issue a read prefetch hint for the control word of the bucket positioned at index \p idx. This method
+		 * has no observable effect, and it is meant to hide the latency of a subsequent call to _find() on the same bucket.
+		 *
+		 * @param[in] idx index of the bucket to be prefetched.
+		 */
+		void _prefetch_bucket(const size_type &idx) const
+		{
+			piranha_assert(idx < bucket_count());
+			piranha_prefetch(static_cast<const void *>(m_ctrl + idx));
+		}
+		/// Erase element.
+		/**
+		 * Erase the element to which \p it points. \p it must be a valid iterator
+		 * pointing to an element of the table.
+		 *
+		 * Erasing an element invalidates all iterators pointing to elements in the same bucket
+		 * as the erased element.
+		 *
+		 * This method will not update the number of elements in the table, nor it will try to access elements
+		 * outside the bucket to which \p it refers.
+		 *
+		 * @param[in] it iterator to the element of the table to be removed.
+		 *
+		 * @return local iterator pointing to the element following \p it pior to the element being erased, or local end() if
+		 * no such element exists.
+		 */
+		local_iterator _erase(const iterator &it)
+		{
+			piranha_assert(it.m_set == this);
+			piranha_assert(it.m_idx < bucket_count());
+			piranha_assert(it.m_it != local_iterator{});
+			const group_ref &ref = it.m_it.m_ref;
+			const unsigned slot = it.m_it.m_slot;
+			// Locate the following element before erasing.
+			const local_iterator retval = local_iterator::next(ref,slot);
+			ref.destroy_slot(slot);
+			// Unlink and free an overflow group that became empty.
+			if (!*ref.m_ctrl && ref.m_ctrl != m_ctrl + it.m_idx) {
+				group **link = m_next + it.m_idx;
+				while (&(*link)->m_ctrl != ref.m_ctrl) {
+					link = &(*link)->m_next;
+					piranha_assert(*link);
+				}
+				group *const g = *link;
+				*link = g->m_next;
+				g->m_next = nullptr;
+				::delete g;
+			}
+			return retval;
+		}
+		//@}
+	private:
+		// Run a consistency check on the table, will return false if something is wrong.
+		bool sanity_check() const
+		{
+			if (environment::shutdown()) {
+				return true;
+			}
+			size_type count = 0u;
+			for (size_type i = 0u; i < bucket_count(); ++i) {
+				// Overflow groups must not be empty.
+				for (const group *g = m_next[i]; g; g = g->m_next) {
+					if (!g->m_ctrl) {
+						return false;
+					}
+				}
+				// Each byte of the control word is either zero or a valid hash byte.
+				group_ref ref = bucket_ref(i);
+				while (true) {
+					for (unsigned slot = 0u; slot < group_size; ++slot) {
+						const ctrl_type byte = ref.byte(slot);
+						if (byte && !(byte & 0x80u)) {
+							return false;
+						}
+					}
+					if (!*ref.m_next) {
+						break;
+					}
+					ref = group_ref(*ref.m_next);
+				}
+				const bucket_type b(bucket_ref(i));
+				for (auto it = b.begin(); it != b.end(); ++it) {
+					if (_bucket(*it) != i) {
+						return false;
+					}
+					if (it.m_ref.byte(it.m_slot) != hash_byte(m_hasher(*it))) {
+						return false;
+					}
+					++count;
+				}
+			}
+			if (count != m_n_elements) {
+				return false;
+			}
+			if (m_log2_size >= unsigned(std::numeric_limits<size_type>::digits)) {
+				return false;
+			}
+			if (!m_ctrl && (m_next || m_slots || m_log2_size || m_n_elements)) {
+				return false;
+			}
+			count = 0u;
+			for (auto it = begin(); it != end(); ++it, ++count) {}
+			if (count != m_n_elements) {
+				return false;
+			}
+			if (load_factor() > max_load_factor()) {
+				return false;
+			}
+			return true;
+		}
+		static const size_type m_n_nonzero_sizes = static_cast<size_type>(std::numeric_limits<size_type>::digits);
+		static size_type get_log2_from_hint(const size_type &hint)
+		{
+			piranha_assert(hint);
+			for (size_type i = 0u; i < m_n_nonzero_sizes; ++i) {
+				if ((size_type(1u) << i) >= hint) {
+					return i;
+				}
+			}
+			piranha_throw(std::bad_alloc,);
+		}
+	private:
+		ctrl_type	*m_ctrl;
+		group		**m_next;
+		storage_type	*m_slots;
+		size_type	m_log2_size;
+		hasher		m_hasher;
+		key_equal	m_key_equal;
+		size_type	m_n_elements;
+		stamp_type	m_stamp;
+		static stamp_type new_stamp()
+		{
+			return stamp_type(detail::hash_set_ids<>::next(),0u);
+		}
+};
+
+template <typename T, typename Hash, typename Pred>
+const unsigned flat_hash_set<T,Hash,Pred>::group_size;
+
+template <typename T, typename Hash, typename Pred>
+const typename flat_hash_set<T,Hash,Pred>::ctrl_type flat_hash_set<T,Hash,Pred>::lsb_mask;
+
+template <typename T, typename Hash, typename Pred>
+const typename flat_hash_set<T,Hash,Pred>::ctrl_type flat_hash_set<T,Hash,Pred>::msb_mask;
+
+template <typename T, typename Hash, typename Pred>
+const typename flat_hash_set<T,Hash,Pred>::ctrl_type flat_hash_set<T,Hash,Pred>::low_mask;
+
+template <typename T, typename Hash, typename Pred>
+const typename flat_hash_set<T,Hash,Pred>::size_type flat_hash_set<T,Hash,Pred>::m_n_nonzero_sizes;
+
+}
+
+#endif
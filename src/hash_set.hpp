@@ -23,9 +23,11 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <boost/integer_traits.hpp>
 #include <boost/iterator/iterator_facade.hpp>
 #include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <initializer_list>
 #include <limits>
@@ -45,6 +47,42 @@
 namespace piranha
 {
 
+namespace detail
+{
+
+// Source of the identifiers used in the modification stamps of piranha::hash_set. The identifiers are handed
+// out to the threads in blocks, so that the global counter is seldom accessed. Zero is never handed out.
+template <typename = int>
+struct hash_set_ids
+{
+	static std::uint_least64_t next()
+	{
+		if (unlikely(s_next == s_end)) {
+			s_next = s_global.fetch_add(block_size);
+			s_end = s_next + block_size;
+		}
+		return s_next++;
+	}
+	static const std::uint_least64_t block_size = 1u << 16u;
+	static std::atomic<std::uint_least64_t> s_global;
+	static PIRANHA_TLS std::uint_least64_t s_next;
+	static PIRANHA_TLS std::uint_least64_t s_end;
+};
+
+template <typename T>
+const std::uint_least64_t hash_set_ids<T>::block_size;
+
+template <typename T>
+std::atomic<std::uint_least64_t> hash_set_ids<T>::s_global(1u);
+
+template <typename T>
+PIRANHA_TLS std::uint_least64_t hash_set_ids<T>::s_next = 0u;
+
+template <typename T>
+PIRANHA_TLS std::uint_least64_t hash_set_ids<T>::s_end = 0u;
+
+}
+
 /// Hash set.
 /**
  * Hash set class with interface similar to \p std::unordered_set. The main points of difference with respect to
@@ -61,6 +99,9 @@ namespace piranha
  * An additional set of low-level methods is provided: such methods are suitable for use in high-performance and multi-threaded contexts,
  * and, if misused, could lead to data corruption and other unpredictable errors.
  * 
+ * Each table carries a modification stamp (see _stamp()), which can be used to cache information about the
+ * elements of the table and to detect when such information becomes stale.
+ * 
  * Note that for performance reasons the implementation employs table sizes that are powers of two. Hence, particular care should be taken
  * that the hash function does not exhibit commensurabilities with powers of 2.
  * 
@@ -331,6 +372,12 @@ class hash_set
 		 * Alias for \p std::size_t.
 		 */
 		typedef std::size_t size_type;
+		/// Modification stamp type.
+		/**
+		 * The first member of the pair is an identifier unique to the table, the second member
+		 * is a counter of the modifications applied to the table.
+		 */
+		typedef std::pair<std::uint_least64_t,std::uint_least64_t> stamp_type;
 	private:
 		template <typename Key>
 		class iterator_impl: public boost::iterator_facade<iterator_impl<Key>,Key,boost::forward_traversal_tag>
@@ -452,7 +499,7 @@ class hash_set
 		 * @throws unspecified any exception thrown by the copy constructors of <tt>Hash</tt> or <tt>Pred</tt>.
 		 */
 		hash_set(const hasher &h = hasher(), const key_equal &k = key_equal()):
-			m_container(nullptr),m_log2_size(0u),m_hasher(h),m_key_equal(k),m_n_elements(0u),m_allocator() {}
+			m_container(nullptr),m_log2_size(0u),m_hasher(h),m_key_equal(k),m_n_elements(0u),m_allocator(),m_stamp(new_stamp()) {}
 		/// Constructor from number of buckets.
 		/**
 		 * Will construct a table whose number of buckets is at least equal to \p n_buckets.
@@ -465,7 +512,7 @@ class hash_set
 		 * @throws unspecified any exception thrown by the copy constructors of <tt>Hash</tt> or <tt>Pred</tt>.
 		 */
 		explicit hash_set(const size_type &n_buckets, const hasher &h = hasher(), const key_equal &k = key_equal()):
-			m_container(nullptr),m_log2_size(0u),m_hasher(h),m_key_equal(k),m_n_elements(0u),m_allocator()
+			m_container(nullptr),m_log2_size(0u),m_hasher(h),m_key_equal(k),m_n_elements(0u),m_allocator(),m_stamp(new_stamp())
 		{
 			init_from_n_buckets(n_buckets);
 		}
@@ -478,7 +525,7 @@ class hash_set
 		 */
 		hash_set(const hash_set &other):
 			m_container(nullptr),m_log2_size(0u),m_hasher(other.m_hasher),
-			m_key_equal(other.m_key_equal),m_n_elements(0u),m_allocator(other.m_allocator)
+			m_key_equal(other.m_key_equal),m_n_elements(0u),m_allocator(other.m_allocator),m_stamp(new_stamp())
 		{
 			// Proceed to actual copy only if other has some content.
 			if (other.m_container) {
@@ -518,12 +565,13 @@ class hash_set
 		 */
 		hash_set(hash_set &&other) noexcept(true) : m_container(other.m_container),m_log2_size(other.m_log2_size),
 			m_hasher(std::move(other.m_hasher)),m_key_equal(std::move(other.m_key_equal)),m_n_elements(other.m_n_elements),
-			m_allocator(std::move(other.m_allocator))
+			m_allocator(std::move(other.m_allocator)),m_stamp(other.m_stamp)
 		{
 			// Clear out the other one.
 			other.m_container = nullptr;
 			other.m_log2_size = 0u;
 			other.m_n_elements = 0u;
+			other.m_stamp = new_stamp();
 		}
 		/// Constructor from range.
 		/**
@@ -542,7 +590,7 @@ class hash_set
 		template <typename InputIterator>
 		explicit hash_set(const InputIterator &begin, const InputIterator &end, const size_type &n_buckets = 0u,
 			const hasher &h = hasher(), const key_equal &k = key_equal()):
-			m_container(nullptr),m_log2_size(0u),m_hasher(h),m_key_equal(k),m_n_elements(0u),m_allocator()
+			m_container(nullptr),m_log2_size(0u),m_hasher(h),m_key_equal(k),m_n_elements(0u),m_allocator(),m_stamp(new_stamp())
 		{
 			init_from_n_buckets(n_buckets);
 			for (auto it = begin; it != end; ++it) {
@@ -561,7 +609,7 @@ class hash_set
 		 */
 		template <typename U>
 		explicit hash_set(std::initializer_list<U> list):
-			m_container(nullptr),m_log2_size(0u),m_hasher(),m_key_equal(),m_n_elements(0u),m_allocator()
+			m_container(nullptr),m_log2_size(0u),m_hasher(),m_key_equal(),m_n_elements(0u),m_allocator(),m_stamp(new_stamp())
 		{
 			// We do not care here for possible truncation of list.size(), as this is only an optimization.
 			init_from_n_buckets(static_cast<size_type>(list.size()));
@@ -610,10 +658,12 @@ class hash_set
 				m_key_equal = std::move(other.m_key_equal);
 				m_n_elements = other.m_n_elements;
 				m_allocator = std::move(other.m_allocator);
+				m_stamp = other.m_stamp;
 				// Zero out other.
 				other.m_container = nullptr;
 				other.m_log2_size = 0u;
 				other.m_n_elements = 0u;
+				other.m_stamp = new_stamp();
 			}
 			return *this;
 		}
@@ -802,6 +852,7 @@ class hash_set
 			}
 			const auto it_retval = _unique_insert(std::forward<U>(k),bucket_idx);
 			++m_n_elements;
+			++m_stamp.second;
 			return std::make_pair(it_retval,true);
 		}
 		/// Erase element.
@@ -847,6 +898,7 @@ class hash_set
 			}
 			piranha_assert(m_n_elements);
 			--m_n_elements;
+			++m_stamp.second;
 			return retval;
 		}
 		/// Remove all elements.
@@ -860,6 +912,7 @@ class hash_set
 			m_container = nullptr;
 			m_log2_size = 0u;
 			m_n_elements = 0u;
+			++m_stamp.second;
 		}
 		/// Swap content.
 		/**
@@ -877,6 +930,7 @@ class hash_set
 			std::swap(m_key_equal,other.m_key_equal);
 			std::swap(m_n_elements,other.m_n_elements);
 			std::swap(m_allocator,other.m_allocator);
+			std::swap(m_stamp,other.m_stamp);
 		}
 		/// Rehash table.
 		/**
@@ -915,8 +969,9 @@ class hash_set
 				new_table.clear();
 				throw;
 			}
-			// Retain the number of elements.
+			// Retain the number of elements and the stamp, as the elements did not change.
 			new_table.m_n_elements = m_n_elements;
+			new_table.m_stamp = m_stamp;
 			// Clear the old table.
 			clear();
 			// Assign the new table.
@@ -1088,6 +1143,22 @@ class hash_set
 		void _update_size(const size_type &new_size)
 		{
 			m_n_elements = new_size;
+			++m_stamp.second;
+		}
+		/// Modification stamp.
+		/**
+		 * The stamp is changed by all the methods that can alter the set of elements contained in the table
+		 * (e.g., insert(), erase(), clear(), _update_size()), and it is preserved by rehash() and
+		 * by move operations. A copied table receives a new stamp, different from the stamp of any other table.
+		 * 
+		 * The low-level methods _unique_insert() and _erase() do not change the stamp: it is the responsibility
+		 * of the user to call _update_size() after a sequence of low-level modifications.
+		 * 
+		 * @return the modification stamp of the table.
+		 */
+		stamp_type _stamp() const
+		{
+			return m_stamp;
 		}
 		/// Increase bucket count.
 		/**
@@ -1121,6 +1192,18 @@ class hash_set
 			piranha_assert(idx < bucket_count());
 			return m_container[idx];
 		}
+		/// Prefetch bucket.
+		/**
+		 * Issue a read prefetch hint for the memory of the bucket positioned at index \p idx. This method
+		 * has no observable effect, and it is meant to hide the latency of a subsequent call to _find() on the same bucket.
+		 *
+		 * @param[in] idx index of the bucket to be prefetched.
+		 */
+		void _prefetch_bucket(const size_type &idx) const
+		{
+			piranha_assert(idx < bucket_count());
+			piranha_prefetch(static_cast<const void *>(m_container + idx));
+		}
 		/// Erase element.
 		/**
 		 * Erase the element to which \p it points. \p it must be a valid iterator
@@ -1257,6 +1340,11 @@ class hash_set
 		key_equal	m_key_equal;
 		size_type	m_n_elements;
 		allocator_type	m_allocator;
+		stamp_type	m_stamp;
+		static stamp_type new_stamp()
+		{
+			return stamp_type(detail::hash_set_ids<>::next(),0u);
+		}
 };
 
 template <typename T, typename Hash, typename Pred>
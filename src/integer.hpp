@@ -41,6 +41,7 @@
 #include <vector>
 
 #include "config.hpp" // For (un)likely.
+#include "extended_integer_types.hpp"
 #include "detail/integer_fwd.hpp"
 #include "detail/is_digit.hpp"
 #include "detail/rational_fwd.hpp"
@@ -83,6 +84,11 @@ namespace piranha
  * 
  * \section implementation_details Implementation details
  * 
+ * Values whose magnitude fits in a single GMP limb are stored inline, without any dynamic memory allocation. Arithmetic on such values
+ * is performed directly on the limb, and the object switches transparently to the GMP representation when the result does not fit
+ * in a limb anymore. The inline storage occupies the same space as an \p mpz_t, so that the size of the class is not affected.
+ * The two representations are indistinguishable from the outside, apart from the value returned by allocated_size().
+ * 
  * This class uses, for certain routines, the internal interface of GMP integers, which is not guaranteed to be stable
  * across different versions. GMP versions 4.x and 5.x are explicitly supported by this class.
  * 
@@ -140,6 +146,156 @@ class integer
 			static const bool value = boost::integer_traits<Uint>::const_max <= boost::integer_traits<unsigned long>::const_max &&
 				boost::integer_traits<Uint>::const_min >= boost::integer_traits<unsigned long>::const_min;
 		};
+		// NOTE: the small-value representation assumes that GMP does not use nail bits, and that an unsigned long
+		// fits in a limb.
+		static_assert(GMP_NAIL_BITS == 0,"GMP nail bits are not supported.");
+		static_assert(std::numeric_limits< ::mp_limb_t>::digits == GMP_NUMB_BITS &&
+			std::numeric_limits< ::mp_limb_t>::digits >= std::numeric_limits<unsigned long>::digits,"Unsupported GMP limb type.");
+		// Inline storage for values whose magnitude fits in a single limb: the sign is stored in m_size (-1, 0 or 1),
+		// the magnitude in m_limb. m_tag is always negative, and it shares its position with the allocated size of the mpz struct
+		// (which is never negative), so that the two representations can be told apart via the common initial sequence of the union members.
+		struct small_type
+		{
+			int		m_tag;
+			int		m_size;
+			::mp_limb_t	m_limb;
+		};
+		union storage_type
+		{
+			::__mpz_struct	m_mpz;
+			small_type	m_small;
+		};
+		bool is_small() const
+		{
+			return m_storage.m_small.m_tag < 0;
+		}
+		// Set the inline value. The mpz storage, if any, must have been cleared.
+		void set_small(int size, ::mp_limb_t limb)
+		{
+			piranha_assert(size >= -1 && size <= 1 && (size != 0 || limb == 0u) && (size == 0 || limb != 0u));
+			m_storage.m_small.m_tag = -1;
+			m_storage.m_small.m_size = size;
+			m_storage.m_small.m_limb = limb;
+		}
+		// Switch to mpz storage, preserving the value. Two limbs are allocated, so that the results of single-limb
+		// operations which overflowed can be stored without reallocation.
+		void promote()
+		{
+			piranha_assert(is_small());
+			const small_type s = m_storage.m_small;
+			::mpz_init2(&m_storage.m_mpz,static_cast< ::mp_bitcnt_t>(2 * GMP_NUMB_BITS));
+			if (s.m_size != 0) {
+				m_storage.m_mpz._mp_d[0] = s.m_limb;
+			}
+			m_storage.m_mpz._mp_size = s.m_size;
+		}
+		// Pointer to the mpz storage, for use as output argument in GMP routines.
+		::mpz_ptr get_mpz()
+		{
+			if (is_small()) {
+				promote();
+			}
+			return &m_storage.m_mpz;
+		}
+		// Switch back to inline storage if the value fits in a single limb.
+		void normalise()
+		{
+			if (!is_small() && m_storage.m_mpz._mp_size >= -1 && m_storage.m_mpz._mp_size <= 1) {
+				const int size = m_storage.m_mpz._mp_size;
+				const ::mp_limb_t limb = size ? m_storage.m_mpz._mp_d[0] : ::mp_limb_t(0u);
+				::mpz_clear(&m_storage.m_mpz);
+				set_small(size,limb);
+			}
+		}
+		// Read-only view of an integer as an mpz_t, valid as long as the viewed integer is not modified.
+		class mpz_view
+		{
+			public:
+				explicit mpz_view(const integer &n)
+				{
+					if (n.is_small()) {
+						m_limb = n.m_storage.m_small.m_limb;
+						m_tmp._mp_alloc = 1;
+						m_tmp._mp_size = n.m_storage.m_small.m_size;
+						m_tmp._mp_d = &m_limb;
+						m_ptr = &m_tmp;
+					} else {
+						m_ptr = &n.m_storage.m_mpz;
+					}
+				}
+				mpz_view(const mpz_view &) = delete;
+				mpz_view(mpz_view &&) = delete;
+				mpz_view &operator=(const mpz_view &) = delete;
+				mpz_view &operator=(mpz_view &&) = delete;
+				operator ::mpz_srcptr() const
+				{
+					return m_ptr;
+				}
+			private:
+				::mp_limb_t	m_limb;
+				::__mpz_struct	m_tmp;
+				::mpz_srcptr	m_ptr;
+		};
+		// Product of two limbs. Will return false if the result does not fit in a limb.
+		static bool limb_mul(const ::mp_limb_t &a, const ::mp_limb_t &b, ::mp_limb_t &r)
+		{
+#if defined(PIRANHA_GCC_UINT128_T)
+			if (GMP_NUMB_BITS == 64) {
+				// NOTE: the extension keyword silences pedantic warnings about the 128-bit type.
+				__extension__ typedef PIRANHA_GCC_UINT128_T uint128;
+				const uint128 p = static_cast<uint128>(a) * b;
+				r = static_cast< ::mp_limb_t>(p);
+				return (p >> 64) == 0u;
+			}
+#endif
+			if (a != 0u && b > std::numeric_limits< ::mp_limb_t>::max() / a) {
+				return false;
+			}
+			r = a * b;
+			return true;
+		}
+		// Add to the inline value a value with sign s and magnitude l. Will return false, leaving this unchanged,
+		// if the result does not fit in a limb.
+		bool small_add(int s, const ::mp_limb_t &l)
+		{
+			piranha_assert(is_small());
+			auto &st = m_storage.m_small;
+			if (s == 0) {
+				return true;
+			}
+			if (st.m_size == 0) {
+				st.m_size = s;
+				st.m_limb = l;
+			} else if (st.m_size == s) {
+				const ::mp_limb_t r = st.m_limb + l;
+				if (unlikely(r < l)) {
+					return false;
+				}
+				st.m_limb = r;
+			} else if (st.m_limb > l) {
+				st.m_limb -= l;
+			} else if (st.m_limb < l) {
+				st.m_limb = l - st.m_limb;
+				st.m_size = s;
+			} else {
+				st.m_size = 0;
+				st.m_limb = 0u;
+			}
+			return true;
+		}
+		// Three-way comparison.
+		static int cmp(const integer &n1, const integer &n2)
+		{
+			if (n1.is_small() && n2.is_small()) {
+				const auto &s1 = n1.m_storage.m_small, &s2 = n2.m_storage.m_small;
+				if (s1.m_size != s2.m_size) {
+					return (s1.m_size < s2.m_size) ? -1 : 1;
+				}
+				const int c = (s1.m_limb > s2.m_limb) - (s1.m_limb < s2.m_limb);
+				return (s1.m_size >= 0) ? c : -c;
+			}
+			return ::mpz_cmp(mpz_view(n1),mpz_view(n2));
+		}
 		// Function to check that a floating point number is not pathological, in order to shield GMP
 		// functions.
 		template <typename T>
@@ -171,31 +327,39 @@ class integer
 		{
 			validate_string(str,std::strlen(str));
 			// String is OK.
-			const int retval = ::mpz_init_set_str(m_value,str,10);
+			const int retval = ::mpz_init_set_str(&m_storage.m_mpz,str,10);
 			if (retval == -1) {
 				// Clear it and throw.
-				::mpz_clear(m_value);
+				::mpz_clear(&m_storage.m_mpz);
 				piranha_throw(std::invalid_argument,"invalid string input for integer type");
 			}
 			piranha_assert(retval == 0);
+			normalise();
 		}
 		template <typename T>
 		void construct_from_arithmetic(const T &x, typename std::enable_if<std::is_floating_point<T>::value>::type * = nullptr)
 		{
 			fp_normal_check(x);
-			::mpz_init_set_d(m_value,static_cast<double>(x));
+			::mpz_init_set_d(&m_storage.m_mpz,static_cast<double>(x));
+			normalise();
 		}
 		template <typename T>
 		void construct_from_arithmetic(const T &si, typename std::enable_if<std::is_signed<T>::value &&
 			is_gmp_int<T>::value>::type * = nullptr)
 		{
-			::mpz_init_set_si(m_value,static_cast<long>(si));
+			const long l = static_cast<long>(si);
+			if (l >= 0) {
+				set_small(l != 0,static_cast< ::mp_limb_t>(l));
+			} else {
+				// NOTE: compute the absolute value in unsigned arithmetic, in order to handle the minimum value.
+				set_small(-1,static_cast< ::mp_limb_t>(static_cast<unsigned long>(-(l + 1l)) + 1ul));
+			}
 		}
 		template <typename T>
 		void construct_from_arithmetic(const T &ui, typename std::enable_if<std::is_unsigned<T>::value &&
 			is_gmp_int<T>::value>::type * = nullptr)
 		{
-			::mpz_init_set_ui(m_value,static_cast<unsigned long>(ui));
+			set_small(ui != 0u,static_cast< ::mp_limb_t>(ui));
 		}
 		template <typename T>
 		void construct_from_arithmetic(const T &ll, typename std::enable_if<std::is_integral<T>::value && !is_gmp_int<T>::value>::type * = nullptr)
@@ -207,7 +371,7 @@ class integer
 		{
 			validate_string(str,std::strlen(str));
 			// String is OK.
-			const int retval = ::mpz_set_str(m_value,str,10);
+			const int retval = ::mpz_set_str(&m_storage.m_mpz,str,10);
 			if (retval == -1) {
 				piranha_throw(std::invalid_argument,"invalid string input for integer type");
 			}
@@ -217,19 +381,19 @@ class integer
 		void assign_from_arithmetic(const T &x, typename std::enable_if<std::is_floating_point<T>::value>::type * = nullptr)
 		{
 			fp_normal_check(x);
-			::mpz_set_d(m_value,static_cast<double>(x));
+			::mpz_set_d(&m_storage.m_mpz,static_cast<double>(x));
 		}
 		template <typename T>
 		void assign_from_arithmetic(const T &si, typename std::enable_if<std::is_signed<T>::value &&
 			is_gmp_int<T>::value>::type * = nullptr)
 		{
-			::mpz_set_si(m_value,static_cast<long>(si));
+			::mpz_set_si(&m_storage.m_mpz,static_cast<long>(si));
 		}
 		template <typename T>
 		void assign_from_arithmetic(const T &ui, typename std::enable_if<std::is_unsigned<T>::value &&
 			is_gmp_int<T>::value>::type * = nullptr)
 		{
-			::mpz_set_ui(m_value,static_cast<unsigned long>(ui));
+			::mpz_set_ui(&m_storage.m_mpz,static_cast<unsigned long>(ui));
 		}
 		template <typename T>
 		void assign_from_arithmetic(const T &ll, typename std::enable_if<std::is_integral<T>::value && !is_gmp_int<T>::value>::type * = nullptr)
@@ -241,9 +405,10 @@ class integer
 		typename std::enable_if<std::is_signed<T>::value && is_gmp_int<T>::value &&
 			!std::is_same<T,bool>::value,T>::type convert_to_impl() const
 		{
-			if (::mpz_fits_slong_p(m_value)) {
+			const mpz_view v(*this);
+			if (::mpz_fits_slong_p(v)) {
 				try {
-					return(boost::numeric_cast<T>(::mpz_get_si(m_value)));
+					return(boost::numeric_cast<T>(::mpz_get_si(v)));
 				} catch (const boost::bad_numeric_cast &) {}
 			}
 			piranha_throw(std::overflow_error,"overflow in conversion to integral type");
@@ -252,9 +417,10 @@ class integer
 		typename std::enable_if<std::is_unsigned<T>::value && is_gmp_int<T>::value &&
 			!std::is_same<T,bool>::value,T>::type convert_to_impl() const
 		{
-			if (::mpz_fits_ulong_p(m_value)) {
+			const mpz_view v(*this);
+			if (::mpz_fits_ulong_p(v)) {
 				try {
-					return(boost::numeric_cast<T>(::mpz_get_ui(m_value)));
+					return(boost::numeric_cast<T>(::mpz_get_ui(v)));
 				} catch (const boost::bad_numeric_cast &) {}
 			}
 			piranha_throw(std::overflow_error,"overflow in conversion to integral type");
@@ -271,7 +437,8 @@ class integer
 		template <typename T>
 		typename std::enable_if<std::is_floating_point<T>::value,T>::type convert_to_impl() const
 		{
-			if (::mpz_cmp_d(m_value,static_cast<double>(std::numeric_limits<T>::lowest())) < 0) {
+			const mpz_view v(*this);
+			if (::mpz_cmp_d(v,static_cast<double>(std::numeric_limits<T>::lowest())) < 0) {
 				// NOTE: in order to be able to produce -inf we have to be sure of the following:
 				// - the lowest fp number is negative,
 				// - we can represent _positive_ infinity.
@@ -281,7 +448,7 @@ class integer
 				} else {
 					piranha_throw(std::overflow_error,"cannot convert to floating point type");
 				}
-			} else if (::mpz_cmp_d(m_value,static_cast<double>(std::numeric_limits<T>::max())) > 0) {
+			} else if (::mpz_cmp_d(v,static_cast<double>(std::numeric_limits<T>::max())) > 0) {
 				// NOTE: here we do not have the issues above: if this is greater than the max fp value
 				// (be it positive or not) and we can represent positive inf, then return it.
 				if (std::numeric_limits<T>::has_infinity) {
@@ -294,7 +461,7 @@ class integer
 				// the checks above should keep us safe, but keep this in mind...
 				// NOTE: here the static cast is safe if T is float because we made sure in the checks above that
 				// the GMP value is within the bounds of float.
-				return static_cast<T>(::mpz_get_d(m_value));
+				return static_cast<T>(::mpz_get_d(v));
 			}
 		}
 		// Special handling for bool.
@@ -306,7 +473,11 @@ class integer
 		// In-place addition.
 		void in_place_add(const integer &n)
 		{
-			::mpz_add(m_value,m_value,n.m_value);
+			if (is_small() && n.is_small() && likely(small_add(n.m_storage.m_small.m_size,n.m_storage.m_small.m_limb))) {
+				return;
+			}
+			const auto ptr = get_mpz();
+			::mpz_add(ptr,ptr,mpz_view(n));
 		}
 		void in_place_add(integer &&n)
 		{
@@ -329,7 +500,11 @@ class integer
 		void in_place_add(const T &ui, typename std::enable_if<std::is_unsigned<T>::value &&
 			is_gmp_int<T>::value>::type * = nullptr)
 		{
-			::mpz_add_ui(m_value,m_value,static_cast<unsigned long>(ui));
+			if (is_small() && likely(small_add(ui != 0u,static_cast< ::mp_limb_t>(ui)))) {
+				return;
+			}
+			const auto ptr = get_mpz();
+			::mpz_add_ui(ptr,ptr,static_cast<unsigned long>(ui));
 		}
 		// For non-gmp ints create a temporary integer and add it.
 		template <typename T>
@@ -345,13 +520,17 @@ class integer
 		// In-place subtraction.
 		void in_place_sub(const integer &n)
 		{
-			::mpz_sub(m_value,m_value,n.m_value);
+			if (is_small() && n.is_small() && likely(small_add(-n.m_storage.m_small.m_size,n.m_storage.m_small.m_limb))) {
+				return;
+			}
+			const auto ptr = get_mpz();
+			::mpz_sub(ptr,ptr,mpz_view(n));
 		}
 		void in_place_sub(integer &&n)
 		{
 			if (n.allocated_size() > allocated_size()) {
 				swap(n);
-				::mpz_neg(m_value,m_value);
+				negate();
 				in_place_add(n);
 			} else {
 				in_place_sub(n);
@@ -367,7 +546,11 @@ class integer
 		void in_place_sub(const T &ui, typename std::enable_if<std::is_unsigned<T>::value &&
 			is_gmp_int<T>::value>::type * = nullptr)
 		{
-			::mpz_sub_ui(m_value,m_value,static_cast<unsigned long>(ui));
+			if (is_small() && likely(small_add(-static_cast<int>(ui != 0u),static_cast< ::mp_limb_t>(ui)))) {
+				return;
+			}
+			const auto ptr = get_mpz();
+			::mpz_sub_ui(ptr,ptr,static_cast<unsigned long>(ui));
 		}
 		template <typename T>
 		void in_place_sub(const T &n, typename std::enable_if<std::is_integral<T>::value && !is_gmp_int<T>::value>::type * = nullptr)
@@ -382,7 +565,16 @@ class integer
 		// In-place multiplication.
 		void in_place_mul(const integer &n)
 		{
-			::mpz_mul(m_value,m_value,n.m_value);
+			if (is_small() && n.is_small()) {
+				::mp_limb_t r;
+				if (likely(limb_mul(m_storage.m_small.m_limb,n.m_storage.m_small.m_limb,r))) {
+					m_storage.m_small.m_size *= n.m_storage.m_small.m_size;
+					m_storage.m_small.m_limb = r;
+					return;
+				}
+			}
+			const auto ptr = get_mpz();
+			::mpz_mul(ptr,ptr,mpz_view(n));
 		}
 		void in_place_mul(integer &&n)
 		{
@@ -403,13 +595,21 @@ class integer
 		void in_place_mul(const T &si, typename std::enable_if<std::is_signed<T>::value &&
 			is_gmp_int<T>::value>::type * = nullptr)
 		{
-			::mpz_mul_si(m_value,m_value,static_cast<long>(si));
+			if (is_small()) {
+				in_place_mul(integer(si));
+			} else {
+				::mpz_mul_si(&m_storage.m_mpz,&m_storage.m_mpz,static_cast<long>(si));
+			}
 		}
 		template <typename T>
 		void in_place_mul(const T &ui, typename std::enable_if<std::is_unsigned<T>::value &&
 			is_gmp_int<T>::value>::type * = nullptr)
 		{
-			::mpz_mul_ui(m_value,m_value,static_cast<unsigned long>(ui));
+			if (is_small()) {
+				in_place_mul(integer(ui));
+			} else {
+				::mpz_mul_ui(&m_storage.m_mpz,&m_storage.m_mpz,static_cast<unsigned long>(ui));
+			}
 		}
 		template <typename T>
 		void in_place_mul(const T &n, typename std::enable_if<std::is_integral<T>::value && !is_gmp_int<T>::value>::type * = nullptr)
@@ -424,7 +624,16 @@ class integer
 		// In-place division.
 		void in_place_div(const integer &n)
 		{
-			::mpz_tdiv_q(m_value,m_value,n.m_value);
+			piranha_assert(n.sign() != 0);
+			if (is_small() && n.is_small()) {
+				m_storage.m_small.m_limb /= n.m_storage.m_small.m_limb;
+				m_storage.m_small.m_size = (m_storage.m_small.m_limb == 0u) ? 0 :
+					m_storage.m_small.m_size * n.m_storage.m_small.m_size;
+				return;
+			}
+			const auto ptr = get_mpz();
+			::mpz_tdiv_q(ptr,ptr,mpz_view(n));
+			normalise();
 		}
 		template <typename T>
 		void in_place_div(const T &si, typename std::enable_if<std::is_signed<T>::value &&
@@ -436,7 +645,7 @@ class integer
 		void in_place_div(const T &ui, typename std::enable_if<std::is_unsigned<T>::value &&
 			is_gmp_int<T>::value>::type * = nullptr)
 		{
-			::mpz_tdiv_q_ui(m_value,m_value,static_cast<unsigned long>(ui));
+			in_place_div(integer(ui));
 		}
 		template <typename T>
 		void in_place_div(const T &n, typename std::enable_if<std::is_integral<T>::value && !is_gmp_int<T>::value>::type * = nullptr)
@@ -454,7 +663,18 @@ class integer
 			if (unlikely(n.sign() <= 0)) {
 				piranha_throw(std::invalid_argument,"non-positive divisor");
 			}
-			::mpz_mod(m_value,m_value,n.m_value);
+			if (is_small() && n.is_small()) {
+				const ::mp_limb_t d = n.m_storage.m_small.m_limb;
+				::mp_limb_t r = m_storage.m_small.m_limb % d;
+				if (r != 0u && m_storage.m_small.m_size < 0) {
+					r = d - r;
+				}
+				set_small(r != 0u,r);
+				return;
+			}
+			const auto ptr = get_mpz();
+			::mpz_mod(ptr,ptr,mpz_view(n));
+			normalise();
 		}
 		template <typename T>
 		void in_place_mod(const T &si, typename std::enable_if<std::is_signed<T>::value &&
@@ -469,7 +689,7 @@ class integer
 			if (unlikely(ui == 0u)) {
 				piranha_throw(std::invalid_argument,"non-positive divisor");
 			}
-			*this = ::mpz_fdiv_ui(m_value,static_cast<unsigned long>(ui));
+			in_place_mod(integer(ui));
 		}
 		template <typename T>
 		void in_place_mod(const T &n, typename std::enable_if<std::is_integral<T>::value && !is_gmp_int<T>::value>::type * = nullptr)
@@ -508,6 +728,10 @@ class integer
 			std::is_same<typename std::decay<T>::type,integer>::value && std::is_same<typename std::decay<U>::type,integer>::value
 			>::type * = nullptr)
 		{
+			// Values stored inline do not need any allocation.
+			if (n1.is_small() && n2.is_small()) {
+				return binary_plus_fwd_first(n1,n2);
+			}
 			const auto a1 = n1.allocated_size(), a2 = n2.allocated_size();
 			const std::size_t target_size = std::max<std::size_t>(n1.size(),n2.size()) + std::size_t(1);
 			if (is_nonconst_rvalue_ref<T &&>::value && is_nonconst_rvalue_ref<U &&>::value) {
@@ -581,6 +805,10 @@ class integer
 			std::is_same<typename std::decay<T>::type,integer>::value && std::is_same<typename std::decay<U>::type,integer>::value
 			>::type * = nullptr)
 		{
+			// Values stored inline do not need any allocation.
+			if (n1.is_small() && n2.is_small()) {
+				return binary_minus_fwd_first<true>(n1,n2);
+			}
 			const auto a1 = n1.allocated_size(), a2 = n2.allocated_size();
 			const std::size_t target_size = std::max<std::size_t>(n1.size(),n2.size()) + std::size_t(1);
 			if (is_nonconst_rvalue_ref<T &&>::value && is_nonconst_rvalue_ref<U &&>::value) {
@@ -661,6 +889,10 @@ class integer
 			std::is_same<typename std::decay<U>::type,integer>::value
 			>::type * = nullptr)
 		{
+			// Values stored inline do not need any allocation.
+			if (n1.is_small() && n2.is_small()) {
+				return binary_mul_fwd_first(n1,n2);
+			}
 			const auto a1 = n1.allocated_size(), a2 = n2.allocated_size();
 			const std::size_t s1 = n1.size(), s2 = n2.size(), target_size = s1 + s2 + std::size_t(1);
 			// Condition for stealing: one integer has size 1 and the other has allocated enough space.
@@ -690,7 +922,7 @@ class integer
 		static integer binary_mul_new(const integer &n1, const integer &n2, const std::size_t &target_size)
 		{
 			integer retval{nlimbs(target_size)};
-			::mpz_mul(retval.m_value,n1.m_value,n2.m_value);
+			::mpz_mul(&retval.m_storage.m_mpz,mpz_view(n1),mpz_view(n2));
 			return retval;
 		}
 		template <typename T>
@@ -780,19 +1012,19 @@ class integer
 		// Binary equality.
 		static bool binary_equality(const integer &n1, const integer &n2)
 		{
-			return (::mpz_cmp(n1.m_value,n2.m_value) == 0);
+			return (cmp(n1,n2) == 0);
 		}
 		template <typename T>
 		static bool binary_equality(const integer &n1, const T &n2, typename std::enable_if<std::is_signed<T>::value &&
 			is_gmp_int<T>::value>::type * = nullptr)
 		{
-			return (mpz_cmp_si(n1.m_value,static_cast<long>(n2)) == 0);
+			return (cmp(n1,integer(n2)) == 0);
 		}
 		template <typename T>
 		static bool binary_equality(const integer &n1, const T &n2, typename std::enable_if<std::is_unsigned<T>::value &&
 			is_gmp_int<T>::value>::type * = nullptr)
 		{
-			return (mpz_cmp_ui(n1.m_value,static_cast<unsigned long>(n2)) == 0);
+			return (cmp(n1,integer(n2)) == 0);
 		}
 		template <typename T>
 		static bool binary_equality(const integer &n1, const T &n2, typename std::enable_if<std::is_integral<T>::value &&
@@ -814,19 +1046,19 @@ class integer
 		// Binary less-than.
 		static bool binary_less_than(const integer &n1, const integer &n2)
 		{
-			return (::mpz_cmp(n1.m_value,n2.m_value) < 0);
+			return (cmp(n1,n2) < 0);
 		}
 		template <typename T>
 		static bool binary_less_than(const integer &n1, const T &n2, typename std::enable_if<std::is_signed<T>::value &&
 			is_gmp_int<T>::value>::type * = nullptr)
 		{
-			return (mpz_cmp_si(n1.m_value,static_cast<long>(n2)) < 0);
+			return (cmp(n1,integer(n2)) < 0);
 		}
 		template <typename T>
 		static bool binary_less_than(const integer &n1, const T &n2, typename std::enable_if<std::is_unsigned<T>::value &&
 			is_gmp_int<T>::value>::type * = nullptr)
 		{
-			return (mpz_cmp_ui(n1.m_value,static_cast<unsigned long>(n2)) < 0);
+			return (cmp(n1,integer(n2)) < 0);
 		}
 		template <typename T>
 		static bool binary_less_than(const integer &n1, const T &n2, typename std::enable_if<std::is_integral<T>::value &&
@@ -842,19 +1074,19 @@ class integer
 		// Binary less-than or equal.
 		static bool binary_leq(const integer &n1, const integer &n2)
 		{
-			return (::mpz_cmp(n1.m_value,n2.m_value) <= 0);
+			return (cmp(n1,n2) <= 0);
 		}
 		template <typename T>
 		static bool binary_leq(const integer &n1, const T &n2, typename std::enable_if<std::is_signed<T>::value &&
 			is_gmp_int<T>::value>::type * = nullptr)
 		{
-			return (mpz_cmp_si(n1.m_value,static_cast<long>(n2)) <= 0);
+			return (cmp(n1,integer(n2)) <= 0);
 		}
 		template <typename T>
 		static bool binary_leq(const integer &n1, const T &n2, typename std::enable_if<std::is_unsigned<T>::value &&
 			is_gmp_int<T>::value>::type * = nullptr)
 		{
-			return (mpz_cmp_ui(n1.m_value,static_cast<unsigned long>(n2)) <= 0);
+			return (cmp(n1,integer(n2)) <= 0);
 		}
 		template <typename T>
 		static bool binary_leq(const integer &n1, const T &n2, typename std::enable_if<std::is_integral<T>::value &&
@@ -889,7 +1121,8 @@ class integer
 				piranha_throw(std::invalid_argument,"invalid argument for integer exponentiation");
 			}
 			integer retval;
-			::mpz_pow_ui(retval.m_value,m_value,exp);
+			::mpz_pow_ui(retval.get_mpz(),mpz_view(*this),exp);
+			retval.normalise();
 			return retval;
 		}
 		template <typename T>
@@ -914,7 +1147,15 @@ class integer
 		// Private constructor for use in rational.
 		explicit integer(const ::mpz_t n)
 		{
-			::mpz_init_set(m_value,n);
+			construct_from_mpz(n);
+		}
+		void construct_from_mpz(::mpz_srcptr n)
+		{
+			if (n->_mp_size >= -1 && n->_mp_size <= 1) {
+				set_small(n->_mp_size,n->_mp_size ? n->_mp_d[0] : ::mp_limb_t(0u));
+			} else {
+				::mpz_init_set(&m_storage.m_mpz,n);
+			}
 		}
 		static std::size_t hash_mpz_t(const ::mpz_t n)
 		{
@@ -963,7 +1204,7 @@ class integer
 		 */
 		integer()
 		{
-			::mpz_init(m_value);
+			set_small(0,0u);
 		}
 		/// Class for the representation of the number of limbs in a piranha::integer.
 		/**
@@ -1012,7 +1253,7 @@ class integer
 		explicit integer(const nlimbs &n)
 		{
 			// NOTE: use unsigned types everywhere, so that in case of overflow we just allocate a different amount of memory.
-			::mpz_init2(m_value,static_cast< ::mp_bitcnt_t>(
+			::mpz_init2(&m_storage.m_mpz,static_cast< ::mp_bitcnt_t>(
 				n.m_n * std::make_unsigned<decltype(::mp_bits_per_limb)>::type(::mp_bits_per_limb)));
 		}
 		/// Copy constructor.
@@ -1021,7 +1262,12 @@ class integer
 		 */
 		integer(const integer &other)
 		{
-			::mpz_init_set(m_value,other.m_value);
+			if (other.is_small()) {
+				m_storage.m_small = other.m_storage.m_small;
+			} else {
+				// NOTE: this will demote to inline storage if possible.
+				construct_from_mpz(&other.m_storage.m_mpz);
+			}
 		}
 		/// Move constructor.
 		/**
@@ -1029,13 +1275,9 @@ class integer
 		 */
 		integer(integer &&other) noexcept(true)
 		{
-			m_value->_mp_size = other.m_value->_mp_size;
-			m_value->_mp_d = other.m_value->_mp_d;
-			m_value->_mp_alloc = other.m_value->_mp_alloc;
-			// Erase other.
-			other.m_value->_mp_size = 0;
-			other.m_value->_mp_d = nullptr;
-			other.m_value->_mp_alloc = 0;
+			m_storage = other.m_storage;
+			// Reset other to zero.
+			other.set_small(0,0u);
 		}
 		/// Generic constructor.
 		/**
@@ -1103,12 +1345,13 @@ class integer
 		integer &operator=(const integer &other)
 		{
 			if (likely(this != &other)) {
-				// Handle assignment to moved-from objects.
-				if (m_value->_mp_d) {
-					::mpz_set(m_value,other.m_value);
+				// NOTE: if this already has allocated storage, re-use it.
+				if (!is_small()) {
+					::mpz_set(&m_storage.m_mpz,mpz_view(other));
+				} else if (other.is_small()) {
+					m_storage.m_small = other.m_storage.m_small;
 				} else {
-					piranha_assert(m_value->_mp_size == 0 && m_value->_mp_alloc == 0);
-					::mpz_init_set(m_value,other.m_value);
+					::mpz_init_set(&m_storage.m_mpz,&other.m_storage.m_mpz);
 				}
 			}
 			return *this;
@@ -1137,10 +1380,9 @@ class integer
 		 */
 		integer &operator=(const char *str)
 		{
-			if (m_value->_mp_d) {
+			if (!is_small()) {
 				assign_from_string(str);
 			} else {
-				piranha_assert(m_value->_mp_size == 0 && m_value->_mp_alloc == 0);
 				construct_from_string(str);
 			}
 			return *this;
@@ -1161,10 +1403,9 @@ class integer
 		template <typename T>
 		typename std::enable_if<is_interop_type<T>::value,integer &>::type operator=(const T &x)
 		{
-			if (m_value->_mp_d) {
+			if (!is_small()) {
 				assign_from_arithmetic(x);
 			} else {
-				piranha_assert(m_value->_mp_size == 0 && m_value->_mp_alloc == 0);
 				construct_from_arithmetic(x);
 			}
 			return *this;
@@ -1180,7 +1421,7 @@ class integer
 			if (unlikely(this == &n)) {
 			    return;
 			}
-			swap_mpz_t(m_value,n.m_value);
+			std::swap(m_storage,n.m_storage);
 		}
 		/// Conversion to interoperable types.
 		/**
@@ -1370,7 +1611,11 @@ class integer
 		 */
 		void negate()
 		{
-			::mpz_neg(m_value,m_value);
+			if (is_small()) {
+				m_storage.m_small.m_size = -m_storage.m_small.m_size;
+			} else {
+				::mpz_neg(&m_storage.m_mpz,&m_storage.m_mpz);
+			}
 		}
 		/// Negated copy.
 		/**
@@ -1705,7 +1950,16 @@ class integer
 		 */
 		integer &multiply_accumulate(const integer &n1, const integer &n2)
 		{
-			::mpz_addmul(m_value,n1.m_value,n2.m_value);
+			if (is_small() && n1.is_small() && n2.is_small()) {
+				::mp_limb_t r;
+				if (likely(limb_mul(n1.m_storage.m_small.m_limb,n2.m_storage.m_small.m_limb,r) &&
+					small_add(n1.m_storage.m_small.m_size * n2.m_storage.m_small.m_size,r)))
+				{
+					return *this;
+				}
+			}
+			const auto ptr = get_mpz();
+			::mpz_addmul(ptr,mpz_view(n1),mpz_view(n2));
 			return *this;
 		}
 		/// Exponentiation.
@@ -1736,7 +1990,11 @@ class integer
 		integer abs() const
 		{
 			integer retval(*this);
-			::mpz_abs(retval.m_value,retval.m_value);
+			if (retval.is_small()) {
+				retval.m_storage.m_small.m_size = (retval.m_storage.m_small.m_size != 0);
+			} else {
+				::mpz_abs(&retval.m_storage.m_mpz,&retval.m_storage.m_mpz);
+			}
 			return retval;
 		}
 		/// Compute next prime number.
@@ -1753,7 +2011,8 @@ class integer
 				piranha_throw(std::invalid_argument,"cannot compute the next prime of a negative number");
 			}
 			integer retval;
-			::mpz_nextprime(retval.m_value,m_value);
+			::mpz_nextprime(retval.get_mpz(),mpz_view(*this));
+			retval.normalise();
 			return retval;
 		}
 		/// Check if \p this is a prime number
@@ -1771,7 +2030,7 @@ class integer
 			if (unlikely(reps < 0)) {
 				piranha_throw(std::invalid_argument,"invalid number of primality tests");
 			}
-			return ::mpz_probab_prime_p(m_value,reps);
+			return ::mpz_probab_prime_p(mpz_view(*this),reps);
 		}
 		/// Integer square root.
 		/**
@@ -1784,14 +2043,15 @@ class integer
 			if (unlikely(sign() < 0)) {
 				piranha_throw(std::invalid_argument,"cannot calculate square root of negative integer");
 			}
-			integer retval(*this);
-			::mpz_sqrt(retval.m_value,m_value);
+			integer retval;
+			::mpz_sqrt(retval.get_mpz(),mpz_view(*this));
+			retval.normalise();
 			return retval;
 		}
 		/// Hash value.
 		/**
-		 * The value is calculated via \p boost::hash_combine over the limbs of the internal \p mpz_t type. The sign of \p this
-		 * is used as initial seed value.
+		 * The value is calculated via \p boost::hash_combine over the limbs of the absolute value of \p this. The sign of \p this
+		 * is used as initial seed value. The hash value does not depend on the internal representation of \p this.
 		 * 
 		 * @return a hash value for \p this.
 		 * 
@@ -1799,7 +2059,14 @@ class integer
 		 */
 		std::size_t hash() const
 		{
-			return hash_mpz_t(m_value);
+			if (is_small()) {
+				std::size_t retval = static_cast<std::size_t>(m_storage.m_small.m_size);
+				if (m_storage.m_small.m_size != 0) {
+					boost::hash_combine(retval,m_storage.m_small.m_limb);
+				}
+				return retval;
+			}
+			return hash_mpz_t(&m_storage.m_mpz);
 		}
 		/// Integer size.
 		/**
@@ -1807,17 +2074,21 @@ class integer
 		 */
 		std::size_t size() const
 		{
-			return ::mpz_size(m_value);
+			if (is_small()) {
+				return static_cast<std::size_t>(m_storage.m_small.m_size != 0);
+			}
+			return ::mpz_size(&m_storage.m_mpz);
 		}
 		/// Number of allocated limbs.
 		/**
-		 * @return number of GMP limbs currently allocated in \p this. The return type is the unsigned counterpart of the integer
+		 * @return number of GMP limbs currently allocated in \p this, or zero if the value of \p this is stored inline
+		 * (see the implementation details of piranha::integer). The return type is the unsigned counterpart of the integer
 		 * type used to represent the allocated size in GMP's integer type.
 		 */
 		auto allocated_size() const -> typename std::decay<std::make_unsigned<decltype(std::declval< ::mpz_t>()->_mp_alloc)>::type>::type
 		{
 			typedef typename std::decay<std::make_unsigned<decltype(std::declval< ::mpz_t>()->_mp_alloc)>::type>::type return_type;
-			return return_type(m_value->_mp_alloc);
+			return is_small() ? return_type(0u) : return_type(m_storage.m_mpz._mp_alloc);
 		}
 		/// Sign.
 		/**
@@ -1825,7 +2096,10 @@ class integer
 		 */
 		int sign() const
 		{
-			return mpz_sgn(m_value);
+			if (is_small()) {
+				return m_storage.m_small.m_size;
+			}
+			return mpz_sgn(&m_storage.m_mpz);
 		}
 		/// Factorial.
 		/**
@@ -1841,7 +2115,8 @@ class integer
 				piranha_throw(std::invalid_argument,"invalid input for factorial()");
 			}
 			integer retval;
-			::mpz_fac_ui(retval.m_value,static_cast<unsigned long>(*this));
+			::mpz_fac_ui(retval.get_mpz(),static_cast<unsigned long>(*this));
+			retval.normalise();
 			return retval;
 		}
 		/// Binomial coefficient.
@@ -1862,7 +2137,8 @@ class integer
 			std::is_same<integer,T>::value>::type * = nullptr) const
 		{
 			integer retval;
-			::mpz_bin_ui(retval.m_value,m_value,check_choose_k(k));
+			::mpz_bin_ui(retval.get_mpz(),mpz_view(*this),check_choose_k(k));
+			retval.normalise();
 			return retval;
 		}
 		/// Overload output stream operator for piranha::integer.
@@ -1877,7 +2153,8 @@ class integer
 		 */
 		friend std::ostream &operator<<(std::ostream &os, const integer &n)
 		{
-			const std::size_t size_base10 = ::mpz_sizeinbase(n.m_value,10);
+			const mpz_view v(n);
+			const std::size_t size_base10 = ::mpz_sizeinbase(v,10);
 			if (size_base10 > boost::integer_traits<std::size_t>::const_max - static_cast<std::size_t>(2)) {
 				piranha_throw(std::overflow_error,"number of digits is too large");
 			}
@@ -1888,7 +2165,7 @@ class integer
 			if (tmp.size() != total_size) {
 				piranha_throw(std::overflow_error,"number of digits is too large");
 			}
-			os << ::mpz_get_str(&tmp[0u],10,n.m_value);
+			os << ::mpz_get_str(&tmp[0u],10,v);
 			return os;
 		}
 		/// Overload input stream operator for piranha::integer.
@@ -1910,7 +2187,7 @@ class integer
 			return is;
 		}
 	private:
-		::mpz_t m_value;
+		storage_type m_storage;
 };
 
 
@@ -2324,11 +2601,9 @@ struct binomial_impl<T,U,typename std::enable_if<std::is_integral<T>::value && s
 inline integer::~integer() noexcept(true)
 {
 	PIRANHA_TT_CHECK(is_cf,integer);
-	piranha_assert(m_value->_mp_alloc >= 0);
-	if (m_value->_mp_d != 0) {
-		::mpz_clear(m_value);
-	} else {
-		piranha_assert(m_value->_mp_size == 0 && m_value->_mp_alloc == 0);
+	if (!is_small()) {
+		piranha_assert(m_storage.m_mpz._mp_d != nullptr);
+		::mpz_clear(&m_storage.m_mpz);
 	}
 }
 
@@ -40,6 +40,7 @@
 
 #include "config.hpp"
 #include "detail/degree_commons.hpp"
+#include "detail/key_metadata.hpp"
 #include "detail/km_commons.hpp"
 #include "detail/prepare_for_print.hpp"
 #include "exceptions.hpp"
@@ -205,6 +206,37 @@ class kronecker_monomial
 				piranha_throw(std::invalid_argument,"incompatible arguments");
 			}
 		}
+		/// Converting constructor from a monomial with a different integer type.
+		/**
+		 * \note
+		 * This constructor is enabled only if \p U is not the same type as \p T.
+		 *
+		 * This constructor allows to change the width of the Kronecker code of a monomial (e.g., to widen
+		 * the keys of a series whose exponents would overflow the limits of piranha::kronecker_array for the
+		 * original type, or to narrow the keys of a small problem in order to reduce memory usage).
+		 * The exponents of \p other are decoded, converted to \p T via \p boost::numeric_cast and encoded again.
+		 *
+		 * @param[in] other construction argument.
+		 * @param[in] args reference set of piranha::symbol.
+		 *
+		 * @throws std::invalid_argument if \p other is not compatible with \p args.
+		 * @throws unspecified any exception thrown by:
+		 * - piranha::kronecker_monomial::unpack(),
+		 * - piranha::kronecker_array::encode() (e.g., if the exponents do not fit in the limits for type \p T),
+		 * - \p boost::numeric_cast,
+		 * - piranha::static_vector::push_back().
+		 */
+		template <typename U, typename = typename std::enable_if<!std::is_same<U,value_type>::value>::type>
+		explicit kronecker_monomial(const kronecker_monomial<U> &other, const symbol_set &args):m_value(0)
+		{
+			if (unlikely(!other.is_compatible(args))) {
+				piranha_throw(std::invalid_argument,"incompatible arguments");
+			}
+			const auto tmp = other.unpack(args);
+			v_type v;
+			std::transform(tmp.begin(),tmp.end(),std::back_inserter(v),[](const U &n) {return boost::numeric_cast<value_type>(n);});
+			m_value = ka::encode(v);
+		}
 		/// Constructor from \p value_type.
 		/**
 		 * This constructor will initialise the internal integer instance
@@ -834,6 +866,38 @@ class kronecker_monomial
 		value_type m_value;
 };
 
+namespace detail
+{
+
+// Key metadata for Kronecker monomials: exponent bounds and distribution of the total degree.
+template <typename T>
+struct key_metadata<kronecker_monomial<T>>: km_key_metadata<T,1u>
+{
+	static const bool has_degree = true;
+	void add(const kronecker_monomial<T> &k, const symbol_set &args)
+	{
+		const auto v = k.unpack(args);
+		this->add_exponents(v,{{monomial_degree<T>(v,km_safe_adder<T>,args)}});
+	}
+	void remove(const kronecker_monomial<T> &k, const symbol_set &args)
+	{
+		this->remove_degrees({{k.degree(args)}});
+	}
+	T degree() const
+	{
+		return this->template extremum<0u,false>();
+	}
+	T ldegree() const
+	{
+		return this->template extremum<0u,true>();
+	}
+};
+
+template <typename T>
+const bool key_metadata<kronecker_monomial<T>>::has_degree;
+
+}
+
 }
 
 namespace std
@@ -135,6 +135,7 @@ namespace detail {}
 #include "environment.hpp"
 #include "exceptions.hpp"
 #include "extended_integer_types.hpp"
+#include "flat_hash_set.hpp"
 #include "hash_set.hpp"
 #include "integer.hpp"
 #include "kronecker_array.hpp"
@@ -22,8 +22,16 @@
 #define PIRANHA_POISSON_SERIES_HPP
 
 #include <algorithm>
+#include <atomic>
+#include <boost/integer_traits.hpp>
+#include <boost/numeric/conversion/cast.hpp>
+#include <cmath>
+#include <cstddef>
+#include <iterator>
+#include <numeric>
 #include <stdexcept>
 #include <string>
+#include <tuple>
 #include <type_traits>
 #include <utility>
 #include <vector>
@@ -31,12 +39,16 @@
 #include "config.hpp"
 #include "detail/poisson_series_fwd.hpp"
 #include "detail/polynomial_fwd.hpp"
+#include "exceptions.hpp"
 #include "forwarding.hpp"
 #include "integer.hpp"
+#include "kronecker_array.hpp"
 #include "math.hpp"
 #include "poisson_series_term.hpp"
 #include "power_series.hpp"
+#include "real_trigonometric_kronecker_monomial.hpp"
 #include "series.hpp"
+#include "series_multiplier.hpp"
 #include "symbol.hpp"
 #include "symbol_set.hpp"
 #include "t_substitutable_series.hpp"
@@ -421,6 +433,533 @@ class poisson_series:
 		}
 };
 
+namespace detail
+{
+
+template <typename Series1, typename Series2>
+struct poisson_kronecker_enabler
+{
+	PIRANHA_TT_CHECK(is_series,Series1);
+	PIRANHA_TT_CHECK(is_series,Series2);
+	template <typename Key1, typename Key2>
+	struct are_same_rtkm
+	{
+		static const bool value = false;
+	};
+	template <typename T>
+	struct are_same_rtkm<real_trigonometric_kronecker_monomial<T>,real_trigonometric_kronecker_monomial<T>>
+	{
+		static const bool value = true;
+	};
+	typedef typename Series1::term_type::key_type key_type1;
+	typedef typename Series2::term_type::key_type key_type2;
+	static const bool value = is_instance_of<Series1,poisson_series>::value && is_instance_of<Series2,poisson_series>::value &&
+		are_same_rtkm<key_type1,key_type2>::value;
+};
+
+}
+
+/// Series multiplier specialisation for Poisson series.
+/**
+ * This specialisation of piranha::series_multiplier is enabled when both \p Series1 and \p Series2 are instances of
+ * piranha::poisson_series with trigonometric monomials represented as piranha::real_trigonometric_kronecker_monomial of the same type.
+ * 
+ * The multiplier operates directly on the Kronecker codes of the monomials: the codes of the sum and of the difference of the multipliers
+ * of two monomials are the sum and the difference of the codes, and the sign of the first nonzero multiplier (which determines whether the
+ * result has to be canonicalised) is extracted from the code without decoding all the multipliers. In multi-threaded mode,
+ * the work is partitioned according to the buckets of the output hash set, so that each bucket is written by a single thread.
+ * 
+ * \section exception_safety Exception safety guarantee
+ * 
+ * This class provides the same guarantee as the non-specialised piranha::series_multiplier.
+ * 
+ * \section move_semantics Move semantics
+ * 
+ * Move semantics is equivalent to piranha::series_multiplier's move semantics.
+ */
+template <typename Series1, typename Series2>
+class series_multiplier<Series1,Series2,typename std::enable_if<detail::poisson_kronecker_enabler<Series1,Series2>::value>::type>:
+	public series_multiplier<Series1,Series2,int>
+{
+		PIRANHA_TT_CHECK(is_series,Series1);
+		PIRANHA_TT_CHECK(is_series,Series2);
+		typedef typename Series1::term_type::key_type::value_type value_type;
+		typedef kronecker_array<value_type> ka;
+	public:
+		/// Base multiplier type.
+		typedef series_multiplier<Series1,Series2,int> base;
+		/// Alias for term type of \p Series1.
+		typedef typename Series1::term_type term_type1;
+		/// Alias for term type of \p Series2.
+		typedef typename Series2::term_type term_type2;
+		/// Alias for the return type.
+		typedef typename base::return_type return_type;
+		/// Constructor.
+		/**
+		 * Will call the base constructor and additionally check that the multipliers of the trigonometric monomials
+		 * resulting from the multiplication are within the representation limits of piranha::real_trigonometric_kronecker_monomial.
+		 * If they are not, the multiplication will be performed by the non-specialised piranha::series_multiplier.
+		 * The bounds of the multipliers of the operands are read from their cached key metadata, if available.
+		 * 
+		 * @param[in] s1 first series operand.
+		 * @param[in] s2 second series operand.
+		 * 
+		 * @throws unspecified any exception thrown by:
+		 * - the base constructor,
+		 * - piranha::real_trigonometric_kronecker_monomial::unpack(),
+		 * - memory allocation errors in standard containers,
+		 * - the arithmetic operators of piranha::integer.
+		 */
+		explicit series_multiplier(const Series1 &s1, const Series2 &s2):base(s1,s2),m_codes_ok(false)
+		{
+			if (unlikely(this->m_s1->empty() || this->m_s2->empty())) {
+				return;
+			}
+			const auto &args = this->m_s1->m_symbol_set;
+			piranha_assert(args.size() < ka::get_limits().size());
+			const auto &minmax_vec = std::get<0u>(ka::get_limits()[args.size()]);
+			// Maximum absolute values of the multipliers in the two operands. They are taken from the cached key metadata
+			// of the operands if possible. The cached bounds might be conservative, in which case we re-examine the
+			// operands before giving up on the multiplication via codes.
+			bool exact1, exact2;
+			auto max1 = operand_max_abs(*this->m_s1,this->m_v1,true,exact1), max2 = operand_max_abs(*this->m_s2,this->m_v2,true,exact2);
+			// The multipliers of the result are sums and differences of the multipliers of the operands, and they
+			// are representable if they are within the (symmetric) bounds of the Kronecker codification.
+			auto check = [&max1,&max2,&minmax_vec]() -> bool {
+				for (decltype(max1.size()) i = 0u; i < max1.size(); ++i) {
+					if (max1[i] + max2[i] > integer(minmax_vec[i])) {
+						return false;
+					}
+				}
+				return true;
+			};
+			if (!check()) {
+				if (exact1 && exact2) {
+					return;
+				}
+				if (!exact1) {
+					max1 = operand_max_abs(*this->m_s1,this->m_v1,false,exact1);
+				}
+				if (!exact2) {
+					max2 = operand_max_abs(*this->m_s2,this->m_v2,false,exact2);
+				}
+				if (!check()) {
+					return;
+				}
+			}
+			// Bounds of the multipliers of the result, recorded in its key metadata.
+			for (decltype(max1.size()) i = 0u; i < max1.size(); ++i) {
+				m_result_max.push_back(static_cast<value_type>(max1[i] + max2[i]));
+				m_result_min.push_back(static_cast<value_type>(-m_result_max.back()));
+			}
+			// Cache the moduli used in the extraction of the sign of the first nonzero multiplier.
+			for (decltype(minmax_vec.size()) i = 0u; i < args.size(); ++i) {
+				m_half_moduli.push_back(static_cast<value_type>(minmax_vec[i]));
+				m_moduli.push_back(static_cast<value_type>(minmax_vec[i] * 2 + 1));
+			}
+			m_codes_ok = true;
+		}
+		/// Perform multiplication.
+		/**
+		 * If the multipliers of the result are within the representation limits and no piranha::degree_truncation policy
+		 * is active, the multiplication will be performed on the Kronecker codes as explained in the class description.
+		 * Otherwise, piranha::series_multiplier::execute() will be used.
+		 * In the former case, the bounds of the multipliers of the result, deduced from the bounds of the operands, are
+		 * recorded in the key metadata of the result.
+		 * 
+		 * @return the result of the multiplication of the input series operands.
+		 * 
+		 * @throws unspecified any exception thrown by:
+		 * - (unlikely) conversion errors between numeric types,
+		 * - the public interface of piranha::hash_set,
+		 * - piranha::series_multiplier::execute(),
+		 * - piranha::series_multiplier::final_size_estimate(),
+		 * - piranha::series_multiplier::blocked_multiplication(),
+		 * - piranha::series_multiplier::sanitize_series(),
+		 * - the arithmetic operators of the coefficient types.
+		 */
+		return_type operator()() const
+		{
+			if (!m_codes_ok || this->m_truncation.get_mode() != 0) {
+				return base::template execute<typename base::default_functor>();
+			}
+			auto retval = execute();
+			if (!retval.empty()) {
+				typename return_type::key_metadata_type md;
+				md.set_bounds(m_result_min,m_result_max);
+				retval.set_key_metadata(std::move(md));
+			}
+			return retval;
+		}
+	private:
+		typedef typename std::vector<term_type1 const *>::size_type index_type;
+		typedef typename Series1::size_type bucket_size_type;
+		// Maximum absolute values of the multipliers in the operand s, whose terms are in v. If use_metadata
+		// is true, the values are taken from the cached key metadata of s when possible, and exact is set to false
+		// if the values are conservative.
+		template <typename Series, typename Term>
+		static std::vector<integer> operand_max_abs(const Series &s, const std::vector<Term const *> &v, bool use_metadata, bool &exact)
+		{
+			const auto &args = s.m_symbol_set;
+			std::vector<integer> retval(args.size(),integer(0));
+			const auto md = use_metadata ? s.cached_key_metadata() : nullptr;
+			if (md && md->m_has_bounds && md->m_min.size() == args.size()) {
+				for (decltype(retval.size()) i = 0u; i < retval.size(); ++i) {
+					retval[i] = std::max(integer(md->m_min[i]).abs(),integer(md->m_max[i]).abs());
+				}
+				exact = md->m_exact;
+				return retval;
+			}
+			for (const auto &ptr: v) {
+				const auto tmp = ptr->m_key.unpack(args);
+				for (decltype(tmp.size()) i = 0u; i < tmp.size(); ++i) {
+					const auto abs_value = integer(tmp[i]).abs();
+					if (abs_value > retval[i]) {
+						retval[i] = abs_value;
+					}
+				}
+			}
+			exact = true;
+			return retval;
+		}
+		typedef typename base::range_type range_type;
+		typedef typename base::range_dispenser range_dispenser;
+		// Canonicalise a code by switching its sign if the first nonzero multiplier is negative. The multipliers
+		// are the digits of the code in a mixed radix system with balanced digits, so the first nonzero one can be
+		// found by examining the remainders of successive divisions, without decoding the whole code.
+		// Will return true if the sign was switched.
+		bool canonicalise(value_type &code) const
+		{
+			value_type c = code;
+			const auto size = m_moduli.size();
+			for (decltype(m_moduli.size()) i = 0u; i < size && c != value_type(0); ++i) {
+				const value_type &mod = m_moduli[i], &half = m_half_moduli[i];
+				auto r = static_cast<value_type>(c % mod);
+				if (r > half) {
+					r = static_cast<value_type>(r - mod);
+				} else if (r < -half) {
+					r = static_cast<value_type>(r + mod);
+				}
+				if (r != value_type(0)) {
+					if (r < value_type(0)) {
+						code = static_cast<value_type>(-code);
+						return true;
+					}
+					return false;
+				}
+				c = static_cast<value_type>(c / mod);
+			}
+			return false;
+		}
+		return_type execute() const
+		{
+			const index_type size1 = this->m_v1.size(), size2 = boost::numeric_cast<index_type>(this->m_v2.size());
+			// Do not do anything if one of the two series is empty, just return an empty series.
+			if (unlikely(!size1 || !size2)) {
+				return return_type{};
+			}
+			// Each term-by-term multiplication produces two terms.
+			const auto max_size = integer(size1) * size2 * 2;
+			if (unlikely(max_size > boost::integer_traits<bucket_size_type>::const_max)) {
+				piranha_throw(std::overflow_error,"possible overflow in series size");
+			}
+			return_type retval;
+			retval.m_symbol_set = this->m_s1->m_symbol_set;
+			auto estimate = this->final_size_estimate(typename base::default_functor(&this->m_v1[0u],size1,&this->m_v2[0u],size2,retval));
+			// Correct the unlikely case of zero estimate.
+			if (unlikely(!estimate)) {
+				estimate = 1u;
+			}
+			// NOTE: if something goes wrong here, no big deal as retval is still empty.
+			retval.m_container.rehash(boost::numeric_cast<bucket_size_type>(std::ceil(static_cast<double>(estimate) /
+				retval.m_container.max_load_factor())));
+			piranha_assert(retval.m_container.bucket_count());
+			const unsigned n_threads = this->determine_n_threads();
+			if (n_threads == 1u) {
+				code_functor f(&this->m_v1[0u],size1,&this->m_v2[0u],size2,retval,*this);
+				try {
+					if (this->m_square) {
+						code_functor f_off(&this->m_v1[0u],size1,&this->m_v2[0u],size2,retval,*this,true);
+						base::blocked_squaring(f,f_off);
+						base::sanitize_series(retval,f.m_insertion_count + f_off.m_insertion_count);
+					} else {
+						base::blocked_multiplication(f);
+						base::sanitize_series(retval,f.m_insertion_count);
+					}
+				} catch (...) {
+					retval.m_container.clear();
+					throw;
+				}
+			} else {
+				multi_thread(retval,n_threads);
+			}
+			this->trace_estimates(retval.size(),estimate);
+			return retval;
+		}
+		// Append to v the closed intervals of bucket indices whose union is R U -R, where R is the range r
+		// and the negation is modulo b_count. The intervals are disjoint.
+		static void symmetric_intervals(std::vector<range_type> &v, const range_type &r, const bucket_size_type &b_count)
+		{
+			piranha_assert(r.first < r.second && r.second <= b_count);
+			v.clear();
+			v.push_back(std::make_pair(r.first,static_cast<bucket_size_type>(r.second - 1u)));
+			if (r.first == 0u) {
+				if (r.second > 1u) {
+					v.push_back(std::make_pair(static_cast<bucket_size_type>(b_count - (r.second - 1u)),
+						static_cast<bucket_size_type>(b_count - 1u)));
+				}
+			} else {
+				v.push_back(std::make_pair(static_cast<bucket_size_type>(b_count - (r.second - 1u)),
+					static_cast<bucket_size_type>(b_count - r.first)));
+			}
+			if (v.size() == 2u) {
+				if (v[1u].first < v[0u].first) {
+					std::swap(v[0u],v[1u]);
+				}
+				// Merge overlapping or adjacent intervals.
+				if (v[1u].first <= v[0u].second + 1u) {
+					v[0u].second = std::max(v[0u].second,v[1u].second);
+					v.pop_back();
+				}
+			}
+		}
+		void multi_thread(return_type &retval, unsigned n_threads) const
+		{
+			const index_type size1 = this->m_v1.size(), size2 = boost::numeric_cast<index_type>(this->m_v2.size());
+			const auto b_count = retval.m_container.bucket_count();
+			piranha_assert(b_count);
+			// Sort the input terms according to the position of their keys in the return value.
+			auto sorter1 = [&retval](term_type1 const *ptr1, term_type1 const *ptr2) {
+				return retval.m_container._bucket_from_hash(ptr1->hash()) < retval.m_container._bucket_from_hash(ptr2->hash());
+			};
+			auto sorter2 = [&retval](term_type2 const *ptr1, term_type2 const *ptr2) {
+				return retval.m_container._bucket_from_hash(ptr1->hash()) < retval.m_container._bucket_from_hash(ptr2->hash());
+			};
+			std::sort(this->m_v1.begin(),this->m_v1.end(),sorter1);
+			if (this->m_square) {
+				this->align_square_operands();
+			} else {
+				std::sort(this->m_v2.begin(),this->m_v2.end(),sorter2);
+			}
+			// The hash of a trigonometric monomial is its code and the bucket count is a power of two, hence the bucket of the sum
+			// (resp. difference) of two codes is the sum (resp. difference), modulo the bucket count, of the buckets of the operands.
+			// For the differences, we need the terms of the second series sorted according to their negated buckets.
+			std::vector<bucket_size_type> buckets1, buckets2, nbuckets2;
+			std::vector<index_type> nperm2;
+			buckets1.reserve(boost::numeric_cast<decltype(buckets1.size())>(size1));
+			buckets2.reserve(boost::numeric_cast<decltype(buckets2.size())>(size2));
+			std::transform(this->m_v1.begin(),this->m_v1.end(),std::back_inserter(buckets1),[&retval](term_type1 const *ptr) {
+				return retval.m_container._bucket_from_hash(ptr->hash());
+			});
+			std::transform(this->m_v2.begin(),this->m_v2.end(),std::back_inserter(buckets2),[&retval](term_type2 const *ptr) {
+				return retval.m_container._bucket_from_hash(ptr->hash());
+			});
+			nperm2.resize(boost::numeric_cast<decltype(nperm2.size())>(size2));
+			std::iota(nperm2.begin(),nperm2.end(),index_type(0u));
+			auto negate_bucket = [b_count](const bucket_size_type &b) {
+				return static_cast<bucket_size_type>(b ? b_count - b : 0u);
+			};
+			std::sort(nperm2.begin(),nperm2.end(),[&buckets2,&negate_bucket](const index_type &a, const index_type &b) {
+				return negate_bucket(buckets2[a]) < negate_bucket(buckets2[b]);
+			});
+			nbuckets2.reserve(buckets2.size());
+			std::transform(nperm2.begin(),nperm2.end(),std::back_inserter(nbuckets2),[&buckets2,&negate_bucket](const index_type &j) {
+				return negate_bucket(buckets2[j]);
+			});
+			std::atomic<bucket_size_type> insertion_count(0u);
+			range_dispenser rd(b_count,n_threads);
+			// In squaring mode, the products of distinct terms are computed only once and doubled.
+			const bool square = this->m_square;
+			auto thread_function = [&rd,&insertion_count,&buckets1,&buckets2,&nbuckets2,&nperm2,&retval,square,b_count,size1,size2,this] () {
+				code_functor f(&this->m_v1[0u],size1,&this->m_v2[0u],size2,retval,*this),
+					f_off(&this->m_v1[0u],size1,&this->m_v2[0u],size2,retval,*this,true);
+				range_type r;
+				auto plus = [&f,&f_off,&r,square,this](const index_type &i, const index_type &j) {
+					const int c = square ? base::compare_square_terms(this->m_v1[i],this->m_v2[j]) : 0;
+					if (c == 0) {
+						f.template insert_one<true>(i,j,r);
+					} else if (c < 0) {
+						f_off.template insert_one<true>(i,j,r);
+					}
+				};
+				auto minus = [&f,&f_off,&r,&nperm2,square,this](const index_type &i, const index_type &nj) {
+					const index_type j = nperm2[nj];
+					const int c = square ? base::compare_square_terms(this->m_v1[i],this->m_v2[j]) : 0;
+					if (c == 0) {
+						f.template insert_one<false>(i,j,r);
+					} else if (c < 0) {
+						f_off.template insert_one<false>(i,j,r);
+					}
+				};
+				auto plus_swapped = [&plus](const index_type &j, const index_type &i) {
+					plus(i,j);
+				};
+				auto minus_swapped = [&minus](const index_type &nj, const index_type &i) {
+					minus(i,nj);
+				};
+				std::vector<range_type> intervals;
+				try {
+					while (rd.next(r)) {
+						// A term lands in r if the (uncanonicalised) code lands either in r or in -r.
+						symmetric_intervals(intervals,r,b_count);
+						for (const auto &iv: intervals) {
+							// NOTE: there are no overflows here, as the max bucket count is 2 ** (n - 1).
+							const bucket_size_type t_start[] = {iv.first,iv.first + b_count},
+								t_end[] = {iv.second,iv.second + b_count};
+							for (std::size_t k = 0u; k < 2u; ++k) {
+								// Loop over the smaller series in the outer cycle.
+								if (size1 <= size2) {
+									base::range_kernel(buckets1,buckets2,t_start[k],t_end[k],plus);
+									base::range_kernel(buckets1,nbuckets2,t_start[k],t_end[k],minus);
+								} else {
+									base::range_kernel(buckets2,buckets1,t_start[k],t_end[k],plus_swapped);
+									base::range_kernel(nbuckets2,buckets1,t_start[k],t_end[k],minus_swapped);
+								}
+							}
+						}
+					}
+				} catch (...) {
+					rd.stop();
+					throw;
+				}
+				insertion_count += f.m_insertion_count + f_off.m_insertion_count;
+			};
+			try {
+				base::run_threads(thread_function,n_threads);
+				base::sanitize_series(retval,insertion_count.load(),n_threads);
+			} catch (...) {
+				retval.m_container.clear();
+				throw;
+			}
+		}
+		// Functor operating on the codes of the trigonometric monomials. The results are inserted in the return value
+		// via the low-level interface of piranha::hash_set, and the number of inserted terms is recorded in m_insertion_count.
+		// If doubling is true, the coefficients of the results are doubled (squaring mode).
+		// The functor assumes that the return value has a nonzero number of buckets.
+		struct code_functor: base::default_functor
+		{
+			explicit code_functor(term_type1 const **ptr1, const index_type &s1,
+				term_type2 const **ptr2, const index_type &s2, return_type &retval, const series_multiplier &mult,
+				bool doubling = false):
+				base::default_functor(ptr1,s1,ptr2,s2,retval),m_mult(mult),m_doubling(doubling),m_cached_i(0u),m_cached_j(0u),
+				m_insertion_count(0u),m_prefetch(base::prefetch_output(retval))
+			{}
+			// Compute the key of the term Plus (sum of the multipliers) or minus (difference of the multipliers) resulting
+			// from the product of the terms i and j. Will return true if the coefficient has to be negated.
+			template <bool Plus>
+			bool compute_key(const index_type &i, const index_type &j, typename term_type1::key_type &key) const
+			{
+				const auto &k1 = this->m_ptr1[i]->m_key;
+				const auto &k2 = this->m_ptr2[j]->m_key;
+				const bool f1 = k1.get_flavour(), f2 = k2.get_flavour(), f = (f1 == f2);
+				// NOTE: no overflow is possible here, as the multipliers of the result have been checked to be within the limits.
+				value_type code = Plus ? static_cast<value_type>(k1.get_int() + k2.get_int()) :
+					static_cast<value_type>(k1.get_int() - k2.get_int());
+				const bool sign_change = m_mult.canonicalise(code);
+				key.set_int(code);
+				key.set_flavour(f);
+				// Prosthaphaeresis formulas: sin * sin negates the plus, cos * sin negates the minus.
+				// A sign change in the multipliers negates sines.
+				return (Plus ? (!f1 && !f2) : (f1 && !f2)) != (sign_change && !f);
+			}
+			// Insert the term in m_tmp with the given coefficient into the return value.
+			template <typename T>
+			void insert_term(typename term_type1::key_type &&key, T &&cf) const
+			{
+				auto &container = this->m_retval.m_container;
+				auto &tmp = std::get<0u>(this->m_tmp);
+				tmp.m_key = std::move(key);
+				const auto bucket_idx = container._bucket(tmp);
+				const auto it = container._find(tmp,bucket_idx);
+				if (it == container.end()) {
+					tmp.m_cf = std::forward<T>(cf);
+					container._unique_insert(std::move(tmp),bucket_idx);
+					++m_insertion_count;
+				} else {
+					// NOTE: ignorable terms will be dealt with from outside.
+					it->m_cf += std::forward<T>(cf);
+				}
+			}
+			void operator()(const index_type &i, const index_type &j) const
+			{
+				piranha_assert(i < this->m_s1 && j < this->m_s2);
+				m_cached_i = i;
+				m_cached_j = j;
+			}
+			// Prefetch the buckets of the two terms resulting from the multiplication of the terms i and j. The canonicalisation
+			// of the codes is skipped, and the buckets of both the candidate codes are prefetched instead.
+			void prefetch(const index_type &i, const index_type &j) const
+			{
+				piranha_assert(i < this->m_s1 && j < this->m_s2);
+				if (m_prefetch) {
+					const auto &container = this->m_retval.m_container;
+					auto pf = [&container](const value_type &code) {
+						container._prefetch_bucket(container._bucket_from_hash(static_cast<std::size_t>(code)));
+						container._prefetch_bucket(container._bucket_from_hash(static_cast<std::size_t>(-code)));
+					};
+					const value_type c1 = this->m_ptr1[i]->m_key.get_int(), c2 = this->m_ptr2[j]->m_key.get_int();
+					pf(static_cast<value_type>(c1 + c2));
+					pf(static_cast<value_type>(c1 - c2));
+				}
+			}
+			// Insert both terms resulting from the multiplication of the terms cached by operator()().
+			void insert() const
+			{
+				typename term_type1::key_type key_plus, key_minus;
+				const bool neg_plus = compute_key<true>(m_cached_i,m_cached_j,key_plus),
+					neg_minus = compute_key<false>(m_cached_i,m_cached_j,key_minus);
+				// NOTE: same sequence of operations as in piranha::poisson_series_term::multiply().
+				typename term_type1::cf_type cf_plus(this->m_ptr1[m_cached_i]->m_cf * this->m_ptr2[m_cached_j]->m_cf);
+				cf_plus /= 2;
+				// NOTE: double after the division, so that the result is the same as the sum of the two products.
+				if (m_doubling) {
+					cf_plus *= 2;
+				}
+				auto cf_minus(cf_plus);
+				if (neg_plus) {
+					math::negate(cf_plus);
+				}
+				if (neg_minus) {
+					math::negate(cf_minus);
+				}
+				insert_term(std::move(key_plus),std::move(cf_plus));
+				insert_term(std::move(key_minus),std::move(cf_minus));
+			}
+			// Insert the term Plus or minus resulting from the multiplication of the terms i and j, if its bucket
+			// is in the range r.
+			template <bool Plus>
+			void insert_one(const index_type &i, const index_type &j, const range_type &r) const
+			{
+				typename term_type1::key_type key;
+				const bool neg = compute_key<Plus>(i,j,key);
+				const auto b = this->m_retval.m_container._bucket_from_hash(key.hash());
+				if (b < r.first || b >= r.second) {
+					return;
+				}
+				typename term_type1::cf_type cf(this->m_ptr1[i]->m_cf * this->m_ptr2[j]->m_cf);
+				cf /= 2;
+				if (m_doubling) {
+					cf *= 2;
+				}
+				if (neg) {
+					math::negate(cf);
+				}
+				insert_term(std::move(key),std::move(cf));
+			}
+			const series_multiplier		&m_mult;
+			const bool			m_doubling;
+			mutable index_type		m_cached_i;
+			mutable index_type		m_cached_j;
+			mutable bucket_size_type	m_insertion_count;
+			const bool			m_prefetch;
+		};
+		bool			m_codes_ok;
+		std::vector<value_type>	m_moduli;
+		std::vector<value_type>	m_half_moduli;
+		std::vector<value_type>	m_result_min;
+		std::vector<value_type>	m_result_max;
+};
+
 namespace math
 {
 
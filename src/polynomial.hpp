@@ -22,16 +22,20 @@
 #define PIRANHA_POLYNOMIAL_HPP
 
 #include <algorithm>
+#include <atomic>
 #include <boost/integer_traits.hpp>
 #include <boost/numeric/conversion/cast.hpp>
 #include <cmath> // For std::ceil.
-#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
 #include <functional> // For std::bind.
 #include <initializer_list>
 #include <iterator>
+#include <limits>
 #include <map>
 #include <mutex>
 #include <numeric>
+#include <random>
 #include <set>
 #include <stdexcept>
 #include <string>
@@ -43,6 +47,7 @@
 #include "debug_access.hpp"
 #include "detail/poisson_series_fwd.hpp"
 #include "detail/polynomial_fwd.hpp"
+#include "detail/scatter_fma.hpp"
 #include "echelon_size.hpp"
 #include "exceptions.hpp"
 #include "forwarding.hpp"
@@ -54,6 +59,7 @@
 #include "power_series.hpp"
 #include "series.hpp"
 #include "series_multiplier.hpp"
+#include "settings.hpp"
 #include "symbol.hpp"
 #include "symbol_set.hpp"
 #include "t_substitutable_series.hpp"
@@ -622,7 +628,10 @@ struct kronecker_enabler
  * piranha::polynomial with monomials represented as piranha::kronecker_monomial of the same type.
  * This multiplier will employ optimized algorithms that take advantage of the properties of Kronecker monomials.
  * It will also take advantage of piranha::math::multiply_accumulate() in place of plain coefficient multiplication
- * when possible.
+ * when possible. In the dense multiplication of polynomials with piranha::integer coefficients, the coefficients
+ * of the result are accumulated in 64-bit or 128-bit hardware integers whenever a bound computed from the
+ * operands guarantees that no overflow can occur. Otherwise, a multi-modular algorithm is employed, in which the
+ * multiplication is performed modulo a set of word-sized primes and the result is reconstructed via the Chinese remainder theorem.
  * 
  * \section exception_safety Exception safety guarantee
  * 
@@ -655,6 +664,7 @@ class series_multiplier<Series1,Series2,typename std::enable_if<detail::kronecke
 		/**
 		 * Will call the base constructor and additionally check that the result of the multiplication will not overflow
 		 * the representation limits of piranha::kronecker_monomial. In such a case, a runtime error will be produced.
+		 * The bounds of the exponents of the operands are read from their cached key metadata, if available.
 		 * 
 		 * @param[in] s1 first series operand.
 		 * @param[in] s2 second series operand.
@@ -675,45 +685,23 @@ class series_multiplier<Series1,Series2,typename std::enable_if<detail::kronecke
 			piranha_assert(this->m_s1->m_symbol_set == this->m_s2->m_symbol_set);
 			const auto &limits = ka::get_limits()[this->m_s1->m_symbol_set.size()];
 			// NOTE: We need to check that the exponents of the monomials in the result do not
-			// go outside the bounds of the Kronecker codification. We need to unpack all monomials
-			// in the operands and examine them, we cannot operate on the codes for this.
-			auto it1 = this->m_v1.begin();
-			auto it2 = this->m_v2.begin();
-			// Initialise minmax values.
-			std::vector<std::pair<value_type,value_type>> minmax_values1;
-			std::vector<std::pair<value_type,value_type>> minmax_values2;
-			auto tmp_vec1 = (*it1)->m_key.unpack(this->m_s1->m_symbol_set);
-			auto tmp_vec2 = (*it2)->m_key.unpack(this->m_s1->m_symbol_set);
+			// go outside the bounds of the Kronecker codification. We need the bounds of the exponents
+			// in the operands for this, we cannot operate on the codes. The bounds are taken from the cached
+			// key metadata of the operands when available, otherwise all monomials are unpacked and examined.
+			// Bounds from the metadata might be conservative: if they fail the check, we fall back to
+			// an exact scan before giving up.
+			bool exact1, exact2;
+			auto minmax_values1 = operand_minmax(*this->m_s1,this->m_v1,true,exact1);
+			auto minmax_values2 = operand_minmax(*this->m_s2,this->m_v2,true,exact2);
 			// Bounds of the Kronecker representation for each component.
 			const auto &minmax_vec = std::get<0u>(limits);
-			std::transform(tmp_vec1.begin(),tmp_vec1.end(),std::back_inserter(minmax_values1),[](const value_type &v) {
-				return std::make_pair(v,v);
-			});
-			std::transform(tmp_vec2.begin(),tmp_vec2.end(),std::back_inserter(minmax_values2),[](const value_type &v) {
-				return std::make_pair(v,v);
-			});
-			// Find the minmaxs.
-			for (; it1 != this->m_v1.end(); ++it1) {
-				tmp_vec1 = (*it1)->m_key.unpack(this->m_s1->m_symbol_set);
-				piranha_assert(tmp_vec1.size() == minmax_values1.size());
-				std::transform(minmax_values1.begin(),minmax_values1.end(),tmp_vec1.begin(),minmax_values1.begin(),
-					[](const std::pair<value_type,value_type> &p, const value_type &v) {
-						return std::make_pair(
-							v < p.first ? v : p.first,
-							v > p.second ? v : p.second
-						);
-				});
-			}
-			for (; it2 != this->m_v2.end(); ++it2) {
-				tmp_vec2 = (*it2)->m_key.unpack(this->m_s2->m_symbol_set);
-				piranha_assert(tmp_vec2.size() == minmax_values2.size());
-				std::transform(minmax_values2.begin(),minmax_values2.end(),tmp_vec2.begin(),minmax_values2.begin(),
-					[](const std::pair<value_type,value_type> &p, const value_type &v) {
-						return std::make_pair(
-							v < p.first ? v : p.first,
-							v > p.second ? v : p.second
-						);
-				});
+			if (!(exact1 && exact2) && !bounds_fit(minmax_values1,minmax_values2,minmax_vec)) {
+				if (!exact1) {
+					minmax_values1 = operand_minmax(*this->m_s1,this->m_v1,false,exact1);
+				}
+				if (!exact2) {
+					minmax_values2 = operand_minmax(*this->m_s2,this->m_v2,false,exact2);
+				}
 			}
 			// Compute the sum of the two minmaxs, using multiprecision to avoid overflow.
 			// NOTE: use m_minmax_values for the ranges of the result only, update it to include
@@ -730,6 +718,9 @@ class series_multiplier<Series1,Series2,typename std::enable_if<detail::kronecke
 				if (unlikely(m_minmax_values[i].first < -minmax_vec[i] || m_minmax_values[i].second > minmax_vec[i])) {
 					piranha_throw(std::overflow_error,"Kronecker monomial components are out of bounds");
 				}
+				// Record the bounds of the result, which are representable as they are within the limits.
+				m_result_min.push_back(static_cast<value_type>(minmax_values1[i].first + minmax_values2[i].first));
+				m_result_max.push_back(static_cast<value_type>(minmax_values1[i].second + minmax_values2[i].second));
 				// Update with the ranges of the operands.
 				m_minmax_values[i] = std::minmax({m_minmax_values[i].first,
 					integer(minmax_values1[i].first),integer(minmax_values2[i].first),m_minmax_values[i].second,
@@ -738,24 +729,161 @@ class series_multiplier<Series1,Series2,typename std::enable_if<detail::kronecke
 		}
 		/// Perform multiplication.
 		/**
+		 * If a piranha::degree_truncation policy is active, the sparse multiplication algorithm will be used
+		 * and the term-by-term multiplications that cannot produce terms within the degree limit will be skipped.
+		 * Otherwise, the algorithm is selected according to piranha::settings::get_multiplication_strategy(): in automatic
+		 * mode, the dense or sparse algorithm is chosen according to a cost model based on the sizes of the operands and on the range
+		 * of the exponents in the result.
+		 * 
+		 * The bounds of the exponents of the result, deduced from the bounds of the operands, are recorded in the key metadata
+		 * of the result.
+		 * 
 		 * @return the result of the multiplication of the input series operands.
 		 * 
 		 * @throws unspecified any exception thrown by:
 		 * - (unlikely) conversion errors between numeric types,
 		 * - the public interface of piranha::hash_set,
-		 * - piranha::series_multiplier::estimate_final_series_size(),
+		 * - piranha::series_multiplier::final_size_estimate(),
 		 * - piranha::series_multiplier::blocked_multiplication(),
 		 * - piranha::math::multiply_accumulate() on the coefficient types.
 		 */
 		return_type operator()() const
 		{
-			return execute();
+			auto retval = execute();
+			// The bounds of the exponents of the result come for free from the bounds of the operands.
+			if (!retval.empty()) {
+				typename return_type::key_metadata_type md;
+				md.set_bounds(m_result_min,m_result_max);
+				retval.set_key_metadata(std::move(md));
+			}
+			return retval;
+		}
+		/// Perform multiplication producing sorted terms.
+		/**
+		 * The terms of the result of the multiplication of the input series operands are returned in a vector, sorted in ascending
+		 * lexicographic order of the exponents, starting from the exponent of the last variable. If no piranha::degree_truncation policy
+		 * is active, the terms are produced directly in order, either by the heap multiplication algorithm or by radix-sorting the
+		 * term-by-term products (see piranha::multiplication_strategy), otherwise the output of operator()() is sorted.
+		 * 
+		 * @return the sorted terms of the result of the multiplication of the input series operands.
+		 * 
+		 * @throws unspecified any exception thrown by:
+		 * - operator()(),
+		 * - (unlikely) conversion errors between numeric types,
+		 * - memory allocation errors in standard containers,
+		 * - piranha::math::multiply_accumulate() on the coefficient types.
+		 */
+		std::vector<term_type1> execute_sorted() const
+		{
+			std::vector<term_type1> retval;
+			if (unlikely(this->m_v1.empty() || this->m_v2.empty())) {
+				return retval;
+			}
+			const auto &args = this->m_s1->m_symbol_set;
+			if (this->m_truncation.get_mode() != 0) {
+				auto tmp = execute();
+				for (auto it = tmp.m_container.begin(); it != tmp.m_container.end(); ++it) {
+					retval.push_back(*it);
+				}
+				std::sort(retval.begin(),retval.end(),[&args](const term_type1 &t1, const term_type1 &t2) {
+					const auto v1 = t1.m_key.unpack(args), v2 = t2.m_key.unpack(args);
+					typedef std::reverse_iterator<decltype(v1.begin())> r_it;
+					return std::lexicographical_compare(r_it(v1.end()),r_it(v1.begin()),r_it(v2.end()),r_it(v2.begin()));
+				});
+				return retval;
+			}
+			// The sort-and-reduce algorithm is used unless the heap strategy is requested, or, in automatic mode, if the estimated
+			// number of products per term of the result is large: in such case, the radix sort on the original Kronecker codes
+			// is slower than the heap.
+			const index_type size1 = this->m_v1.size(), size2 = this->m_v2.size();
+			const auto strategy = settings::get_multiplication_strategy();
+			bool heap = strategy == multiplication_strategy::heap || !sort_reduce_is_viable(size1,size2);
+			if (!heap && strategy == multiplication_strategy::automatic) {
+				return_type tmp;
+				tmp.m_symbol_set = args;
+				const auto estimate = this->final_size_estimate(sparse_functor<>(&this->m_v1[0u],size1,&this->m_v2[0u],size2,tmp));
+				heap = integer(estimate) * 32 < n_products(size1,size2);
+			}
+			term_type1 tmp_term;
+			if (heap) {
+				const repacked_operands ro(*this);
+				auto parts = heap_multiplication(ro);
+				for (auto &part: parts) {
+					for (auto &p: part) {
+						tmp_term.m_cf = std::move(p.second);
+						ro.decode(p.first,tmp_term);
+						if (!tmp_term.is_ignorable(args)) {
+							retval.push_back(std::move(tmp_term));
+						}
+					}
+				}
+			} else {
+				// NOTE: the order of the original Kronecker codes is the same as the order of the repacked codes.
+				auto parts = sorted_sort_reduce_multiplication();
+				for (auto &part: parts) {
+					for (auto &p: part) {
+						tmp_term.m_cf = std::move(p.second);
+						tmp_term.m_key.set_int(p.first);
+						if (!tmp_term.is_ignorable(args)) {
+							retval.push_back(std::move(tmp_term));
+						}
+					}
+				}
+			}
+			return retval;
 		}
 	private:
 		typedef typename std::vector<term_type1 const *>::size_type index_type;
 		typedef typename Series1::size_type bucket_size_type;
-		// This is a bucket region, i.e., a _closed_ interval [a,b] of bucket indices in a hash set.
-		typedef std::pair<bucket_size_type,bucket_size_type> region_type;
+		typedef std::vector<std::pair<value_type,value_type>> minmax_vector;
+		// Closed ranges of the exponents in the operand s, whose terms are in v. If use_metadata is true,
+		// the ranges are taken from the cached key metadata of s when possible, and exact is set to false
+		// if the ranges are conservative.
+		template <typename Series, typename Term>
+		static minmax_vector operand_minmax(const Series &s, const std::vector<Term const *> &v, bool use_metadata, bool &exact)
+		{
+			piranha_assert(!v.empty());
+			minmax_vector retval;
+			const auto md = use_metadata ? s.cached_key_metadata() : nullptr;
+			if (md && md->m_has_bounds && md->m_min.size() == s.m_symbol_set.size()) {
+				for (decltype(md->m_min.size()) i = 0u; i < md->m_min.size(); ++i) {
+					retval.push_back(std::make_pair(md->m_min[i],md->m_max[i]));
+				}
+				exact = md->m_exact;
+				return retval;
+			}
+			auto tmp_vec = v[0u]->m_key.unpack(s.m_symbol_set);
+			std::transform(tmp_vec.begin(),tmp_vec.end(),std::back_inserter(retval),[](const value_type &x) {
+				return std::make_pair(x,x);
+			});
+			for (auto it = v.begin() + 1; it != v.end(); ++it) {
+				tmp_vec = (*it)->m_key.unpack(s.m_symbol_set);
+				piranha_assert(tmp_vec.size() == retval.size());
+				std::transform(retval.begin(),retval.end(),tmp_vec.begin(),retval.begin(),
+					[](const std::pair<value_type,value_type> &p, const value_type &x) {
+						return std::make_pair(
+							x < p.first ? x : p.first,
+							x > p.second ? x : p.second
+						);
+				});
+			}
+			exact = true;
+			return retval;
+		}
+		// Check if the ranges of the exponents of the result fit in the Kronecker limits.
+		template <typename Limits>
+		static bool bounds_fit(const minmax_vector &mm1, const minmax_vector &mm2, const Limits &minmax_vec)
+		{
+			piranha_assert(mm1.size() == mm2.size() && mm1.size() == minmax_vec.size());
+			for (decltype(mm1.size()) i = 0u; i < mm1.size(); ++i) {
+				if (integer(mm1[i].first) + integer(mm2[i].first) < -minmax_vec[i] ||
+					integer(mm1[i].second) + integer(mm2[i].second) > minmax_vec[i])
+				{
+					return false;
+				}
+			}
+			return true;
+		}
 		// Block-by-block multiplication task.
 		struct task_type
 		{
@@ -763,110 +891,16 @@ class series_multiplier<Series1,Series2,typename std::enable_if<detail::kronecke
 			std::pair<index_type,index_type>	m_b1;
 			// Second block (indices in second input series).
 			std::pair<index_type,index_type>	m_b2;
-			// First region memory region involved in the multiplication.
-			region_type				m_r1;
-			// Second memory region.
-			region_type				m_r2;
-			// Boolean flag to signal if the second region is present or not.
-			bool					m_second_region;
 		};
 		// Create task from indices i in first series, j in second series (semi-open intervals).
-		task_type task_from_indices(const index_type &i_start, const index_type &i_end,
-			const index_type &j_start, const index_type &j_end, const return_type &retval) const
+		static task_type task_from_indices(const index_type &i_start, const index_type &i_end,
+			const index_type &j_start, const index_type &j_end)
 		{
-			const auto &v1 = this->m_v1;
-			const auto &v2 = this->m_v2;
 			piranha_assert(i_start < i_end && j_start < j_end);
-			piranha_assert(i_end <= v1.size() && j_end <= v2.size());
-			const auto b_count = retval.m_container.bucket_count();
-			piranha_assert(b_count > 0u);
-			region_type r1{0u,0u}, r2{0u,0u};
-			bool second_region = false;
-			// Addition is safe because of the limits on the max bucket count of hash_set.
-			const auto a = retval.m_container._bucket_from_hash(v1[i_start]->hash()) +
-				retval.m_container._bucket_from_hash(v2[j_start]->hash()),
-				// NOTE: we are sure that the tasks are not empty, so the -1 is safe.
-				b = retval.m_container._bucket_from_hash(v1[i_end - 1u]->hash()) +
-				retval.m_container._bucket_from_hash(v2[j_end - 1u]->hash());
-			// NOTE: using <= here as [a,b] is now a closed interval.
-			piranha_assert(a <= b);
-			piranha_assert(b <= b_count * 2u - 2u);
-			if (b < b_count || a >= b_count) {
-				r1.first = a % b_count;
-				r1.second = b % b_count;
-			} else {
-				second_region = true;
-				r1.first = a;
-				r1.second = b_count - 1u;
-				r2.first = 0u;
-				r2.second = b % b_count;
-			}
-			// Correct the case in which a second region reaches the first one (thus
-			// covering the whole range of buckets).
-			if (second_region && r2.second >= r1.first) {
-				second_region = false;
-				r1.first = 0u;
-				r1.second = b_count - 1u;
-				r2.first = 0u;
-				r2.second = 0u;
-			}
-			piranha_assert(r1.first <= r1.second);
-			piranha_assert(!second_region || (r2.first <= r2.second && r2.second < r1.first));
-			return task_type{std::make_pair(i_start,i_end),std::make_pair(j_start,j_end),r1,r2,second_region};
-		}
-		// Functor to check if region r does not overlap any of the busy ones.
-		template <typename RegionSet>
-		static bool region_checker(const region_type &r, const RegionSet &busy_regions)
-		{
-			if (busy_regions.empty()) {
-				return true;
-			}
-			// NOTE: lower bound means that it_b->first >= r.first.
-			auto it_b = busy_regions.lower_bound(r);
-			// Handle end().
-			if (it_b == busy_regions.end()) {
-				// NOTE: safe because busy_regions is not empty.
-				--it_b;
-				// Now check that the region in it_b does not overlap with
-				// the current one.
-				piranha_assert(it_b->first < r.first);
-				return it_b->second < r.first;
-			}
-			if (r.second >= it_b->first) {
-				// The end point of r1 overlaps the start point of *it_b, no good.
-				return false;
-			}
-			// Lastly, we have to check that the previous element (if any) does not
-			// overlap r.first.
-			if (it_b != busy_regions.begin()) {
-				--it_b;
-				if (it_b->second >= r.first) {
-					return false;
-				}
-			}
-			return true;
-		}
-		// Check that a set of busy regions is well-formed, for debug purposes.
-		template <typename RegionSet>
-		static bool region_set_checker(const RegionSet &busy_regions)
-		{
-			if (busy_regions.empty()) {
-				return true;
-			}
-			const auto it_f = busy_regions.end();
-			auto it = busy_regions.begin();
-			auto prev_it(it);
-			++it;
-			for (; it != it_f; ++it, ++prev_it) {
-				if (it->first > it->second || prev_it->first > prev_it->second) {
-					return false;
-				}
-				if (prev_it->second >= it->first) {
-					return false;
-				}
-			}
-			return true;
+			return task_type{std::make_pair(i_start,i_end),std::make_pair(j_start,j_end)};
 		}
+		typedef typename base::range_type range_type;
+		typedef typename base::range_dispenser range_dispenser;
 		// Have to place this here because if created as a lambda, it will result in a
 		// compiler error in GCC 4.5. In GCC 4.6 there is no such problem.
 		// This will sort tasks according to the initial writing position in the hash table
@@ -904,41 +938,135 @@ class series_multiplier<Series1,Series2,typename std::enable_if<detail::kronecke
 		};
 		return_type execute() const
 		{
-			const index_type size1 = this->m_v1.size(), size2 = boost::numeric_cast<index_type>(this->m_v2.size());
 			// Do not do anything if one of the two series is empty, just return an empty series.
-			if (unlikely(!size1 || !size2)) {
+			if (unlikely(this->m_v1.empty() || this->m_v2.empty())) {
 				return return_type{};
 			}
+			// In truncated mode, sort and trim the operands, and compute the limits.
+			std::vector<index_type> limits;
+			if (this->m_truncation.get_mode() != 0) {
+				limits = this->prepare_truncation();
+				if (limits.empty()) {
+					return_type retval;
+					retval.m_symbol_set = this->m_s1->m_symbol_set;
+					return retval;
+				}
+			}
+			const index_type size1 = this->m_v1.size(), size2 = boost::numeric_cast<index_type>(this->m_v2.size());
+			piranha_assert(size1 && size2);
 			// This check is done here to avoid controlling the number of elements of the output series
 			// at every iteration of the functor.
 			const auto max_size = integer(size1) * size2;
 			if (unlikely(max_size > boost::integer_traits<bucket_size_type>::const_max)) {
 				piranha_throw(std::overflow_error,"possible overflow in series size");
 			}
-			// First, let's get the estimation on the size of the final series.
 			return_type retval;
 			retval.m_symbol_set = this->m_s1->m_symbol_set;
+			// The skinny multiplication does not need an estimation of the size of the result.
+			const auto strategy = settings::get_multiplication_strategy();
+			if (limits.empty() && strategy == multiplication_strategy::automatic && skinny_is_viable(size1,size2)) {
+				skinny_multiplication(retval);
+				return retval;
+			}
+			// First, let's get the estimation on the size of the final series.
 			typename Series1::size_type estimate;
 			// Use the sparse functor for the estimation.
-			estimate = base::estimate_final_series_size(sparse_functor<>(&this->m_v1[0u],size1,&this->m_v2[0u],size2,retval));
+			estimate = this->final_size_estimate(sparse_functor<>(&this->m_v1[0u],size1,&this->m_v2[0u],size2,retval));
 			// Correct the unlikely case of zero estimate.
 			if (unlikely(!estimate)) {
 				estimate = 1u;
 			}
+			if (!limits.empty()) {
+				estimate = base::truncated_estimate(estimate,size1,size2,&limits[0u]);
+			}
 			// Rehash the retun value's container accordingly.
 			// NOTE: if something goes wrong here, no big deal as retval is still empty.
 			retval.m_container.rehash(boost::numeric_cast<typename Series1::size_type>(std::ceil(static_cast<double>(estimate) /
 				retval.m_container.max_load_factor())));
 			piranha_assert(retval.m_container.bucket_count());
-			if ((integer(size1) * integer(size2)) / estimate > 200) {
+			// NOTE: the dense and heap algorithms operate on the whole range of output codes, hence they are not used
+			// in truncated mode. The heap algorithm is never selected automatically, as in our measurements it is slower
+			// than the sparse algorithm also on problems with very sparse results. It is used when sorted output is requested
+			// (see execute_sorted()).
+			if (!limits.empty() || strategy == multiplication_strategy::sparse) {
+				sparse_multiplication<sparse_functor<>>(retval,limits);
+			} else if (strategy == multiplication_strategy::dense || (strategy == multiplication_strategy::automatic &&
+				dense_is_cheaper(size1,size2)))
+			{
 				dense_multiplication(retval);
+			} else if (sort_reduce_is_viable(size1,size2) && (strategy == multiplication_strategy::sort_reduce ||
+				(strategy == multiplication_strategy::automatic && sort_reduce_is_cheaper(estimate,size1,size2))))
+			{
+				sort_reduce_multiplication(retval);
+			} else if (strategy == multiplication_strategy::heap) {
+				const repacked_operands ro(*this);
+				auto parts = heap_multiplication(ro);
+				term_type1 tmp_term;
+				for (auto &part: parts) {
+					for (auto &p: part) {
+						tmp_term.m_cf = std::move(p.second);
+						ro.decode(p.first,tmp_term);
+						retval.insert(std::move(tmp_term));
+					}
+				}
 			} else {
-				sparse_multiplication<sparse_functor<>>(retval);
+				sparse_multiplication<sparse_functor<>>(retval,limits);
 			}
 			// Trace the result of estimation.
 			this->trace_estimates(retval.size(),estimate);
 			return retval;
 		}
+		// Cost model for the choice between dense and sparse multiplication. The cost of the sparse algorithm
+		// is proportional to the number of term-by-term products, whereas the dense algorithm performs the products
+		// at a lower cost but needs to zero and scan the whole range of output codes. The constants are the measured
+		// costs (in tenths of nanoseconds on a modern x86-64 machine, double-precision coefficients) of a product in the
+		// sparse and dense algorithms and of the processing of an element of the output range. The ratio between the
+		// costs of sparse and dense products is higher for multiprecision coefficients, so the model is conservative.
+		bool dense_is_cheaper(const index_type &size1, const index_type &size2) const
+		{
+			const unsigned sparse_product_cost = 43u, dense_product_cost = 20u, dense_range_cost = 17u;
+			integer range(1);
+			for (const auto &p: m_minmax_values) {
+				range *= p.second - p.first + 1;
+			}
+			const integer n_products = integer(size1) * size2;
+			return n_products * (sparse_product_cost - dense_product_cost) > range * dense_range_cost && dense_fixed_width();
+		}
+		// For integer coefficients, the dense algorithm is selected only if the accumulation can be performed in hardware
+		// integers: with the multi-modular or multiprecision accumulation, in our measurements the dense algorithm is never
+		// significantly faster than the sparse one, and it can be much slower when the output range is sparse.
+		template <typename T1 = term_type1, typename T2 = term_type2>
+		bool dense_fixed_width(typename std::enable_if<!std::is_same<typename T1::cf_type,integer>::value ||
+			!std::is_same<typename T2::cf_type,integer>::value>::type * = nullptr) const
+		{
+			return true;
+		}
+		template <typename T1 = term_type1, typename T2 = term_type2>
+		bool dense_fixed_width(typename std::enable_if<std::is_same<typename T1::cf_type,integer>::value &&
+			std::is_same<typename T2::cf_type,integer>::value>::type * = nullptr) const
+		{
+			integer bound;
+			return integer_dense_width(bound) != 0u;
+		}
+		// The sort-and-reduce algorithm stores the indices of the terms of the operands in 32-bit integers.
+		static bool sort_reduce_is_viable(const index_type &size1, const index_type &size2)
+		{
+			return size1 <= std::numeric_limits<std::uint_least32_t>::max() && size2 <= std::numeric_limits<std::uint_least32_t>::max();
+		}
+		// The sort-and-reduce algorithm pays off when almost every product is a new term of the result, that is, when
+		// the estimated size of the result is close to the number of term-by-term products, and the table is large enough
+		// not to fit in the cache (in our measurements, from about 4M terms).
+		bool sort_reduce_is_cheaper(const bucket_size_type &estimate, const index_type &size1, const index_type &size2) const
+		{
+			return estimate >= (1u << 22u) && integer(estimate) * 2 > n_products(size1,size2);
+		}
+		// Skinny multiplication is used when one of the operands has few terms, as is the case when computing powers by repeated
+		// multiplication. Without blocking, each term of the smaller operand streams through the whole result, and the generic
+		// algorithms become competitive at around this size.
+		static bool skinny_is_viable(const index_type &size1, const index_type &size2)
+		{
+			return std::min(size1,size2) <= 64u;
+		}
 		// Utility function to determine block sizes.
 		static std::pair<integer,integer> get_block_sizes(const index_type &size1, const index_type &size2)
 		{
@@ -959,363 +1087,1313 @@ class series_multiplier<Series1,Series2,typename std::enable_if<detail::kronecke
 			}
 			return std::make_pair(std::move(block_size1),std::move(block_size2));
 		}
-		// Compare regions by lower bound.
-		struct region_comparer
+		// Fill up a task list with all the blocks of sizes bsize1 and bsize2 of the input series. If triangular is true,
+		// the block sizes must be equal and only the blocks on or above the diagonal will be included (squaring mode).
+		// NOTE: the way tasks are created, there is never an empty task - all intervals have nonzero sizes.
+		template <typename TaskList>
+		static void build_task_list(TaskList &task_list, const index_type &size1, const index_type &size2,
+			const index_type &bsize1, const index_type &bsize2, bool triangular = false)
 		{
-			bool operator()(const region_type &r1, const region_type &r2) const
-			{
-				return r1.first < r2.first;
+			piranha_assert(bsize1 && bsize2);
+			piranha_assert(!triangular || bsize1 == bsize2);
+			for (index_type i = 0u; i < size1; i += bsize1) {
+				const index_type i_end = (size1 - i > bsize1) ? i + bsize1 : size1;
+				for (index_type j = triangular ? i : index_type(0u); j < size2; j += bsize2) {
+					const index_type j_end = (size2 - j > bsize2) ? j + bsize2 : size2;
+					task_list.insert(task_from_indices(i,i_end,j,j_end));
+				}
 			}
+		}
+		// Operands repacked according to the Kronecker substitution tailored to the ranges of the exponents in the result
+		// (see m_minmax_values). The codes of the operands are sorted in ascending order, and the sum of two codes of the operands
+		// is the code of the corresponding term of the result. The codes of the result are in the closed interval [m_hmin,m_hmax].
+		class repacked_operands
+		{
+				typedef typename term_type1::key_type::v_type unpack_type;
+			public:
+				typedef std::pair<value_type,term_type1 const *> new_key_type1;
+				typedef std::pair<value_type,term_type2 const *> new_key_type2;
+				explicit repacked_operands(const series_multiplier &m)
+				{
+					const auto &minmax_values = m.m_minmax_values;
+					// Vectors of minimum / maximum values, cast to hardware int.
+					std::transform(minmax_values.begin(),minmax_values.end(),std::back_inserter(m_mins),[](const std::pair<integer,integer> &p) {
+						return static_cast<value_type>(p.first);
+					});
+					std::transform(minmax_values.begin(),minmax_values.end(),std::back_inserter(m_maxs),[](const std::pair<integer,integer> &p) {
+						return static_cast<value_type>(p.second);
+					});
+					// Build the encoding vector.
+					integer f_delta(1);
+					std::transform(minmax_values.begin(),minmax_values.end(),std::back_inserter(m_c_vec),
+						[&f_delta](const std::pair<integer,integer> &p) -> value_type {
+							auto old(f_delta);
+							f_delta *= p.second - p.first + 1;
+							return static_cast<value_type>(old);
+					});
+					// Try casting final delta.
+					(void)static_cast<value_type>(f_delta);
+					// Compute hmax and hmin.
+					piranha_assert(minmax_values.size() == m_c_vec.size());
+					const auto h_minmax = std::inner_product(minmax_values.begin(),minmax_values.end(),m_c_vec.begin(),
+						std::make_pair(integer(0),integer(0)),
+						[](const std::pair<integer,integer> &p1, const std::pair<integer,integer> &p2) {
+							return std::make_pair(p1.first + p2.first,p1.second + p2.second);
+						},[](const std::pair<integer,integer> &p, const value_type &value) {
+							return std::make_pair(p.first * value,p.second * value);
+						}
+					);
+					piranha_assert(f_delta == h_minmax.second - h_minmax.first + 1);
+					// Try casting hmax and hmin.
+					m_hmin = static_cast<value_type>(h_minmax.first);
+					m_hmax = static_cast<value_type>(h_minmax.second);
+					// Build copies of the input keys repacked according to the new Kronecker substitution. Attach
+					// also a pointer to the term.
+					std::transform(m.m_v1.begin(),m.m_v1.end(),std::back_inserter(m_new_keys1),
+						[this,&m](term_type1 const *ptr) {
+						return std::make_pair(this->encode(ptr->m_key.unpack(m.m_s1->m_symbol_set)),ptr);
+					});
+					std::transform(m.m_v2.begin(),m.m_v2.end(),std::back_inserter(m_new_keys2),
+						[this,&m](term_type2 const *ptr) {
+						return std::make_pair(this->encode(ptr->m_key.unpack(m.m_s1->m_symbol_set)),ptr);
+					});
+					// Sort the the new keys.
+					std::sort(m_new_keys1.begin(),m_new_keys1.end(),[](const new_key_type1 &p1, const new_key_type1 &p2) {
+						return p1.first < p2.first;
+					});
+					std::sort(m_new_keys2.begin(),m_new_keys2.end(),[](const new_key_type2 &p1, const new_key_type2 &p2) {
+						return p1.first < p2.first;
+					});
+					piranha_assert(m_new_keys1.size() == m.m_s1->size());
+					piranha_assert(m_new_keys2.size() == m.m_s2->size());
+					// Append the final delta to the coding vector for use in the decoding routine.
+					m_c_vec.push_back(static_cast<value_type>(f_delta));
+				}
+				// Decode the code n into the key of term.
+				void decode(const value_type &n, term_type1 &term) const
+				{
+					piranha_assert(m_c_vec.size() - 1u == m_mins.size());
+					unpack_type tmp_v;
+					for (decltype(m_mins.size()) i = 0u; i < m_mins.size(); ++i) {
+						const auto value = (n % m_c_vec[i + 1u]) / m_c_vec[i] + m_mins[i];
+						piranha_assert(value >= m_mins[i] && value <= m_maxs[i]);
+						tmp_v.push_back(static_cast<value_type>(value));
+					}
+					term.m_key = typename term_type1::key_type(tmp_v.begin(),tmp_v.end());
+				}
+				std::vector<new_key_type1>	m_new_keys1;
+				std::vector<new_key_type2>	m_new_keys2;
+				value_type			m_hmin;
+				value_type			m_hmax;
+			private:
+				value_type encode(const unpack_type &v) const
+				{
+					piranha_assert(m_c_vec.size() == v.size());
+					piranha_assert(m_c_vec.size() == m_mins.size());
+					decltype(m_mins.size()) i = 0u;
+					value_type retval = std::inner_product(m_c_vec.begin(),m_c_vec.end(),v.begin(),value_type(0),
+						std::plus<value_type>(),[&i,this](const value_type &c, const value_type &n) -> value_type {
+							const decltype(m_mins.size()) old_i = i;
+							++i;
+							piranha_assert(n >= m_mins[old_i]);
+							return static_cast<value_type>(c * (n - m_mins[old_i]));
+						}
+					);
+					return static_cast<value_type>(retval + m_hmin);
+				}
+				std::vector<value_type>	m_mins;
+				std::vector<value_type>	m_maxs;
+				std::vector<value_type>	m_c_vec;
 		};
-		// Function to remove the regions associated to a task from the set of busy regions.
-		template <typename RegionSet>
-		static void cleanup_regions(RegionSet &busy_regions, const task_type &task)
+		// Dense multiplication method.
+		void dense_multiplication(return_type &retval) const
+		{
+			const repacked_operands ro(*this);
+			// Functor to insert into retval the coefficient accumulated at position n of the dense storage.
+			term_type1 tmp_term;
+			auto inserter = [&tmp_term,&ro,&retval](const value_type &n, typename term_type1::cf_type &&cf) {
+				tmp_term.m_cf = std::move(cf);
+				ro.decode(n,tmp_term);
+				retval.insert(std::move(tmp_term));
+			};
+			dense_accumulation(ro.m_new_keys1,ro.m_new_keys2,ro.m_hmin,ro.m_hmax,inserter);
+		}
+		// Heap-based multiplication (M. Monagan and R. Pearce). The term-by-term products are merged in ascending order of
+		// their codes via a binary heap containing, for each term of the smaller operand, the next product to be computed.
+		// The output range of codes is split in parts containing roughly the same number of products, which are processed
+		// in parallel if possible. The return value contains, for each part, the codes of the result in ascending
+		// order with the accumulated coefficients (possibly zero).
+		typedef std::vector<std::pair<value_type,typename term_type1::cf_type>> heap_part_type;
+		std::vector<heap_part_type> heap_multiplication(const repacked_operands &ro) const
 		{
-			auto tmp_it = busy_regions.find(task.m_r1);
-			if (tmp_it != busy_regions.end()) {
-				busy_regions.erase(tmp_it);
+			typedef typename term_type1::cf_type cf_type1;
+			const auto &new_keys1 = ro.m_new_keys1;
+			const auto &new_keys2 = ro.m_new_keys2;
+			std::vector<value_type> codes1, codes2;
+			std::vector<cf_type1 const *> cfs1;
+			std::vector<typename term_type2::cf_type const *> cfs2;
+			for (const auto &p: new_keys1) {
+				codes1.push_back(p.first);
+				cfs1.push_back(&p.second->m_cf);
 			}
-			// Deal with second region only if present.
-			if (!task.m_second_region) {
-				return;
+			for (const auto &p: new_keys2) {
+				codes2.push_back(p.first);
+				cfs2.push_back(&p.second->m_cf);
+			}
+			// In squaring mode, the products of distinct terms are computed only once, using the doubled coefficients
+			// of the first operand.
+			const bool square = this->m_square;
+			std::vector<cf_type1> dcfs;
+			if (square) {
+				for (const auto &ptr: cfs1) {
+					dcfs.push_back(*ptr);
+					dcfs.back() *= 2;
+				}
 			}
-			tmp_it = busy_regions.find(task.m_r2);
-			if (tmp_it != busy_regions.end()) {
-				busy_regions.erase(tmp_it);
+			// Loop over the smaller series in the outer cycle.
+			const bool swapped = codes1.size() > codes2.size();
+			const std::vector<value_type> &outer = swapped ? codes2 : codes1, &inner = swapped ? codes1 : codes2;
+			auto mult = [&](cf_type1 &acc, const index_type &i, const index_type &j) {
+				math::multiply_accumulate(acc,(square && i != j) ? dcfs[i] : *cfs1[i],*cfs2[j]);
+			};
+			// Split the output range.
+			const unsigned n_threads = this->determine_n_threads();
+			const auto parts = heap_parts(outer,inner,(n_threads > 1u) ? n_threads * 4u : 1u,square);
+			std::vector<heap_part_type> retval(parts.size());
+			std::atomic<decltype(parts.size())> next_part(0u);
+			auto thread_function = [&]() {
+				// A row of products: the index in outer, the current and final indices in inner, and the next row
+				// in the same chain.
+				struct row_type
+				{
+					index_type	m_i;
+					index_type	m_j;
+					index_type	m_j_end;
+					index_type	m_next;
+				};
+				const index_type null_row = std::numeric_limits<index_type>::max();
+				// The heap contains chains of rows whose current products have the same code. Each element of the
+				// heap is the code and the first row of the chain.
+				typedef std::pair<value_type,index_type> heap_item;
+				std::vector<row_type> rows;
+				std::vector<heap_item> heap;
+				// Insertion of row r, whose current product has code c. The new element is moved up from the bottom of the
+				// heap, and it is chained to an element with the same code if such an element is found along the way.
+				// As the new codes tend to be large, insertion has constant average cost.
+				auto insert = [&heap,&rows,null_row](const value_type &c, const index_type &r) {
+					typedef typename std::vector<heap_item>::size_type size_type;
+					// Locate the final position of the new element.
+					size_type pos = heap.size();
+					while (pos) {
+						const size_type parent = (pos - 1u) / 2u;
+						if (heap[parent].first == c) {
+							rows[r].m_next = heap[parent].second;
+							heap[parent].second = r;
+							return;
+						}
+						if (!(c < heap[parent].first)) {
+							break;
+						}
+						pos = parent;
+					}
+					// Move down the elements along the path and place the new element.
+					rows[r].m_next = null_row;
+					size_type hole = heap.size();
+					heap.push_back(heap_item(c,r));
+					while (hole != pos) {
+						const size_type parent = (hole - 1u) / 2u;
+						heap[hole] = heap[parent];
+						hole = parent;
+					}
+					heap[pos] = heap_item(c,r);
+				};
+				// Removal of the element at the top of the heap.
+				auto pop = [&heap]() {
+					typedef typename std::vector<heap_item>::size_type size_type;
+					const heap_item item = heap.back();
+					heap.pop_back();
+					const size_type size = heap.size();
+					if (!size) {
+						return;
+					}
+					size_type pos = 0u, child = 1u;
+					while (child < size) {
+						if (child + 1u < size && heap[child + 1u].first < heap[child].first) {
+							++child;
+						}
+						if (!(heap[child].first < item.first)) {
+							break;
+						}
+						heap[pos] = heap[child];
+						pos = child;
+						child = 2u * pos + 1u;
+					}
+					heap[pos] = item;
+				};
+				try {
+					for (auto k = next_part.fetch_add(1u); k < parts.size(); k = next_part.fetch_add(1u)) {
+						rows.clear();
+						heap.clear();
+						base::range_rows(outer,inner,parts[k].first,parts[k].second,
+							[&rows,null_row](const index_type &i, const index_type &j_start, const index_type &j_end) {
+							rows.push_back(row_type{i,j_start,j_end,null_row});
+						},square);
+						for (index_type r = 0u; r < rows.size(); ++r) {
+							insert(outer[rows[r].m_i] + inner[rows[r].m_j],r);
+						}
+						auto &out = retval[k];
+						while (!heap.empty()) {
+							const heap_item top = heap[0u];
+							pop();
+							if (out.empty() || out.back().first != top.first) {
+								out.push_back(std::make_pair(top.first,cf_type1()));
+							}
+							auto &acc = out.back().second;
+							// Compute the products of the chain and advance its rows.
+							index_type r = top.second;
+							while (r != null_row) {
+								auto &row = rows[r];
+								const index_type next = row.m_next;
+								if (swapped) {
+									mult(acc,row.m_j,row.m_i);
+								} else {
+									mult(acc,row.m_i,row.m_j);
+								}
+								if (++row.m_j < row.m_j_end) {
+									insert(outer[row.m_i] + inner[row.m_j],r);
+								}
+								r = next;
+							}
+						}
+					}
+				} catch (...) {
+					// Stop the other threads.
+					next_part.store(parts.size());
+					throw;
+				}
+			};
+			if (n_threads > 1u) {
+				base::run_threads(thread_function,n_threads);
+			} else {
+				thread_function();
 			}
-			piranha_assert(region_set_checker(busy_regions));
+			return retval;
 		}
-		// Dense multiplication method.
-		void dense_multiplication(return_type &retval) const
+		// Split the range of the sums of the values in outer and inner in at most n_parts closed intervals containing roughly the
+		// same number of sums. If upper is true, outer and inner are identical and only the sums outer[i] + inner[j] with i <= j are considered.
+		static std::vector<std::pair<value_type,value_type>> heap_parts(const std::vector<value_type> &outer, const std::vector<value_type> &inner,
+			const unsigned &n_parts, bool upper)
 		{
-			// Vectors of minimum / maximum values, cast to hardware int.
-			std::vector<value_type> mins;
-			std::transform(m_minmax_values.begin(),m_minmax_values.end(),std::back_inserter(mins),[](const std::pair<integer,integer> &p) {
-				return static_cast<value_type>(p.first);
-			});
-			std::vector<value_type> maxs;
-			std::transform(m_minmax_values.begin(),m_minmax_values.end(),std::back_inserter(maxs),[](const std::pair<integer,integer> &p) {
-				return static_cast<value_type>(p.second);
-			});
-			// Build the encoding vector.
-			std::vector<value_type> c_vec;
-			integer f_delta(1);
-			std::transform(m_minmax_values.begin(),m_minmax_values.end(),std::back_inserter(c_vec),
-				[&f_delta](const std::pair<integer,integer> &p) -> value_type {
-					auto old(f_delta);
-					f_delta *= p.second - p.first + 1;
-					return static_cast<value_type>(old);
-			});
-			// Try casting final delta.
-			(void)static_cast<value_type>(f_delta);
-			// Compute hmax and hmin.
-			piranha_assert(m_minmax_values.size() == c_vec.size());
-			const auto h_minmax = std::inner_product(m_minmax_values.begin(),m_minmax_values.end(),c_vec.begin(),
-				std::make_pair(integer(0),integer(0)),
-				[](const std::pair<integer,integer> &p1, const std::pair<integer,integer> &p2) {
-					return std::make_pair(p1.first + p2.first,p1.second + p2.second);
-				},[](const std::pair<integer,integer> &p, const value_type &value) {
-					return std::make_pair(p.first * value,p.second * value);
-				}
-			);
-			piranha_assert(f_delta == h_minmax.second - h_minmax.first + 1);
-			// Try casting hmax and hmin.
-			const auto hmin = static_cast<value_type>(h_minmax.first);
-			const auto hmax = static_cast<value_type>(h_minmax.second);
-			// Encoding functor.
-			typedef typename term_type1::key_type::v_type unpack_type;
-			auto encoder = [&c_vec,hmin,&mins](const unpack_type &v) -> value_type {
-				piranha_assert(c_vec.size() == v.size());
-				piranha_assert(c_vec.size() == mins.size());
-				decltype(mins.size()) i = 0u;
-				value_type retval = std::inner_product(c_vec.begin(),c_vec.end(),v.begin(),value_type(0),
-					std::plus<value_type>(),[&i,&mins](const value_type &c, const value_type &n) -> value_type {
-						const decltype(mins.size()) old_i = i;
-						++i;
-						piranha_assert(n >= mins[old_i]);
-						return static_cast<value_type>(c * (n - mins[old_i]));
+			piranha_assert(!outer.empty() && !inner.empty() && n_parts);
+			// Number of sums less than or equal to t.
+			auto count = [&outer,&inner,upper](const value_type &t) -> integer {
+				integer retval(0);
+				index_type j = inner.size();
+				for (index_type i = 0u; i < outer.size(); ++i) {
+					while (j && outer[i] + inner[j - 1u] > t) {
+						--j;
 					}
-				);
-				return static_cast<value_type>(retval + hmin);
+					if (!j) {
+						break;
+					}
+					if (!upper) {
+						retval += j;
+					} else if (j > i) {
+						retval += j - i;
+					}
+				}
+				return retval;
 			};
-			// Build copies of the input keys repacked according to the new Kronecker substitution. Attach
-			// also a pointer to the term.
-			typedef std::pair<value_type,term_type1 const *> new_key_type1;
-			typedef std::pair<value_type,term_type2 const *> new_key_type2;
-			std::vector<new_key_type1> new_keys1;
-			std::vector<new_key_type2> new_keys2;
-			std::transform(this->m_v1.begin(),this->m_v1.end(),std::back_inserter(new_keys1),
-				[this,encoder](term_type1 const *ptr) {
-				return std::make_pair(encoder(ptr->m_key.unpack(this->m_s1->m_symbol_set)),ptr);
-			});
-			std::transform(this->m_v2.begin(),this->m_v2.end(),std::back_inserter(new_keys2),
-				[this,encoder](term_type2 const *ptr) {
-				return std::make_pair(encoder(ptr->m_key.unpack(this->m_s1->m_symbol_set)),ptr);
-			});
-			// Sort the the new keys.
-			std::sort(new_keys1.begin(),new_keys1.end(),[](const new_key_type1 &p1, const new_key_type1 &p2) {
-				return p1.first < p2.first;
-			});
-			std::sort(new_keys2.begin(),new_keys2.end(),[](const new_key_type2 &p1, const new_key_type2 &p2) {
-				return p1.first < p2.first;
-			});
-			// Store the sizes and compute the block sizes.
-			const index_type size1 = boost::numeric_cast<index_type>(new_keys1.size()),
-				size2 = boost::numeric_cast<index_type>(new_keys2.size());
-			piranha_assert(size1 == this->m_s1->size());
-			piranha_assert(size2 == this->m_s2->size());
-			const auto bsizes = get_block_sizes(size1,size2);
-			// Cast to hardware integers.
-			const auto bsize1 = static_cast<index_type>(bsizes.first), bsize2 = static_cast<index_type>(bsizes.second);
-			// Build the list of tasks.
-			auto dense_task_sorter = [&new_keys1,&new_keys2](const task_type &t1, const task_type &t2) {
-				return new_keys1[t1.m_b1.first].first + new_keys2[t1.m_b2.first].first <
-					new_keys1[t2.m_b1.first].first + new_keys2[t2.m_b2.first].first;
+			const value_type lo = outer.front() + inner.front(), hi = outer.back() + inner.back();
+			const integer total = count(hi);
+			std::vector<std::pair<value_type,value_type>> retval;
+			value_type start = lo;
+			for (unsigned k = 1u; k < n_parts; ++k) {
+				// Locate the smallest end of the interval such that the number of sums up to the end is at least k * total / n_parts.
+				const integer target = (total * k) / n_parts;
+				value_type a = start, b = hi;
+				while (a < b) {
+					const value_type mid = static_cast<value_type>(a + (b - a) / 2);
+					if (count(mid) >= target) {
+						b = mid;
+					} else {
+						a = static_cast<value_type>(mid + 1);
+					}
+				}
+				if (a == hi) {
+					break;
+				}
+				retval.push_back(std::make_pair(start,a));
+				start = static_cast<value_type>(a + 1);
+			}
+			retval.push_back(std::make_pair(start,hi));
+			return retval;
+		}
+		// Record of a term-by-term product in the sort-and-reduce algorithm: the offset of the sum of the keys of the factors from the
+		// start of the current window, and the indices of the factors.
+		// NOTE: the indices are stored in 32-bit integers, see sort_reduce_is_viable().
+		template <typename U>
+		struct sr_product
+		{
+			U			m_offset;
+			std::uint_least32_t	m_i;
+			std::uint_least32_t	m_j;
+		};
+		// Append to buffer the products whose keys outer[i] + inner[j] lie in the closed interval [t_start,t_end].
+		template <typename T, typename U>
+		static void sr_append(const std::vector<T> &outer, const std::vector<T> &inner, const T &t_start, const T &t_end, bool upper,
+			std::vector<sr_product<U>> &buffer)
+		{
+			// NOTE: unsigned arithmetic avoids overflows in the computation of the offsets.
+			base::range_rows(outer,inner,t_start,t_end,[&buffer,&outer,&inner,&t_start](const index_type &i, const index_type &j_start,
+				const index_type &j_end) {
+				for (index_type j = j_start; j < j_end; ++j) {
+					buffer.push_back(sr_product<U>{static_cast<U>(static_cast<U>(outer[i] + inner[j]) - static_cast<U>(t_start)),
+						static_cast<std::uint_least32_t>(i),static_cast<std::uint_least32_t>(j)});
+				}
+			},upper);
+		}
+		// LSD radix sort of the products in buffer on their offsets, which must not be greater than max_offset. tmp and counts are used
+		// as temporary storage.
+		template <typename U>
+		static void sr_radix_sort(std::vector<sr_product<U>> &buffer, std::vector<sr_product<U>> &tmp, std::vector<bucket_size_type> &counts,
+			const U &max_offset)
+		{
+			const unsigned digit_bits = 8u, radix = 1u << digit_bits;
+			unsigned n_digits = 0u;
+			for (U n = max_offset; n; n = static_cast<U>(n >> digit_bits)) {
+				++n_digits;
+			}
+			// Compute the histograms of all the digits in a single pass.
+			counts.assign(n_digits * radix,0u);
+			for (const auto &p: buffer) {
+				for (unsigned d = 0u; d < n_digits; ++d) {
+					++counts[d * radix + ((p.m_offset >> (d * digit_bits)) & (radix - 1u))];
+				}
+			}
+			tmp.resize(buffer.size());
+			for (unsigned d = 0u; d < n_digits; ++d) {
+				bucket_size_type *c = &counts[d * radix];
+				// Skip the digits on which all the offsets agree.
+				if (std::find(c,c + radix,buffer.size()) != c + radix) {
+					continue;
+				}
+				bucket_size_type start = 0u;
+				for (unsigned r = 0u; r < radix; ++r) {
+					const bucket_size_type old = c[r];
+					c[r] = start;
+					start += old;
+				}
+				for (const auto &p: buffer) {
+					tmp[c[(p.m_offset >> (d * digit_bits)) & (radix - 1u)]++] = p;
+				}
+				buffer.swap(tmp);
+			}
+		}
+		// Number of term-by-term products in the multiplication of series of sizes size1 and size2 (in squaring mode, only the
+		// products of the upper triangle are computed).
+		integer n_products(const index_type &size1, const index_type &size2) const
+		{
+			return this->m_square ? (integer(size1) * (size1 + 1u)) / 2 : integer(size1) * size2;
+		}
+		// Sort-and-reduce multiplication. The bucket range of retval is split in windows receiving about 2**16 term-by-term
+		// products each. For each window, the products are written in a buffer together with the indices of their
+		// factors, and the buffer is radix-sorted on the bucket index. The products are then accumulated in the
+		// window's buckets, in ascending order: the memory of the table is accessed sequentially and runs of equal codes are
+		// reduced in a bucket that is already in cache. The windows are disjoint, so they are processed in parallel without locking.
+		void sort_reduce_multiplication(return_type &retval) const
+		{
+			const auto b_count = retval.m_container.bucket_count();
+			piranha_assert(b_count);
+			// Number of buckets per window, assuming that the products are uniformly distributed in the table.
+			const bucket_size_type w_size = std::min(b_count,std::max(bucket_size_type(1u),static_cast<bucket_size_type>(
+				integer(65536) * b_count / n_products(this->m_v1.size(),this->m_v2.size()))));
+			// NOTE: store the offsets from the start of the window in the narrowest type that can represent them (this reduces the
+			// size of the product records, and hence the memory traffic of the radix sort, by a quarter on 64-bit platforms).
+			if (w_size - 1u <= std::numeric_limits<std::uint_least32_t>::max()) {
+				sort_reduce_multiplication_impl<std::uint_least32_t>(retval,w_size);
+			} else {
+				sort_reduce_multiplication_impl<bucket_size_type>(retval,w_size);
+			}
+		}
+		template <typename U>
+		void sort_reduce_multiplication_impl(return_type &retval, const bucket_size_type &w_size) const
+		{
+			typedef typename term_type1::cf_type cf_type1;
+			typedef sr_product<U> product_type;
+			auto &container = retval.m_container;
+			const auto b_count = container.bucket_count();
+			std::vector<bucket_size_type> buckets1, buckets2;
+			std::vector<value_type> codes1, codes2;
+			std::vector<cf_type1 const *> cfs1;
+			std::vector<typename term_type2::cf_type const *> cfs2;
+			auto bucket_key = [&container](const value_type &code) {
+				return container._bucket_from_hash(static_cast<std::size_t>(code));
 			};
-			std::multiset<task_type,decltype(dense_task_sorter)> task_list(dense_task_sorter);
-			decltype(task_list.insert(std::declval<task_type>())) ins_result;
-			auto dense_task_from_indices = [hmin,hmax,&new_keys1,&new_keys2](const index_type &i_start, const index_type &i_end,
-				const index_type &j_start, const index_type &j_end) -> task_type
-			{
-				piranha_assert(i_end <= new_keys1.size() && j_end <= new_keys2.size());
-				piranha_assert(i_start < i_end && j_start < j_end);
-				const bucket_size_type a = boost::numeric_cast<bucket_size_type>((new_keys1[i_start].first + new_keys2[j_start].first) - hmin);
-				const bucket_size_type b = boost::numeric_cast<bucket_size_type>((new_keys1[i_end - 1u].first + new_keys2[j_end - 1u].first) - hmin);
-				piranha_assert(a <= b);
-				piranha_assert(b <= boost::numeric_cast<bucket_size_type>(hmax - hmin));
-				return task_type{std::make_pair(i_start,i_end),std::make_pair(j_start,j_end),
-					std::make_pair(a,b),std::make_pair(bucket_size_type(0u),bucket_size_type(0u)),false};
+			sorted_keys(this->m_v1,bucket_key,buckets1,codes1,cfs1);
+			sorted_keys(this->m_v2,bucket_key,buckets2,codes2,cfs2);
+			const bool square = this->m_square;
+			std::vector<cf_type1> dcfs;
+			if (square) {
+				for (const auto &ptr: cfs1) {
+					dcfs.push_back(*ptr);
+					dcfs.back() *= 2;
+				}
+			}
+			const bool swapped = buckets1.size() > buckets2.size();
+			const std::vector<bucket_size_type> &outer = swapped ? buckets2 : buckets1, &inner = swapped ? buckets1 : buckets2;
+			const bucket_size_type n_windows = b_count / w_size + static_cast<bucket_size_type>(b_count % w_size != 0u);
+			const unsigned n_threads = this->determine_n_threads();
+			std::atomic<bucket_size_type> next_window(0u), insertion_count(0u);
+			auto thread_function = [&]() {
+				std::vector<product_type> buffer, tmp;
+				std::vector<bucket_size_type> counts;
+				term_type1 tmp_term;
+				bucket_size_type count = 0u;
+				try {
+					for (auto k = next_window.fetch_add(1u); k < n_windows; k = next_window.fetch_add(1u)) {
+						const bucket_size_type start = k * w_size, end = std::min(b_count,start + w_size);
+						buffer.clear();
+						// The sums of the bucket indices of the factors landing in the window modulo b_count form the
+						// closed intervals [start,end - 1] and [start + b_count,end - 1 + b_count].
+						// NOTE: there are no overflows here, as the max bucket count is 2 ** (n - 1).
+						sr_append(outer,inner,start,end - 1u,square,buffer);
+						sr_append(outer,inner,start + b_count,end - 1u + b_count,square,buffer);
+						sr_radix_sort(buffer,tmp,counts,static_cast<U>(end - 1u - start));
+						for (const auto &p: buffer) {
+							const index_type i = swapped ? p.m_j : p.m_i, j = swapped ? p.m_i : p.m_j;
+							const auto &cf1 = (square && i != j) ? dcfs[i] : *cfs1[i];
+							const bucket_size_type bucket_idx = start + p.m_offset;
+							tmp_term.m_key.set_int(static_cast<value_type>(codes1[i] + codes2[j]));
+							piranha_assert(container._bucket(tmp_term) == bucket_idx);
+							const auto it = container._find(tmp_term,bucket_idx);
+							if (it == container.end()) {
+								// NOTE: the key of tmp_term is re-set at every iteration, so it is fine to leave
+								// it in a moved-from state.
+								sparse_functor<>::compute_cf(tmp_term.m_cf,cf1,*cfs2[j]);
+								container._unique_insert(std::move(tmp_term),bucket_idx);
+								++count;
+							} else {
+								math::multiply_accumulate(it->m_cf,cf1,*cfs2[j]);
+							}
+						}
+					}
+				} catch (...) {
+					// Stop the other threads.
+					next_window.store(n_windows);
+					insertion_count += count;
+					throw;
+				}
+				insertion_count += count;
 			};
-			for (index_type i = 0u; i < size1 / bsize1; ++i) {
-				for (index_type j = 0u; j < size2 / bsize2; ++j) {
-					ins_result = task_list.insert(dense_task_from_indices(i * bsize1,(i + 1u) * bsize1,j * bsize2,(j + 1u) * bsize2));
-					piranha_assert(ins_result->m_b1.first != ins_result->m_b1.second && ins_result->m_b2.first != ins_result->m_b2.second);
+			try {
+				if (n_threads > 1u) {
+					base::run_threads(thread_function,n_threads);
+				} else {
+					thread_function();
 				}
-				if (size2 % bsize2) {
-					ins_result = task_list.insert(dense_task_from_indices(i * bsize1,(i + 1u) * bsize1,(size2 / bsize2) * bsize2,size2));
-					piranha_assert(ins_result->m_b1.first != ins_result->m_b1.second && ins_result->m_b2.first != ins_result->m_b2.second);
+				base::sanitize_series(retval,insertion_count.load(),n_threads);
+			} catch (...) {
+				container._update_size(insertion_count.load());
+				container.clear();
+				throw;
+			}
+		}
+		// Sort-and-reduce multiplication producing sorted terms. The output range of codes is split in windows containing
+		// roughly the same number of term-by-term products, and the products of each window are radix-sorted on their codes,
+		// so that the runs of equal codes can be reduced. The windows are processed in parallel if possible. The return value
+		// contains, for each window, the codes of the result in ascending order with the accumulated coefficients (possibly zero).
+		std::vector<heap_part_type> sorted_sort_reduce_multiplication() const
+		{
+			typedef typename term_type1::cf_type cf_type1;
+			typedef typename std::make_unsigned<value_type>::type uvalue_type;
+			typedef sr_product<uvalue_type> product_type;
+			typedef typename std::conditional<(std::numeric_limits<uvalue_type>::digits > std::numeric_limits<std::uint_least32_t>::digits),
+				std::uint_least32_t,uvalue_type>::type narrow_type;
+			typedef sr_product<narrow_type> narrow_product_type;
+			std::vector<value_type> codes1, codes2;
+			std::vector<cf_type1 const *> cfs1;
+			std::vector<typename term_type2::cf_type const *> cfs2;
+			auto code_key = [](const value_type &code) {return code;};
+			sorted_keys(this->m_v1,code_key,codes1,codes1,cfs1);
+			sorted_keys(this->m_v2,code_key,codes2,codes2,cfs2);
+			const bool square = this->m_square;
+			std::vector<cf_type1> dcfs;
+			if (square) {
+				for (const auto &ptr: cfs1) {
+					dcfs.push_back(*ptr);
+					dcfs.back() *= 2;
 				}
 			}
-			if (size1 % bsize1) {
-				for (index_type j = 0u; j < size2 / bsize2; ++j) {
-					ins_result = task_list.insert(dense_task_from_indices((size1 / bsize1) * bsize1,size1,j * bsize2,(j + 1u) * bsize2));
-					piranha_assert(ins_result->m_b1.first != ins_result->m_b1.second && ins_result->m_b2.first != ins_result->m_b2.second);
+			const bool swapped = codes1.size() > codes2.size();
+			const std::vector<value_type> &outer = swapped ? codes2 : codes1, &inner = swapped ? codes1 : codes2;
+			const unsigned n_threads = this->determine_n_threads();
+			const index_type n_windows = std::max(static_cast<index_type>(n_products(codes1.size(),codes2.size()) / 65536 + 1),
+				static_cast<index_type>((n_threads > 1u) ? n_threads * 4u : 1u));
+			const auto windows = sampled_parts(outer,inner,n_windows,square);
+			std::vector<heap_part_type> retval(windows.size());
+			std::atomic<decltype(windows.size())> next_window(0u);
+			auto thread_function = [&]() {
+				std::vector<product_type> buffer, tmp;
+				std::vector<narrow_product_type> n_buffer, n_tmp;
+				std::vector<bucket_size_type> counts;
+				try {
+					for (auto k = next_window.fetch_add(1u); k < windows.size(); k = next_window.fetch_add(1u)) {
+						const uvalue_type max_offset = static_cast<uvalue_type>(static_cast<uvalue_type>(windows[k].second) -
+							static_cast<uvalue_type>(windows[k].first));
+						// NOTE: the offsets are stored in the narrow type when possible, as in sort_reduce_multiplication().
+						if (max_offset <= std::numeric_limits<narrow_type>::max()) {
+							sorted_sr_window(outer,inner,windows[k],static_cast<narrow_type>(max_offset),swapped,dcfs,cfs1,cfs2,
+								n_buffer,n_tmp,counts,retval[k]);
+						} else {
+							sorted_sr_window(outer,inner,windows[k],max_offset,swapped,dcfs,cfs1,cfs2,buffer,tmp,counts,retval[k]);
+						}
+					}
+				} catch (...) {
+					// Stop the other threads.
+					next_window.store(windows.size());
+					throw;
 				}
-				if (size2 % bsize2) {
-					ins_result = task_list.insert(dense_task_from_indices((size1 / bsize1) * bsize1,size1,(size2 / bsize2) * bsize2,size2));
-					piranha_assert(ins_result->m_b1.first != ins_result->m_b1.second && ins_result->m_b2.first != ins_result->m_b2.second);
+			};
+			if (n_threads > 1u) {
+				base::run_threads(thread_function,n_threads);
+			} else {
+				thread_function();
+			}
+			return retval;
+		}
+		// Compute the products of a window of sorted_sort_reduce_multiplication() (i.e., those whose codes lie in the closed interval
+		// window), and reduce the runs of equal codes into out.
+		template <typename U>
+		void sorted_sr_window(const std::vector<value_type> &outer, const std::vector<value_type> &inner,
+			const std::pair<value_type,value_type> &window, const U &max_offset, bool swapped,
+			const std::vector<typename term_type1::cf_type> &dcfs, const std::vector<typename term_type1::cf_type const *> &cfs1,
+			const std::vector<typename term_type2::cf_type const *> &cfs2, std::vector<sr_product<U>> &buffer,
+			std::vector<sr_product<U>> &tmp, std::vector<bucket_size_type> &counts, heap_part_type &out) const
+		{
+			const bool square = this->m_square;
+			buffer.clear();
+			sr_append(outer,inner,window.first,window.second,square,buffer);
+			sr_radix_sort(buffer,tmp,counts,max_offset);
+			// Reduce the runs of equal codes.
+			const auto it_f = buffer.end();
+			for (auto it = buffer.begin(); it != it_f;) {
+				const U offset = it->m_offset;
+				out.push_back(std::make_pair(static_cast<value_type>(outer[it->m_i] + inner[it->m_j]),typename term_type1::cf_type()));
+				auto &acc = out.back().second;
+				for (; it != it_f && it->m_offset == offset; ++it) {
+					const index_type i = swapped ? it->m_j : it->m_i, j = swapped ? it->m_i : it->m_j;
+					math::multiply_accumulate(acc,(square && i != j) ? dcfs[i] : *cfs1[i],*cfs2[j]);
 				}
 			}
-			// Prepare the storage for multiplication.
-			std::vector<typename term_type1::cf_type> cf_vector;
-			cf_vector.resize(boost::numeric_cast<decltype(cf_vector.size())>((hmax - hmin) + 1));
-			// Get the number of threads.
-			typedef decltype(this->determine_n_threads()) thread_size_type;
-			const thread_size_type n_threads = this->determine_n_threads();
-			if (n_threads == 1u) {
-				// Single-thread multiplication.
-				const auto it_f = task_list.end();
-				for (auto it = task_list.begin(); it != it_f; ++it) {
-					const index_type i_start = it->m_b1.first, j_start = it->m_b2.first,
-						i_end = it->m_b1.second, j_end = it->m_b2.second;
-					piranha_assert(i_end > i_start && j_end > j_start);
+		}
+		// Multiplication by an operand with few terms. With a single term in the smaller operand, the multiplication is a shift of the
+		// codes and a scaling of the coefficients, and the results are inserted without lookups into a table of the exact size.
+		// Otherwise, the table of the return value is initially sized after the larger operand, and the products are computed
+		// window by window in the order of the buckets of the result. The first window is computed on its own, and the table is
+		// enlarged if the number of terms it produced indicates that the result will be larger than the table: hence the size
+		// of the result is never estimated by sampling, and there is no blocking of the operands. The remaining windows are
+		// processed in parallel if possible.
+		void skinny_multiplication(return_type &retval) const
+		{
+			const index_type size1 = this->m_v1.size(), size2 = this->m_v2.size();
+			auto &container = retval.m_container;
+			if (std::min(size1,size2) == 1u) {
+				shift_multiplication(retval);
+				return;
+			}
+			container.rehash(boost::numeric_cast<bucket_size_type>(std::ceil(static_cast<double>(std::max(size1,size2)) /
+				container.max_load_factor())));
+			const auto b_count = container.bucket_count();
+			piranha_assert(b_count);
+			sort_by_output_bucket(retval);
+			// NOTE: the windows are defined with respect to the initial bucket count, also after the table has been enlarged.
+			// Enlarging the table splits each bucket into buckets which are congruent modulo the initial bucket count, hence
+			// the products landing in different windows still land in different buckets.
+			std::vector<bucket_size_type> buckets1, buckets2;
+			buckets1.reserve(boost::numeric_cast<decltype(buckets1.size())>(size1));
+			buckets2.reserve(boost::numeric_cast<decltype(buckets2.size())>(size2));
+			std::transform(this->m_v1.begin(),this->m_v1.end(),std::back_inserter(buckets1),[&container](term_type1 const *ptr) {
+				return container._bucket_from_hash(ptr->hash());
+			});
+			std::transform(this->m_v2.begin(),this->m_v2.end(),std::back_inserter(buckets2),[&container](term_type2 const *ptr) {
+				return container._bucket_from_hash(ptr->hash());
+			});
+			// Compute the products landing in the window [start,end[.
+			auto window = [&buckets1,&buckets2,b_count,size1,size2](const sparse_functor<true> &f, const bucket_size_type &start,
+				const bucket_size_type &end)
+			{
+				auto mult_row = [&f](const index_type &i, const index_type &j_start, const index_type &j_end) {
+					base::multiply_row(f,i,j_start,j_end);
+				};
+				auto mult_row_swapped = [&f](const index_type &j, const index_type &i_start, const index_type &i_end) {
 					for (index_type i = i_start; i < i_end; ++i) {
-						for (index_type j = j_start; j < j_end; ++j) {
-							const auto idx = (new_keys1[i].first + new_keys2[j].first) - hmin;
-							piranha_assert(idx < boost::numeric_cast<value_type>(cf_vector.size()));
-							math::multiply_accumulate(cf_vector[static_cast<decltype(cf_vector.size())>(idx)],
-								new_keys1[i].second->m_cf,new_keys2[j].second->m_cf);
+						if (i + base::prefetch_distance < i_end) {
+							f.prefetch(i + base::prefetch_distance,j);
 						}
+						f(i,j);
+						f.insert();
+					}
+				};
+				// NOTE: there are no overflows here, as the max bucket count is 2 ** (n - 1).
+				const bucket_size_type t_start[] = {start,start + b_count}, t_end[] = {end - 1u,end - 1u + b_count};
+				for (std::size_t k = 0u; k < 2u; ++k) {
+					// Loop over the smaller series in the outer cycle.
+					if (size1 <= size2) {
+						base::range_rows(buckets1,buckets2,t_start[k],t_end[k],mult_row);
+					} else {
+						base::range_rows(buckets2,buckets1,t_start[k],t_end[k],mult_row_swapped);
 					}
 				}
-			} else {
-				// Set of busy bucket regions, ordered by starting point.
-				// NOTE: we do not need a multiset, as regions that compare equal (i.e., same starting point) will not exist
-				// at the same time in the set by design.
-				region_comparer rc;
-				std::set<region_type,region_comparer> busy_regions(rc);
-				// Synchronization.
-				std::mutex m;
-				std::condition_variable cond;
-				// Thread function.
-				auto thread_function = [&cond,&m,&task_list,&busy_regions,&new_keys1,&new_keys2,hmin,&cf_vector,this] () {
-					task_type task;
-					while (true) {
-						{
-							// First, lock down everything.
-							std::unique_lock<std::mutex> lock(m);
-							if (task_list.empty()) {
-								break;
-							}
-							// Look for a suitable task.
-							const auto it_f = task_list.end();
-							auto it = task_list.begin();
-							for (; it != it_f; ++it) {
-								piranha_assert(!it->m_second_region);
-								// Check the region.
-								if (this->region_checker(it->m_r1,busy_regions)) {
-									try {
-										// The region is ok, insert it and break the cycle.
-										auto tmp = busy_regions.insert(it->m_r1);
-										(void)tmp;
-										piranha_assert(tmp.second);
-										piranha_assert(this->region_set_checker(busy_regions));
-									} catch (...) {
-										// NOTE: the idea here is that in case of errors
-										// we want to restore the original situation
-										// as if nothing happened.
-										this->cleanup_regions(busy_regions,*it);
-										throw;
-									}
-									break;
-								}
-							}
-							// We might have identified a suitable task, check it is not end().
-							if (it == it_f) {
-								// The thread can't do anything, will have to wait until something happens
-								// and then re-identify a good task.
-								cond.wait(lock);
-								continue;
-							}
-							// Now we have a good task, pop it from the task list.
-							task = *it;
-							task_list.erase(it);
-						}
+			};
+			const bucket_size_type first_end = std::max(bucket_size_type(1u),static_cast<bucket_size_type>(b_count / 32u));
+			const unsigned n_threads = this->determine_n_threads();
+			std::atomic<bucket_size_type> insertion_count(0u);
+			try {
+				{
+					sparse_functor<true> f(&this->m_v1[0u],size1,&this->m_v2[0u],size2,retval);
+					window(f,0u,first_end);
+					insertion_count = f.m_insertion_count;
+				}
+				// Enlarge the table according to the size of the result extrapolated from the first window.
+				const double projected = static_cast<double>(insertion_count.load()) * static_cast<double>(b_count) /
+					static_cast<double>(first_end);
+				if (projected > static_cast<double>(b_count) * container.max_load_factor()) {
+					container._update_size(insertion_count.load());
+					container.rehash(boost::numeric_cast<bucket_size_type>(std::ceil(projected / container.max_load_factor())));
+				}
+				if (first_end < b_count) {
+					range_dispenser rd(b_count - first_end,n_threads);
+					auto thread_function = [&rd,&insertion_count,&window,&retval,first_end,size1,size2,this]() {
+						sparse_functor<true> f(&this->m_v1[0u],size1,&this->m_v2[0u],size2,retval);
+						range_type r;
 						try {
-							// Perform the multiplication on the selected task.
-							const index_type i_start = task.m_b1.first, j_start = task.m_b2.first,
-								i_end = task.m_b1.second, j_end = task.m_b2.second;
-							piranha_assert(i_end > i_start && j_end > j_start);
-							for (index_type i = i_start; i < i_end; ++i) {
-								for (index_type j = j_start; j < j_end; ++j) {
-									const auto idx = (new_keys1[i].first + new_keys2[j].first) - hmin;
-									piranha_assert(idx < boost::numeric_cast<value_type>(cf_vector.size()));
-									math::multiply_accumulate(cf_vector[static_cast<decltype(cf_vector.size())>(idx)],
-										new_keys1[i].second->m_cf,new_keys2[j].second->m_cf);
-								}
+							while (rd.next(r)) {
+								window(f,r.first + first_end,r.second + first_end);
 							}
 						} catch (...) {
-							// Re-acquire the lock.
-							std::lock_guard<std::mutex> lock(m);
-							// Cleanup the regions.
-							this->cleanup_regions(busy_regions,task);
-							// Notify all waiting threads that a region was removed from the busy set.
-							cond.notify_all();
+							rd.stop();
 							throw;
 						}
-						{
-							// Re-acquire the lock.
-							std::lock_guard<std::mutex> lock(m);
-							// Take out the regions in which we just wrote from the set of busy regions.
-							this->cleanup_regions(busy_regions,task);
-							// Notify all waiting threads that a region was removed from the busy set.
-							cond.notify_all();
-						}
+						insertion_count += f.m_insertion_count;
+					};
+					if (n_threads > 1u) {
+						base::run_threads(thread_function,n_threads);
+					} else {
+						thread_function();
 					}
-				};
-				// NOTE: one of the fundamental requirements here is that we wait for pending
-				// tasks, in case of errors, before getting out of this function: thread_function
-				// contains references to local variables, if we get out of here before the tasks are finished
-				// memory corruption will occur.
-				future_list<decltype(thread_pool::enqueue(0u,thread_function))> f_list;
-				try {
-					for (thread_size_type i = 0u; i < n_threads; ++i) {
-						// NOTE: enqueue() will either happen or it won't, we only care
-						// about memory allocation errors in push_back() here. In such case,
-						// push_back() will wait on the temporary future from enqueue
-						// before returning the exception.
-						f_list.push_back(thread_pool::enqueue(i,thread_function));
+				}
+				base::sanitize_series(retval,insertion_count.load(),n_threads);
+			} catch (...) {
+				retval.m_container.clear();
+				throw;
+			}
+		}
+		// Multiplication by a single term.
+		void shift_multiplication(return_type &retval) const
+		{
+			const index_type size1 = this->m_v1.size(), size2 = this->m_v2.size(), size = std::max(size1,size2);
+			piranha_assert(std::min(size1,size2) == 1u);
+			auto &container = retval.m_container;
+			container.rehash(boost::numeric_cast<bucket_size_type>(std::ceil(static_cast<double>(size) / container.max_load_factor())));
+			const auto &args = retval.m_symbol_set;
+			term_type1 tmp;
+			bucket_size_type count = 0u;
+			try {
+				for (index_type k = 0u; k < size; ++k) {
+					const auto &t1 = *this->m_v1[size1 == 1u ? index_type(0u) : k];
+					const auto &t2 = *this->m_v2[size1 == 1u ? k : index_type(0u)];
+					// NOTE: the codes of the results are all distinct, and the key of tmp is re-set
+					// at every iteration, so it is fine to leave it in a moved-from state.
+					tmp.m_key.set_int(static_cast<value_type>(t1.m_key.get_int() + t2.m_key.get_int()));
+					sparse_functor<>::compute_cf(tmp.m_cf,t1.m_cf,t2.m_cf);
+					if (likely(!tmp.is_ignorable(args))) {
+						const auto bucket_idx = container._bucket(tmp);
+						container._unique_insert(std::move(tmp),bucket_idx);
+						++count;
 					}
-					// First let's wait for everything to finish.
-					f_list.wait_all();
-					// Then, let's handle the exceptions.
-					f_list.get_all();
-				} catch (...) {
-					// Make sure any pending task is finished -> this is for
-					// the case the exception was thrown in the future creation
-					// loop. It is safe to call this again in case the exception
-					// being handled is generated by get_all(), as wait_all() will check
-					// the validity of the future before calling wait().
-					f_list.wait_all();
-					throw;
 				}
+			} catch (...) {
+				container._update_size(count);
+				container.clear();
+				throw;
 			}
-			// Build the return value.
-			// Append the final delta to the coding vector for use in the decoding routine.
-			c_vec.push_back(static_cast<value_type>(f_delta));
-			// Temp vector for decoding.
-			std::vector<value_type> tmp_v;
-			tmp_v.resize(boost::numeric_cast<decltype(tmp_v.size())>(this->m_s1->m_symbol_set.size()));
-			piranha_assert(c_vec.size() - 1u == tmp_v.size());
-			piranha_assert(mins.size() == tmp_v.size());
-			auto decoder = [&tmp_v,&c_vec,&mins,&maxs](const value_type &n) {
-				decltype(c_vec.size()) i = 0u;
-				std::generate(tmp_v.begin(),tmp_v.end(),
-					[&n,&i,&mins,&maxs,&c_vec]() -> value_type
-				{
-					auto retval = (n % c_vec[i + 1u]) / c_vec[i] + mins[i];
-					piranha_assert(retval >= mins[i] && retval <= maxs[i]);
-					++i;
-					return static_cast<value_type>(retval);
-				});
-			};
-			const auto cf_size = cf_vector.size();
-			term_type1 tmp_term;
-			for (decltype(cf_vector.size()) i = 0u; i < cf_size; ++i) {
-				if (!math::is_zero(cf_vector[i])) {
-					tmp_term.m_cf = std::move(cf_vector[i]);
-					decoder(boost::numeric_cast<value_type>(i));
-					tmp_term.m_key = decltype(tmp_term.m_key)(tmp_v.begin(),tmp_v.end());
-					retval.insert(std::move(tmp_term));
+			container._update_size(count);
+		}
+		// Sort the terms pointed to by v according to the keys of their Kronecker codes computed by key_func, and write
+		// in keys, codes and cfs the keys, the codes and the pointers to the coefficients. keys and codes can be the same object.
+		template <typename Term, typename KeyFunc, typename Key>
+		static void sorted_keys(const std::vector<Term const *> &v, const KeyFunc &key_func, std::vector<Key> &keys,
+			std::vector<value_type> &codes, std::vector<typename Term::cf_type const *> &cfs)
+		{
+			std::vector<std::pair<Key,Term const *>> sorted;
+			sorted.reserve(v.size());
+			for (const auto &ptr: v) {
+				sorted.push_back(std::make_pair(key_func(ptr->m_key.get_int()),ptr));
+			}
+			std::sort(sorted.begin(),sorted.end(),[](const std::pair<Key,Term const *> &p1, const std::pair<Key,Term const *> &p2) {
+				return p1.first < p2.first;
+			});
+			keys.clear();
+			codes.clear();
+			cfs.clear();
+			for (const auto &p: sorted) {
+				keys.push_back(p.first);
+				if (static_cast<void *>(&keys) != static_cast<void *>(&codes)) {
+					codes.push_back(p.second->m_key.get_int());
 				}
+				cfs.push_back(&p.second->m_cf);
 			}
 		}
-		template <typename Functor>
-		void sparse_multiplication(return_type &retval) const
+		// Split the range of the sums of the values in outer and inner in at most n_parts closed intervals containing roughly the
+		// same number of sums, using the quantiles of a random sample of the sums. If upper is true, outer and inner are identical
+		// and only the sums outer[i] + inner[j] with i <= j are considered. Cheaper than heap_parts() for a large number of parts.
+		static std::vector<std::pair<value_type,value_type>> sampled_parts(const std::vector<value_type> &outer,
+			const std::vector<value_type> &inner, const index_type &n_parts, bool upper)
 		{
-			const index_type size1 = this->m_v1.size(), size2 = boost::numeric_cast<index_type>(this->m_v2.size());
-			// Sort the input terms according to the position of the Kronecker keys in the estimated return value.
-			auto sorter1 = [&retval](term_type1 const *ptr1, term_type1 const *ptr2) {
-				return retval.m_container._bucket_from_hash(ptr1->hash()) < retval.m_container._bucket_from_hash(ptr2->hash());
+			piranha_assert(!outer.empty() && !inner.empty() && n_parts);
+			const value_type lo = static_cast<value_type>(outer.front() + inner.front()),
+				hi = static_cast<value_type>(outer.back() + inner.back());
+			std::vector<std::pair<value_type,value_type>> retval;
+			value_type start = lo;
+			if (n_parts > 1u) {
+				// NOTE: a default-constructed engine makes the splitting deterministic.
+				std::mt19937 engine;
+				std::uniform_int_distribution<index_type> dist1(0u,outer.size() - 1u), dist2(0u,inner.size() - 1u);
+				const index_type n_samples = n_parts * 16u;
+				std::vector<value_type> samples;
+				samples.reserve(n_samples);
+				for (index_type k = 0u; k < n_samples; ++k) {
+					index_type i = dist1(engine), j = dist2(engine);
+					if (upper && i > j) {
+						std::swap(i,j);
+					}
+					samples.push_back(static_cast<value_type>(outer[i] + inner[j]));
+				}
+				std::sort(samples.begin(),samples.end());
+				for (index_type k = 1u; k < n_parts; ++k) {
+					const value_type &b = samples[(k * n_samples) / n_parts];
+					if (b > start) {
+						retval.push_back(std::make_pair(start,static_cast<value_type>(b - 1)));
+						start = b;
+					}
+				}
+			}
+			retval.push_back(std::make_pair(start,hi));
+			return retval;
+		}
+		// Accumulator types for the dense multiplication of integer coefficients.
+		typedef long long dense_int64;
+#if defined(PIRANHA_GCC_INT128_T)
+		// NOTE: the extension keyword silences pedantic warnings about the 128-bit type.
+		__extension__ typedef PIRANHA_GCC_INT128_T dense_int128;
+		// Conversion of a 128-bit accumulator to integer.
+		static integer fixed_width_to_integer(const dense_int128 &n)
+		{
+			__extension__ typedef PIRANHA_GCC_UINT128_T uint128;
+			static_assert(std::numeric_limits<unsigned long long>::digits == 64,"Invalid number of bits in unsigned long long.");
+			// NOTE: compute the absolute value in unsigned arithmetic, in order to handle the minimum value.
+			const uint128 abs_n = (n >= 0) ? static_cast<uint128>(n) : static_cast<uint128>(-(n + 1)) + 1u;
+			integer retval(static_cast<unsigned long long>(abs_n >> 64));
+			retval *= integer(std::numeric_limits<unsigned long long>::max()) + 1;
+			retval += static_cast<unsigned long long>(abs_n);
+			if (n < 0) {
+				retval.negate();
+			}
+			return retval;
+		}
+		__extension__ typedef PIRANHA_GCC_UINT128_T dense_uint128;
+		typedef unsigned long long modulus_type;
+		static_assert(std::numeric_limits<modulus_type>::digits == 64,"Invalid number of bits in unsigned long long.");
+		// Modular multiplication and exponentiation.
+		static modulus_type mul_mod(const modulus_type &a, const modulus_type &b, const modulus_type &m)
+		{
+			return static_cast<modulus_type>((static_cast<dense_uint128>(a) * b) % m);
+		}
+		static modulus_type pow_mod(modulus_type base, modulus_type exp, const modulus_type &m)
+		{
+			modulus_type retval = 1u % m;
+			base %= m;
+			while (exp) {
+				if (exp & 1u) {
+					retval = mul_mod(retval,base,m);
+				}
+				base = mul_mod(base,base,m);
+				exp >>= 1u;
+			}
+			return retval;
+		}
+		// Multi-modular dense accumulation. The multiplication is performed modulo a set of primes in the ]2**49,2**50[ range,
+		// whose product is greater than twice the bound on the absolute values of the coefficients of the result. The coefficients
+		// are then reconstructed via the Chinese remainder theorem (Garner's algorithm). In each modular pass the coefficients
+		// of the operands are represented by their symmetric residues, whose absolute values are less than 2**49 (2**50 for the doubled
+		// coefficients in squaring mode). The absolute values of the products are then less than 2**99, and they are accumulated in 128-bit
+		// integers: no overflow is possible if less than 2**28 products contribute to each term of the result.
+		// The modular passes are independent, and they are distributed among the threads if there are enough of them.
+		template <typename NewKeys1, typename NewKeys2, typename Inserter>
+		void multi_modular_dense_accumulation(const NewKeys1 &new_keys1, const NewKeys2 &new_keys2, const value_type &hmin,
+			const value_type &hmax, const Inserter &inserter, const integer &bound) const
+		{
+			piranha_assert(std::min(new_keys1.size(),new_keys2.size()) < (1ull << 28u));
+			// Select the moduli.
+			std::vector<modulus_type> moduli;
+			integer M(1), p(integer(2).pow(49u));
+			const integer target = bound * 2;
+			while (M <= target) {
+				p = p.nextprime();
+				piranha_assert(p < integer(2).pow(50u));
+				moduli.push_back(static_cast<modulus_type>(p));
+				M *= p;
+			}
+			const integer half_M = M / 2;
+			typedef typename std::vector<modulus_type>::size_type m_size_type;
+			const m_size_type n_moduli = moduli.size();
+			const auto size = boost::numeric_cast<typename std::vector<modulus_type>::size_type>((hmax - hmin) + 1);
+			// Symmetric residue of n modulo m.
+			auto sym_residue = [](const integer &n, const modulus_type &m) -> dense_int128 {
+				auto tmp = n.abs();
+				tmp %= m;
+				auto r = static_cast<modulus_type>(tmp);
+				if (n.sign() < 0 && r) {
+					r = m - r;
+				}
+				return (r > m / 2u) ? -static_cast<dense_int128>(m - r) : static_cast<dense_int128>(r);
 			};
-			auto sorter2 = [&retval](term_type2 const *ptr1, term_type2 const *ptr2) {
-				return retval.m_container._bucket_from_hash(ptr1->hash()) < retval.m_container._bucket_from_hash(ptr2->hash());
+			// The residues of the coefficients of the result, in the [0,m[ range.
+			std::vector<std::vector<modulus_type>> residues(n_moduli);
+			auto modular_pass = [&](const m_size_type &k) {
+				const modulus_type m = moduli[k];
+				std::vector<dense_int128> v1, v2;
+				std::vector<dense_int128 const *> cfs1, cfs2;
+				v1.reserve(new_keys1.size());
+				v2.reserve(new_keys2.size());
+				cfs1.reserve(new_keys1.size());
+				cfs2.reserve(new_keys2.size());
+				for (const auto &p: new_keys1) {
+					v1.push_back(sym_residue(p.second->m_cf,m));
+					cfs1.push_back(&v1.back());
+				}
+				for (const auto &p: new_keys2) {
+					v2.push_back(sym_residue(p.second->m_cf,m));
+					cfs2.push_back(&v2.back());
+				}
+				auto &res = residues[k];
+				res.resize(size);
+				dense_kernel<dense_int128>(new_keys1,new_keys2,cfs1,cfs2,hmin,hmax,
+					[&res,m](const value_type &n, dense_int128 &acc) {
+						dense_int128 r = acc % static_cast<dense_int128>(m);
+						if (r < 0) {
+							r += static_cast<dense_int128>(m);
+						}
+						res[static_cast<typename std::vector<modulus_type>::size_type>(n)] = static_cast<modulus_type>(r);
+				});
 			};
-			std::sort(this->m_v1.begin(),this->m_v1.end(),sorter1);
-			std::sort(this->m_v2.begin(),this->m_v2.end(),sorter2);
-			// Start defining the blocks for series multiplication.
-			const auto bsizes = get_block_sizes(size1,size2);
-			// Cast to hardware integers.
-			const auto bsize1 = static_cast<index_type>(bsizes.first), bsize2 = static_cast<index_type>(bsizes.second);
-			// Create the list of tasks.
-			// NOTE: the way tasks are created, there is never an empty task - all intervals have nonzero sizes.
-			// The task are sorted according to the index of the first bucket of retval that will be written to,
-			// so we need a multiset as different tasks might have the same starting position.
-			std::multiset<task_type,sparse_task_sorter> task_list(sparse_task_sorter(retval,this->m_v1,this->m_v2));
-			decltype(task_list.insert(std::declval<task_type>())) ins_result;
-			for (index_type i = 0u; i < size1 / bsize1; ++i) {
-				for (index_type j = 0u; j < size2 / bsize2; ++j) {
-					ins_result = task_list.insert(task_from_indices(i * bsize1,(i + 1u) * bsize1,j * bsize2,(j + 1u) * bsize2,retval));
-					piranha_assert(ins_result->m_b1.first != ins_result->m_b1.second && ins_result->m_b2.first != ins_result->m_b2.second);
+			typedef decltype(this->determine_n_threads()) thread_size_type;
+			const thread_size_type n_threads = this->determine_n_threads();
+			if (n_threads > 1u && n_moduli >= n_threads) {
+				// NOTE: the dense kernel will run in single-thread mode when called from the threads of the pool.
+				std::atomic<m_size_type> next(0u);
+				auto thread_function = [&next,n_moduli,&modular_pass]() {
+					for (auto k = next.fetch_add(1u); k < n_moduli; k = next.fetch_add(1u)) {
+						modular_pass(k);
+					}
+				};
+				base::run_threads(thread_function,n_threads);
+			} else {
+				for (m_size_type k = 0u; k < n_moduli; ++k) {
+					modular_pass(k);
 				}
-				if (size2 % bsize2) {
-					ins_result = task_list.insert(task_from_indices(i * bsize1,(i + 1u) * bsize1,(size2 / bsize2) * bsize2,size2,retval));
-					piranha_assert(ins_result->m_b1.first != ins_result->m_b1.second && ins_result->m_b2.first != ins_result->m_b2.second);
+			}
+			// Garner's algorithm: inv[j] is the inverse of the product of the first j moduli, modulo the j-th modulus.
+			std::vector<modulus_type> inv(n_moduli,modulus_type(0u));
+			for (m_size_type j = 1u; j < n_moduli; ++j) {
+				modulus_type prod = 1u;
+				for (m_size_type i = 0u; i < j; ++i) {
+					prod = mul_mod(prod,moduli[i] % moduli[j],moduli[j]);
+				}
+				inv[j] = pow_mod(prod,moduli[j] - 2u,moduli[j]);
+			}
+			// Reconstruct the coefficients of the result.
+			std::vector<integer> cf_vector(size);
+			auto reconstruct = [&](const typename std::vector<modulus_type>::size_type &start, const typename std::vector<modulus_type>::size_type &end) {
+				// Mixed-radix digits.
+				std::vector<modulus_type> v(n_moduli);
+				for (auto n = start; n < end; ++n) {
+					if (std::all_of(residues.begin(),residues.end(),[n](const std::vector<modulus_type> &r) {return r[n] == 0u;})) {
+						continue;
+					}
+					v[0u] = residues[0u][n];
+					for (m_size_type j = 1u; j < n_moduli; ++j) {
+						const modulus_type m = moduli[j];
+						// Value of the mixed-radix representation computed so far, modulo m.
+						modulus_type y = v[j - 1u] % m;
+						for (m_size_type i = j - 1u; i > 0u; --i) {
+							y = (mul_mod(y,moduli[i - 1u] % m,m) + v[i - 1u] % m) % m;
+						}
+						v[j] = mul_mod((residues[j][n] + (m - y)) % m,inv[j],m);
+					}
+					auto &x = cf_vector[n];
+					x = v[n_moduli - 1u];
+					for (m_size_type i = n_moduli - 1u; i > 0u; --i) {
+						x *= moduli[i - 1u];
+						x += v[i - 1u];
+					}
+					if (x > half_M) {
+						x -= M;
+					}
 				}
+			};
+			if (n_threads > 1u) {
+				range_dispenser rd(boost::numeric_cast<bucket_size_type>(size),n_threads);
+				auto thread_function = [&rd,&reconstruct]() {
+					range_type r;
+					try {
+						while (rd.next(r)) {
+							reconstruct(r.first,r.second);
+						}
+					} catch (...) {
+						rd.stop();
+						throw;
+					}
+				};
+				base::run_threads(thread_function,n_threads);
+			} else {
+				reconstruct(0u,size);
 			}
-			if (size1 % bsize1) {
-				for (index_type j = 0u; j < size2 / bsize2; ++j) {
-					ins_result = task_list.insert(task_from_indices((size1 / bsize1) * bsize1,size1,j * bsize2,(j + 1u) * bsize2,retval));
-					piranha_assert(ins_result->m_b1.first != ins_result->m_b1.second && ins_result->m_b2.first != ins_result->m_b2.second);
+			for (typename std::vector<integer>::size_type n = 0u; n < size; ++n) {
+				if (!math::is_zero(cf_vector[n])) {
+					inserter(boost::numeric_cast<value_type>(n),std::move(cf_vector[n]));
 				}
-				if (size2 % bsize2) {
-					ins_result = task_list.insert(task_from_indices((size1 / bsize1) * bsize1,size1,(size2 / bsize2) * bsize2,size2,retval));
-					piranha_assert(ins_result->m_b1.first != ins_result->m_b1.second && ins_result->m_b2.first != ins_result->m_b2.second);
+			}
+		}
+#endif
+		static integer fixed_width_to_integer(const dense_int64 &n)
+		{
+			return integer(n);
+		}
+		// Generic dense accumulation: the coefficients are accumulated directly in the coefficient type of the first series.
+		template <typename NewKeys1, typename NewKeys2, typename Inserter, typename T1 = term_type1, typename T2 = term_type2>
+		void dense_accumulation(const NewKeys1 &new_keys1, const NewKeys2 &new_keys2, const value_type &hmin, const value_type &hmax,
+			const Inserter &inserter, typename std::enable_if<!std::is_same<typename T1::cf_type,integer>::value ||
+			!std::is_same<typename T2::cf_type,integer>::value>::type * = nullptr) const
+		{
+			std::vector<typename term_type1::cf_type const *> cfs1;
+			std::vector<typename term_type2::cf_type const *> cfs2;
+			cfs1.reserve(new_keys1.size());
+			cfs2.reserve(new_keys2.size());
+			for (const auto &p: new_keys1) {
+				cfs1.push_back(&p.second->m_cf);
+			}
+			for (const auto &p: new_keys2) {
+				cfs2.push_back(&p.second->m_cf);
+			}
+			dense_kernel<typename term_type1::cf_type>(new_keys1,new_keys2,cfs1,cfs2,hmin,hmax,
+				[&inserter](const value_type &n, typename term_type1::cf_type &cf) {inserter(n,std::move(cf));});
+		}
+		// Dense accumulation for integer coefficients. The maximum absolute value of the coefficients of the result is bounded
+		// by the product of the maximum absolute values of the coefficients of the operands times the maximum number of products
+		// contributing to a single term of the result. If such bound fits, the accumulation is performed in 64-bit or 128-bit
+		// hardware integers, otherwise integer is used.
+		template <typename NewKeys1, typename NewKeys2, typename Inserter, typename T1 = term_type1, typename T2 = term_type2>
+		void dense_accumulation(const NewKeys1 &new_keys1, const NewKeys2 &new_keys2, const value_type &hmin, const value_type &hmax,
+			const Inserter &inserter, typename std::enable_if<std::is_same<typename T1::cf_type,integer>::value &&
+			std::is_same<typename T2::cf_type,integer>::value>::type * = nullptr) const
+		{
+			integer bound;
+			const unsigned width = integer_dense_width(bound);
+			if (width == 64u) {
+				fixed_width_dense_accumulation<dense_int64>(new_keys1,new_keys2,hmin,hmax,inserter);
+				return;
+			}
+#if defined(PIRANHA_GCC_INT128_T)
+			if (width == 128u) {
+				fixed_width_dense_accumulation<dense_int128>(new_keys1,new_keys2,hmin,hmax,inserter);
+				return;
+			}
+			// NOTE: this limit on the number of products contributing to a single term of the result prevents
+			// the overflow of the accumulators in the modular kernels (see multi_modular_dense_accumulation()).
+			if (std::min(new_keys1.size(),new_keys2.size()) < (1ull << 28u)) {
+				multi_modular_dense_accumulation(new_keys1,new_keys2,hmin,hmax,inserter,bound);
+				return;
+			}
+#endif
+			std::vector<integer const *> cfs1, cfs2;
+			cfs1.reserve(new_keys1.size());
+			cfs2.reserve(new_keys2.size());
+			for (const auto &p: new_keys1) {
+				cfs1.push_back(&p.second->m_cf);
+			}
+			for (const auto &p: new_keys2) {
+				cfs2.push_back(&p.second->m_cf);
+			}
+			dense_kernel<integer>(new_keys1,new_keys2,cfs1,cfs2,hmin,hmax,
+				[&inserter](const value_type &n, integer &cf) {inserter(n,std::move(cf));});
+		}
+		// Width of the hardware integers in which the dense multiplication of integer coefficients can accumulate (64 or 128 bits),
+		// or zero if no hardware integer is wide enough. bound will contain the bound on the absolute values of the coefficients of
+		// the result.
+		template <typename T1 = term_type1, typename T2 = term_type2>
+		unsigned integer_dense_width(integer &bound, typename std::enable_if<std::is_same<typename T1::cf_type,integer>::value &&
+			std::is_same<typename T2::cf_type,integer>::value>::type * = nullptr) const
+		{
+			integer max1(0), max2(0);
+			for (const auto &ptr: this->m_v1) {
+				max1 = std::max(max1,ptr->m_cf.abs());
+			}
+			for (const auto &ptr: this->m_v2) {
+				max2 = std::max(max2,ptr->m_cf.abs());
+			}
+			// NOTE: in squaring mode the products of distinct terms are doubled.
+			bound = max1 * max2 * std::min(this->m_v1.size(),this->m_v2.size()) * (this->m_square ? 2 : 1);
+			if (bound <= std::numeric_limits<dense_int64>::max()) {
+				return 64u;
+			}
+#if defined(PIRANHA_GCC_INT128_T)
+			// NOTE: the maximum value of the signed 128-bit type is 2**127 - 1. The coefficients of the operands
+			// are converted to 128 bits via a signed 64-bit integer, so they must fit in it.
+			if (bound < integer(2).pow(127) && max1 <= std::numeric_limits<dense_int64>::max() &&
+				max2 <= std::numeric_limits<dense_int64>::max())
+			{
+				return 128u;
+			}
+#endif
+			return 0u;
+		}
+		// Convert the integer coefficients of the operands to the hardware integer type Int, and run the dense kernel.
+		template <typename Int, typename NewKeys1, typename NewKeys2, typename Inserter>
+		void fixed_width_dense_accumulation(const NewKeys1 &new_keys1, const NewKeys2 &new_keys2, const value_type &hmin,
+			const value_type &hmax, const Inserter &inserter) const
+		{
+			std::vector<Int> v1, v2;
+			std::vector<Int const *> cfs1, cfs2;
+			v1.reserve(new_keys1.size());
+			v2.reserve(new_keys2.size());
+			cfs1.reserve(new_keys1.size());
+			cfs2.reserve(new_keys2.size());
+			// NOTE: the caller checks that the coefficients of the operands fit in a signed 64-bit integer.
+			for (const auto &p: new_keys1) {
+				v1.push_back(static_cast<Int>(static_cast<dense_int64>(p.second->m_cf)));
+				cfs1.push_back(&v1.back());
+			}
+			for (const auto &p: new_keys2) {
+				v2.push_back(static_cast<Int>(static_cast<dense_int64>(p.second->m_cf)));
+				cfs2.push_back(&v2.back());
+			}
+			dense_kernel<Int>(new_keys1,new_keys2,cfs1,cfs2,hmin,hmax,
+				[&inserter](const value_type &n, Int &cf) {inserter(n,fixed_width_to_integer(cf));});
+		}
+		// Dense multiplication kernel. cfs1 and cfs2 point to the coefficients of the terms in new_keys1 and new_keys2,
+		// and the products are accumulated in vectors of Acc instances covering windows of the range of codes [hmin,hmax].
+		// The windows are processed in parallel if possible. When a window is completed, its nonzero accumulated values are
+		// passed to inserter as mutable references, together with their position in the range. The calls to inserter
+		// are serialised.
+		template <typename Acc, typename NewKeys1, typename NewKeys2, typename Cf1, typename Cf2, typename Inserter>
+		void dense_kernel(const NewKeys1 &new_keys1, const NewKeys2 &new_keys2, const std::vector<Cf1 const *> &cfs1,
+			const std::vector<Cf2 const *> &cfs2, const value_type &hmin, const value_type &hmax, const Inserter &inserter) const
+		{
+			const index_type size1 = boost::numeric_cast<index_type>(new_keys1.size()),
+				size2 = boost::numeric_cast<index_type>(new_keys2.size());
+			piranha_assert(cfs1.size() == size1 && cfs2.size() == size2);
+			// Extract the codes, so that they can be used in the multiplication kernel.
+			std::vector<value_type> codes1, codes2;
+			codes1.reserve(new_keys1.size());
+			codes2.reserve(new_keys2.size());
+			std::transform(new_keys1.begin(),new_keys1.end(),std::back_inserter(codes1),[](const typename NewKeys1::value_type &p) {return p.first;});
+			std::transform(new_keys2.begin(),new_keys2.end(),std::back_inserter(codes2),[](const typename NewKeys2::value_type &p) {return p.first;});
+			const dense_window_accumulator<Acc,Cf1,Cf2> accumulator(codes1,codes2,cfs1,cfs2,this->m_square);
+			// Split the output range in windows.
+			const bucket_size_type range_size = boost::numeric_cast<bucket_size_type>((hmax - hmin) + 1),
+				w_size = dense_window_size(range_size,sizeof(Acc),std::max(size1,size2)),
+				n_windows = static_cast<bucket_size_type>(range_size / w_size + static_cast<bucket_size_type>(range_size % w_size != 0u));
+			typedef decltype(this->determine_n_threads()) thread_size_type;
+			const thread_size_type n_threads = static_cast<thread_size_type>(std::min<bucket_size_type>(this->determine_n_threads(),n_windows));
+			std::atomic<bucket_size_type> next_window(0u);
+			std::mutex mutex;
+			auto thread_function = [&]() {
+				std::vector<Acc> window(boost::numeric_cast<typename std::vector<Acc>::size_type>(w_size));
+				try {
+					for (auto w_idx = next_window.fetch_add(1u); w_idx < n_windows; w_idx = next_window.fetch_add(1u)) {
+						// Absolute positions of the beginning and end of the current window in the output range.
+						const bucket_size_type w_start = static_cast<bucket_size_type>(w_idx * w_size),
+							w_end = (range_size - w_start > w_size) ? static_cast<bucket_size_type>(w_start + w_size) : range_size;
+						// Accumulate the products whose codes sum to values in the window.
+						accumulator(window,static_cast<value_type>(hmin + static_cast<value_type>(w_start)),
+							static_cast<value_type>(hmin + static_cast<value_type>(w_end - 1u)));
+						// Flush the window and reset it.
+						std::unique_lock<std::mutex> lock(mutex,std::defer_lock);
+						if (n_threads > 1u) {
+							lock.lock();
+						}
+						for (bucket_size_type k = 0u; k < w_end - w_start; ++k) {
+							auto &acc = window[static_cast<typename std::vector<Acc>::size_type>(k)];
+							if (!math::is_zero(acc)) {
+								inserter(boost::numeric_cast<value_type>(w_start + k),acc);
+								acc = Acc();
+							}
+						}
+					}
+				} catch (...) {
+					// Stop the other threads.
+					next_window.store(n_windows);
+					throw;
 				}
+			};
+			if (n_threads > 1u) {
+				base::run_threads(thread_function,n_threads);
+			} else {
+				thread_function();
 			}
+		}
+		// Accumulation of the products of the terms of the operands whose codes sum to values in the closed interval [c_start,c_end]
+		// into the dense window of accumulators starting at c_start. In squaring mode, the two vectors of codes are identical (the codes
+		// are unique), and the products of distinct terms are computed only once, using the doubled coefficients of the first operand.
+		template <typename Acc, typename Cf1, typename Cf2, typename = void>
+		class dense_window_accumulator
+		{
+			public:
+				explicit dense_window_accumulator(const std::vector<value_type> &codes1, const std::vector<value_type> &codes2,
+					const std::vector<Cf1 const *> &cfs1, const std::vector<Cf2 const *> &cfs2, bool square):
+					m_codes1(codes1),m_codes2(codes2),m_cfs1(cfs1),m_cfs2(cfs2),m_square(square)
+				{
+					if (square) {
+						m_dcfs.reserve(cfs1.size());
+						for (const auto &ptr: cfs1) {
+							m_dcfs.push_back(*ptr);
+							m_dcfs.back() *= 2;
+						}
+					}
+				}
+				void operator()(std::vector<Acc> &window, const value_type &c_start, const value_type &c_end) const
+				{
+					auto mult = [&](const index_type &i, const index_type &j) {
+						const auto idx = static_cast<typename std::vector<Acc>::size_type>((m_codes1[i] + m_codes2[j]) - c_start);
+						piranha_assert(idx < window.size());
+						math::multiply_accumulate(window[idx],(m_square && i != j) ? m_dcfs[i] : *m_cfs1[i],*m_cfs2[j]);
+					};
+					// Loop over the smaller series in the outer cycle. In squaring mode, only the upper triangle is considered.
+					if (m_codes1.size() <= m_codes2.size()) {
+						base::range_kernel(m_codes1,m_codes2,c_start,c_end,mult,m_square);
+					} else {
+						base::range_kernel(m_codes2,m_codes1,c_start,c_end,[&mult](const index_type &j, const index_type &i) {
+							mult(i,j);
+						});
+					}
+				}
+			private:
+				const std::vector<value_type>	&m_codes1;
+				const std::vector<value_type>	&m_codes2;
+				const std::vector<Cf1 const *>	&m_cfs1;
+				const std::vector<Cf2 const *>	&m_cfs2;
+				const bool			m_square;
+				std::vector<Cf1>		m_dcfs;
+		};
+		// Specialisation for single and double precision coefficients. The coefficients are copied into contiguous vectors,
+		// and each row of products landing in the window is accumulated via the (possibly vectorised) detail::scatter_fma() kernel.
+		template <typename T>
+		class dense_window_accumulator<T,T,T,typename std::enable_if<(std::is_same<T,double>::value || std::is_same<T,float>::value) &&
+			std::is_signed<value_type>::value && sizeof(value_type) == 8u>::type>
+		{
+			public:
+				explicit dense_window_accumulator(const std::vector<value_type> &codes1, const std::vector<value_type> &codes2,
+					const std::vector<T const *> &cfs1, const std::vector<T const *> &cfs2, bool square):
+					m_codes1(codes1),m_codes2(codes2),m_square(square)
+				{
+					m_cfs1.reserve(cfs1.size());
+					m_cfs2.reserve(cfs2.size());
+					std::transform(cfs1.begin(),cfs1.end(),std::back_inserter(m_cfs1),[](T const *ptr) {return *ptr;});
+					std::transform(cfs2.begin(),cfs2.end(),std::back_inserter(m_cfs2),[](T const *ptr) {return *ptr;});
+				}
+				void operator()(std::vector<T> &window, const value_type &c_start, const value_type &c_end) const
+				{
+					typedef typename std::vector<value_type>::size_type size_type;
+					const bool swapped = m_codes1.size() > m_codes2.size();
+					const std::vector<value_type> &outer = swapped ? m_codes2 : m_codes1, &inner = swapped ? m_codes1 : m_codes2;
+					const std::vector<T> &outer_cfs = swapped ? m_cfs2 : m_cfs1, &inner_cfs = swapped ? m_cfs1 : m_cfs2;
+					base::range_rows(outer,inner,c_start,c_end,[&](const size_type &i, size_type j_start, const size_type &j_end) {
+						// Position in the window of outer[i] + inner[j] is inner[j] + offset.
+						const value_type offset = outer[i] - c_start;
+						T a = outer_cfs[i];
+						if (m_square) {
+							// The diagonal term is not doubled.
+							if (j_start == i) {
+								math::multiply_accumulate(window[static_cast<size_type>(inner[i] + offset)],a,inner_cfs[i]);
+								++j_start;
+							}
+							a *= 2;
+						}
+						piranha_assert(j_start == j_end || static_cast<size_type>(inner[j_end - 1u] + offset) < window.size());
+						detail::scatter_fma(window.data(),inner.data() + j_start,inner_cfs.data() + j_start,
+							static_cast<std::size_t>(j_end - j_start),a,offset);
+					},m_square);
+				}
+			private:
+				const std::vector<value_type>	&m_codes1;
+				const std::vector<value_type>	&m_codes2;
+				std::vector<T>			m_cfs1;
+				std::vector<T>			m_cfs2;
+				const bool			m_square;
+		};
+		// Size of the windows in which the output range of size range_size is split in the dense kernel. The accumulators
+		// of a window (of size acc_size each) should fit in the L2 cache, but the number of windows should also be small
+		// with respect to the size of the larger operand, as locating the terms contributing to each window has a cost
+		// proportional to the size of the smaller operand.
+		static bucket_size_type dense_window_size(const bucket_size_type &range_size, const std::size_t &acc_size, const index_type &max_size)
+		{
+			piranha_assert(range_size && acc_size && max_size);
+			// NOTE: 1MB turned out to be a good compromise on current hardware.
+			const std::size_t window_bytes = 1048576u;
+			const bucket_size_type cache_size = static_cast<bucket_size_type>(std::max<std::size_t>(std::size_t(1u),
+				window_bytes / acc_size)), min_size = static_cast<bucket_size_type>(range_size / max_size * 8u);
+			return std::min(range_size,std::max(cache_size,min_size));
+		}
+		// Sparse multiplication method. If limits is not empty, the multiplication is truncated according
+		// to the limits computed by prepare_truncation().
+		template <typename Functor>
+		void sparse_multiplication(return_type &retval, const std::vector<index_type> &limits) const
+		{
+			const index_type size1 = this->m_v1.size(), size2 = boost::numeric_cast<index_type>(this->m_v2.size());
 			typedef decltype(this->determine_n_threads()) thread_size_type;
 			const thread_size_type n_threads = this->determine_n_threads();
+			if (!limits.empty()) {
+				piranha_assert(limits.size() == size1);
+				if (n_threads == 1u) {
+					// NOTE: here the operands are sorted by degree, and the truncated blocked multiplication
+					// of the base class takes care of skipping the terms beyond the limits.
+					typedef typename Functor::fast_rebind fast_functor_type;
+					fast_functor_type f(&this->m_v1[0u],size1,&this->m_v2[0u],size2,retval);
+					try {
+						if (this->m_square) {
+							std::vector<term_type1> d_terms;
+							std::vector<term_type1 const *> dv1;
+							double_terms(this->m_v1,d_terms,dv1);
+							fast_functor_type f_off(&dv1[0u],size1,&this->m_v2[0u],size2,retval);
+							base::blocked_squaring(f,f_off,&limits[0u]);
+							base::sanitize_series(retval,f.m_insertion_count + f_off.m_insertion_count);
+						} else {
+							base::blocked_multiplication(f,&limits[0u]);
+							base::sanitize_series(retval,f.m_insertion_count);
+						}
+					} catch (...) {
+						retval.m_container.clear();
+						throw;
+					}
+				} else {
+					sparse_multi_thread<Functor>(retval,n_threads,&limits);
+				}
+				return;
+			}
+			sort_by_output_bucket(retval);
 			if (n_threads == 1u) {
+				// Start defining the blocks for series multiplication.
+				const auto bsizes = get_block_sizes(size1,size2);
+				// Cast to hardware integers.
+				const auto bsize1 = static_cast<index_type>(bsizes.first), bsize2 = static_cast<index_type>(bsizes.second);
+				// Create the list of tasks.
+				// NOTE: the way tasks are created, there is never an empty task - all intervals have nonzero sizes.
+				// The task are sorted according to the index of the first bucket of retval that will be written to,
+				// so we need a multiset as different tasks might have the same starting position.
+				std::multiset<task_type,sparse_task_sorter> task_list(sparse_task_sorter(retval,this->m_v1,this->m_v2));
+				build_task_list(task_list,size1,size2,bsize1,bsize2,this->m_square);
 				// Perform the multiplication. We need this try/catch because, by using the fast interface,
 				// in case of an error the container in retval could be left in an inconsistent state.
 				try {
@@ -1325,125 +2403,172 @@ class series_multiplier<Series1,Series2,typename std::enable_if<detail::kronecke
 					throw;
 				}
 			} else {
-				// Insertion counter.
-				bucket_size_type insertion_count = 0u;
-				// Set of busy bucket regions, ordered by starting point.
-				// NOTE: we do not need a multiset, as regions that compare equal (i.e., same starting point) will not exist
-				// at the same time in the set by design.
-				region_comparer rc;
-				std::set<region_type,region_comparer> busy_regions(rc);
-				// Synchronization.
-				std::mutex m;
-				std::condition_variable cond;
-				// Thread function.
-				auto thread_function = [&cond,&m,&insertion_count,&task_list,&busy_regions,&retval,this] () {
-					task_type task;
-					while (true) {
-						{
-							// First, lock down everything.
-							std::unique_lock<std::mutex> lock(m);
-							if (task_list.empty()) {
-								break;
-							}
-							// Look for a suitable task.
-							const auto it_f = task_list.end();
-							auto it = task_list.begin();
-							for (; it != it_f; ++it) {
-								// Check the regions.
-								if (this->region_checker(it->m_r1,busy_regions) &&
-									(!it->m_second_region || this->region_checker(it->m_r2,busy_regions)))
-								{
-									try {
-										// The regions are ok, insert them and break the cycle.
-										auto tmp = busy_regions.insert(it->m_r1);
-										piranha_assert(tmp.second);
-										if (it->m_second_region) {
-											tmp = busy_regions.insert(it->m_r2);
-											piranha_assert(tmp.second);
-										}
-										piranha_assert(this->region_set_checker(busy_regions));
-									} catch (...) {
-										// NOTE: the idea here is that in case of errors
-										// we want to restore the original situation
-										// as if nothing happened.
-										this->cleanup_regions(busy_regions,*it);
-										throw;
-									}
-									break;
-								}
-							}
-							// We might have identified a suitable task, check it is not end().
-							if (it == it_f) {
-								// The thread can't do anything, will have to wait until something happens
-								// and then re-identify a good task.
-								cond.wait(lock);
-								continue;
-							}
-							// Now we have a good task, pop it from the task list.
-							task = *it;
-							task_list.erase(it);
+				sparse_multi_thread<Functor>(retval,n_threads);
+			}
+		}
+		// Sort the input terms according to the position of the Kronecker keys in the return value.
+		void sort_by_output_bucket(const return_type &retval) const
+		{
+			auto sorter1 = [&retval](term_type1 const *ptr1, term_type1 const *ptr2) {
+				return retval.m_container._bucket_from_hash(ptr1->hash()) < retval.m_container._bucket_from_hash(ptr2->hash());
+			};
+			auto sorter2 = [&retval](term_type2 const *ptr1, term_type2 const *ptr2) {
+				return retval.m_container._bucket_from_hash(ptr1->hash()) < retval.m_container._bucket_from_hash(ptr2->hash());
+			};
+			std::sort(this->m_v1.begin(),this->m_v1.end(),sorter1);
+			if (this->m_square) {
+				this->align_square_operands();
+			} else {
+				std::sort(this->m_v2.begin(),this->m_v2.end(),sorter2);
+			}
+		}
+		// Multi-thread sparse multiplication. The terms of the operands are expected to be sorted by bucket,
+		// unless limits is not null: in such case, the operands are sorted by degree and they will be
+		// re-sorted here by bucket, keeping track of the original positions for the purpose of truncation.
+		template <typename Functor>
+		void sparse_multi_thread(return_type &retval, unsigned n_threads, const std::vector<index_type> *limits = nullptr) const
+		{
+			typedef typename Functor::fast_rebind fast_functor_type;
+			const index_type size1 = this->m_v1.size(), size2 = boost::numeric_cast<index_type>(this->m_v2.size());
+			const auto b_count = retval.m_container.bucket_count();
+			piranha_assert(b_count);
+			// In truncated mode, lim1[i] is the limit of the i-th term of the first series, and rank2[j] the
+			// position of the j-th term of the second series in the ordering by degree. The multiplication
+			// of the terms i and j is then performed only if rank2[j] < lim1[i].
+			std::vector<index_type> lim1, rank2;
+			if (limits != nullptr) {
+				piranha_assert(limits->size() == size1);
+				sort_by_bucket(this->m_v1,retval,lim1,*limits);
+				std::vector<index_type> ranks(size2);
+				std::iota(ranks.begin(),ranks.end(),index_type(0u));
+				sort_by_bucket(this->m_v2,retval,rank2,ranks);
+			}
+			const bool truncated = (limits != nullptr), square = this->m_square;
+			// In squaring mode, the products of distinct terms are computed only once, using the doubled terms. The operands
+			// might not be aligned here (in truncated mode they are sorted separately), hence the pairs are selected by comparing
+			// the pointers to the terms.
+			std::vector<term_type1> d_terms;
+			std::vector<term_type1 const *> dv1;
+			if (square) {
+				double_terms(this->m_v1,d_terms,dv1);
+			}
+			term_type1 const **ptr_off = square ? &dv1[0u] : &this->m_v1[0u];
+			// Cache the bucket indices of the terms of the two series. The bucket of the product
+			// of two Kronecker monomials is the sum, modulo the bucket count, of the buckets of the operands,
+			// as the hash of a Kronecker monomial is its code and the bucket count is a power of two.
+			std::vector<bucket_size_type> buckets1, buckets2;
+			buckets1.reserve(boost::numeric_cast<decltype(buckets1.size())>(size1));
+			buckets2.reserve(boost::numeric_cast<decltype(buckets2.size())>(size2));
+			std::transform(this->m_v1.begin(),this->m_v1.end(),std::back_inserter(buckets1),[&retval](term_type1 const *ptr) {
+				return retval.m_container._bucket_from_hash(ptr->hash());
+			});
+			std::transform(this->m_v2.begin(),this->m_v2.end(),std::back_inserter(buckets2),[&retval](term_type2 const *ptr) {
+				return retval.m_container._bucket_from_hash(ptr->hash());
+			});
+			// Insertion counter.
+			std::atomic<bucket_size_type> insertion_count(0u);
+			range_dispenser rd(b_count,n_threads);
+			// Thread function.
+			auto thread_function = [&rd,&insertion_count,&buckets1,&buckets2,&lim1,&rank2,&retval,truncated,square,ptr_off,b_count,size1,size2,this] () {
+				fast_functor_type f(&this->m_v1[0u],size1,&this->m_v2[0u],size2,retval), f_off(ptr_off,size1,&this->m_v2[0u],size2,retval);
+				auto mult = [&f,&f_off,&lim1,&rank2,truncated,square,this](const index_type &i, const index_type &j) {
+					if (!truncated || rank2[j] < lim1[i]) {
+						const int c = square ? base::compare_square_terms(this->m_v1[i],this->m_v2[j]) : -1;
+						if (c < 0) {
+							f_off(i,j);
+							f_off.insert();
+						} else if (c == 0) {
+							f(i,j);
+							f.insert();
 						}
-						bucket_size_type tmp_ins_count = 0u;
-						try {
-							// Perform the multiplication on the selected task.
-							typedef typename Functor::fast_rebind fast_functor_type;
-							const index_type i_start = task.m_b1.first, j_start = task.m_b2.first,
-								i_end = task.m_b1.second, j_end = task.m_b2.second;
-							piranha_assert(i_end > i_start && j_end > j_start);
-							const index_type i_size = i_end - i_start, j_size = j_end - j_start;
-							fast_functor_type f(&this->m_v1[0u] + i_start,i_size,&this->m_v2[0u] + j_start,j_size,retval);
-							for (index_type i = 0u; i < i_size; ++i) {
-								for (index_type j = 0u; j < j_size; ++j) {
-									f(i,j);
-									f.insert();
-								}
-							}
-							tmp_ins_count = f.m_insertion_count;
-						} catch (...) {
-							// Re-acquire the lock.
-							std::lock_guard<std::mutex> lock(m);
-							// Cleanup the regions.
-							this->cleanup_regions(busy_regions,task);
-							// Notify all waiting threads that a region was removed from the busy set.
-							cond.notify_all();
-							throw;
+					}
+				};
+				// Process a row of products, prefetching the output buckets in advance.
+				auto mult_row = [&f,&mult](const index_type &i, const index_type &j_start, const index_type &j_end) {
+					for (index_type j = j_start; j < j_end; ++j) {
+						if (j + base::prefetch_distance < j_end) {
+							f.prefetch(i,j + base::prefetch_distance);
 						}
-						{
-							// Re-acquire the lock.
-							std::lock_guard<std::mutex> lock(m);
-							// Update the insertion count.
-							insertion_count += tmp_ins_count;
-							// Take out the regions in which we just wrote from the set of busy regions.
-							this->cleanup_regions(busy_regions,task);
-							// Notify all waiting threads that a region was removed from the busy set.
-							cond.notify_all();
+						mult(i,j);
+					}
+				};
+				auto mult_row_swapped = [&f,&mult](const index_type &j, const index_type &i_start, const index_type &i_end) {
+					for (index_type i = i_start; i < i_end; ++i) {
+						if (i + base::prefetch_distance < i_end) {
+							f.prefetch(i + base::prefetch_distance,j);
 						}
+						mult(i,j);
 					}
 				};
-				future_list<decltype(thread_pool::enqueue(0u,thread_function))> f_list;
+				range_type r;
 				try {
-					for (thread_size_type i = 0u; i < n_threads; ++i) {
-						f_list.push_back(thread_pool::enqueue(i,thread_function));
+					while (rd.next(r)) {
+						// The sums of the bucket indices of the operands landing in r modulo b_count form the
+						// closed intervals [r.first,r.second - 1] and [r.first + b_count,r.second - 1 + b_count].
+						// NOTE: there are no overflows here, as the max bucket count is 2 ** (n - 1).
+						const bucket_size_type t_start[] = {r.first,r.first + b_count},
+							t_end[] = {r.second - 1u,r.second - 1u + b_count};
+						for (std::size_t k = 0u; k < 2u; ++k) {
+							// Loop over the smaller series in the outer cycle.
+							if (size1 <= size2) {
+								base::range_rows(buckets1,buckets2,t_start[k],t_end[k],mult_row);
+							} else {
+								base::range_rows(buckets2,buckets1,t_start[k],t_end[k],mult_row_swapped);
+							}
+						}
 					}
-					// First let's wait for everything to finish.
-					f_list.wait_all();
-					// Then, let's handle the exceptions.
-					f_list.get_all();
-					// Finally, fix the series.
-					sanitize_series(retval,insertion_count,n_threads);
 				} catch (...) {
-					f_list.wait_all();
-					// Clean up and re-throw.
-					retval.m_container.clear();
+					rd.stop();
 					throw;
 				}
+				insertion_count += f.m_insertion_count + f_off.m_insertion_count;
+			};
+			try {
+				base::run_threads(thread_function,n_threads);
+				// Finally, fix the series.
+				base::sanitize_series(retval,insertion_count.load(),n_threads);
+			} catch (...) {
+				// Clean up and re-throw.
+				retval.m_container.clear();
+				throw;
 			}
 		}
+		// Sort the term pointers in v according to the position of the Kronecker keys in retval, and store in out the
+		// elements of in permuted accordingly.
+		template <typename Term>
+		static void sort_by_bucket(std::vector<Term const *> &v, const return_type &retval, std::vector<index_type> &out,
+			const std::vector<index_type> &in)
+		{
+			piranha_assert(v.size() == in.size());
+			std::vector<index_type> perm(in.size());
+			std::iota(perm.begin(),perm.end(),index_type(0u));
+			std::sort(perm.begin(),perm.end(),[&v,&retval](const index_type &a, const index_type &b) {
+				return retval.m_container._bucket_from_hash(v[a]->hash()) < retval.m_container._bucket_from_hash(v[b]->hash());
+			});
+			std::vector<Term const *> tmp;
+			tmp.reserve(v.size());
+			out.clear();
+			out.reserve(in.size());
+			for (const auto &idx: perm) {
+				tmp.push_back(v[idx]);
+				out.push_back(in[idx]);
+			}
+			v = std::move(tmp);
+		}
 		// Single-thread sparse multiplication.
+		// In squaring mode, the task list must contain only the tasks on or above the diagonal.
 		template <typename Functor, typename TaskList>
 		void sparse_single_thread(return_type &retval, const TaskList &task_list) const
 		{
 			typedef typename Functor::fast_rebind fast_functor_type;
+			// In squaring mode, the products of distinct terms are computed using the doubled terms. Otherwise,
+			// f_off below operates on the same terms as f.
+			std::vector<term_type1> d_terms;
+			std::vector<term_type1 const *> dv1;
+			if (this->m_square) {
+				double_terms(this->m_v1,d_terms,dv1);
+			}
+			term_type1 const **ptr_off = this->m_square ? &dv1[0u] : &this->m_v1[0u];
 			bucket_size_type insertion_count = 0u;
 			const auto it_f = task_list.end();
 			for (auto it = task_list.begin(); it != it_f; ++it) {
@@ -1451,91 +2576,39 @@ class series_multiplier<Series1,Series2,typename std::enable_if<detail::kronecke
 					i_end = it->m_b1.second, j_end = it->m_b2.second;
 				piranha_assert(i_end > i_start && j_end > j_start);
 				const index_type i_size = i_end - i_start, j_size = j_end - j_start;
-				fast_functor_type f(&this->m_v1[0u] + i_start,i_size,&this->m_v2[0u] + j_start,j_size,retval);
+				fast_functor_type f(&this->m_v1[0u] + i_start,i_size,&this->m_v2[0u] + j_start,j_size,retval),
+					f_off(ptr_off + i_start,i_size,&this->m_v2[0u] + j_start,j_size,retval);
 				for (index_type i = 0u; i < i_size; ++i) {
-					for (index_type j = 0u; j < j_size; ++j) {
+					index_type j = 0u;
+					if (this->m_square && i_start + i >= j_start) {
+						// Diagonal block: skip the lower triangle and compute the diagonal product normally.
+						j = i_start + i - j_start;
+						if (j >= j_size) {
+							continue;
+						}
 						f(i,j);
 						f.insert();
+						++j;
 					}
+					base::multiply_row(f_off,i,j,j_size);
 				}
-				insertion_count += f.m_insertion_count;
+				insertion_count += f.m_insertion_count + f_off.m_insertion_count;
 			}
-			sanitize_series(retval,insertion_count);
+			base::sanitize_series(retval,insertion_count);
 		}
-		// Sanitize series after completion of sparse multiplication.
-		static void sanitize_series(return_type &retval, const bucket_size_type &insertion_count, unsigned n_threads = 1u)
-		{
-			// Here we have to do the following things:
-			// - check ignorability of terms,
-			// - cope with excessive load factor,
-			// - update the size of the series.
-			// Compatibility is not a concern for polynomials.
-			// First, let's fix the size of inserted terms.
-			retval.m_container._update_size(insertion_count);
-			// Second, erase the ignorable terms.
-			if (n_threads == 1u) {
-				const auto it_f = retval.m_container.end();
-				for (auto it = retval.m_container.begin(); it != it_f;) {
-					if (unlikely(it->is_ignorable(retval.m_symbol_set))) {
-						it = retval.m_container.erase(it);
-					} else {
-						++it;
-					}
-				}
-			} else {
-				const auto b_count = retval.m_container.bucket_count();
-				piranha_assert(b_count);
-				// Adjust the number of threads if they are more than the bucket count.
-				const unsigned nt = (n_threads <= b_count) ? n_threads : static_cast<unsigned>(b_count);
-				std::mutex m;
-				auto eraser = [b_count,&retval,&m](const bucket_size_type &start, const bucket_size_type &end) {
-					piranha_assert(start < end && end <= b_count);
-					bucket_size_type erase_count = 0u;
-					std::vector<term_type1> term_list;
-					for (bucket_size_type i = start; i != end; ++i) {
-						term_list.clear();
-						const auto &bl = retval.m_container._get_bucket_list(i);
-						const auto it_f = bl.end();
-						for (auto it = bl.begin(); it != it_f; ++it) {
-							if (unlikely(it->is_ignorable(retval.m_symbol_set))) {
-								term_list.push_back(*it);
-							}
-						}
-						for (auto it = term_list.begin(); it != term_list.end(); ++it) {
-							// NOTE: must use _erase to avoid concurrent modifications
-							// to the number of elements in the table.
-							retval.m_container._erase(retval.m_container._find(*it,i));
-							++erase_count;
-						}
-					}
-					if (erase_count) {
-						std::lock_guard<std::mutex> lock(m);
-						piranha_assert(erase_count <= retval.m_container.size());
-						retval.m_container._update_size(retval.m_container.size() - erase_count);
-					}
-				};
-				future_list<decltype(thread_pool::enqueue(0u,eraser,bucket_size_type(),bucket_size_type()))> f_list;
-				try {
-					for (unsigned i = 0u; i < nt; ++i) {
-						const auto start = (b_count / nt) * i, end = (i == nt - 1u) ? b_count : (b_count / nt) * (i + 1u);
-						f_list.push_back(thread_pool::enqueue(i,eraser,start,end));
-					}
-					// First let's wait for everything to finish.
-					f_list.wait_all();
-					// Then, let's handle the exceptions.
-					f_list.get_all();
-				} catch (...) {
-					f_list.wait_all();
-					// Clean up and re-throw.
-					retval.m_container.clear();
-					throw;
-				}
-			}
-			// Finally, cope with excessive load factor.
-			if (unlikely(retval.m_container.load_factor() > retval.m_container.max_load_factor())) {
-				retval.m_container.rehash(
-					boost::numeric_cast<bucket_size_type>(std::ceil(static_cast<double>(retval.m_container.size()) / retval.m_container.max_load_factor()))
-				);
+		// Store in terms copies of the terms pointed to by v with doubled coefficients, and in dv the pointers
+		// to the copies. Used in squaring mode.
+		static void double_terms(const std::vector<term_type1 const *> &v, std::vector<term_type1> &terms,
+			std::vector<term_type1 const *> &dv)
+		{
+			terms.clear();
+			dv.clear();
+			terms.reserve(v.size());
+			dv.reserve(v.size());
+			for (const auto &ptr: v) {
+				terms.push_back(*ptr);
+				terms.back().m_cf *= 2;
+				dv.push_back(&terms.back());
 			}
 		}
 		// Functor for use in sparse multiplication.
@@ -1548,7 +2621,7 @@ class series_multiplier<Series1,Series2,typename std::enable_if<detail::kronecke
 			explicit sparse_functor(term_type1 const **ptr1, const index_type &s1,
 				term_type2 const **ptr2, const index_type &s2, return_type &retval):
 				base::default_functor(ptr1,s1,ptr2,s2,retval),
-				m_cached_i(0u),m_cached_j(0u),m_insertion_count(0u)
+				m_cached_i(0u),m_cached_j(0u),m_insertion_count(0u),m_prefetch(FastMode && base::prefetch_output(retval))
 			{}
 			void operator()(const index_type &i, const index_type &j) const
 			{
@@ -1558,6 +2631,17 @@ class series_multiplier<Series1,Series2,typename std::enable_if<detail::kronecke
 				m_cached_i = i;
 				m_cached_j = j;
 			}
+			// The bucket of the product is computed directly from the codes, as the hash of a Kronecker monomial is its code.
+			void prefetch(const index_type &i, const index_type &j) const
+			{
+				using int_type = decltype(this->m_ptr1[i]->m_key.get_int());
+				piranha_assert(i < this->m_s1 && j < this->m_s2);
+				if (m_prefetch) {
+					const auto &container = this->m_retval.m_container;
+					container._prefetch_bucket(container._bucket_from_hash(static_cast<std::size_t>(
+						static_cast<int_type>(this->m_ptr1[i]->m_key.get_int() + this->m_ptr2[j]->m_key.get_int()))));
+				}
+			}
 			void insert() const
 			{
 				// NOTE: be very careful: every kind of optimization in here must involve only the key part,
@@ -1586,24 +2670,18 @@ class series_multiplier<Series1,Series2,typename std::enable_if<detail::kronecke
 						// We need a new bucket index in case of a rehash.
 						bucket_idx = container._bucket(tmp);
 					}
-					// TODO optimize this in case of series and integer (?), now it is optimized for simple coefficients.
-					// Note that the best course of action here for integer multiplication would seem to resize tmp.m_cf appropriately
-					// and then use something like mpz_mul. On the other hand, it seems like in the insertion below we need to perform
-					// a copy anyway, so insertion with move seems ok after all? Mmmh...
-					// TODO: other important thing: for coefficient series, we probably want to insert with move() below,
-					// as we are not going to re-use the allocated resources in tmp.m_cf -> in other words, optimize this
-					// as much as possible.
 					// Take care of multiplying the coefficient.
-					tmp.m_cf = cf1;
-					tmp.m_cf *= cf2;
+					// NOTE: the key of tmp is re-set at every call of operator(), so it is fine to leave tmp in a moved-from state
+					// after the insertion below.
+					compute_cf(tmp.m_cf,cf1,cf2);
 					// Insert and update size.
 					// NOTE: in fast mode, the check will be done at the end.
 					// NOTE: the counters are protected from overflows by the check done in the operator() of the multiplier.
 					if (FastMode) {
-						container._unique_insert(tmp,bucket_idx);
+						container._unique_insert(std::move(tmp),bucket_idx);
 						++m_insertion_count;
 					} else if (likely(!tmp.is_ignorable(args))) {
-						container._unique_insert(tmp,bucket_idx);
+						container._unique_insert(std::move(tmp),bucket_idx);
 						container._update_size(container.size() + 1u);
 					}
 				} else {
@@ -1632,13 +2710,33 @@ class series_multiplier<Series1,Series2,typename std::enable_if<detail::kronecke
 					}
 				}
 			}
+			// If the coefficient types are the same, compute the product via the binary operator and move it into the output:
+			// this way multiprecision and series coefficients are allocated only once, with the appropriate size,
+			// and they are never copied.
+			template <typename Cf1, typename Cf2>
+			static void compute_cf(Cf1 &out, const Cf1 &cf1, const Cf2 &cf2, typename std::enable_if<
+				std::is_same<Cf1,Cf2>::value>::type * = nullptr)
+			{
+				out = cf1 * cf2;
+			}
+			template <typename Cf1, typename Cf2>
+			static void compute_cf(Cf1 &out, const Cf1 &cf1, const Cf2 &cf2, typename std::enable_if<
+				!std::is_same<Cf1,Cf2>::value>::type * = nullptr)
+			{
+				out = cf1;
+				out *= cf2;
+			}
 			mutable index_type		m_cached_i;
 			mutable index_type		m_cached_j;
 			mutable bucket_size_type	m_insertion_count;
+			const bool			m_prefetch;
 		};
 	private:
 		// Vector of closed ranges of the exponents in both the operands and the result.
 		std::vector<std::pair<integer,integer>> m_minmax_values;
+		// Conservative bounds of the exponents of the result, recorded in the key metadata of the result.
+		std::vector<value_type> m_result_min;
+		std::vector<value_type> m_result_max;
 };
 
 }
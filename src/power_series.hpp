@@ -27,8 +27,10 @@
 #include <type_traits>
 #include <utility>
 
+#include "degree_truncation.hpp"
 #include "detail/degree_commons.hpp"
 #include "forwarding.hpp"
+#include "integer.hpp"
 #include "math.hpp"
 #include "series.hpp"
 #include "symbol_set.hpp"
@@ -165,6 +167,29 @@ class power_series: public Series
 			}
 			#undef PIRANHA_TMP_RETURN
 		};
+		// The total (low) degree can be read from the cached key metadata if only the key has a degree
+		// and the metadata records the distribution of the degree.
+		template <typename T, typename ... Args>
+		struct cached_degree_enabler
+		{
+			static const bool value = sizeof...(Args) == 0u && term_score<T>::value == 2u &&
+				T::key_metadata_type::has_degree;
+		};
+		template <bool Low, typename R>
+		bool cached_degree(R &, std::false_type) const
+		{
+			return false;
+		}
+		template <bool Low, typename R>
+		bool cached_degree(R &retval, std::true_type) const
+		{
+			const auto md = this->cached_key_metadata();
+			if (md && md->complete()) {
+				retval = Low ? md->ldegree() : md->degree();
+				return true;
+			}
+			return false;
+		}
 	public:
 		/// Defaulted default constructor.
 		power_series() = default;
@@ -193,6 +218,9 @@ class power_series: public Series
 		 * of a set of strings, the partial degree (i.e., calculated considering only the variables in the set) will be returned.
 		 * In all other cases, the call is malformed and the method will be disabled.
 		 *
+		 * If only the key type has a degree, the total degree is read from the cached key metadata of the series, when
+		 * available.
+		 *
 		 * @param[in] args variadic parameter pack.
 		 *
 		 * @return the total or partial degree of the series.
@@ -206,6 +234,11 @@ class power_series: public Series
 		auto degree(const Args & ... args) const ->
 			decltype(degree_utils<T>::get(std::declval<typename T::term_type>(),std::declval<symbol_set>(),args...))
 		{
+			typedef decltype(degree_utils<T>::get(std::declval<typename T::term_type>(),std::declval<symbol_set>(),args...)) return_type;
+			return_type retval(0);
+			if (cached_degree<false>(retval,std::integral_constant<bool,cached_degree_enabler<T,Args...>::value>())) {
+				return retval;
+			}
 			auto g = std::bind(degree_utils<T>::template get<typename T::term_type,Args...>,std::placeholders::_1,
 				std::cref(this->m_symbol_set),std::cref(args)...);
 			return detail::generic_series_degree<0>(this->m_container,g);
@@ -220,6 +253,9 @@ class power_series: public Series
 		 * of a set of strings, the partial low degree (i.e., calculated considering only the variables in the set) will be returned.
 		 * In all other cases, the call is malformed and the method will be disabled.
 		 *
+		 * If only the key type has a degree, the total low degree is read from the cached key metadata of the series, when
+		 * available.
+		 *
 		 * @param[in] args variadic parameter pack.
 		 *
 		 * @return the total or partial low degree of the series.
@@ -233,10 +269,95 @@ class power_series: public Series
 		auto ldegree(const Args & ... args) const ->
 			decltype(degree_utils<T>::lget(std::declval<typename T::term_type>(),std::declval<symbol_set>(),args...))
 		{
+			typedef decltype(degree_utils<T>::lget(std::declval<typename T::term_type>(),std::declval<symbol_set>(),args...)) return_type;
+			return_type retval(0);
+			if (cached_degree<true>(retval,std::integral_constant<bool,cached_degree_enabler<T,Args...>::value>())) {
+				return retval;
+			}
 			auto g = std::bind(degree_utils<T>::template lget<typename T::term_type,Args...>,std::placeholders::_1,
 				std::cref(this->m_symbol_set),std::cref(args)...);
 			return detail::generic_series_degree<1>(this->m_container,g);
 		}
+		/// Low degree of a term (low-level).
+		/**
+		 * \note
+		 * This method is available only if the requisites outlined in piranha::power_series are satisfied.
+		 *
+		 * This method is used by the series multipliers to implement degree truncation (see piranha::degree_truncation).
+		 * If the parameter pack has a size of zero, the total low degree of \p t will be returned. If the parameter pack consists
+		 * of a set of strings, the partial low degree will be returned.
+		 *
+		 * @param[in] t the input term.
+		 * @param[in] s the reference set of symbols.
+		 * @param[in] args variadic parameter pack.
+		 *
+		 * @return the total or partial low degree of \p t.
+		 *
+		 * @throws unspecified any exception thrown by the calculation of the low degree of the term.
+		 */
+		template <typename ... Args, typename T = power_series>
+		static auto _term_ldegree(const typename T::term_type &t, const symbol_set &s, const Args & ... args) ->
+			decltype(degree_utils<T>::lget(t,s,args...))
+		{
+			return degree_utils<T>::lget(t,s,args...);
+		}
+		/// Truncated multiplication by total degree.
+		/**
+		 * This method will return <tt>a * b</tt>, computed with a per-call piranha::degree_truncation policy of truncation
+		 * by total degree. The per-call policy overrides the global one for the outermost multiplication.
+		 *
+		 * @param[in] a first operand.
+		 * @param[in] b second operand.
+		 * @param[in] max_degree maximum total degree of the terms of the result.
+		 *
+		 * @return <tt>a * b</tt>, truncated to \p max_degree.
+		 *
+		 * @throws unspecified any exception thrown by the multiplication operator or by the constructor of piranha::degree_truncation.
+		 */
+		template <typename T, typename U>
+		static auto truncated_multiplication(const T &a, const U &b, const integer &max_degree) -> decltype(a * b)
+		{
+			const degree_truncation t(max_degree);
+			return truncated_multiplication_impl(a,b,t);
+		}
+		/// Truncated multiplication by partial degree.
+		/**
+		 * This method will return <tt>a * b</tt>, computed with a per-call piranha::degree_truncation policy of truncation
+		 * by partial degree. The per-call policy overrides the global one for the outermost multiplication.
+		 *
+		 * @param[in] a first operand.
+		 * @param[in] b second operand.
+		 * @param[in] max_degree maximum partial degree of the terms of the result.
+		 * @param[in] names names of the symbols that will be considered in the computation of the partial degree.
+		 *
+		 * @return <tt>a * b</tt>, truncated to \p max_degree in the symbols \p names.
+		 *
+		 * @throws unspecified any exception thrown by the multiplication operator or by the constructor of piranha::degree_truncation.
+		 */
+		template <typename T, typename U>
+		static auto truncated_multiplication(const T &a, const U &b, const integer &max_degree, const std::set<std::string> &names) ->
+			decltype(a * b)
+		{
+			const degree_truncation t(max_degree,names);
+			return truncated_multiplication_impl(a,b,t);
+		}
+	private:
+		template <typename T, typename U>
+		static auto truncated_multiplication_impl(const T &a, const U &b, const degree_truncation &t) -> decltype(a * b)
+		{
+			// Make sure the per-call policy is cleared on exit, whatever happens.
+			struct override_cleaner
+			{
+				~override_cleaner() noexcept(true)
+				{
+					degree_truncation::_set_override(nullptr);
+				}
+			};
+			degree_truncation::_set_override(&t);
+			override_cleaner oc;
+			(void)oc;
+			return a * b;
+		}
 };
 
 namespace math
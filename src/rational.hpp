@@ -140,7 +140,7 @@ class rational
 		}
 		void construct_from_generic(const integer &n)
 		{
-			::mpz_init_set(mpq_numref(m_value),n.m_value);
+			::mpz_init_set(mpq_numref(m_value),integer::mpz_view(n));
 			::mpz_init_set_ui(mpq_denref(m_value),1ul);
 		}
 		template <typename T>
@@ -163,8 +163,8 @@ class rational
 		void construct_from_numden(const T &num, const T &den, typename std::enable_if<std::is_same<T,integer>::value>::type * = nullptr)
 		{
 			piranha_assert(!math::is_zero(den));
-			::mpz_init_set(mpq_numref(m_value),num.m_value);
-			::mpz_init_set(mpq_denref(m_value),den.m_value);
+			::mpz_init_set(mpq_numref(m_value),integer::mpz_view(num));
+			::mpz_init_set(mpq_denref(m_value),integer::mpz_view(den));
 		}
 		template <typename T>
 		void construct_from_numden(const T &num, const T &den, typename std::enable_if<std::is_integral<T>::value &&
@@ -244,7 +244,7 @@ class rational
 		}
 		void assign_from_generic(const integer &n)
 		{
-			::mpz_set(mpq_numref(m_value),n.m_value);
+			::mpz_set(mpq_numref(m_value),integer::mpz_view(n));
 			::mpz_set_ui(mpq_denref(m_value),1ul);
 		}
 		// Conversion.
@@ -293,7 +293,7 @@ class rational
 		}
 		void in_place_add(const integer &n)
 		{
-			::mpz_addmul(mpq_numref(m_value),mpq_denref(m_value),n.m_value);
+			::mpz_addmul(mpq_numref(m_value),mpq_denref(m_value),integer::mpz_view(n));
 		}
 		template <typename T>
 		void in_place_add(const T &si, typename std::enable_if<std::is_signed<T>::value &&
@@ -345,7 +345,7 @@ class rational
 		}
 		void in_place_sub(const integer &n)
 		{
-			::mpz_submul(mpq_numref(m_value),mpq_denref(m_value),n.m_value);
+			::mpz_submul(mpq_numref(m_value),mpq_denref(m_value),integer::mpz_view(n));
 		}
 		template <typename T>
 		void in_place_sub(const T &si, typename std::enable_if<std::is_signed<T>::value &&
@@ -397,7 +397,7 @@ class rational
 		}
 		void in_place_mul(const integer &n)
 		{
-			::mpz_mul(mpq_numref(m_value),mpq_numref(m_value),n.m_value);
+			::mpz_mul(mpq_numref(m_value),mpq_numref(m_value),integer::mpz_view(n));
 			::mpq_canonicalize(m_value);
 		}
 		template <typename T>
@@ -452,7 +452,7 @@ class rational
 		}
 		void in_place_div(const integer &n)
 		{
-			::mpz_mul(mpq_denref(m_value),mpq_denref(m_value),n.m_value);
+			::mpz_mul(mpq_denref(m_value),mpq_denref(m_value),integer::mpz_view(n));
 			::mpq_canonicalize(m_value);
 		}
 		template <typename T>
@@ -514,7 +514,7 @@ class rational
 		}
 		static bool binary_equality(const rational &q, const integer &n)
 		{
-			return (mpz_cmp_ui(mpq_denref(q.m_value),1ul) == 0 && ::mpz_cmp(mpq_numref(q.m_value),n.m_value) == 0);
+			return (mpz_cmp_ui(mpq_denref(q.m_value),1ul) == 0 && ::mpz_cmp(mpq_numref(q.m_value),integer::mpz_view(n)) == 0);
 		}
 		template <typename T>
 		static bool binary_equality(const rational &q, const T &n, typename std::enable_if<std::is_signed<T>::value &&
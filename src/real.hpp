@@ -164,7 +164,7 @@ class real: public detail::real_base<>
 		}
 		void construct_from_generic(const integer &n)
 		{
-			::mpfr_set_z(m_value,n.m_value,default_rnd);
+			::mpfr_set_z(m_value,integer::mpz_view(n),default_rnd);
 		}
 		void construct_from_generic(const rational &q)
 		{
@@ -195,7 +195,8 @@ class real: public detail::real_base<>
 			}
 			integer retval;
 			// Explicitly request rounding to zero in this case.
-			::mpfr_get_z(retval.m_value,m_value,MPFR_RNDZ);
+			::mpfr_get_z(retval.get_mpz(),m_value,MPFR_RNDZ);
+			retval.normalise();
 			return retval;
 		}
 		template <typename T>
@@ -288,7 +289,7 @@ class real: public detail::real_base<>
 		}
 		void in_place_add(const integer &n)
 		{
-			::mpfr_add_z(m_value,m_value,n.m_value,default_rnd);
+			::mpfr_add_z(m_value,m_value,integer::mpz_view(n),default_rnd);
 		}
 		template <typename T>
 		void in_place_add(const T &si, typename std::enable_if<std::is_signed<T>::value &&
@@ -355,7 +356,7 @@ class real: public detail::real_base<>
 		}
 		void in_place_sub(const integer &n)
 		{
-			::mpfr_sub_z(m_value,m_value,n.m_value,default_rnd);
+			::mpfr_sub_z(m_value,m_value,integer::mpz_view(n),default_rnd);
 		}
 		template <typename T>
 		void in_place_sub(const T &si, typename std::enable_if<std::is_signed<T>::value &&
@@ -419,7 +420,7 @@ class real: public detail::real_base<>
 		}
 		void in_place_mul(const integer &n)
 		{
-			::mpfr_mul_z(m_value,m_value,n.m_value,default_rnd);
+			::mpfr_mul_z(m_value,m_value,integer::mpz_view(n),default_rnd);
 		}
 		template <typename T>
 		void in_place_mul(const T &si, typename std::enable_if<std::is_signed<T>::value &&
@@ -481,7 +482,7 @@ class real: public detail::real_base<>
 		}
 		void in_place_div(const integer &n)
 		{
-			::mpfr_div_z(m_value,m_value,n.m_value,default_rnd);
+			::mpfr_div_z(m_value,m_value,integer::mpz_view(n),default_rnd);
 		}
 		template <typename T>
 		void in_place_div(const T &si, typename std::enable_if<std::is_signed<T>::value &&
@@ -542,7 +543,7 @@ class real: public detail::real_base<>
 			if (r.is_nan()) {
 				return false;
 			}
-			return (::mpfr_cmp_z(r.m_value,n.m_value) == 0);
+			return (::mpfr_cmp_z(r.m_value,integer::mpz_view(n)) == 0);
 		}
 		static bool binary_equality(const real &r, const rational &q)
 		{
@@ -602,7 +603,7 @@ class real: public detail::real_base<>
 		}
 		static bool binary_less_than(const real &r, const integer &n)
 		{
-			return (::mpfr_cmp_z(r.m_value,n.m_value) < 0);
+			return (::mpfr_cmp_z(r.m_value,integer::mpz_view(n)) < 0);
 		}
 		template <typename T>
 		static bool binary_less_than(const real &r, const T &n, typename std::enable_if<std::is_signed<T>::value &&
@@ -638,7 +639,7 @@ class real: public detail::real_base<>
 		}
 		static bool binary_leq(const real &r, const integer &n)
 		{
-			return (::mpfr_cmp_z(r.m_value,n.m_value) <= 0);
+			return (::mpfr_cmp_z(r.m_value,integer::mpz_view(n)) <= 0);
 		}
 		template <typename T>
 		static bool binary_leq(const real &r, const T &n, typename std::enable_if<std::is_signed<T>::value &&
@@ -708,7 +709,7 @@ class real: public detail::real_base<>
 		real pow_impl(const integer &n) const
 		{
 			real retval{0,get_prec()};
-			::mpfr_pow_z(retval.m_value,m_value,n.m_value,default_rnd);
+			::mpfr_pow_z(retval.m_value,m_value,integer::mpz_view(n),default_rnd);
 			return retval;
 		}
 		template <typename T>
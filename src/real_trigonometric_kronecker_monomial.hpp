@@ -39,6 +39,7 @@
 #include "config.hpp"
 #include "detail/km_commons.hpp"
 #include "detail/degree_commons.hpp"
+#include "detail/key_metadata.hpp"
 #include "detail/prepare_for_print.hpp"
 #include "exceptions.hpp"
 #include "integer.hpp"
@@ -270,6 +271,36 @@ class real_trigonometric_kronecker_monomial
 				piranha_throw(std::invalid_argument,"incompatible arguments");
 			}
 		}
+		/// Converting constructor from a monomial with a different integer type.
+		/**
+		 * \note
+		 * This constructor is enabled only if \p U is not the same type as \p T.
+		 *
+		 * The multipliers of \p other are decoded, converted to \p T via \p boost::numeric_cast and encoded again.
+		 * The flavour is copied from \p other.
+		 *
+		 * @param[in] other construction argument.
+		 * @param[in] args reference set of piranha::symbol.
+		 *
+		 * @throws std::invalid_argument if \p other is not compatible with \p args.
+		 * @throws unspecified any exception thrown by:
+		 * - piranha::real_trigonometric_kronecker_monomial::unpack(),
+		 * - piranha::kronecker_array::encode() (e.g., if the multipliers do not fit in the limits for type \p T),
+		 * - \p boost::numeric_cast,
+		 * - piranha::static_vector::push_back().
+		 */
+		template <typename U, typename = typename std::enable_if<!std::is_same<U,value_type>::value>::type>
+		explicit real_trigonometric_kronecker_monomial(const real_trigonometric_kronecker_monomial<U> &other, const symbol_set &args):
+			m_value(0),m_flavour(other.get_flavour())
+		{
+			if (unlikely(!other.is_compatible(args))) {
+				piranha_throw(std::invalid_argument,"incompatible arguments");
+			}
+			const auto tmp = other.unpack(args);
+			v_type v;
+			std::transform(tmp.begin(),tmp.end(),std::back_inserter(v),[](const U &n) {return boost::numeric_cast<value_type>(n);});
+			m_value = ka::encode(v);
+		}
 		/// Trivial destructor.
 		~real_trigonometric_kronecker_monomial() noexcept(true)
 		{
@@ -1077,6 +1108,47 @@ class real_trigonometric_kronecker_monomial
 		bool		m_flavour;
 };
 
+namespace detail
+{
+
+// Key metadata for trigonometric Kronecker monomials: multiplier bounds and distributions of
+// the trigonometric degree and order.
+template <typename T>
+struct key_metadata<real_trigonometric_kronecker_monomial<T>>: km_key_metadata<T,2u>
+{
+	static const bool has_t_degree = true;
+	void add(const real_trigonometric_kronecker_monomial<T> &k, const symbol_set &args)
+	{
+		const auto v = k.unpack(args);
+		this->add_exponents(v,{{monomial_degree<T>(v,km_safe_adder<T>,args),monomial_degree<T>(v,km_safe_abs_adder<T>,args)}});
+	}
+	void remove(const real_trigonometric_kronecker_monomial<T> &k, const symbol_set &args)
+	{
+		this->remove_degrees({{k.t_degree(args),k.t_order(args)}});
+	}
+	T t_degree() const
+	{
+		return this->template extremum<0u,false>();
+	}
+	T t_ldegree() const
+	{
+		return this->template extremum<0u,true>();
+	}
+	T t_order() const
+	{
+		return this->template extremum<1u,false>();
+	}
+	T t_lorder() const
+	{
+		return this->template extremum<1u,true>();
+	}
+};
+
+template <typename T>
+const bool key_metadata<real_trigonometric_kronecker_monomial<T>>::has_t_degree;
+
+}
+
 }
 
 namespace std
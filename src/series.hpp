@@ -28,10 +28,12 @@
 #include <boost/iterator/transform_iterator.hpp>
 #include <boost/math/special_functions/trunc.hpp>
 #include <boost/numeric/conversion/cast.hpp>
+#include <cmath>
 #include <functional>
 #include <memory>
 #include <iostream>
 #include <iterator>
+#include <map>
 #include <mutex>
 #include <sstream>
 #include <stdexcept>
@@ -44,6 +46,7 @@
 #include "base_term.hpp"
 #include "config.hpp"
 #include "debug_access.hpp"
+#include "detail/key_metadata.hpp"
 #include "detail/sfinae_types.hpp"
 #include "detail/series_fwd.hpp"
 #include "echelon_size.hpp"
@@ -92,6 +95,33 @@ inline std::pair<typename Term::cf_type,Derived> pair_from_term(const symbol_set
 
 }
 
+/// Container for the terms of a series.
+/**
+ * The type member \p type is the container used by piranha::series to store terms of type \p Term. The default
+ * implementation selects piranha::hash_set. This class can be specialised in order to select a different container
+ * for specific term types (e.g., piranha::flat_hash_set, whose layout is better suited to terms
+ * with small trivially-copyable keys and coefficients):
+ * @code
+ * namespace piranha
+ * {
+ * template <>
+ * struct series_container<polynomial_term<double,kronecker_monomial<>>>
+ * {
+ * 	typedef flat_hash_set<polynomial_term<double,kronecker_monomial<>>,
+ * 		detail::term_hasher<polynomial_term<double,kronecker_monomial<>>>> type;
+ * };
+ * }
+ * @endcode
+ * The container must provide the same interface as piranha::hash_set, including the low-level interface.
+ * The specialisation must be visible wherever the series type is used.
+ */
+template <typename Term, typename = void>
+struct series_container
+{
+	/// Container type.
+	typedef hash_set<Term,detail::term_hasher<Term>> type;
+};
+
 /// Series class.
 /**
  * This class provides arithmetic and relational operators overloads for interaction with other series and non-series (scalar) types.
@@ -152,8 +182,14 @@ class series: series_binary_operators, detail::series_tag
 		friend std::pair<typename Term2::cf_type,Derived2> detail::pair_from_term(const symbol_set &, const Term2 &);
 	protected:
 		/// Container type for terms.
-		typedef hash_set<term_type,detail::term_hasher<Term>> container_type;
+		/**
+		 * The container type is determined by piranha::series_container.
+		 */
+		typedef typename series_container<Term>::type container_type;
+		/// Type of the metadata about the keys of the series.
+		typedef detail::key_metadata<typename term_type::key_type> key_metadata_type;
 	private:
+		typedef typename container_type::stamp_type stamp_type;
 		// Avoid confusing doxygen.
 		typedef decltype(std::declval<container_type>().evaluate_sparsity()) sparsity_info_type;
 		// Overload for completely different term type: copy-convert to term_type and proceed.
@@ -227,10 +263,15 @@ class series: series_binary_operators, detail::series_tag
 			// Try to locate the element.
 			auto bucket_idx = m_container._bucket(term);
 			const auto it = m_container._find(term,bucket_idx);
+			// Whether the key metadata needs to be maintained.
+			const bool md = key_metadata_type::enabled && key_metadata_is_current();
 			// Cleanup function that checks ignorability and compatibility of an element in the hash set,
 			// and removes it if necessary.
-			auto cleanup = [this](const typename container_type::const_iterator &it) {
+			auto cleanup = [this,md](const typename container_type::const_iterator &it) {
 				if (unlikely(!it->is_compatible(this->m_symbol_set) || it->is_ignorable(this->m_symbol_set))) {
+					if (md) {
+						this->key_metadata_update<false>(it->m_key);
+					}
 					this->m_container.erase(it);
 				}
 			};
@@ -248,6 +289,9 @@ class series: series_binary_operators, detail::series_tag
 				}
 				const auto new_it = m_container._unique_insert(std::forward<T>(term),bucket_idx);
 				m_container._update_size(m_container.size() + size_type(1u));
+				if (md) {
+					key_metadata_update<true>(new_it->m_key);
+				}
 				// Insertion was successful, change sign if requested.
 				if (!Sign) {
 					try {
@@ -273,6 +317,62 @@ class series: series_binary_operators, detail::series_tag
 					throw;
 				}
 			}
+			// NOTE: in case of exceptions we never get here, and the metadata will be stale
+			// because of the modifications to the container.
+			if (md) {
+				key_metadata_restamp();
+			}
+		}
+		// Key metadata
+		// ============
+		// NOTE: the metadata is up to date if its stamp coincides with the stamp of the container. The stamp of the
+		// container changes with every modification not performed via insertion_impl(), so that the metadata
+		// is invalidated conservatively. The metadata is never computed lazily from const methods, as
+		// series might be accessed concurrently (e.g., as coefficients in multi-threaded multiplications).
+		bool key_metadata_is_current() const
+		{
+			return m_key_metadata_stamp == m_container._stamp();
+		}
+		void key_metadata_invalidate()
+		{
+			m_key_metadata_stamp = stamp_type();
+		}
+		// Re-validate the metadata after modifications of the container, unless it was invalidated in the meantime.
+		void key_metadata_restamp()
+		{
+			if (m_key_metadata_stamp != stamp_type()) {
+				m_key_metadata_stamp = m_container._stamp();
+			}
+		}
+		template <bool Add>
+		void key_metadata_update(const typename term_type::key_type &k)
+		{
+			// NOTE: the metadata is an optimisation, errors here (e.g., overflows in the computation
+			// of the degree) should not be propagated.
+			if (m_key_metadata_stamp == stamp_type()) {
+				return;
+			}
+			try {
+				if (Add) {
+					m_key_metadata.add(k,m_symbol_set);
+				} else {
+					m_key_metadata.remove(k,m_symbol_set);
+				}
+			} catch (...) {
+				key_metadata_invalidate();
+			}
+		}
+		// Copy the metadata of another series with the same term type, if it is up to date and the container
+		// of this is a copy of the container of s.
+		template <typename Series>
+		void key_metadata_copy(const Series &s)
+		{
+			if (s.key_metadata_is_current()) {
+				m_key_metadata = s.m_key_metadata;
+				m_key_metadata_stamp = m_container._stamp();
+			} else {
+				key_metadata_invalidate();
+			}
 		}
 		// Terms merging
 		// =============
@@ -435,6 +535,9 @@ class series: series_binary_operators, detail::series_tag
 			static_assert(!std::is_same<series,typename std::decay<Series>::type>::value,"Invalid series type for generic construction.");
 			m_symbol_set = std::move(s.m_symbol_set);
 			m_container = std::move(s.m_container);
+			// The stamp of the container was transferred as well.
+			m_key_metadata = std::move(s.m_key_metadata);
+			m_key_metadata_stamp = s.m_key_metadata_stamp;
 		}
 		// Series with same echelon size, same term type, copy.
 		template <typename Series>
@@ -448,6 +551,7 @@ class series: series_binary_operators, detail::series_tag
 			static_assert(!std::is_same<series,typename std::decay<Series>::type>::value,"Invalid series type for generic construction.");
 			m_symbol_set = s.m_symbol_set;
 			m_container = s.m_container;
+			key_metadata_copy(s);
 		}
 		// Series with same echelon size and different term type, move.
 		template <typename Series>
@@ -658,25 +762,290 @@ class series: series_binary_operators, detail::series_tag
 			}
 		}
 		// Exponentiation.
+		// Power-law model of the size of the powers of the base, |b**k| ~ c * k**e, fitted on the last two powers computed.
+		class pow_size_model
+		{
+			public:
+				pow_size_model():m_k1(0.),m_s1(0.),m_k2(0.),m_s2(0.) {}
+				void update(std::size_t k, const typename container_type::size_type &s)
+				{
+					m_k1 = m_k2;
+					m_s1 = m_s2;
+					m_k2 = static_cast<double>(k);
+					m_s2 = static_cast<double>(s);
+				}
+				double predict(std::size_t k) const
+				{
+					if (m_s1 <= 0. || m_s2 <= 0. || m_k1 <= 0. || m_k2 == m_k1) {
+						return 0.;
+					}
+					const double e = std::log(m_s2 / m_s1) / std::log(m_k2 / m_k1);
+					return m_s2 * std::pow(static_cast<double>(k) / m_k2,e);
+				}
+			private:
+				double	m_k1;
+				double	m_s1;
+				double	m_k2;
+				double	m_s2;
+		};
+		// Multiplication of two powers of the base, pre-sizing the result according to the hint (if nonzero).
+		static Derived pow_multiply(const Derived &a, const Derived &b, double hint)
+		{
+			// NOTE: this can happen only in case of cancellations. Do not go through the multiplier, as the symbol set
+			// of the empty operand might not be the one of the other operand.
+			if (unlikely(a.empty() || b.empty())) {
+				return Derived{};
+			}
+			// Some slack on the hint, and a cap on the maximum size of the result (products of terms might
+			// generate more than one term).
+			hint = std::min(hint * 1.1,static_cast<double>(a.size()) * static_cast<double>(b.size()) * 2.);
+			if (hint >= 1. && hint < static_cast<double>(boost::integer_traits<std::size_t>::const_max)) {
+				series_multiplier<Derived,Derived>::_set_size_hint(static_cast<std::size_t>(hint));
+			}
+			Derived retval;
+			try {
+				static_cast<series &>(retval) = a.multiply_by_series(b);
+			} catch (...) {
+				series_multiplier<Derived,Derived>::_set_size_hint(0u);
+				throw;
+			}
+			series_multiplier<Derived,Derived>::_set_size_hint(0u);
+			return retval;
+		}
+		// Estimated costs, in number of term-by-term multiplications, of the linear and binary strategies for
+		// the computation of b**n, given b and b**2.
+		static double pow_linear_cost(const pow_size_model &m, std::size_t n, double s1, double limit)
+		{
+			double retval = 0.;
+			for (std::size_t k = 2u; k < n && retval <= limit; ++k) {
+				retval += s1 * m.predict(k);
+			}
+			return retval;
+		}
+		static double pow_binary_cost(const pow_size_model &m, std::size_t n, double s1)
+		{
+			double retval = 0.;
+			std::size_t k = 1u;
+			for (auto bit = pow_top_bit(n); bit > 1u;) {
+				bit >>= 1u;
+				if (k > 1u) {
+					const double s = m.predict(k);
+					retval += s * s / 2.;
+				}
+				k *= 2u;
+				if (n & bit) {
+					retval += m.predict(k) * s1;
+					++k;
+				}
+			}
+			return retval;
+		}
+		static std::size_t pow_top_bit(std::size_t n)
+		{
+			piranha_assert(n);
+			std::size_t retval = 1u;
+			while (n >>= 1u) {
+				retval <<= 1u;
+			}
+			return retval;
+		}
+		// Linear strategy, starting from b**2.
+		Derived pow_linear(Derived &&b2, std::size_t n, pow_size_model &m) const
+		{
+			const Derived &b = *static_cast<Derived const *>(this);
+			Derived retval(std::move(b2));
+			for (std::size_t k = 3u; k <= n; ++k) {
+				retval = pow_multiply(retval,b,m.predict(k));
+				m.update(k,retval.size());
+			}
+			return retval;
+		}
+		// Left-to-right binary exponentiation, starting from b**2.
+		Derived pow_binary(Derived &&b2, std::size_t n, pow_size_model &m) const
+		{
+			const Derived &b = *static_cast<Derived const *>(this);
+			Derived retval;
+			std::size_t k = 1u;
+			for (auto bit = pow_top_bit(n); bit > 1u;) {
+				bit >>= 1u;
+				if (k == 1u) {
+					retval = std::move(b2);
+				} else {
+					retval = pow_multiply(retval,retval,m.predict(2u * k));
+					m.update(2u * k,retval.size());
+				}
+				k *= 2u;
+				if (n & bit) {
+					retval = pow_multiply(retval,b,m.predict(k + 1u));
+					m.update(k + 1u,retval.size());
+					++k;
+				}
+			}
+			return retval;
+		}
+		// Recursive splitting of the exponent: b**n = b**(n/2) * b**(n - n/2), so that the last (and most expensive)
+		// multiplication is between balanced operands.
+		Derived pow_split(const Derived &b2, std::size_t n, pow_size_model &m) const
+		{
+			const Derived &b = *static_cast<Derived const *>(this);
+			if (n == 1u) {
+				return b;
+			}
+			if (n == 2u) {
+				return b2;
+			}
+			const auto half = pow_split(b2,n / 2u,m);
+			Derived retval;
+			if (n % 2u) {
+				const auto other = pow_multiply(half,b,m.predict(n / 2u + 1u));
+				m.update(n / 2u + 1u,other.size());
+				retval = pow_multiply(half,other,m.predict(n));
+			} else {
+				retval = pow_multiply(half,half,m.predict(n));
+			}
+			m.update(n,retval.size());
+			return retval;
+		}
+		// The recurrence strategy requires the total degree of the terms (as an integral value), and coefficients which are not
+		// series and which support the divisions by an integral value.
+		template <typename S>
+		class pow_recurrence_enabler
+		{
+				typedef typename S::term_type::cf_type cf_type;
+				template <typename S1>
+				static auto test(const S1 *) -> decltype(S1::_term_ldegree(std::declval<const typename S1::term_type &>(),
+					std::declval<const symbol_set &>()));
+				static void test(...);
+				typedef typename std::decay<decltype(test(static_cast<const S *>(nullptr)))>::type degree_type;
+			public:
+				typedef std::integral_constant<bool,(std::is_integral<degree_type>::value || std::is_same<degree_type,integer>::value) &&
+					!is_instance_of<cf_type,piranha::series>::value && std::is_constructible<cf_type,integer>::value &&
+					is_multipliable_in_place<cf_type>::value && is_multipliable_in_place<S,cf_type>::value &&
+					is_divisible_in_place<S,cf_type>::value> type;
+		};
+		// J.C.P. Miller's recurrence. The base is decomposed in homogeneous components f_i by total degree, the component of
+		// degree zero being a nonzero constant c. The homogeneous components g_k of the result satisfy
+		// k * c * g_k = sum_{i=1}^{k} ((n + 1) * i - k) * f_i * g_{k-i}, as follows from the identity f * E(f**n) = n * f**n * E(f),
+		// where E is the derivation that multiplies the components of degree k by k. The divisions are exact for exact coefficients.
+		// Will return false if the base does not have the required structure.
+		template <typename T>
+		bool pow_recurrence(Derived &retval, const T &x, std::size_t n, const std::true_type &) const
+		{
+			typedef typename term_type::cf_type cf_type;
+			typedef typename term_type::key_type key_type;
+			std::map<std::size_t,Derived> f;
+			term_type const *c_term = nullptr;
+			for (const auto &t: m_container) {
+				const integer d(Derived::_term_ldegree(t,m_symbol_set));
+				if (d.sign() < 0) {
+					return false;
+				}
+				if (d.sign() == 0) {
+					if (c_term != nullptr || !t.m_key.is_unitary(m_symbol_set)) {
+						return false;
+					}
+					c_term = &t;
+					continue;
+				}
+				auto &comp = f[static_cast<std::size_t>(d)];
+				comp.m_symbol_set = m_symbol_set;
+				comp.insert(t);
+			}
+			if (c_term == nullptr || f.empty()) {
+				return false;
+			}
+			// Number of homogeneous components of the result. Do not use the recurrence if the result is very
+			// sparse in degree.
+			const std::size_t max_d = f.rbegin()->first;
+			if (max_d > boost::integer_traits<std::size_t>::const_max / n || max_d * n > 1000000u) {
+				return false;
+			}
+			const std::size_t n_comps = max_d * n + 1u;
+			const cf_type &c = c_term->m_cf;
+			const integer n1 = integer(n) + 1;
+			std::vector<Derived> g;
+			g.reserve(n_comps);
+			g.emplace_back();
+			g.back().m_symbol_set = m_symbol_set;
+			g.back().insert(term_type(math::pow(c,x),key_type(m_symbol_set)));
+			for (std::size_t k = 1u; k < n_comps; ++k) {
+				Derived g_k;
+				g_k.m_symbol_set = m_symbol_set;
+				for (const auto &p: f) {
+					if (p.first > k) {
+						break;
+					}
+					const Derived &g_prev = g[k - p.first];
+					const integer factor = n1 * p.first - k;
+					if (g_prev.empty() || factor.sign() == 0) {
+						continue;
+					}
+					Derived tmp(p.second);
+					tmp *= cf_type(factor);
+					g_k += pow_multiply(tmp,g_prev,0.);
+				}
+				if (!g_k.empty()) {
+					cf_type div((integer(k)));
+					div *= c;
+					g_k /= div;
+				}
+				g.push_back(std::move(g_k));
+			}
+			retval = std::move(g[0u]);
+			for (std::size_t k = 1u; k < n_comps; ++k) {
+				retval += std::move(g[k]);
+			}
+			return true;
+		}
+		template <typename T>
+		bool pow_recurrence(Derived &, const T &, std::size_t, const std::false_type &) const
+		{
+			return false;
+		}
 		template <typename T>
 		Derived pow_impl(const T &x) const
 		{
-			integer n;
+			integer n_int;
 			try {
-				n = math::integral_cast(x);
+				n_int = math::integral_cast(x);
 			} catch (const std::invalid_argument &) {
 				piranha_throw(std::invalid_argument,"invalid argument for series exponentiation: non-integral value");
 			}
-			if (n.sign() < 0) {
+			if (n_int.sign() < 0) {
 				piranha_throw(std::invalid_argument,"invalid argument for series exponentiation: negative integral value");
 			}
-			// NOTE: for series it seems like it is better to run the dumb algorithm instead of, e.g.,
-			// exponentiation by squaring - the growth in number of terms seems to be slower.
-			Derived retval(*static_cast<Derived const *>(this));
-			for (integer i(1); i < n; ++i) {
-				retval *= *static_cast<Derived const *>(this);
+			const Derived &b = *static_cast<Derived const *>(this);
+			if (n_int == 1) {
+				return b;
+			}
+			const auto n = static_cast<std::size_t>(n_int);
+			auto strategy = settings::get_pow_strategy();
+			if (strategy == pow_strategy::automatic || strategy == pow_strategy::recurrence) {
+				Derived retval;
+				if (pow_recurrence(retval,x,n,typename pow_recurrence_enabler<Derived>::type())) {
+					return retval;
+				}
+				strategy = pow_strategy::automatic;
+			}
+			pow_size_model m;
+			m.update(1u,b.size());
+			auto b2 = pow_multiply(b,b,0.);
+			m.update(2u,b2.size());
+			if (n == 2u) {
+				return b2;
+			}
+			if (strategy == pow_strategy::automatic) {
+				const double s1 = static_cast<double>(b.size()), b_cost = pow_binary_cost(m,n,s1);
+				strategy = (pow_linear_cost(m,n,s1,b_cost) <= b_cost) ? pow_strategy::linear : pow_strategy::binary;
+			}
+			switch (strategy) {
+				case pow_strategy::binary:
+					return pow_binary(std::move(b2),n,m);
+				case pow_strategy::split:
+					return pow_split(b2,n,m);
+				default:
+					return pow_linear(std::move(b2),n,m);
 			}
-			return retval;
 		}
 		// Iterator utilities.
 		typedef boost::transform_iterator<std::function<std::pair<typename term_type::cf_type,Derived>(const term_type &)>,
@@ -838,13 +1207,24 @@ class series: series_binary_operators, detail::series_tag
 		 * @see piranha::series::begin() and piranha::series::end().
 		 */
 		typedef const_iterator_impl const_iterator;
-		/// Defaulted default constructor.
-		series() = default;
-		/// Defaulted copy constructor.
+		/// Default constructor.
+		/**
+		 * Will construct an empty series with an empty symbol set.
+		 * 
+		 * @throws unspecified any exception thrown by the default constructor of piranha::hash_set.
+		 */
+		series():m_symbol_set(),m_container(),m_key_metadata(),m_key_metadata_stamp(m_container._stamp()) {}
+		/// Copy constructor.
 		/**
+		 * @param[in] other construction argument.
+		 * 
 		 * @throws unspecified any exception thrown by the copy constructor of piranha::hash_set.
 		 */
-		series(const series &) = default;
+		series(const series &other):m_symbol_set(other.m_symbol_set),m_container(other.m_container),
+			m_key_metadata(),m_key_metadata_stamp()
+		{
+			key_metadata_copy(other);
+		}
 		/// Defaulted move constructor.
 		series(series &&) = default;
 		/// Generic constructor.
@@ -877,7 +1257,8 @@ class series: series_binary_operators, detail::series_tag
 		 */
 		template <typename T>
 		explicit series(T &&x, typename std::enable_if<!std::is_same<series,typename std::decay<T>::type>::value &&
-			generic_ctor_enabler<T>::value>::type * = nullptr)
+			generic_ctor_enabler<T>::value>::type * = nullptr):m_symbol_set(),m_container(),m_key_metadata(),
+			m_key_metadata_stamp(m_container._stamp())
 		{
 			dispatch_generic_construction(std::forward<T>(x));
 		}
@@ -1224,6 +1605,23 @@ class series: series_binary_operators, detail::series_tag
 			return m_container.bucket_count();
 		}
 		//@}
+		/// Squaring.
+		/**
+		 * Return \p this multiplied by itself. The multiplication is performed by piranha::series_multiplier in squaring mode,
+		 * in which each pair of distinct terms is multiplied only once. The result is the same as <tt>(*this) * (*this)</tt>,
+		 * which also triggers the squaring mode.
+		 * 
+		 * @return the square of \p this.
+		 * 
+		 * @throws unspecified any exception thrown by the constructor and function call operator of piranha::series_multiplier,
+		 * or by the default constructor of \p Derived.
+		 */
+		Derived square() const
+		{
+			Derived retval;
+			static_cast<series &>(retval) = multiply_by_series(*static_cast<Derived const *>(this));
+			return retval;
+		}
 		/// Exponentiation.
 		/**
 		 * \note
@@ -1240,15 +1638,34 @@ class series: series_binary_operators, detail::series_tag
 		 * - if \p x is zero (as established by piranha::math::is_zero()), a series with a single term
 		 *   with unitary key and coefficient constructed from the integer numeral "1" is returned (i.e., any series raised to the power of zero
 		 *   is 1 - including empty series);
-		 * - if \p x represents a non-negative integral value, the return value is constructed via repeated multiplications;
+		 * - if \p x represents a non-negative integral value, the return value is computed via series multiplications
+		 *   according to the strategy returned by piranha::settings::get_pow_strategy();
 		 * - otherwise, an exception will be raised.
 		 * 
+		 * The available strategies are:
+		 * - piranha::pow_strategy::linear, repeated multiplication by the base;
+		 * - piranha::pow_strategy::binary, left-to-right binary exponentiation, using the squaring mode of the series multipliers;
+		 * - piranha::pow_strategy::split, computation of the two factors <tt>this**(n/2)</tt> and <tt>this**(n-n/2)</tt> (recursively)
+		 *   followed by a balanced multiplication;
+		 * - piranha::pow_strategy::recurrence, J.C.P. Miller's recurrence on the homogeneous components of the series. This strategy
+		 *   is available only if the terms provide an integral total degree via <tt>Derived::_term_ldegree()</tt> (see piranha::power_series),
+		 *   the coefficients are not series and are divisible by an integral value, and the series consists of a nonzero constant term
+		 *   plus terms of positive degree. If any of these conditions is not met, the strategy will be selected automatically;
+		 * - piranha::pow_strategy::automatic, the recurrence if available, otherwise either the linear or the binary strategy,
+		 *   according to a cost model extrapolating the size of the powers of the series from the sizes of \p this and
+		 *   of its square.
+		 * 
+		 * In all strategies but the recurrence, the size of each intermediate power is extrapolated from the previous steps and
+		 * passed as a size hint to the series multipliers (see piranha::series_multiplier::_set_size_hint()). Note that with
+		 * floating-point coefficients different strategies may produce slightly different results.
+		 * 
 		 * @param[in] x exponent.
 		 * 
 		 * @return \p this raised to the power of \p x.
 		 * 
-		 * @throws std::invalid_argument if exponentiation is computed via repeated series multiplications and
+		 * @throws std::invalid_argument if exponentiation is computed via series multiplications and
 		 * \p x does not represent a non-negative integer.
+		 * @throws std::overflow_error if \p x is not representable by \p std::size_t.
 		 * @throws unspecified any exception thrown by:
 		 * - series, term, coefficient and key construction,
 		 * - insert(),
@@ -1665,7 +2082,54 @@ class series: series_binary_operators, detail::series_tag
 		symbol_set	m_symbol_set;
 		/// Terms container.
 		container_type	m_container;
+		/// Up-to-date key metadata.
+		/**
+		 * The metadata about the keys of the series (e.g., the bounds of the exponents and the distribution of the degree)
+		 * is maintained incrementally by insert(), and it is invalidated by any other modification of the
+		 * terms container. This method does not compute the metadata.
+		 * 
+		 * @return a pointer to the key metadata, or \p nullptr if the metadata is not up to date.
+		 */
+		const key_metadata_type *cached_key_metadata() const
+		{
+			return key_metadata_is_current() ? &m_key_metadata : nullptr;
+		}
+		/// Set key metadata.
+		/**
+		 * The metadata will be considered up to date until the next modification of the terms container.
+		 * The metadata must be consistent with the current content of the series.
+		 * 
+		 * @param[in] md key metadata.
+		 */
+		void set_key_metadata(key_metadata_type md)
+		{
+			m_key_metadata = std::move(md);
+			m_key_metadata_stamp = m_container._stamp();
+		}
+		/// Recompute the key metadata.
+		/**
+		 * Will scan the terms of the series and recompute the key metadata. In case of errors
+		 * the metadata will not be up to date.
+		 * 
+		 * @return a pointer to the key metadata, or \p nullptr if it could not be computed.
+		 */
+		const key_metadata_type *refresh_key_metadata()
+		{
+			key_metadata_invalidate();
+			try {
+				m_key_metadata.clear();
+				for (const auto &t: m_container) {
+					m_key_metadata.add(t.m_key,m_symbol_set);
+				}
+			} catch (...) {
+				return nullptr;
+			}
+			m_key_metadata_stamp = m_container._stamp();
+			return &m_key_metadata;
+		}
 	private:
+		key_metadata_type	m_key_metadata;
+		stamp_type		m_key_metadata_stamp;
 		// NOTE: Derived is not a complete type here, so we need to wrap everything in a unique_ptr.
 		typedef std::unique_ptr<std::unordered_map<std::string,std::function<Derived(const Derived &)>>> cp_map_type;
 		static std::mutex	cp_mutex;
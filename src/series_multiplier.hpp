@@ -22,18 +22,19 @@
 #define PIRANHA_SERIES_MULTIPLIER_HPP
 
 #include <algorithm>
+#include <atomic>
 #include <boost/any.hpp>
 #include <boost/integer_traits.hpp>
 #include <boost/numeric/conversion/cast.hpp>
 #include <cmath>
 #include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <future>
 #include <iterator>
-#include <list>
 #include <mutex>
 #include <new> // For bad_alloc.
 #include <numeric>
-#include <random>
 #include <stdexcept>
 #include <thread>
 #include <tuple>
@@ -41,8 +42,9 @@
 #include <utility>
 #include <vector>
 
-#include "cache_aligning_allocator.hpp"
 #include "config.hpp"
+#include "degree_truncation.hpp"
+#include "detail/hyperloglog.hpp"
 #include "detail/series_fwd.hpp"
 #include "detail/series_multiplier_fwd.hpp"
 #include "echelon_size.hpp"
@@ -57,6 +59,20 @@
 namespace piranha
 {
 
+namespace detail
+{
+
+template <typename = int>
+struct base_series_multiplier
+{
+	static PIRANHA_TLS std::size_t s_size_hint;
+};
+
+template <typename T>
+PIRANHA_TLS std::size_t base_series_multiplier<T>::s_size_hint = 0u;
+
+}
+
 /// Default series multiplier.
 /**
  * This class is used by the multiplication operators involving two series operands with the same echelon size. The class works as follows:
@@ -126,16 +142,65 @@ class series_multiplier
 		template <typename T, typename U>
 		void swap_operands(const T &, const U &)
 		{}
+		// The multiplication is a squaring if the two operands are the same object.
+		template <typename T>
+		static bool is_square(const T &s1, const T &s2)
+		{
+			return &s1 == &s2;
+		}
+		template <typename T, typename U>
+		static bool is_square(const T &, const U &)
+		{
+			return false;
+		}
+		// Copy the vector of term pointers of the first series into the vector of the second series.
+		template <typename T>
+		static void copy_term_pointers(std::vector<T const *> &out, const std::vector<T const *> &in)
+		{
+			out = in;
+		}
+		template <typename T, typename U>
+		static void copy_term_pointers(std::vector<T const *> &, const std::vector<U const *> &)
+		{
+			piranha_assert(false);
+		}
+		// Truncation is supported only if both series provide degree information on their terms.
+		typedef std::integral_constant<bool,detail::truncation_enabled<Series1>::value &&
+			detail::truncation_enabled<Series2>::value> truncation_support;
+		static degree_truncation get_truncation()
+		{
+			// NOTE: consume the policy in any case, so that a per-call policy does not leak to other multiplications.
+			auto retval = degree_truncation::_consume();
+			return truncation_support::value ? retval : degree_truncation{};
+		}
+		// NOTE: consume the hint in any case, as for the truncation policy. The hint is ignored in truncated mode, as it
+		// refers to the full product.
+		static std::size_t get_size_hint(const degree_truncation &t)
+		{
+			const std::size_t retval = detail::base_series_multiplier<>::s_size_hint;
+			detail::base_series_multiplier<>::s_size_hint = 0u;
+			return (t.get_mode() == 0) ? retval : 0u;
+		}
 	public:
 		/// Constructor.
 		/**
+		 * The piranha::degree_truncation policy in effect for the multiplication will be retrieved via
+		 * piranha::degree_truncation::_consume() and stored in the protected member \p m_truncation. If the terms of \p Series1
+		 * and \p Series2 do not support degree truncation, the policy will be ignored.
+		 *
+		 * If \p s1 and \p s2 are the same object, the multiplication is flagged as a squaring via the protected member \p m_square.
+		 *
+		 * The size hint set via _set_size_hint(), if any, will be cleared and stored in the protected member \p m_size_hint.
+		 *
 		 * @param[in] s1 first series.
 		 * @param[in] s2 second series.
 		 * 
 		 * @throws std::invalid_argument if the symbol sets of \p s1 and \p s2 differ.
-		 * @throws unspecified any exception thrown by memory allocation errors in standard containers.
+		 * @throws unspecified any exception thrown by memory allocation errors in standard containers, or by
+		 * piranha::degree_truncation::_consume().
 		 */
-		explicit series_multiplier(const Series1 &s1, const Series2 &s2) : m_s1(&s1),m_s2(&s2)
+		explicit series_multiplier(const Series1 &s1, const Series2 &s2) : m_s1(&s1),m_s2(&s2),m_truncation(get_truncation()),
+			m_square(is_square(s1,s2)),m_size_hint(get_size_hint(m_truncation))
 		{
 			swap_operands(s1,s2);
 			if (unlikely(m_s1->m_symbol_set != m_s2->m_symbol_set)) {
@@ -172,6 +237,20 @@ class series_multiplier
 		{
 			return execute<default_functor>();
 		}
+		/// Set the size hint for the next multiplication (low-level).
+		/**
+		 * The hint is an estimate of the number of terms of the result of the next series multiplication
+		 * performed in the current thread (e.g., as extrapolated by piranha::series::pow() from the previous steps of
+		 * an exponentiation). It will be read and cleared by the constructor of the next multiplier, and used in place of
+		 * estimate_final_series_size() to pre-size the result. A value of zero clears the hint. The hint is ignored
+		 * in truncated mode.
+		 * 
+		 * @param[in] n the estimated number of terms of the result of the next multiplication.
+		 */
+		static void _set_size_hint(std::size_t n)
+		{
+			detail::base_series_multiplier<>::s_size_hint = n;
+		}
 	protected:
 		/// Determine the number of threads to use in the multiplication.
 		/**
@@ -223,17 +302,25 @@ class series_multiplier
 		 * The multiplication algorithm proceeds as follows:
 		 * 
 		 * - if one of the two series is empty, a default-constructed instance of \p return_type is returned;
+		 * - if a piranha::degree_truncation policy is active, the operands are prepared via prepare_truncation(), and the term-by-term
+		 *   multiplications that cannot produce terms within the degree limit are skipped in the steps below;
+		 * - if the multiplication is a squaring (see \p m_square), each pair of distinct terms is multiplied only once and the
+		 *   result of the multiplication is doubled (see blocked_squaring());
 		 * - a heuristic determines whether to enable multi-threaded mode or not;
 		 * - in single-threaded mode:
 		 *   - an instance of \p Functor is created and used to compute the return value via term-by-term multiplications and
 		 *     insertions in the return series;
 		 * - in multi-threaded mode:
-		 *   - the first series is subdivided into segments and the same process described for single-threaded mode is run in parallel,
-		 *     storing the multiple resulting series in a list;
-		 *   - the series in the result list are merged into a single series via piranha::series::insert().
+		 *   - the return series is pre-sized according to estimate_final_series_size(), and its buckets are grouped into
+		 *     contiguous stripes, each protected by a mutex;
+		 *   - the threads claim small chunks of rows of the first series dynamically, compute the term-by-term multiplications
+		 *     via \p Functor and buffer the results locally per stripe;
+		 *   - the buffers are merged directly into the return series under the stripe locks, so that no per-thread
+		 *     partial results need to be merged at the end.
 		 * 
 		 * \p Functor must be a type exposing the same public interface as default_functor.
-		 * It will be used to compute term-by-term multiplications and insert the terms into the return series.
+		 * It will be used to compute term-by-term multiplications and insert the terms into the return series (in multi-threaded mode,
+		 * the results of the multiplications are read directly from the <tt>m_tmp</tt> member of \p Functor).
 		 * 
 		 * @return the result of multiplying the first series by the second series.
 		 * 
@@ -254,6 +341,17 @@ class series_multiplier
 			}
 			// This is the size type that will be used throughout the calculations.
 			typedef decltype(m_v1.size()) size_type;
+			// In truncated mode, sort and trim the operands, and compute the limits.
+			std::vector<size_type> limits;
+			if (m_truncation.get_mode() != 0) {
+				limits = prepare_truncation();
+				if (limits.empty()) {
+					return_type retval;
+					retval.m_symbol_set = m_s1->m_symbol_set;
+					return retval;
+				}
+			}
+			const size_type *l_ptr = limits.empty() ? nullptr : &limits[0u];
 			const size_type size1 = m_v1.size(), size2 = boost::numeric_cast<size_type>(m_v2.size());
 			piranha_assert(size1 && size2);
 			// Establish the number of threads to use.
@@ -269,84 +367,35 @@ class series_multiplier
 				return_type retval;
 				retval.m_symbol_set = m_s1->m_symbol_set;
 				Functor f(&m_v1[0u],size1,&m_v2[0u],size2,retval);
-				const auto tmp = rehasher(f);
-				blocked_multiplication(f);
+				const auto tmp = rehasher(f,l_ptr);
+				if (m_square) {
+					blocked_squaring(f,doubling_functor<Functor>(&m_v1[0u],size1,&m_v2[0u],size2,retval),l_ptr);
+				} else {
+					blocked_multiplication(f,l_ptr);
+				}
 				if (tmp.first) {
 					trace_estimates(retval.size(),tmp.second);
 				}
 				return retval;
 			} else {
-				// Build the return values and the multiplication functors.
-				std::list<return_type,cache_aligning_allocator<return_type>> retval_list;
-				std::list<Functor,cache_aligning_allocator<Functor>> functor_list;
-				const auto block_size = size1 / n_threads;
-				for (size_type i = 0u; i < n_threads; ++i) {
-					// Last thread needs a different size from block_size.
-					const size_type s1 = (i == n_threads - 1u) ? (size1 - i * block_size) : block_size;
-					retval_list.push_back(return_type{});
-					retval_list.back().m_symbol_set = m_s1->m_symbol_set;
-					functor_list.push_back(Functor(&m_v1[0u] + i * block_size,s1,&m_v2[0u],size2,retval_list.back()));
-				}
-				auto f_it = functor_list.begin();
-				auto r_it = retval_list.begin();
-				future_list<std::future<void>> f_list;
-				try {
-					for (size_type i = 0u; i < n_threads; ++i, ++f_it, ++r_it) {
-						// Functor for use in the thread.
-						auto f = [f_it,r_it,this]() {
-							const auto tmp = this->rehasher(*f_it);
-							this->blocked_multiplication(*f_it);
-							if (tmp.first) {
-								this->trace_estimates(r_it->m_container.size(),tmp.second);
-							}
-						};
-						f_list.push_back(thread_pool::enqueue(static_cast<unsigned>(i),f));
-					}
-					f_list.wait_all();
-					f_list.get_all();
-				} catch (...) {
-					f_list.wait_all();
-					throw;
-				}
 				return_type retval;
 				retval.m_symbol_set = m_s1->m_symbol_set;
-				auto final_estimate = estimate_final_series_size(Functor(&m_v1[0u],size1,&m_v2[0u],size2,retval));
-				// We want to make sure that final_estimate contains at least 1 element, so that we can use faster low-level
+				auto estimate = final_size_estimate(Functor(&m_v1[0u],size1,&m_v2[0u],size2,retval));
+				if (l_ptr != nullptr && estimate) {
+					estimate = truncated_estimate(estimate,size1,size2,l_ptr);
+				}
+				// We want to make sure that estimate contains at least 1 element, so that we can use faster low-level
 				// methods in hash_set.
-				if (unlikely(!final_estimate)) {
-					final_estimate = 1u;
-				}
-				// Try to see if a series already has enough buckets.
-				auto it = std::find_if(retval_list.begin(),retval_list.end(),[&final_estimate](const return_type &r) {
-					return static_cast<double>(r.m_container.bucket_count()) * r.m_container.max_load_factor() >= final_estimate;
-				});
-				if (it != retval_list.end()) {
-					retval = std::move(*it);
-					retval_list.erase(it);
-				} else {
-					// Otherwise, just rehash to the desired value, corrected for max load factor.
-					retval.m_container.rehash(
-						boost::numeric_cast<typename Series1::size_type>(std::ceil(static_cast<double>(final_estimate) / retval.m_container.max_load_factor()))
-					);
-				}
-				// Cleanup functor that will erase all elements in retval_list.
-				auto cleanup = [&retval_list]() {
-					std::for_each(retval_list.begin(),retval_list.end(),[](return_type &r) {r.m_container.clear();});
-				};
-				try {
-					final_merge(retval,retval_list,n_threads);
-					// Here the estimate will be correct if the initial estimate (corrected for load factor)
-					// is at least equal to the final real bucket count.
-					trace_estimates(retval.m_container.size(),final_estimate);
-				} catch (...) {
-					// Do the cleanup before re-throwing, as we use mutable iterators in final_merge.
-					cleanup();
-					// Clear also retval: it could have bogus number of elements if errors arise in the final merge.
-					retval.m_container.clear();
-					throw;
+				if (unlikely(!estimate)) {
+					estimate = 1u;
 				}
-				// Clean up the temporary series.
-				cleanup();
+				// Pre-size the output series, correcting for the max load factor. The table will not be rehashed
+				// during the multiplication.
+				retval.m_container.rehash(
+					boost::numeric_cast<typename Series1::size_type>(std::ceil(static_cast<double>(estimate) / retval.m_container.max_load_factor()))
+				);
+				shared_multiplication<Functor>(retval,static_cast<unsigned>(n_threads),l_ptr);
+				trace_estimates(retval.m_container.size(),estimate);
 				return retval;
 			}
 		}
@@ -425,6 +474,21 @@ class series_multiplier
 					piranha_assert(i < m_s1 && j < m_s2);
 					(m_ptr1[i])->multiply(m_tmp,*(m_ptr2[j]),m_retval.m_symbol_set);
 				}
+				/// Prefetch the output of a term multiplication.
+				/**
+				 * This method is called by the multiplication loops (see multiply_row()) a few multiplications ahead of the calls to
+				 * operator()() with the same indices. Functors locating the result of the multiplication of the i-th and j-th terms in the
+				 * return value via cheap operations can override this method to issue memory prefetch hints. The default implementation
+				 * is a no-op.
+				 * 
+				 * @param[in] i index of the first term operand.
+				 * @param[in] j index of the second term operand.
+				 */
+				void prefetch(const size_type &i, const size_type &j) const
+				{
+					(void)i;
+					(void)j;
+				}
 				/// Term insertion.
 				/**
 				 * This method will insert into the return value \p m_retval the term(s) stored in \p m_tmp.
@@ -459,58 +523,489 @@ class series_multiplier
 		 *
 		 * The method will perform the multiplications after logically subdividing the input series in blocks, in order to
 		 * optimize cache memory access patterns.
+		 *
+		 * If \p limits is not null, it must point to an array of non-increasing values, one for each term of the first series:
+		 * the i-th term of the first series will then be multiplied only by the terms of the second series with index
+		 * less than <tt>limits[i]</tt>, and the blocks lying entirely beyond the limits will be skipped. This is used to implement
+		 * degree truncation (see prepare_truncation()).
 		 * 
 		 * @param[in] f multiplication functor.
+		 * @param[in] limits optional pointer to the array of limits.
 		 * 
 		 * @throws unspecified any exception thrown by the public interface of \p Functor.
 		 */
 		template <typename Functor>
-		static void blocked_multiplication(const Functor &f)
+		static void blocked_multiplication(const Functor &f, const typename Functor::size_type *limits = nullptr)
 		{
 			typedef typename std::decay<decltype(f.m_s1)>::type size_type;
 			// NOTE: hard-coded block size of 256.
 			static_assert(boost::integer_traits<size_type>::const_max >= 256u, "Invalid size type.");
-			const size_type size1 = f.m_s1, size2 = f.m_s2, bsize1 = 256u, nblocks1 = size1 / bsize1, bsize2 = bsize1, nblocks2 = size2 / bsize2;
-			// Start and end of last (possibly irregular) blocks.
-			const size_type i_ir_start = nblocks1 * bsize1, i_ir_end = size1;
-			const size_type j_ir_start = nblocks2 * bsize2, j_ir_end = size2;
-			for (size_type n1 = 0u; n1 < nblocks1; ++n1) {
-				const size_type i_start = n1 * bsize1, i_end = i_start + bsize1;
-				// regulars1 * regulars2
-				for (size_type n2 = 0u; n2 < nblocks2; ++n2) {
-					const size_type j_start = n2 * bsize2, j_end = j_start + bsize2;
+			const size_type size1 = f.m_s1, size2 = f.m_s2, bsize = 256u;
+			for (size_type i_start = 0u; i_start < size1;) {
+				// Last (possibly irregular) blocks are truncated to the sizes of the series.
+				const size_type i_end = (size1 - i_start > bsize) ? i_start + bsize : size1;
+				// NOTE: as the limits are non-increasing, the limit of the first row is the limit for the whole block.
+				const size_type j_max = (limits == nullptr) ? size2 : limits[i_start];
+				if (j_max == 0u) {
+					// All the following rows have null limits as well.
+					break;
+				}
+				for (size_type j_start = 0u; j_start < j_max;) {
+					const size_type j_end = (size2 - j_start > bsize) ? j_start + bsize : size2;
+					for (size_type i = i_start; i < i_end; ++i) {
+						const size_type j_stop = (limits != nullptr && limits[i] < j_end) ? limits[i] : j_end;
+						multiply_row(f,i,j_start,j_stop);
+					}
+					j_start = j_end;
+				}
+				i_start = i_end;
+			}
+		}
+		/// Block-by-block squaring.
+		/**
+		 * This method is the squaring counterpart of blocked_multiplication(). It expects the first <tt>f.m_s1</tt> terms of the two
+		 * arrays of pointers of \p f to be the same (which is the case in squaring mode, see \p m_square), and it will perform only the
+		 * term-by-term multiplications <tt>(i,j)</tt> with <tt>i <= j</tt>: the products with <tt>i == j</tt> are computed via \p f,
+		 * the others via \p f_off, which must accumulate twice the product of the terms into the same output series as \p f.
+		 * The lower-triangular blocks are skipped altogether.
+		 *
+		 * \p limits is interpreted as in blocked_multiplication() and it must be symmetric (i.e., <tt>j < limits[i]</tt>
+		 * if and only if <tt>i < limits[j]</tt>), as is the case for the limits returned by prepare_truncation() in squaring mode.
+		 *
+		 * @param[in] f multiplication functor for the diagonal products.
+		 * @param[in] f_off multiplication functor for the off-diagonal products.
+		 * @param[in] limits optional pointer to the array of limits.
+		 *
+		 * @throws unspecified any exception thrown by the public interface of \p Functor and \p OffFunctor.
+		 */
+		template <typename Functor, typename OffFunctor>
+		static void blocked_squaring(const Functor &f, const OffFunctor &f_off, const typename Functor::size_type *limits = nullptr)
+		{
+			typedef typename std::decay<decltype(f.m_s1)>::type size_type;
+			// NOTE: hard-coded block size of 256, as in blocked_multiplication().
+			static_assert(boost::integer_traits<size_type>::const_max >= 256u, "Invalid size type.");
+			const size_type size1 = f.m_s1, size2 = f.m_s2, bsize = 256u;
+			piranha_assert(size1 <= size2);
+			for (size_type i_start = 0u; i_start < size1;) {
+				const size_type i_end = (size1 - i_start > bsize) ? i_start + bsize : size1;
+				const size_type j_max = (limits == nullptr) ? size2 : limits[i_start];
+				if (j_max == 0u) {
+					break;
+				}
+				// The blocks of the second series start from the diagonal.
+				for (size_type j_start = i_start; j_start < j_max;) {
+					const size_type j_end = (size2 - j_start > bsize) ? j_start + bsize : size2;
 					for (size_type i = i_start; i < i_end; ++i) {
-						for (size_type j = j_start; j < j_end; ++j) {
-							f(i,j);
+						const size_type j_stop = (limits != nullptr && limits[i] < j_end) ? limits[i] : j_end;
+						size_type j = j_start;
+						if (i >= j) {
+							if (i >= j_stop) {
+								continue;
+							}
+							f(i,i);
 							f.insert();
+							j = i + 1u;
 						}
+						multiply_row(f_off,i,j,j_stop);
 					}
+					j_start = j_end;
 				}
-				// regulars1 * rem2
-				for (size_type i = i_start; i < i_end; ++i) {
-					for (size_type j = j_ir_start; j < j_ir_end; ++j) {
-						f(i,j);
-						f.insert();
-					}
+				i_start = i_end;
+			}
+		}
+		/// Multiply a term by a range of terms.
+		/**
+		 * This method will call <tt>f(i,j)</tt> and <tt>f.insert()</tt> for each \p j in <tt>[j_start,j_end[</tt>. The output of the multiplications
+		 * is prefetched via <tt>f.prefetch()</tt> #prefetch_distance multiplications in advance.
+		 * 
+		 * @param[in] f multiplication functor.
+		 * @param[in] i index of the first term operand.
+		 * @param[in] j_start start of the range of indices of the second term operand.
+		 * @param[in] j_end end of the range of indices of the second term operand.
+		 * 
+		 * @throws unspecified any exception thrown by the public interface of \p Functor.
+		 */
+		template <typename Functor>
+		static void multiply_row(const Functor &f, const typename Functor::size_type &i, const typename Functor::size_type &j_start,
+			const typename Functor::size_type &j_end)
+		{
+			typedef typename Functor::size_type size_type;
+			const size_type j_pf = (j_end - j_start > prefetch_distance) ? j_start + prefetch_distance : j_end;
+			for (size_type j = j_start; j < j_pf; ++j) {
+				f.prefetch(i,j);
+			}
+			for (size_type j = j_start; j < j_end; ++j) {
+				if (j + prefetch_distance < j_end) {
+					f.prefetch(i,j + prefetch_distance);
 				}
+				f(i,j);
+				f.insert();
 			}
-			// rem1 * regulars2
-			for (size_type n2 = 0u; n2 < nblocks2; ++n2) {
-				const size_type j_start = n2 * bsize2, j_end = j_start + bsize2;
-				for (size_type i = i_ir_start; i < i_ir_end; ++i) {
-					for (size_type j = j_start; j < j_end; ++j) {
-						f(i,j);
-						f.insert();
+		}
+		/// Check if the output of the multiplication should be prefetched.
+		/**
+		 * Prefetching the destination buckets of the term-by-term multiplications (see default_functor::prefetch()) pays off only when the
+		 * table of the return value does not fit in the cache memory. This method will return \p true if the capacity of the table of \p retval
+		 * (i.e., the number of buckets times the maximum load factor) is large enough for prefetching to be useful.
+		 * 
+		 * @param[in] retval return value of the multiplication.
+		 * 
+		 * @return \p true if the output of the multiplication should be prefetched.
+		 */
+		static bool prefetch_output(const return_type &retval)
+		{
+			// NOTE: this corresponds to a table of tens of megabytes, i.e., larger than the last level cache on current hardware.
+			return static_cast<double>(retval.m_container.bucket_count()) * retval.m_container.max_load_factor() >=
+				static_cast<double>(typename Series1::size_type(1u) << 20u);
+		}
+		/// Prefetch distance.
+		/**
+		 * Number of term-by-term multiplications by which the prefetching of the output runs ahead of the insertions in multiply_row().
+		 */
+		static const std::size_t prefetch_distance = 16u;
+		/// Align the operands for squaring.
+		/**
+		 * In squaring mode, this method will copy \p m_v1 into \p m_v2, so that the two vectors of term pointers
+		 * have the same ordering after \p m_v1 has been sorted. Otherwise, the method is a no-op.
+		 */
+		void align_square_operands() const
+		{
+			if (m_square) {
+				copy_term_pointers(m_v2,m_v1);
+			}
+		}
+		/// Compare terms in squaring mode.
+		/**
+		 * In squaring mode, each unordered pair of distinct terms has to be multiplied only once. Multiplication algorithms
+		 * that cannot skip the redundant pairs structurally (e.g., because they enumerate the term-by-term multiplications
+		 * according to their output) can use this method: the product of the terms pointed to by \p p1 and \p p2 is to be skipped if
+		 * the return value is positive, doubled if it is negative, and computed normally if it is zero (i.e., if \p p1 and \p p2
+		 * point to the same term).
+		 *
+		 * @param[in] p1 pointer to the first term.
+		 * @param[in] p2 pointer to the second term.
+		 *
+		 * @return an integer whose sign establishes how the product of the terms must be computed.
+		 */
+		static int compare_square_terms(const void *p1, const void *p2)
+		{
+			if (p1 == p2) {
+				return 0;
+			}
+			return std::less<const void *>()(p1,p2) ? -1 : 1;
+		}
+		/// Prepare the operands for truncated multiplication.
+		/**
+		 * This method can be called only if the piranha::degree_truncation policy \p m_truncation is active.
+		 * It will sort the vectors of term pointers \p m_v1 and \p m_v2 in ascending order of low degree (total or partial,
+		 * according to the policy), and it will remove from them the pointers to the terms that cannot produce
+		 * terms within the degree limit. The return value is a non-increasing vector of limits, one for each element of \p m_v1,
+		 * such that the multiplication of the i-th term of the first series by the j-th term of the second series
+		 * produces terms within the degree limit only if j is less than the i-th limit.
+		 * 
+		 * @return the vector of limits for use in blocked_multiplication().
+		 * 
+		 * @throws unspecified any exception thrown by:
+		 * - memory allocation errors in standard containers,
+		 * - the computation of the degree of the terms,
+		 * - the arithmetic operators of piranha::integer.
+		 */
+		std::vector<typename std::vector<term_type1 const *>::size_type> prepare_truncation() const
+		{
+			piranha_assert(m_truncation.get_mode() != 0);
+			return prepare_truncation_impl(truncation_support());
+		}
+		/// Scale size estimate in truncated mode.
+		/**
+		 * The estimate returned by estimate_final_series_size() assumes that all the term-by-term multiplications are performed.
+		 * This method will scale \p estimate by the fraction of term-by-term multiplications actually performed when the limits
+		 * returned by prepare_truncation() are applied to series of sizes \p s1 and \p s2.
+		 * 
+		 * @param[in] estimate the original estimate.
+		 * @param[in] s1 size of the first series.
+		 * @param[in] s2 size of the second series.
+		 * @param[in] limits pointer to the array of \p s1 limits.
+		 * 
+		 * @return the scaled estimate, which will never be zero.
+		 * 
+		 * @throws unspecified any exception thrown by the arithmetic and conversion operators of piranha::integer.
+		 */
+		template <typename Size>
+		static typename Series1::size_type truncated_estimate(const typename Series1::size_type &estimate, const Size &s1, const Size &s2,
+			const Size *limits)
+		{
+			piranha_assert(s1 && s2);
+			const auto n_mults = std::accumulate(limits,limits + s1,integer(0),[](const integer &n, const Size &l) {return n + l;});
+			const auto retval = static_cast<typename Series1::size_type>((integer(estimate) * n_mults) / (integer(s1) * s2));
+			return retval ? retval : typename Series1::size_type(1u);
+		}
+		/// Output range.
+		/**
+		 * Semi-open interval <tt>[a,b[</tt> of bucket indices in the hash set of the result, or of indices in
+		 * a dense output vector.
+		 */
+		typedef std::pair<typename Series1::size_type,typename Series1::size_type> range_type;
+		/// Lock-free dispenser of output ranges.
+		/**
+		 * This class is used in multi-threaded multiplications based on output ownership. The output space <tt>[0,size[</tt>
+		 * is split into a number of ranges larger than the number of threads, and each thread claims the next free range
+		 * via an atomic counter. The thread owning a range is the only one that computes and writes the products landing in it,
+		 * so no locking or waiting is needed, and the dynamic claiming balances the load.
+		 */
+		class range_dispenser
+		{
+				typedef typename Series1::size_type bucket_size_type;
+			public:
+				/// Constructor.
+				/**
+				 * @param[in] size size of the output space.
+				 * @param[in] n_threads number of threads that will claim ranges.
+				 */
+				explicit range_dispenser(const bucket_size_type &size, const unsigned &n_threads):
+					m_size(size),m_n_ranges(0u),m_next(0u)
+				{
+					piranha_assert(size && n_threads);
+					// NOTE: the number of ranges per thread is a tradeoff between load balancing
+					// and the cost of locating, for each term of the first series, the terms
+					// of the second series whose products land in a given range.
+					const bucket_size_type candidate = static_cast<bucket_size_type>(n_threads) * 32u;
+					m_n_ranges = (candidate < size) ? candidate : size;
+				}
+				/// Claim the next range.
+				/**
+				 * @param[out] r the claimed range.
+				 * 
+				 * @return \p false if there are no more ranges available, \p true otherwise.
+				 */
+				bool next(range_type &r)
+				{
+					const bucket_size_type idx = m_next.fetch_add(1u);
+					if (idx >= m_n_ranges) {
+						return false;
 					}
+					const bucket_size_type q = m_size / m_n_ranges, rem = m_size % m_n_ranges,
+						start = q * idx + ((idx < rem) ? idx : rem);
+					r.first = start;
+					r.second = start + q + ((idx < rem) ? 1u : 0u);
+					piranha_assert(r.first < r.second && r.second <= m_size);
+					return true;
+				}
+				/// Stop the dispenser.
+				/**
+				 * All ranges will be marked as claimed, so that the other threads will stop
+				 * as soon as they are done with their current range.
+				 */
+				void stop()
+				{
+					m_next.store(m_n_ranges);
+				}
+			private:
+				const bucket_size_type			m_size;
+				bucket_size_type			m_n_ranges;
+				std::atomic<bucket_size_type>		m_next;
+		};
+		/// Enumerate rows of pairs of indices landing in an interval.
+		/**
+		 * Given two vectors of values sorted in ascending order, this method will call <tt>func(i,j_start,j_end)</tt> for each index \p i
+		 * in \p outer, where <tt>[j_start,j_end[</tt> is the nonempty range of indices in \p inner such that <tt>outer[i] + inner[j]</tt> is in the
+		 * closed interval <tt>[t_start,t_end]</tt>.
+		 * 
+		 * As \p outer is sorted, the range of indices in \p inner to be used with <tt>outer[i]</tt> can only move backwards
+		 * when \p i increases. The range is located via galloping search, hence the cost of this method, apart from the calls to
+		 * \p func, is roughly linear in the size of \p outer (which should thus be the smaller of the two vectors).
+		 * 
+		 * If \p upper is \p true, \p outer and \p inner must contain the same values, and only the pairs with <tt>i <= j</tt>
+		 * will be considered (this is useful in squaring mode).
+		 * 
+		 * @param[in] outer first vector of values.
+		 * @param[in] inner second vector of values.
+		 * @param[in] t_start start of the target interval.
+		 * @param[in] t_end end of the target interval.
+		 * @param[in] func functor to be called on the rows of indices.
+		 * @param[in] upper consider only the pairs of indices in the upper triangle.
+		 * 
+		 * @throws unspecified any exception thrown by \p func.
+		 */
+		template <typename T, typename Func>
+		static void range_rows(const std::vector<T> &outer, const std::vector<T> &inner, const T &t_start, const T &t_end,
+			const Func &func, bool upper = false)
+		{
+			typedef typename std::vector<T>::size_type size_type;
+			piranha_assert(t_start <= t_end);
+			// Current semi-open range [j_start,j_end[ in inner.
+			size_type j_start = inner.size(), j_end = inner.size();
+			const size_type outer_size = outer.size();
+			for (size_type i = 0u; i < outer_size; ++i) {
+				const T &o = outer[i];
+				j_end = gallop_back(inner,j_end,[&o,&t_end](const T &n) {return !(t_end < o + n);});
+				if (!j_end) {
+					// All the next elements of outer will produce values past t_end.
+					break;
+				}
+				j_start = gallop_back(inner,j_start,[&o,&t_start](const T &n) {return o + n < t_start;});
+				const size_type j_first = (upper && j_start < i) ? i : j_start;
+				if (j_first < j_end) {
+					func(i,j_first,j_end);
 				}
 			}
-			// rem1 * rem2.
-			for (size_type i = i_ir_start; i < i_ir_end; ++i) {
-				for (size_type j = j_ir_start; j < j_ir_end; ++j) {
-					f(i,j);
-					f.insert();
+		}
+		/// Enumerate pairs of indices landing in an interval.
+		/**
+		 * This method will call <tt>func(i,j)</tt> for all the pairs of indices enumerated by range_rows().
+		 * 
+		 * @param[in] outer first vector of values.
+		 * @param[in] inner second vector of values.
+		 * @param[in] t_start start of the target interval.
+		 * @param[in] t_end end of the target interval.
+		 * @param[in] func functor to be called on the pairs of indices.
+		 * @param[in] upper consider only the pairs of indices in the upper triangle.
+		 * 
+		 * @throws unspecified any exception thrown by \p func.
+		 */
+		template <typename T, typename Func>
+		static void range_kernel(const std::vector<T> &outer, const std::vector<T> &inner, const T &t_start, const T &t_end,
+			const Func &func, bool upper = false)
+		{
+			typedef typename std::vector<T>::size_type size_type;
+			range_rows(outer,inner,t_start,t_end,[&func](const size_type &i, const size_type &j_start, const size_type &j_end) {
+				for (size_type j = j_start; j < j_end; ++j) {
+					func(i,j);
+				}
+			},upper);
+		}
+		/// Run function in multiple threads.
+		/**
+		 * \p thread_function will be run by \p n_threads threads from piranha::thread_pool. This method will wait for all the threads
+		 * to finish before returning, also in case of errors.
+		 * 
+		 * @param[in] thread_function function to be run.
+		 * @param[in] n_threads number of threads.
+		 * 
+		 * @throws unspecified any exception thrown by \p thread_function, by piranha::thread_pool::enqueue_any() or by memory allocation
+		 * errors in standard containers.
+		 */
+		template <typename Functor>
+		static void run_threads(const Functor &thread_function, const unsigned &n_threads)
+		{
+			// NOTE: one of the fundamental requirements here is that we wait for pending
+			// tasks, in case of errors, before getting out of this function: thread_function
+			// contains references to local variables, if we get out of here before the tasks are finished
+			// memory corruption will occur.
+			future_list<decltype(thread_pool::enqueue_any(thread_function))> f_list;
+			try {
+				for (unsigned i = 0u; i < n_threads; ++i) {
+					// NOTE: enqueue_any() will either happen or it won't, we only care
+					// about memory allocation errors in push_back() here. In such case,
+					// push_back() will wait on the temporary future from enqueue_any()
+					// before returning the exception.
+					f_list.push_back(thread_pool::enqueue_any(thread_function));
+				}
+				// First let's wait for everything to finish.
+				f_list.wait_all();
+				// Then, let's handle the exceptions.
+				f_list.get_all();
+			} catch (...) {
+				// Make sure any pending task is finished -> this is for
+				// the case the exception was thrown in the future creation
+				// loop. It is safe to call this again in case the exception
+				// being handled is generated by get_all(), as wait_all() will check
+				// the validity of the future before calling wait().
+				f_list.wait_all();
+				throw;
+			}
+		}
+		/// Sanitize series after low-level insertions.
+		/**
+		 * This method is to be called after terms have been inserted in \p retval via the low-level interface of piranha::hash_set,
+		 * without updating the number of elements and without checking for ignorability. It will set the number of elements of \p retval
+		 * to \p insertion_count, erase the ignorable terms (in parallel using \p n_threads threads), and rehash \p retval if its load
+		 * factor is too high. The inserted terms must be compatible with the symbol set of \p retval.
+		 * 
+		 * @param[in,out] retval the series to be sanitized.
+		 * @param[in] insertion_count number of terms inserted in \p retval.
+		 * @param[in] n_threads number of threads to use.
+		 * 
+		 * @throws unspecified any exception thrown by:
+		 * - the <tt>is_ignorable()</tt> method of the term type,
+		 * - errors in threading primitives,
+		 * - memory allocation errors in standard containers,
+		 * - the public interface of piranha::hash_set.
+		 */
+		static void sanitize_series(return_type &retval, const typename Series1::size_type &insertion_count, unsigned n_threads = 1u)
+		{
+			typedef typename Series1::size_type bucket_size_type;
+			// Here we have to do the following things:
+			// - check ignorability of terms,
+			// - cope with excessive load factor,
+			// - update the size of the series.
+			// Compatibility is guaranteed by the caller.
+			// First, let's fix the size of inserted terms.
+			retval.m_container._update_size(insertion_count);
+			// Second, erase the ignorable terms.
+			if (n_threads == 1u) {
+				const auto it_f = retval.m_container.end();
+				for (auto it = retval.m_container.begin(); it != it_f;) {
+					if (unlikely(it->is_ignorable(retval.m_symbol_set))) {
+						it = retval.m_container.erase(it);
+					} else {
+						++it;
+					}
+				}
+			} else {
+				const auto b_count = retval.m_container.bucket_count();
+				piranha_assert(b_count);
+				// Adjust the number of threads if they are more than the bucket count.
+				const unsigned nt = (n_threads <= b_count) ? n_threads : static_cast<unsigned>(b_count);
+				std::mutex m;
+				auto eraser = [b_count,&retval,&m](const bucket_size_type &start, const bucket_size_type &end) {
+					piranha_assert(start < end && end <= b_count);
+					bucket_size_type erase_count = 0u;
+					std::vector<typename return_type::term_type> term_list;
+					for (bucket_size_type i = start; i != end; ++i) {
+						term_list.clear();
+						const auto &bl = retval.m_container._get_bucket_list(i);
+						const auto it_f = bl.end();
+						for (auto it = bl.begin(); it != it_f; ++it) {
+							if (unlikely(it->is_ignorable(retval.m_symbol_set))) {
+								term_list.push_back(*it);
+							}
+						}
+						for (auto it = term_list.begin(); it != term_list.end(); ++it) {
+							// NOTE: must use _erase to avoid concurrent modifications
+							// to the number of elements in the table.
+							retval.m_container._erase(retval.m_container._find(*it,i));
+							++erase_count;
+						}
+					}
+					if (erase_count) {
+						std::lock_guard<std::mutex> lock(m);
+						piranha_assert(erase_count <= retval.m_container.size());
+						retval.m_container._update_size(retval.m_container.size() - erase_count);
+					}
+				};
+				future_list<decltype(thread_pool::enqueue_any(eraser,bucket_size_type(),bucket_size_type()))> f_list;
+				try {
+					for (unsigned i = 0u; i < nt; ++i) {
+						const auto start = (b_count / nt) * i, end = (i == nt - 1u) ? b_count : (b_count / nt) * (i + 1u);
+						f_list.push_back(thread_pool::enqueue_any(eraser,start,end));
+					}
+					// First let's wait for everything to finish.
+					f_list.wait_all();
+					// Then, let's handle the exceptions.
+					f_list.get_all();
+				} catch (...) {
+					f_list.wait_all();
+					// Clean up and re-throw.
+					retval.m_container.clear();
+					throw;
 				}
 			}
+			// Finally, cope with excessive load factor.
+			if (unlikely(retval.m_container.load_factor() > retval.m_container.max_load_factor())) {
+				retval.m_container.rehash(
+					boost::numeric_cast<bucket_size_type>(std::ceil(static_cast<double>(retval.m_container.size()) / retval.m_container.max_load_factor()))
+				);
+			}
 		}
 		/// Estimate size of series multiplication.
 		/**
@@ -518,107 +1013,161 @@ class series_multiplier
 		 * will employ a statistical approach to estimate the size of the output of the series multiplication represented
 		 * by \p f (without actually going through the whole calculation).
 		 * 
+		 * The estimation proceeds in rounds of increasing size. In each round, a number of distinct term-by-term multiplications,
+		 * selected via a pseudo-random permutation of the pairs of input terms, is performed via \p f, and the hashes
+		 * of the resulting terms are fed into a HyperLogLog sketch, without inserting them into the return value. The
+		 * number of distinct terms in the sample is then compared to the number of sampled terms, and the rounds continue until
+		 * the fraction of duplicates is large enough to be measured reliably (or an implementation-defined maximum
+		 * sample size is reached). The size of the result is finally extrapolated from the sample by modelling
+		 * the terms as thrown uniformly at random into the terms of the result. Each round is split among up to \p n_threads
+		 * threads, each operating on a copy of \p f.
+		 * 
 		 * If either input series has a null size, zero will be returned.
 		 * 
 		 * @param[in] f multiplication functor.
+		 * @param[in] n_threads maximum number of threads to be used in the estimation.
 		 * 
 		 * @return the estimated size of the series multiplication represented by \p f.
 		 * 
+		 * @throws std::overflow_error if the number of term-by-term multiplications is too large.
 		 * @throws unspecified any exception thrown by:
 		 * - memory allocation errors in standard containers,
 		 * - overflow errors while converting between integer types,
-		 * - the public interface of \p Functor.
+		 * - the public interface of \p Functor,
+		 * - run_threads().
 		 */
 		template <typename Functor>
-		static typename Series1::size_type estimate_final_series_size(const Functor &f)
+		static typename Series1::size_type estimate_final_series_size(const Functor &f, unsigned n_threads = 1u)
 		{
 			typedef typename Series1::size_type bucket_size_type;
 			typedef typename std::decay<decltype(f.m_s1)>::type size_type;
+			typedef std::uint_least64_t pair_type;
 			const size_type size1 = f.m_s1, size2 = f.m_s2;
 			// If one of the two series is empty, just return 0.
 			if (unlikely(!size1 || !size2)) {
 				return 0u;
 			}
-			// Cache reference to return series.
-			auto &retval = f.m_retval;
-			// NOTE: Hard-coded number of trials = 10.
-			// NOTE: here consider that in case of extremely sparse series with few terms (e.g., next to the lower limit
-			// for which this function is called) this will incur in noticeable overhead, since we will need many term-by-term
-			// before encountering the first duplicate.
-			const auto ntrials = 10u;
-			// NOTE: Hard-coded value for the estimation multiplier.
-			// NOTE: This value should be tuned for performance/memory usage tradeoffs.
-			const auto multiplier = 2;
-			// Size of the multiplication result
-			// Vectors of indices.
-			std::vector<size_type> v_idx1, v_idx2;
-			for (size_type i = 0u; i < size1; ++i) {
-				v_idx1.push_back(i);
-			}
-			for (size_type i = 0u; i < size2; ++i) {
-				v_idx2.push_back(i);
-			}
-			// Maxium number of random multiplications before which a duplicate term must be generated.
-			const size_type max_M = static_cast<size_type>(((integer(size1) * size2) / multiplier).sqrt());
-			// Random number engine and generator. We need something more than vanilla random_shuffle as we
-			// want to have a different engine per thread, in order to avoid potential problems with vanilla shuffle
-			// sharing and syncing a state across threads.
-			std::mt19937 engine;
-			typedef typename std::iterator_traits<typename std::vector<size_type>::iterator>::difference_type diff_type;
-			typedef std::uniform_int_distribution<diff_type> dist_type;
-			auto rng = [&engine](const diff_type &n) {return dist_type(diff_type(0),n - diff_type(1))(engine);};
-			// Init counter.
-			integer total(0);
-			// Go with the trials.
-			// NOTE: This could be easily parallelised, but not sure if it is worth.
-			for (auto n = 0u; n < ntrials; ++n) {
-				// Randomise.
-				std::random_shuffle(v_idx1.begin(),v_idx1.end(),rng);
-				std::random_shuffle(v_idx2.begin(),v_idx2.end(),rng);
-				size_type count = 0u;
-				auto it1 = v_idx1.begin(), it2 = v_idx2.begin();
-				while (count < max_M) {
-					if (it1 == v_idx1.end()) {
-						// Each time we wrap around the first series,
-						// wrap around also the second one and rotate it.
-						it1 = v_idx1.begin();
-						auto middle = v_idx2.end();
-						--middle;
-						std::rotate(v_idx2.begin(),middle,v_idx2.end());
-						it2 = v_idx2.begin();
-					}
-					if (it2 == v_idx2.end()) {
-						it2 = v_idx2.begin();
-					}
-					// Perform multiplication and check if it produces a new term.
-					f(*it1,*it2);
-					f.insert();
-					// Check for unlikely overflow when increasing count.
-					if (unlikely(result_size(f.m_tmp) > boost::integer_traits<size_type>::const_max ||
-						count > boost::integer_traits<size_type>::const_max - result_size(f.m_tmp)))
-					{
-						piranha_throw(std::overflow_error,"overflow error");
-					}
-					if (retval.size() != count + result_size(f.m_tmp)) {
-						break;
+			piranha_assert(n_threads);
+			const integer n_pairs_int = integer(size1) * size2;
+			if (unlikely(n_pairs_int > integer(boost::integer_traits<pair_type>::const_max / 2u))) {
+				piranha_throw(std::overflow_error,"overflow error");
+			}
+			const auto n_pairs = static_cast<pair_type>(n_pairs_int);
+			// The pairs are sampled via the permutation k -> (k * stride) mod n_pairs, with stride coprime with n_pairs.
+			// The golden ratio scatters the sampled pairs evenly.
+			pair_type stride = static_cast<pair_type>(static_cast<double>(n_pairs) * 0.6180339887498949);
+			auto gcd = [](pair_type a, pair_type b) {
+				while (b) {
+					const auto r = a % b;
+					a = b;
+					b = r;
+				}
+				return a;
+			};
+			while (gcd(stride,n_pairs) != 1u) {
+				++stride;
+			}
+			// NOTE: hard-coded sample sizes: the sampling starts with 2 ** 10 multiplications, and it does not exceed the
+			// larger of 2 ** 16 and 16 * sqrt(n_pairs) multiplications, which is small with respect to the cost of the
+			// whole multiplication.
+			const pair_type max_sample = std::min(n_pairs,std::max(pair_type(1u) << 16u,
+				static_cast<pair_type>(16 * n_pairs_int.sqrt())));
+			// NOTE: the minimum number of sampled multiplications per thread.
+			const pair_type min_work = 1u << 14u;
+			std::vector<detail::hyperloglog> sketches(n_threads);
+			pair_type sampled = 0u, next = std::min(max_sample,pair_type(1u) << 10u);
+			// Number of terms resulting from the sampled multiplications.
+			integer n_terms(0);
+			double n_distinct = 0.;
+			while (true) {
+				const pair_type round_size = next - sampled;
+				const unsigned n_round = static_cast<unsigned>(std::max(pair_type(1u),std::min(pair_type(n_threads),round_size / min_work)));
+				const pair_type chunk = round_size / n_round;
+				std::vector<integer> counts(n_round);
+				auto thread_function = [&](unsigned t) {
+					const Functor f_copy(f);
+					auto &sketch = sketches[t];
+					const pair_type start = sampled + chunk * t, end = (t == n_round - 1u) ? next : start + chunk;
+					auto pair = static_cast<pair_type>((integer(start) * stride) % n_pairs_int);
+					pair_type count = 0u;
+					auto adder = [&sketch,&count](const typename Series1::term_type &term) {
+						sketch.add(term.hash());
+						++count;
+					};
+					for (pair_type k = start; k < end; ++k) {
+						f_copy(static_cast<size_type>(pair / size2),static_cast<size_type>(pair % size2));
+						visit_terms(f_copy.m_tmp,adder);
+						// NOTE: pair and stride are both less than 2 ** 63.
+						pair += stride;
+						if (pair >= n_pairs) {
+							pair -= n_pairs;
+						}
 					}
-					// Increase cycle variables.
-					count += result_size(f.m_tmp);
-					++it1;
-					++it2;
+					counts[t] = count;
+				};
+				if (n_round == 1u) {
+					thread_function(0u);
+				} else {
+					std::atomic<unsigned> t_id(0u);
+					run_threads([&thread_function,&t_id]() {thread_function(t_id++);},n_round);
 				}
-				total += count;
-				// Reset retval.
-				retval.m_container.clear();
+				for (const auto &c: counts) {
+					n_terms += c;
+				}
+				sampled = next;
+				detail::hyperloglog total;
+				for (const auto &sketch: sketches) {
+					total.merge(sketch);
+				}
+				n_distinct = total.estimate();
+				// Stop when at least 10% of the terms are duplicates, or when the maximum sample size has been reached.
+				if (sampled == max_sample || n_distinct <= 0.9 * static_cast<double>(n_terms)) {
+					break;
+				}
+				next = std::min(max_sample,sampled * 2u);
 			}
-			const auto mean = total / ntrials;
-			// Avoid division by zero.
-			if (total.sign()) {
-				const integer M = (mean * mean * multiplier * total) / total;
-				return static_cast<bucket_size_type>(M);
-			} else {
-				return static_cast<bucket_size_type>(mean * mean * multiplier);
+			// If all the pairs were sampled, the estimate of the sketch is the estimate of the size.
+			if (sampled == n_pairs) {
+				return boost::numeric_cast<bucket_size_type>(std::ceil(n_distinct));
+			}
+			// Throwing n uniformly at random into N terms, the expected number of distinct terms is d = N * (1 - exp(-n / N)).
+			// Invert the relation via bisection, as d is an increasing function of N. The number of terms of the result
+			// cannot be larger than the number of terms resulting from all the multiplications.
+			// NOTE: in series multiplications the terms of the result are hit with very different frequencies, and the
+			// rarely hit ones tend to be missed by the sample: the inversion underestimates the size, hence the hard-coded
+			// multiplier, to be tuned for performance/memory usage tradeoffs.
+			const double multiplier = 2.;
+			const double n = static_cast<double>(n_terms), n_max = n * static_cast<double>(n_pairs) / static_cast<double>(sampled);
+			auto distinct = [n](const double &N) {return N * -std::expm1(-n / N);};
+			if (n_distinct >= distinct(n_max)) {
+				return boost::numeric_cast<bucket_size_type>(std::ceil(n_max));
+			}
+			double lo = std::max(n_distinct,1.), hi = n_max;
+			for (int i = 0; i < 100 && hi - lo > 1.; ++i) {
+				const double mid = lo + (hi - lo) / 2.;
+				if (distinct(mid) < n_distinct) {
+					lo = mid;
+				} else {
+					hi = mid;
+				}
 			}
+			return boost::numeric_cast<bucket_size_type>(std::ceil(std::min(n_max,hi * multiplier)));
+		}
+		/// Size of the result of the multiplication.
+		/**
+		 * @param[in] f the multiplication functor that will be passed to estimate_final_series_size().
+		 * 
+		 * @return \p m_size_hint, if nonzero, otherwise the output of estimate_final_series_size().
+		 * 
+		 * @throws unspecified any exception thrown by estimate_final_series_size() or by \p boost::numeric_cast.
+		 */
+		template <typename Functor>
+		typename Series1::size_type final_size_estimate(const Functor &f) const
+		{
+			if (m_size_hint) {
+				return boost::numeric_cast<typename Series1::size_type>(m_size_hint);
+			}
+			return estimate_final_series_size(f,determine_n_threads());
 		}
 		/// Trace series size estimates.
 		/**
@@ -673,123 +1222,242 @@ class series_multiplier
 			});
 		}
 	private:
-		template <typename RetvalList, typename Size>
-		static void final_merge(return_type &retval, RetvalList &retval_list, const Size &n_threads)
-		{
-			piranha_assert(n_threads > 1u);
-			piranha_assert(retval.m_container.bucket_count());
-			typedef typename std::vector<std::pair<typename Series1::size_type,decltype(retval.m_container._m_begin())>> container_type;
-			typedef typename container_type::size_type size_type;
-			// First, let's fill a vector assigning each term of each element in retval_list to a bucket in retval.
-			const size_type size = static_cast<size_type>(
-				std::accumulate(retval_list.begin(),retval_list.end(),integer(0),[](const integer &n, const return_type &r) {return n + r.size();}));
-			container_type idx(size);
-			future_list<std::future<void>> f_list1;
-			size_type i = 0u;
-			piranha_assert(retval_list.size() <= n_threads);
-			try {
-				unsigned thread_idx = 0u;
-				for (auto r_it = retval_list.begin(); r_it != retval_list.end(); ++r_it, ++thread_idx) {
-					auto f = [&idx,&retval,i,r_it]() {
-						const auto it_f = r_it->m_container._m_end();
-						// NOTE: size_type can represent the sum of the sizes of all retvals,
-						// so it will not overflow here.
-						size_type tmp_i = i;
-						for (auto it = r_it->m_container._m_begin(); it != it_f; ++it, ++tmp_i) {
-							piranha_assert(tmp_i < idx.size());
-							idx[tmp_i] = std::make_pair(retval.m_container._bucket(*it),it);
-						}
-					};
-					f_list1.push_back(thread_pool::enqueue(thread_idx,f));
-					i += r_it->size();
-				}
-				f_list1.wait_all();
-				f_list1.get_all();
-			} catch (...) {
-				f_list1.wait_all();
-				throw;
+		// Visit the term(s) resulting from a term-by-term multiplication.
+		template <typename Tuple, std::size_t N = 0u, typename Enable2 = void>
+		struct term_visitor
+		{
+			static_assert(N < boost::integer_traits<std::size_t>::const_max,
+				"Overflow error.");
+			template <typename F>
+			static void run(Tuple &t, F &f)
+			{
+				f(std::get<N>(t));
+				term_visitor<Tuple,N + 1u>::run(t,f);
+			}
+		};
+		template <typename Tuple, std::size_t N>
+		struct term_visitor<Tuple,N,typename std::enable_if<N == std::tuple_size<Tuple>::value>::type>
+		{
+			template <typename F>
+			static void run(Tuple &, F &)
+			{}
+		};
+		template <typename F, typename... Args>
+		static void visit_terms(std::tuple<Args...> &mult_res, F &f)
+		{
+			term_visitor<std::tuple<Args...>>::run(mult_res,f);
+		}
+		template <typename F>
+		static void visit_terms(typename Series1::term_type &mult_res, F &f)
+		{
+			f(mult_res);
+		}
+		// Functor doubling the results of the term-by-term multiplications computed by Functor. Used for the
+		// products of distinct terms in squaring mode.
+		template <typename Functor>
+		struct doubling_functor: Functor
+		{
+			typedef typename Functor::size_type size_type;
+			explicit doubling_functor(term_type1 const **ptr1, const size_type &s1,
+				term_type2 const **ptr2, const size_type &s2, return_type &retval):
+				Functor(ptr1,s1,ptr2,s2,retval)
+			{}
+			void operator()(const size_type &i, const size_type &j) const
+			{
+				Functor::operator()(i,j);
+				auto doubler = [](term_type1 &t) {t.m_cf *= 2;};
+				visit_terms(this->m_tmp,doubler);
 			}
-			future_list<std::future<void>> f_list2;
-			std::mutex m;
-			std::vector<integer> new_sizes;
-			new_sizes.reserve(static_cast<std::vector<integer>::size_type>(n_threads));
-			if (unlikely(new_sizes.capacity() != n_threads)) {
-				piranha_throw(std::bad_alloc,);
+		};
+		// Multi-threaded multiplication into a single, pre-sized output series.
+		// The buckets of retval are grouped into contiguous stripes, each protected by its own mutex. The rows of the
+		// first series are claimed in small chunks via an atomic counter; the products are buffered locally per stripe
+		// and merged into retval when the buffer fills up (opportunistically via try_lock(), or unconditionally once the
+		// buffer becomes too large) and at the end. The number of elements and the ignorability of the terms are fixed
+		// afterwards by sanitize_series(). If limits is not null, the truncation limits are honoured as in
+		// blocked_multiplication(). In squaring mode, the products are computed as in blocked_squaring().
+		template <typename Functor, typename Size>
+		void shared_multiplication(return_type &retval, const unsigned &n_threads, const Size *limits) const
+		{
+			typedef typename Series1::size_type bucket_size_type;
+			typedef typename Series1::term_type term_type;
+			typedef std::vector<std::pair<bucket_size_type,term_type>> buffer_type;
+			const bucket_size_type b_count = retval.m_container.bucket_count();
+			piranha_assert(b_count && n_threads > 1u);
+			// The number of stripes is a power of two (like the bucket count), possibly 32 times larger than the number of threads.
+			bucket_size_type n_stripes = 1u;
+			const bucket_size_type target = static_cast<bucket_size_type>(n_threads) * 32u;
+			while (n_stripes < target && n_stripes < b_count) {
+				n_stripes <<= 1u;
 			}
-			const typename Series1::size_type bucket_count = retval.m_container.bucket_count(), block_size = bucket_count / n_threads;
-			try {
-				for (Size n = 0u; n < n_threads; ++n) {
-					// These are the bucket indices allowed to the current thread.
-					const typename Series1::size_type start = n * block_size, end = (n == n_threads - 1u) ? bucket_count : (n + 1u) * block_size;
-					auto f = [start,end,&size,&retval,&idx,&m,&new_sizes]() {
-						size_type count_plus = 0u, count_minus = 0u;
-						for (size_type i = 0u; i < size; ++i) {
-							const auto &bucket_idx = idx[i].first;
-							auto &term_it = idx[i].second;
-							if (bucket_idx >= start && bucket_idx < end) {
-								// Reconstruct part of series insertion, without the update in the number of elements.
-								// NOTE: compatibility and ignorability do not matter, as terms being inserted come from series
-								// anyway. Same for check on bucket_count.
-								const auto it = retval.m_container._find(*term_it,bucket_idx);
-								if (it == retval.m_container.end()) {
-									// Term is new.
-									retval.m_container._unique_insert(std::move(*term_it),bucket_idx);
-									// Update term count.
-									piranha_assert(count_plus < boost::integer_traits<size_type>::const_max);
-									++count_plus;
-								} else {
-									// Assert the existing term is not ignorable and it is compatible.
-									piranha_assert(!it->is_ignorable(retval.m_symbol_set) && it->is_compatible(retval.m_symbol_set));
-									// Cleanup function.
-									auto cleanup = [&]() {
-										if (unlikely(!it->is_compatible(retval.m_symbol_set) || it->is_ignorable(retval.m_symbol_set))) {
-											retval.m_container._erase(it);
-											// After term is erased, update count.
-											piranha_assert(count_minus < boost::integer_traits<size_type>::const_max);
-											++count_minus;
-										}
-									};
-									try {
-										// The term exists already, update it.
-										retval.template insertion_cf_arithmetics<true>(it,std::move(*term_it));
-										// Check if the term has become ignorable or incompatible after the modification.
-										cleanup();
-									} catch (...) {
-										cleanup();
-										throw;
+			const bucket_size_type stripe_size = b_count / n_stripes;
+			std::vector<std::mutex> locks(boost::numeric_cast<typename std::vector<std::mutex>::size_type>(n_stripes));
+			const Size size1 = static_cast<Size>(m_v1.size()), size2 = static_cast<Size>(m_v2.size());
+			// NOTE: hard-coded chunk of roughly 2^14 term-by-term multiplications, with rows subdivided in
+			// blocks of 256 columns as in blocked_multiplication().
+			const Size chunk = (size2 >= 16384u) ? Size(1u) : ((size2 <= 64u) ? Size(256u) : static_cast<Size>(16384u / size2)),
+				bsize = 256u;
+			// NOTE: hard-coded soft and hard limits on the size of the stripe buffers.
+			const typename buffer_type::size_type soft_limit = 256u, hard_limit = 4096u;
+			std::atomic<Size> next_row(0u);
+			std::atomic<bool> stop(false);
+			std::atomic<bucket_size_type> insertion_count(0u);
+			auto thread_function = [&retval,&locks,&next_row,&stop,&insertion_count,n_stripes,stripe_size,size1,size2,
+				chunk,bsize,soft_limit,hard_limit,limits,this]() {
+				Functor f(&this->m_v1[0u],size1,&this->m_v2[0u],size2,retval);
+				doubling_functor<Functor> f_off(&this->m_v1[0u],size1,&this->m_v2[0u],size2,retval);
+				std::vector<buffer_type> buffers(static_cast<typename std::vector<buffer_type>::size_type>(n_stripes));
+				bucket_size_type count = 0u;
+				// Merge the buffer of the stripe idx into retval. If block is false, give up if the stripe is locked.
+				auto flush = [&retval,&locks,&buffers,&count](const bucket_size_type &idx, bool block) {
+					std::unique_lock<std::mutex> lock(locks[static_cast<typename std::vector<std::mutex>::size_type>(idx)],std::defer_lock);
+					if (block) {
+						lock.lock();
+					} else if (!lock.try_lock()) {
+						return;
+					}
+					auto &buffer = buffers[static_cast<typename std::vector<buffer_type>::size_type>(idx)];
+					for (auto it = buffer.begin(); it != buffer.end(); ++it) {
+						// NOTE: ignorability is checked afterwards in sanitize_series(), and the number of elements
+						// is updated there as well.
+						const auto r_it = retval.m_container._find(it->second,it->first);
+						if (r_it == retval.m_container.end()) {
+							retval.m_container._unique_insert(std::move(it->second),it->first);
+							piranha_assert(count < boost::integer_traits<bucket_size_type>::const_max);
+							++count;
+						} else {
+							retval.template insertion_cf_arithmetics<true>(r_it,std::move(it->second));
+						}
+					}
+					buffer.clear();
+				};
+				// Store a product in the buffer of its stripe, following the same rules as piranha::series::insert().
+				auto store = [&retval,&buffers,&flush,stripe_size,soft_limit,hard_limit](const term_type &t) {
+					if (unlikely(!t.is_compatible(retval.m_symbol_set))) {
+						piranha_throw(std::invalid_argument,"cannot insert incompatible term");
+					}
+					if (unlikely(t.is_ignorable(retval.m_symbol_set))) {
+						return;
+					}
+					const auto bucket_idx = retval.m_container._bucket(t);
+					const bucket_size_type idx = bucket_idx / stripe_size;
+					auto &buffer = buffers[static_cast<typename std::vector<buffer_type>::size_type>(idx)];
+					buffer.push_back(std::make_pair(bucket_idx,t));
+					if (buffer.size() >= soft_limit) {
+						flush(idx,buffer.size() >= hard_limit);
+					}
+				};
+				try {
+					while (!stop.load()) {
+						const Size i_start = next_row.fetch_add(chunk);
+						if (i_start >= size1) {
+							break;
+						}
+						const Size i_end = (size1 - i_start > chunk) ? i_start + chunk : size1;
+						const Size j_max = (limits == nullptr) ? size2 : limits[i_start];
+						// In squaring mode, skip the lower triangle as in blocked_squaring().
+						for (Size j_start = this->m_square ? i_start : Size(0u); j_start < j_max;) {
+							const Size j_end = (size2 - j_start > bsize) ? j_start + bsize : size2;
+							for (Size i = i_start; i < i_end; ++i) {
+								const Size j_stop = (limits != nullptr && limits[i] < j_end) ? limits[i] : j_end;
+								Size j = j_start;
+								if (this->m_square && i >= j) {
+									if (i >= j_stop) {
+										continue;
+									}
+									f(i,i);
+									visit_terms(f.m_tmp,store);
+									j = static_cast<Size>(i + 1u);
+								}
+								for (; j < j_stop; ++j) {
+									if (this->m_square) {
+										f_off(i,j);
+										visit_terms(f_off.m_tmp,store);
+									} else {
+										f(i,j);
+										visit_terms(f.m_tmp,store);
 									}
 								}
 							}
+							j_start = j_end;
 						}
-						// Store the new size.
-						std::lock_guard<std::mutex> lock(m);
-						new_sizes.push_back(integer(count_plus) - integer(count_minus));
-					};
-					// NOTE: here the static cast is safe as nthreads is coming from a call to
-					// the size of the thread pool.
-					f_list2.push_back(thread_pool::enqueue(static_cast<unsigned>(n),f));
+					}
+					for (bucket_size_type idx = 0u; idx < n_stripes; ++idx) {
+						flush(idx,true);
+					}
+				} catch (...) {
+					stop.store(true);
+					throw;
 				}
-				f_list2.wait_all();
-				f_list2.get_all();
+				insertion_count += count;
+			};
+			try {
+				run_threads(thread_function,n_threads);
+				sanitize_series(retval,insertion_count.load(),n_threads);
 			} catch (...) {
-				f_list2.wait_all();
+				// Clean up and re-throw.
+				retval.m_container.clear();
 				throw;
 			}
-			// Final update of retval's size.
-			const auto new_size = std::accumulate(new_sizes.begin(),new_sizes.end(),integer(0));
-			piranha_assert(new_size + retval.m_container.size() >= 0);
-			retval.m_container._update_size(static_cast<decltype(retval.m_container.size())>(new_size + retval.m_container.size()));
-			// Take care of rehashing, if needed.
-			if (unlikely(retval.m_container.load_factor() > retval.m_container.max_load_factor())) {
-				retval.m_container.rehash(
-					boost::numeric_cast<typename Series1::size_type>(std::ceil(static_cast<double>(retval.size()) / retval.m_container.max_load_factor()))
-				);
+		}
+		// Starting from an index j such that pred() is false for all the elements of v from j onwards, locate
+		// the partition point of v with respect to pred() (i.e., the first element for which pred() is false).
+		// The search proceeds backwards with exponentially increasing steps, so that the cost is logarithmic
+		// in the distance between j and the partition point.
+		template <typename T, typename Pred>
+		static typename std::vector<T>::size_type gallop_back(const std::vector<T> &v, typename std::vector<T>::size_type j, const Pred &pred)
+		{
+			typedef typename std::vector<T>::size_type size_type;
+			typedef typename std::vector<T>::difference_type diff_type;
+			piranha_assert(j <= v.size());
+			size_type step = 1u;
+			while (j) {
+				const size_type probe = (j > step) ? j - step : size_type(0u);
+				if (pred(v[probe])) {
+					return static_cast<size_type>(std::partition_point(v.begin() + static_cast<diff_type>(probe + 1u),
+						v.begin() + static_cast<diff_type>(j),pred) - v.begin());
+				}
+				j = probe;
+				step *= 2u;
+			}
+			return 0u;
+		}
+		std::vector<typename std::vector<term_type1 const *>::size_type> prepare_truncation_impl(const std::true_type &) const
+		{
+			typedef typename std::vector<term_type1 const *>::size_type size_type;
+			const auto &args = m_s1->m_symbol_set;
+			const auto d1 = detail::truncation_sort<Series1>(m_v1,args,m_truncation),
+				d2 = detail::truncation_sort<Series2>(m_v2,args,m_truncation);
+			const auto &max_degree = m_truncation.get_max_degree();
+			std::vector<size_type> retval;
+			retval.reserve(d1.size());
+			// As d1 is sorted, the limit for each term of the first series can only decrease.
+			auto j = boost::numeric_cast<size_type>(d2.size());
+			for (decltype(d1.size()) i = 0u; i < d1.size(); ++i) {
+				while (j && d1[i] + d2[j - 1u] > max_degree) {
+					--j;
+				}
+				if (!j) {
+					// This term and the following ones (which have higher degree) do not contribute.
+					break;
+				}
+				retval.push_back(j);
 			}
+			// Remove the terms that do not contribute.
+			m_v1.resize(retval.size());
+			m_v2.resize(retval.empty() ? 0u : retval[0u]);
+			return retval;
+		}
+		std::vector<typename std::vector<term_type1 const *>::size_type> prepare_truncation_impl(const std::false_type &) const
+		{
+			piranha_assert(false);
+			return {};
 		}
 		// Functor tasked to prepare return value(s) with estimated bucket sizes (if
-		// it is worth to perform such analysis).
+		// it is worth to perform such analysis). In truncated mode, the estimate is scaled
+		// by the fraction of term-by-term multiplications that will be actually performed.
 		template <typename Functor>
-		static std::pair<bool,typename Series1::size_type> rehasher(const Functor &f)
+		std::pair<bool,typename Series1::size_type> rehasher(const Functor &f, const typename Functor::size_type *limits = nullptr) const
 		{
 			const auto s1 = f.m_s1, s2 = f.m_s2;
 			auto &r = f.m_retval;
@@ -799,7 +1467,10 @@ class series_multiplier
 				// of the estimate or in rehashing. In such a case, just ignore the rehashing, clean
 				// up retval just to be sure, and proceed.
 				try {
-					auto size = estimate_final_series_size(f);
+					auto size = final_size_estimate(f);
+					if (limits != nullptr) {
+						size = truncated_estimate(size,s1,s2,limits);
+					}
 					r.m_container.rehash(boost::numeric_cast<decltype(size)>(std::ceil(static_cast<double>(size) / r.m_container.max_load_factor())));
 					return std::make_pair(true,size);
 				} catch (...) {
@@ -829,6 +1500,19 @@ class series_multiplier
 		mutable std::vector<term_type1 const *>	m_v1;
 		/// Vector of const pointers to the terms in the second series.
 		mutable std::vector<term_type2 const *>	m_v2;
+		/// Degree truncation policy in effect for the multiplication.
+		const degree_truncation			m_truncation;
+		/// Squaring flag.
+		/**
+		 * \p true if the two operands are the same object. In this case \p m_v1 and \p m_v2 initially contain the same
+		 * pointers in the same order.
+		 */
+		const bool				m_square;
+		/// Size hint.
+		/**
+		 * The estimated size of the result set via _set_size_hint() before construction, or zero if no hint was given.
+		 */
+		const std::size_t			m_size_hint;
 };
 
 }
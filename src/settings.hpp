@@ -31,6 +31,44 @@
 namespace piranha
 {
 
+/// Series exponentiation strategies.
+/**
+ * The strategies that can be used by piranha::series::pow() to compute integral powers of series.
+ * See piranha::settings::set_pow_strategy().
+ */
+enum class pow_strategy
+{
+	/// Select the strategy automatically.
+	automatic,
+	/// Repeated multiplication by the base.
+	linear,
+	/// Binary exponentiation via squaring.
+	binary,
+	/// J.C.P. Miller's recurrence on the homogeneous components of the base.
+	recurrence,
+	/// Recursive splitting of the exponent into two halves.
+	split
+};
+
+/// Polynomial multiplication strategies.
+/**
+ * The strategies that can be used to multiply polynomials with Kronecker monomials.
+ * See piranha::settings::set_multiplication_strategy().
+ */
+enum class multiplication_strategy
+{
+	/// Select the strategy automatically.
+	automatic,
+	/// Accumulation of the term-by-term products in a hash table.
+	sparse,
+	/// Accumulation of the term-by-term products in dense arrays spanning the range of the Kronecker codes of the result.
+	dense,
+	/// Merge of the term-by-term products via a heap (Monagan and Pearce), producing the terms of the result in order.
+	heap,
+	/// Radix sort of the term-by-term products on the Kronecker codes, followed by the reduction of the runs of equal codes.
+	sort_reduce
+};
+
 namespace detail
 {
 
@@ -42,6 +80,8 @@ struct base_settings
 	static unsigned			m_cache_line_size;
 	static unsigned long		m_max_term_output;
 	static const unsigned long	m_default_max_term_output = 20ul;
+	static pow_strategy		m_pow_strategy;
+	static multiplication_strategy	m_multiplication_strategy;
 };
 
 template <typename T>
@@ -59,6 +99,12 @@ unsigned long base_settings<T>::m_max_term_output = base_settings<T>::m_default_
 template <typename T>
 const unsigned long base_settings<T>::m_default_max_term_output;
 
+template <typename T>
+pow_strategy base_settings<T>::m_pow_strategy = pow_strategy::automatic;
+
+template <typename T>
+multiplication_strategy base_settings<T>::m_multiplication_strategy = multiplication_strategy::automatic;
+
 }
 
 /// Global settings.
@@ -205,6 +251,76 @@ class settings: private detail::base_settings<>
 			std::lock_guard<std::mutex> lock(m_mutex);
 			m_max_term_output = m_default_max_term_output;
 		}
+		/// Get the series exponentiation strategy.
+		/**
+		 * @return the strategy used by piranha::series::pow() to compute integral powers of series.
+		 *
+		 * @throws std::system_error in case of failure(s) by threading primitives.
+		 */
+		static pow_strategy get_pow_strategy()
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			return m_pow_strategy;
+		}
+		/// Set the series exponentiation strategy.
+		/**
+		 * @param[in] s the strategy that will be used by piranha::series::pow() to compute integral powers of series.
+		 *
+		 * @throws std::system_error in case of failure(s) by threading primitives.
+		 */
+		static void set_pow_strategy(pow_strategy s)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_pow_strategy = s;
+		}
+		/// Reset the series exponentiation strategy.
+		/**
+		 * Will set the exponentiation strategy to piranha::pow_strategy::automatic.
+		 *
+		 * @throws std::system_error in case of failure(s) by threading primitives.
+		 */
+		static void reset_pow_strategy()
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_pow_strategy = pow_strategy::automatic;
+		}
+		/// Get the polynomial multiplication strategy.
+		/**
+		 * The initial value is piranha::multiplication_strategy::automatic.
+		 *
+		 * @return the strategy that will be used to multiply polynomials with Kronecker monomials.
+		 *
+		 * @throws std::system_error in case of failure(s) by threading primitives.
+		 */
+		static multiplication_strategy get_multiplication_strategy()
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			return m_multiplication_strategy;
+		}
+		/// Set the polynomial multiplication strategy.
+		/**
+		 * The strategy is ignored in truncated multiplications, which always use the sparse algorithm.
+		 *
+		 * @param[in] s the strategy that will be used to multiply polynomials with Kronecker monomials.
+		 *
+		 * @throws std::system_error in case of failure(s) by threading primitives.
+		 */
+		static void set_multiplication_strategy(multiplication_strategy s)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_multiplication_strategy = s;
+		}
+		/// Reset the polynomial multiplication strategy.
+		/**
+		 * Will set the multiplication strategy to piranha::multiplication_strategy::automatic.
+		 *
+		 * @throws std::system_error in case of failure(s) by threading primitives.
+		 */
+		static void reset_multiplication_strategy()
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_multiplication_strategy = multiplication_strategy::automatic;
+		}
 };
 
 }
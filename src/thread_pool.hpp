@@ -21,16 +21,21 @@
 #ifndef PIRANHA_THREAD_POOL_HPP
 #define PIRANHA_THREAD_POOL_HPP
 
+#include <atomic>
+#include <boost/integer_traits.hpp>
 #include <condition_variable>
+#include <cstddef>
 #include <cstdlib>
+#include <deque>
+#include <exception>
 #include <functional>
 #include <future>
 #include <list>
 #include <memory>
 #include <mutex>
-#include <queue>
 #include <stdexcept>
 #include <thread>
+#include <utility>
 #include <vector>
 
 #include "config.hpp"
@@ -46,62 +51,202 @@ namespace piranha
 namespace detail
 {
 
-// Task queue class. Inspired by:
-// https://github.com/progschj/ThreadPool
-class task_queue
+// Lock-free work-stealing deque, storing pointers to T. The owner thread pushes and pops at the bottom,
+// any other thread can steal from the top. Adapted from:
+// http://www.di.ens.fr/~zappa/readings/ppopp13.pdf
+// NOTE: the storage arrays are never shrunk, and arrays replaced by a growth operation are kept alive
+// until the destruction of the deque, as thieves might still be reading from them.
+template <typename T>
+class work_stealing_deque
 {
+		using index_type = std::ptrdiff_t;
+		struct circular_array
+		{
+			explicit circular_array(index_type size):m_size(size),m_buffer(::new std::atomic<T *>[static_cast<std::size_t>(size)])
+			{
+				piranha_assert(size > 0 && !(size & (size - 1)));
+			}
+			T *get(index_type i) const
+			{
+				return m_buffer[static_cast<std::size_t>(i & (m_size - 1))].load(std::memory_order_relaxed);
+			}
+			void put(index_type i, T *x)
+			{
+				m_buffer[static_cast<std::size_t>(i & (m_size - 1))].store(x,std::memory_order_relaxed);
+			}
+			const index_type			m_size;
+			std::unique_ptr<std::atomic<T *>[]>	m_buffer;
+		};
+	public:
+		explicit work_stealing_deque(index_type initial_size = 64):m_top(0),m_bottom(0)
+		{
+			m_arrays.emplace_back(::new circular_array(initial_size));
+			m_array.store(m_arrays.back().get(),std::memory_order_relaxed);
+		}
+		work_stealing_deque(const work_stealing_deque &) = delete;
+		work_stealing_deque(work_stealing_deque &&) = delete;
+		work_stealing_deque &operator=(const work_stealing_deque &) = delete;
+		work_stealing_deque &operator=(work_stealing_deque &&) = delete;
+		// Push to the bottom. Can be called only by the owner.
+		void push(T *x)
+		{
+			const index_type b = m_bottom.load(std::memory_order_relaxed), t = m_top.load(std::memory_order_acquire);
+			circular_array *a = m_array.load(std::memory_order_relaxed);
+			if (unlikely(b - t > a->m_size - 1)) {
+				a = grow(a,t,b);
+			}
+			a->put(b,x);
+			std::atomic_thread_fence(std::memory_order_release);
+			m_bottom.store(b + 1,std::memory_order_relaxed);
+		}
+		// Pop from the bottom. Can be called only by the owner. Will return null if the deque is empty.
+		T *pop()
+		{
+			const index_type b = m_bottom.load(std::memory_order_relaxed) - 1;
+			circular_array *a = m_array.load(std::memory_order_relaxed);
+			m_bottom.store(b,std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			index_type t = m_top.load(std::memory_order_relaxed);
+			T *x = nullptr;
+			if (t <= b) {
+				x = a->get(b);
+				if (t == b) {
+					// Last element, compete with the thieves.
+					if (!m_top.compare_exchange_strong(t,t + 1,std::memory_order_seq_cst,std::memory_order_relaxed)) {
+						x = nullptr;
+					}
+					m_bottom.store(b + 1,std::memory_order_relaxed);
+				}
+			} else {
+				m_bottom.store(b + 1,std::memory_order_relaxed);
+			}
+			return x;
+		}
+		// Steal from the top. Can be called by any thread. Will return null if the deque is empty
+		// or if the race with another thief/the owner was lost.
+		T *steal()
+		{
+			index_type t = m_top.load(std::memory_order_acquire);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			const index_type b = m_bottom.load(std::memory_order_acquire);
+			if (t < b) {
+				// NOTE: consume would be enough here.
+				T *x = m_array.load(std::memory_order_acquire)->get(t);
+				if (!m_top.compare_exchange_strong(t,t + 1,std::memory_order_seq_cst,std::memory_order_relaxed)) {
+					return nullptr;
+				}
+				return x;
+			}
+			return nullptr;
+		}
+		// Approximate check for emptiness, usable from any thread.
+		bool empty() const
+		{
+			return m_bottom.load(std::memory_order_relaxed) <= m_top.load(std::memory_order_relaxed);
+		}
+	private:
+		circular_array *grow(circular_array *a, index_type t, index_type b)
+		{
+			if (unlikely(a->m_size > boost::integer_traits<index_type>::const_max / 2)) {
+				piranha_throw(std::overflow_error,"work-stealing deque size overflow");
+			}
+			std::unique_ptr<circular_array> new_a(::new circular_array(a->m_size * 2));
+			for (index_type i = t; i < b; ++i) {
+				new_a->put(i,a->get(i));
+			}
+			m_arrays.push_back(std::move(new_a));
+			circular_array *retval = m_arrays.back().get();
+			m_array.store(retval,std::memory_order_release);
+			return retval;
+		}
+	private:
+		std::atomic<index_type>				m_top;
+		std::atomic<index_type>				m_bottom;
+		std::atomic<circular_array *>			m_array;
+		std::vector<std::unique_ptr<circular_array>>	m_arrays;
+};
+
+class worker_pool;
+
+// Per-thread pointer to the worker the thread belongs to (null if the thread is not a worker).
+template <typename = int>
+struct current_worker
+{
+	static PIRANHA_TLS void *s_worker;
+};
+
+template <typename T>
+PIRANHA_TLS void *current_worker<T>::s_worker = nullptr;
+
+// Work-stealing pool of worker threads. Each worker owns:
+// - a lock-free deque for tasks generated by the worker itself,
+// - a mutex-protected queue of tasks submitted from outside the pool, which other workers can steal from,
+// - a mutex-protected queue of tasks pinned to the worker, which cannot be stolen.
+// Idle workers sleep on a condition variable when no work is available anywhere.
+class worker_pool
+{
+	public:
+		using task_type = std::function<void()>;
+	private:
+		struct worker
+		{
+			explicit worker(worker_pool *pool, unsigned idx):m_pool(pool),m_idx(idx),m_n_pinned(0u) {}
+			worker_pool				*m_pool;
+			const unsigned				m_idx;
+			work_stealing_deque<task_type>		m_deque;
+			std::mutex				m_mutex;
+			std::deque<task_type *>			m_shared;
+			std::deque<task_type *>			m_pinned;
+			std::atomic<unsigned long long>		m_n_pinned;
+			std::thread				m_thread;
+		};
 		struct runner
 		{
-			runner(task_queue *ptr, unsigned n):m_ptr(ptr),m_n(n) {}
 			void operator()() const
 			{
 				// Don't stop if we cannot bind.
 				try {
-					thread_management::bind_to_proc(m_n);
+					thread_management::bind_to_proc(m_w->m_idx);
 				} catch (...) {
 					// NOTE: logging candidate.
 				}
+				current_worker<>::s_worker = static_cast<void *>(m_w);
 				try {
-					while (true) {
-						std::unique_lock<std::mutex> lock(m_ptr->m_mutex);
-						while (!m_ptr->m_stop && m_ptr->m_tasks.empty()) {
-							// Need to wait for something to happen only if the task
-							// list is empty and we are not stopping.
-							m_ptr->m_cond.wait(lock);
-						}
-						if (m_ptr->m_stop && m_ptr->m_tasks.empty()) {
-							// If the stop flag was set, and we do not have more tasks,
-							// just exit.
-							break;
-						}
-						// NOTE: move constructor of std::function could throw, unfortunately.
-						std::function<void()> task(std::move(m_ptr->m_tasks.front()));
-						m_ptr->m_tasks.pop();
-						lock.unlock();
-						task();
-					}
+					m_w->m_pool->worker_loop(*m_w);
 				} catch (...) {
-					// The errors we could get here are:
-					// - threading primitives,
-					// - move-construction of std::function,
-					// - queue popping (I guess unlikely, as the destructor of std::function
-					//   is noexcept).
-					// In any case, not much that can be done to recover from this, better to abort.
+					// The errors we could get here are from threading primitives and memory allocation
+					// in the queues. In any case, not much that can be done to recover from this, better to abort.
 					// NOTE: logging candidate.
 					std::abort();
 				}
+				current_worker<>::s_worker = nullptr;
 				// Free the MPFR caches.
 				::mpfr_free_cache();
 			}
-			task_queue	*m_ptr;
-			const unsigned	m_n;
+			worker *m_w;
 		};
 	public:
-		task_queue(unsigned n = 0):m_stop(false)
+		explicit worker_pool(unsigned n):m_stop(false),m_pending(0u),m_queued(0),m_sleepers(0u),m_next(0u)
 		{
-			m_thread.reset(::new std::thread(runner{this,n}));
+			if (unlikely(n == 0u)) {
+				piranha_throw(std::invalid_argument,"cannot create a worker pool with zero threads");
+			}
+			m_workers.reserve(n);
+			for (unsigned i = 0u; i < n; ++i) {
+				m_workers.emplace_back(::new worker(this,i));
+			}
+			// NOTE: start the threads only after all the workers have been set up, as they
+			// will look at each other's queues.
+			try {
+				for (auto &w: m_workers) {
+					w->m_thread = std::thread(runner{w.get()});
+				}
+			} catch (...) {
+				stop();
+				throw;
+			}
 		}
-		~task_queue() noexcept
+		~worker_pool() noexcept
 		{
 			// NOTE: logging candidate (catch any exception,
 			// log it and abort as there is not much we can do).
@@ -111,81 +256,273 @@ class task_queue
 				std::abort();
 			}
 		}
+		worker_pool(const worker_pool &) = delete;
+		worker_pool(worker_pool &&) = delete;
+		worker_pool &operator=(const worker_pool &) = delete;
+		worker_pool &operator=(worker_pool &&) = delete;
+		unsigned size() const
+		{
+			return static_cast<unsigned>(m_workers.size());
+		}
+		// Wrap a callable and its arguments into a task, returning the future.
 		template <typename F, typename ... Args>
-		auto enqueue(F &&f, Args && ... args) -> std::future<decltype(f(args...))>
+		static auto package(std::unique_ptr<task_type> &task, F &&f, Args && ... args) -> std::future<decltype(f(args...))>
 		{
 			using f_ret_type = decltype(f(args...));
 			using p_task_type = std::packaged_task<f_ret_type()>;
-			auto task = std::make_shared<p_task_type>(std::bind(std::forward<F>(f),std::forward<Args>(args)...));
-			std::future<f_ret_type> res = task->get_future();
-			{
-			std::unique_lock<std::mutex> lock(m_mutex);
-			if (m_stop) {
-				// Enqueueing is not allowed if the queue is stopped.
-				piranha_throw(std::runtime_error,"cannot enqueue task while task queue is stopping");
-			}
-			m_tasks.push([task](){(*task)();});
-			}
-			// NOTE: if an exception is thrown here, the thread might not get notified.
+			auto p_task = std::make_shared<p_task_type>(std::bind(std::forward<F>(f),std::forward<Args>(args)...));
+			std::future<f_ret_type> res = p_task->get_future();
+			task.reset(::new task_type([p_task](){(*p_task)();}));
+			return res;
+		}
+		// Enqueue a task that will be consumed by the n-th worker.
+		void push_pinned(unsigned n, std::unique_ptr<task_type> &&task)
+		{
+			piranha_assert(n < m_workers.size() && task);
+			worker &w = *m_workers[n];
+			begin_push();
 			try {
-				m_cond.notify_one();
+				std::lock_guard<std::mutex> lock(w.m_mutex);
+				w.m_pinned.push_back(task.get());
+				task.release();
 			} catch (...) {
-				// NOTE: logging candidate.
-				std::abort();
+				task_done();
+				throw;
 			}
-			return res;
+			++w.m_n_pinned;
+			wake(true);
+		}
+		// Enqueue a task that can be consumed by any worker. If the calling thread is a worker of this pool,
+		// the task is pushed in the worker's lock-free deque, otherwise the task is assigned in a round-robin
+		// fashion to one of the workers' shared queues.
+		void push_any(std::unique_ptr<task_type> &&task)
+		{
+			piranha_assert(task);
+			worker *cur = static_cast<worker *>(current_worker<>::s_worker);
+			if (cur && cur->m_pool == this) {
+				// NOTE: pushing from a worker is allowed also while stopping, as the pool
+				// is drained before the workers exit.
+				++m_pending;
+				++m_queued;
+				try {
+					cur->m_deque.push(task.get());
+				} catch (...) {
+					--m_queued;
+					task_done();
+					throw;
+				}
+				task.release();
+			} else {
+				begin_push();
+				worker &w = *m_workers[static_cast<std::size_t>(m_next++ % m_workers.size())];
+				++m_queued;
+				try {
+					std::lock_guard<std::mutex> lock(w.m_mutex);
+					w.m_shared.push_back(task.get());
+					task.release();
+				} catch (...) {
+					--m_queued;
+					task_done();
+					throw;
+				}
+			}
+			wake(false);
+		}
+		// Run one task from the pool on behalf of worker w. Returns false if no task could be found.
+		bool run_one(worker &w)
+		{
+			std::unique_ptr<task_type> task(find_task(w));
+			if (!task) {
+				return false;
+			}
+			(*task)();
+			task.reset();
+			task_done();
+			return true;
 		}
+		// Run one task on behalf of the calling thread, if the calling thread is a worker of some pool.
+		// Returns false if the calling thread is not a worker or if no task could be found.
+		static bool help()
+		{
+			worker *cur = static_cast<worker *>(current_worker<>::s_worker);
+			return cur && cur->m_pool->run_one(*cur);
+		}
+		// Return true if the calling thread is a worker of any pool.
+		static bool in_worker()
+		{
+			return current_worker<>::s_worker != nullptr;
+		}
+		// Return the pool of the calling worker thread, or null.
+		static worker_pool *current_pool()
+		{
+			worker *cur = static_cast<worker *>(current_worker<>::s_worker);
+			return cur ? cur->m_pool : nullptr;
+		}
+		// Stop the pool: forbid external submissions, wait for all the pending tasks to be
+		// consumed and join the threads.
 		// NOTE: we call this only from dtor, it is here in order to be able to test it.
 		// So the exception handling in dtor will suffice, keep it in mind if things change.
 		void stop()
 		{
 			{
-			std::unique_lock<std::mutex> lock(m_mutex);
-			if (m_stop) {
-				// Already stopped.
-				return;
+				std::lock_guard<std::mutex> lock(m_sleep_mutex);
+				if (m_stop.load()) {
+					// Already stopped.
+					return;
+				}
+				m_stop.store(true);
+				m_sleep_cond.notify_all();
+			}
+			for (auto &w: m_workers) {
+				if (w->m_thread.joinable()) {
+					w->m_thread.join();
+				}
+			}
+		}
+	private:
+		// Register a new pending task coming from outside the pool, checking the stop flag.
+		// NOTE: the pending counter is increased before checking the stop flag, so that a worker
+		// will never exit while a submission is in progress.
+		void begin_push()
+		{
+			++m_pending;
+			if (unlikely(m_stop.load())) {
+				task_done();
+				piranha_throw(std::runtime_error,"cannot enqueue task while the thread pool is stopping");
+			}
+		}
+		// Signal that a task has been consumed.
+		void task_done()
+		{
+			if (m_pending.fetch_sub(1u) == 1u && m_stop.load()) {
+				// Last pending task while stopping: wake up everybody so they can exit.
+				std::lock_guard<std::mutex> lock(m_sleep_mutex);
+				m_sleep_cond.notify_all();
+			}
+		}
+		void wake(bool all)
+		{
+			if (m_sleepers.load() != 0u) {
+				std::lock_guard<std::mutex> lock(m_sleep_mutex);
+				if (all) {
+					m_sleep_cond.notify_all();
+				} else {
+					m_sleep_cond.notify_one();
+				}
+			}
+		}
+		static task_type *pop_front(std::deque<task_type *> &d)
+		{
+			if (d.empty()) {
+				return nullptr;
+			}
+			task_type *retval = d.front();
+			d.pop_front();
+			return retval;
+		}
+		task_type *find_task(worker &w)
+		{
+			task_type *retval = nullptr;
+			// Pinned tasks first.
+			if (w.m_n_pinned.load() != 0u) {
+				std::lock_guard<std::mutex> lock(w.m_mutex);
+				if ((retval = pop_front(w.m_pinned))) {
+					--w.m_n_pinned;
+					return retval;
+				}
+			}
+			// Nothing to do if there is no stealable task anywhere.
+			if (m_queued.load() <= 0) {
+				return nullptr;
+			}
+			// Own deque.
+			if ((retval = w.m_deque.pop())) {
+				--m_queued;
+				return retval;
+			}
+			// Own shared queue.
+			{
+				std::lock_guard<std::mutex> lock(w.m_mutex);
+				if ((retval = pop_front(w.m_shared))) {
+					--m_queued;
+					return retval;
+				}
 			}
-			m_stop = true;
+			// Try to steal from the other workers.
+			const auto n = m_workers.size();
+			for (decltype(m_workers.size()) i = 1u; i < n; ++i) {
+				worker &victim = *m_workers[(w.m_idx + i) % n];
+				if ((retval = victim.m_deque.steal())) {
+					--m_queued;
+					return retval;
+				}
+				std::unique_lock<std::mutex> lock(victim.m_mutex,std::try_to_lock);
+				if (lock.owns_lock() && (retval = pop_front(victim.m_shared))) {
+					--m_queued;
+					return retval;
+				}
+			}
+			return nullptr;
+		}
+		void worker_loop(worker &w)
+		{
+			while (true) {
+				if (run_one(w)) {
+					continue;
+				}
+				std::unique_lock<std::mutex> lock(m_sleep_mutex);
+				// NOTE: the sleepers counter is increased before checking for available work, and
+				// the pushing functions check the sleepers counter after having made the work visible: this guarantees
+				// that either we see the new work here, or the pusher sees us and notifies.
+				++m_sleepers;
+				if (m_stop.load() && m_pending.load() == 0u) {
+					--m_sleepers;
+					break;
+				}
+				if (m_queued.load() > 0 || w.m_n_pinned.load() != 0u) {
+					--m_sleepers;
+					continue;
+				}
+				m_sleep_cond.wait(lock);
+				--m_sleepers;
 			}
-			// Notify the thread that queue has been stopped, wait for it
-			// to consume the remaining tasks and exit.
-			m_cond.notify_one();
-			m_thread->join();
 		}
 	private:
-		bool					m_stop;
-		std::condition_variable			m_cond;
-		std::mutex				m_mutex;
-		std::queue<std::function<void()>>	m_tasks;
-		std::unique_ptr<std::thread>		m_thread;
+		std::atomic<bool>			m_stop;
+		// Number of tasks submitted but not completed yet.
+		std::atomic<unsigned long long>		m_pending;
+		// Number of stealable tasks sitting in the queues.
+		std::atomic<long long>			m_queued;
+		std::atomic<unsigned>			m_sleepers;
+		std::atomic<unsigned long long>		m_next;
+		std::mutex				m_sleep_mutex;
+		std::condition_variable			m_sleep_cond;
+		std::vector<std::unique_ptr<worker>>	m_workers;
 };
 
-static inline std::vector<std::unique_ptr<task_queue>> get_initial_thread_queues()
+inline std::shared_ptr<worker_pool> get_initial_worker_pool()
 {
-	std::vector<std::unique_ptr<task_queue>> retval;
 	const unsigned candidate = runtime_info::get_hardware_concurrency(), hc = (candidate > 0u) ? candidate : 1u;
-	retval.reserve(static_cast<decltype(retval.size())>(hc));
-	for (unsigned i = 0u; i < hc; ++i) {
-		retval.emplace_back(::new task_queue(i));
-	}
-	return retval;
+	return std::make_shared<worker_pool>(hc);
 }
 
 template <typename = int>
 struct thread_pool_base
 {
-	static std::vector<std::unique_ptr<task_queue>>	s_queues;
-	static std::mutex				s_mutex;
+	static std::shared_ptr<worker_pool>	s_pool;
+	static std::mutex			s_mutex;
 };
 
 template <typename T>
-std::vector<std::unique_ptr<task_queue>> thread_pool_base<T>::s_queues = get_initial_thread_queues();
+std::shared_ptr<worker_pool> thread_pool_base<T>::s_pool = get_initial_worker_pool();
 
 template <typename T>
 std::mutex thread_pool_base<T>::s_mutex;
 
 }
 
+class task_group;
+
 /// Static thread pool.
 /**
  * This class manages, via a set of static methods, a pool of threads created at program startup.
@@ -193,6 +530,11 @@ std::mutex thread_pool_base<T>::s_mutex;
  * and, if possible, each thread is bound to a different processor. If the hardware concurrency cannot be determined,
  * the size of the thread pool will be one.
  *
+ * The pool uses a work-stealing scheduler: each thread owns a lock-free deque of tasks, and idle threads
+ * steal tasks from the other threads. Tasks can be either pinned to a specific thread via enqueue(), or submitted
+ * to the pool as a whole via enqueue_any() and piranha::task_group. Tasks submitted from within a thread of the pool
+ * are pushed in the thread's own deque without any locking.
+ *
  * This class provides methods to enqueue arbitray tasks to the threads in the pool, query the size of the pool
  * and resize the pool. All methods, unless otherwise specified, are thread-safe, and they provide the strong
  * exception safety guarantee.
@@ -200,15 +542,33 @@ std::mutex thread_pool_base<T>::s_mutex;
 class thread_pool: private detail::thread_pool_base<>
 {
 		using base = detail::thread_pool_base<>;
+		using task_type = detail::worker_pool::task_type;
+		friend class task_group;
+		static std::shared_ptr<detail::worker_pool> get_pool()
+		{
+			std::lock_guard<std::mutex> lock(s_mutex);
+			return base::s_pool;
+		}
+		// Submit a raw task to the pool, preferring the pool of the calling worker thread.
+		static void spawn(std::unique_ptr<task_type> &&task)
+		{
+			auto cur = detail::worker_pool::current_pool();
+			if (cur) {
+				cur->push_any(std::move(task));
+			} else {
+				get_pool()->push_any(std::move(task));
+			}
+		}
 	public:
-		/// Append task
+		/// Append task to a specific thread.
 		/**
 		 * \note
 		 * This method is enabled only if the expression <tt>f(args...)</tt> is well-formed.
 		 *
 		 * This method will add a task to the <tt>n</tt>-th thread in the pool. The task is represented
 		 * by a callable \p F and its arguments \p args, which will be copied into an execution queue
-		 * consumed by the thread to which the task is assigned.
+		 * consumed by the thread to which the task is assigned. Tasks added with this method will never be stolen
+		 * by other threads.
 		 *
 		 * @param[in] n index of the thread that will consume the task.
 		 * @param[in] f callable object representing the task.
@@ -223,15 +583,44 @@ class thread_pool: private detail::thread_pool_base<>
 		 * - the constructors of \p f or \p args.
 		 */
 		template <typename F, typename ... Args>
-		static auto enqueue(unsigned n, F &&f, Args && ... args) ->
-			decltype(base::s_queues[0u]->enqueue(std::forward<F>(f),std::forward<Args>(args)...))
+		static auto enqueue(unsigned n, F &&f, Args && ... args) -> std::future<decltype(f(args...))>
 		{
-			std::lock_guard<std::mutex> lock(s_mutex);
-			using size_type = decltype(base::s_queues.size());
-			if (n >= s_queues.size()) {
+			std::unique_ptr<task_type> task;
+			auto retval = detail::worker_pool::package(task,std::forward<F>(f),std::forward<Args>(args)...);
+			auto pool = get_pool();
+			if (n >= pool->size()) {
 				piranha_throw(std::invalid_argument,"thread index is out of range");
 			}
-			return base::s_queues[static_cast<size_type>(n)]->enqueue(std::forward<F>(f),std::forward<Args>(args)...);
+			pool->push_pinned(n,std::move(task));
+			return retval;
+		}
+		/// Append task to any thread.
+		/**
+		 * \note
+		 * This method is enabled only if the expression <tt>f(args...)</tt> is well-formed.
+		 *
+		 * This method will add a task to the pool without pinning it to a specific thread. If the calling thread
+		 * belongs to the pool, the task is pushed without locking into the thread's own deque, otherwise
+		 * it is assigned to the threads in a round-robin fashion. In both cases, idle threads will steal the task
+		 * if its owner is busy.
+		 *
+		 * @param[in] f callable object representing the task.
+		 * @param[in] args arguments to \p f.
+		 *
+		 * @return an <tt>std::future</tt> that will store the result of <tt>f(args...)</tt>.
+		 *
+		 * @throws unspecified any exception thrown by:
+		 * - threading primitives,
+		 * - memory allocation errors,
+		 * - the constructors of \p f or \p args.
+		 */
+		template <typename F, typename ... Args>
+		static auto enqueue_any(F &&f, Args && ... args) -> std::future<decltype(f(args...))>
+		{
+			std::unique_ptr<task_type> task;
+			auto retval = detail::worker_pool::package(task,std::forward<F>(f),std::forward<Args>(args)...);
+			spawn(std::move(task));
+			return retval;
 		}
 		/// Size
 		/**
@@ -242,19 +631,21 @@ class thread_pool: private detail::thread_pool_base<>
 		static unsigned size()
 		{
 			std::lock_guard<std::mutex> lock(s_mutex);
-			return static_cast<unsigned>(base::s_queues.size());
+			return base::s_pool->size();
 		}
 		/// Pool resize
 		/**
 		 * This method will resize the internal pool to contain \p new_size threads.
-		 * The method will first wait for the threads to consume all the pending tasks
-		 * (while forbidding the addition of new tasks),
-		 * and it will then create a new pool of size \p new_size. The new threads will be
+		 * The method will first create a new pool of size \p new_size, which will replace the current one,
+		 * and it will then wait for the threads of the old pool to consume all their pending tasks
+		 * (while forbidding the addition of new tasks from outside the old pool). The new threads will be
 		 * bound, if possible, to the processor corresponding to their index in the pool.
 		 *
+		 * This method must not be called from a thread belonging to the pool.
+		 *
 		 * @param[in] new_size the new size of the pool.
 		 *
-		 * @throws std::invalid_argument if \p new_size is larger than an implementation-defined value or zero.
+		 * @throws std::invalid_argument if \p new_size is zero.
 		 * @throws unspecified any exception thrown by:
 		 * - threading primitives,
 		 * - memory allocation errors.
@@ -264,23 +655,145 @@ class thread_pool: private detail::thread_pool_base<>
 			if (unlikely(new_size == 0u)) {
 				piranha_throw(std::invalid_argument,"cannot resize the thread pool to zero");
 			}
-			std::lock_guard<std::mutex> lock(s_mutex);
-			using size_type = decltype(base::s_queues.size());
-			const size_type new_s = static_cast<size_type>(new_size);
-			if (unlikely(new_s != new_size)) {
-				piranha_throw(std::invalid_argument,"invalid size");
-			}
-			std::vector<std::unique_ptr<detail::task_queue>> new_queues;
-			new_queues.reserve(new_s);
-			for (size_type i = 0u; i < new_s; ++i) {
-				new_queues.emplace_back(::new detail::task_queue(static_cast<unsigned>(i)));
-			}
-			// NOTE: here the allocator is not swapped, as std::allocator won't propagate on swap.
-			// Besides, all instances of std::allocator are equal, so the operation is well-defined.
-			// http://en.cppreference.com/w/cpp/container/vector/swap
-			// If an exception gets actually thrown, no big deal.
-			new_queues.swap(base::s_queues);
+			auto new_pool = std::make_shared<detail::worker_pool>(new_size);
+			{
+				std::lock_guard<std::mutex> lock(s_mutex);
+				new_pool.swap(base::s_pool);
+			}
+			// Now new_pool holds the old pool. Other threads might be still holding a reference to it
+			// in the middle of an enqueue() call: wait for them to finish before destroying the old pool.
+			while (new_pool.use_count() != 1) {
+				std::this_thread::yield();
+			}
+			new_pool.reset();
+		}
+};
+
+/// Group of tasks with fork/join semantics.
+/**
+ * This class allows to submit an arbitrary number of tasks to piranha::thread_pool via run(), and to wait for their completion
+ * via wait(). Tasks are not pinned to any specific thread, and they can in turn create new task groups. When wait()
+ * is called from a thread of the pool, the calling thread will execute pending tasks from the pool while waiting,
+ * so that nested fork/join parallelism will not exhaust the pool.
+ *
+ * The methods of this class are thread-safe.
+ */
+class task_group
+{
+		using task_type = detail::worker_pool::task_type;
+	public:
+		/// Default constructor.
+		task_group():m_pending(0u) {}
+		/// Deleted copy constructor.
+		task_group(const task_group &) = delete;
+		/// Deleted move constructor.
+		task_group(task_group &&) = delete;
+		/// Deleted copy assignment.
+		task_group &operator=(const task_group &) = delete;
+		/// Deleted move assignment.
+		task_group &operator=(task_group &&) = delete;
+		/// Destructor.
+		/**
+		 * Will wait for the completion of all the tasks in the group. Exceptions thrown by the tasks will be ignored.
+		 */
+		~task_group() noexcept
+		{
+			try {
+				wait_impl();
+			} catch (...) {
+				// NOTE: logging candidate.
+				std::abort();
+			}
 		}
+		/// Run task.
+		/**
+		 * \note
+		 * This method is enabled only if the expression <tt>f(args...)</tt> is well-formed.
+		 *
+		 * Will submit <tt>f(args...)</tt> for execution in the thread pool. The return value of the call is discarded,
+		 * and the first exception thrown by the tasks of the group will be re-thrown by wait().
+		 *
+		 * @param[in] f callable object representing the task.
+		 * @param[in] args arguments to \p f.
+		 *
+		 * @throws unspecified any exception thrown by:
+		 * - threading primitives,
+		 * - memory allocation errors,
+		 * - the copy constructors of \p f or \p args.
+		 */
+		template <typename F, typename ... Args>
+		auto run(F &&f, Args && ... args) -> decltype(f(args...),void())
+		{
+			auto func = std::bind(std::forward<F>(f),std::forward<Args>(args)...);
+			std::unique_ptr<task_type> task(::new task_type([this,func]() mutable {
+				try {
+					func();
+				} catch (...) {
+					std::lock_guard<std::mutex> lock(m_mutex);
+					if (!m_exception) {
+						m_exception = std::current_exception();
+					}
+				}
+				// NOTE: the decrement must happen while holding the lock, as the waiting thread
+				// will destroy the group as soon as it can acquire the lock with a null counter.
+				std::lock_guard<std::mutex> lock(m_mutex);
+				piranha_assert(m_pending.load() > 0u);
+				if (--m_pending == 0u) {
+					m_cond.notify_all();
+				}
+			}));
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				++m_pending;
+			}
+			try {
+				thread_pool::spawn(std::move(task));
+			} catch (...) {
+				std::lock_guard<std::mutex> lock(m_mutex);
+				--m_pending;
+				throw;
+			}
+		}
+		/// Wait for the completion of the tasks.
+		/**
+		 * This method will block until all the tasks submitted via run() have been completed. If any
+		 * task threw an exception, the first exception will be re-thrown and then discarded.
+		 *
+		 * @throws unspecified any exception thrown by threading primitives or by the tasks of the group.
+		 */
+		void wait()
+		{
+			wait_impl();
+			std::exception_ptr exc;
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				std::swap(exc,m_exception);
+			}
+			if (exc) {
+				std::rethrow_exception(exc);
+			}
+		}
+	private:
+		void wait_impl()
+		{
+			// If we are in a worker thread, help executing tasks.
+			if (detail::worker_pool::in_worker()) {
+				while (m_pending.load() != 0u) {
+					if (!detail::worker_pool::help()) {
+						std::this_thread::yield();
+					}
+				}
+			}
+			std::unique_lock<std::mutex> lock(m_mutex);
+			while (m_pending.load() != 0u) {
+				m_cond.wait(lock);
+			}
+		}
+	private:
+		std::atomic<unsigned long long>	m_pending;
+		std::mutex			m_mutex;
+		std::condition_variable		m_cond;
+		std::exception_ptr		m_exception;
 };
 
 /// Class to store a list of futures.
@@ -137,6 +137,42 @@ class trigonometric_series: public Series
 			PIRANHA_DECLARE_KEY_GETTER(t_lorder)
 			#undef PIRANHA_DECLARE_KEY_GETTER
 		};
+		// The total trigonometric degree and order can be read from the cached key metadata if only the key
+		// has them and the metadata records their distributions.
+		template <typename T, typename ... Args>
+		struct cached_enabler
+		{
+			static const bool value = sizeof...(Args) == 0u && key_trig_score<typename T::term_type::key_type>::value == 4 &&
+				T::key_metadata_type::has_t_degree;
+		};
+		// N is 0 for t_degree, 1 for t_ldegree, 2 for t_order, 3 for t_lorder.
+		template <int N, typename R>
+		bool cached_property(R &, std::false_type) const
+		{
+			return false;
+		}
+		template <int N, typename R>
+		bool cached_property(R &retval, std::true_type) const
+		{
+			const auto md = this->cached_key_metadata();
+			if (md && md->complete()) {
+				switch (N) {
+					case 0:
+						retval = md->t_degree();
+						break;
+					case 1:
+						retval = md->t_ldegree();
+						break;
+					case 2:
+						retval = md->t_order();
+						break;
+					default:
+						retval = md->t_lorder();
+				}
+				return true;
+			}
+			return false;
+		}
 	public:
 		/// Defaulted default constructor.
 		trigonometric_series() = default;
@@ -162,7 +198,8 @@ class trigonometric_series: public Series
 		 *
 		 * This method can compute both the total and the partial trigonometric degree (the former is computed when the
 		 * variadic pack is empty, the latter when an <tt>std::set<std::string></tt> is passed as the only argument - in
-		 * all other cases, the method will be disabled).
+		 * all other cases, the method will be disabled). If only the key type has the property, the total value is
+		 * read from the cached key metadata of the series, when available.
 		 *
 		 * @param[in] args variadic argument pack.
 		 * 
@@ -173,6 +210,11 @@ class trigonometric_series: public Series
 		template <typename ... Args, typename T = Series>
 		auto t_degree(const Args & ... args) const -> decltype(t_get<typename T::term_type>::t_degree(std::declval<typename T::term_type>(),std::declval<symbol_set>(),args...))
 		{
+			typedef decltype(t_get<typename T::term_type>::t_degree(std::declval<typename T::term_type>(),std::declval<symbol_set>(),args...)) return_type;
+			return_type retval(0);
+			if (cached_property<0>(retval,std::integral_constant<bool,cached_enabler<T,Args...>::value>())) {
+				return retval;
+			}
 			// NOTE: according to the documentation, the placeholder will generate a binder in which the corresponding argument will be forwarded
 			// perfectly to the underlying function - so there should be no risk of useless copying.
 			// http://en.cppreference.com/w/cpp/utility/functional/bind
@@ -186,7 +228,8 @@ class trigonometric_series: public Series
 		 *
 		 * This method can compute both the total and the partial trigonometric low degree (the former is computed when the
 		 * variadic pack is empty, the latter when an <tt>std::set<std::string></tt> is passed as the only argument - in
-		 * all other cases, the method will be disabled).
+		 * all other cases, the method will be disabled). If only the key type has the property, the total value is
+		 * read from the cached key metadata of the series, when available.
 		 *
 		 * @param[in] args variadic argument pack.
 		 *
@@ -197,6 +240,11 @@ class trigonometric_series: public Series
 		template <typename ... Args, typename T = Series>
 		auto t_ldegree(const Args & ... args) const -> decltype(t_get<typename T::term_type>::t_ldegree(std::declval<typename T::term_type>(),std::declval<symbol_set>(),args...))
 		{
+			typedef decltype(t_get<typename T::term_type>::t_ldegree(std::declval<typename T::term_type>(),std::declval<symbol_set>(),args...)) return_type;
+			return_type retval(0);
+			if (cached_property<1>(retval,std::integral_constant<bool,cached_enabler<T,Args...>::value>())) {
+				return retval;
+			}
 			auto g = std::bind(t_get<typename Series::term_type>::template t_ldegree<Args...>,std::placeholders::_1,std::cref(this->m_symbol_set),std::cref(args)...);
 			return detail::generic_series_degree<1>(this->m_container,g);
 		}
@@ -207,7 +255,8 @@ class trigonometric_series: public Series
 		 *
 		 * This method can compute both the total and the partial trigonometric order (the former is computed when the
 		 * variadic pack is empty, the latter when an <tt>std::set<std::string></tt> is passed as the only argument - in
-		 * all other cases, the method will be disabled).
+		 * all other cases, the method will be disabled). If only the key type has the property, the total value is
+		 * read from the cached key metadata of the series, when available.
 		 *
 		 * @param[in] args variadic argument pack.
 		 *
@@ -218,6 +267,11 @@ class trigonometric_series: public Series
 		template <typename ... Args, typename T = Series>
 		auto t_order(const Args & ... args) const -> decltype(t_get<typename T::term_type>::t_order(std::declval<typename T::term_type>(),std::declval<symbol_set>(),args...))
 		{
+			typedef decltype(t_get<typename T::term_type>::t_order(std::declval<typename T::term_type>(),std::declval<symbol_set>(),args...)) return_type;
+			return_type retval(0);
+			if (cached_property<2>(retval,std::integral_constant<bool,cached_enabler<T,Args...>::value>())) {
+				return retval;
+			}
 			auto g = std::bind(t_get<typename Series::term_type>::template t_order<Args...>,std::placeholders::_1,std::cref(this->m_symbol_set),std::cref(args)...);
 			return detail::generic_series_degree<0>(this->m_container,g);
 		}
@@ -228,7 +282,8 @@ class trigonometric_series: public Series
 		 *
 		 * This method can compute both the total and the partial trigonometric low order (the former is computed when the
 		 * variadic pack is empty, the latter when an <tt>std::set<std::string></tt> is passed as the only argument - in
-		 * all other cases, the method will be disabled).
+		 * all other cases, the method will be disabled). If only the key type has the property, the total value is
+		 * read from the cached key metadata of the series, when available.
 		 *
 		 * @param[in] args variadic argument pack.
 		 *
@@ -239,6 +294,11 @@ class trigonometric_series: public Series
 		template <typename ... Args, typename T = Series>
 		auto t_lorder(const Args & ... args) const -> decltype(t_get<typename T::term_type>::t_lorder(std::declval<typename T::term_type>(),std::declval<symbol_set>(),args...))
 		{
+			typedef decltype(t_get<typename T::term_type>::t_lorder(std::declval<typename T::term_type>(),std::declval<symbol_set>(),args...)) return_type;
+			return_type retval(0);
+			if (cached_property<3>(retval,std::integral_constant<bool,cached_enabler<T,Args...>::value>())) {
+				return retval;
+			}
 			auto g = std::bind(t_get<typename Series::term_type>::template t_lorder<Args...>,std::placeholders::_1,std::cref(this->m_symbol_set),std::cref(args)...);
 			return detail::generic_series_degree<1>(this->m_container,g);
 		}
@@ -0,0 +1,171 @@
+/***************************************************************************
+ *   Copyright (C) 2009-2011 by Francesco Biscani                          *
+ *   bluescarni@gmail.com                                                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include "../src/degree_truncation.hpp"
+
+#define BOOST_TEST_MODULE degree_truncation_test
+#include <boost/test/unit_test.hpp>
+
+#include <boost/mpl/for_each.hpp>
+#include <boost/mpl/vector.hpp>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "../src/environment.hpp"
+#include "../src/integer.hpp"
+#include "../src/kronecker_monomial.hpp"
+#include "../src/polynomial.hpp"
+#include "../src/settings.hpp"
+
+using namespace piranha;
+
+typedef boost::mpl::vector<polynomial<integer,int>,polynomial<integer,kronecker_monomial<>>> p_types;
+
+BOOST_AUTO_TEST_CASE(degree_truncation_policy_test)
+{
+	environment env;
+	degree_truncation t0;
+	BOOST_CHECK_EQUAL(t0.get_mode(),0);
+	BOOST_CHECK_EQUAL(t0.get_max_degree(),0);
+	BOOST_CHECK(t0.get_names().empty());
+	degree_truncation t1(integer(5));
+	BOOST_CHECK_EQUAL(t1.get_mode(),1);
+	BOOST_CHECK_EQUAL(t1.get_max_degree(),5);
+	degree_truncation t2(integer(-3),{"x","y"});
+	BOOST_CHECK_EQUAL(t2.get_mode(),2);
+	BOOST_CHECK_EQUAL(t2.get_max_degree(),-3);
+	BOOST_CHECK((t2.get_names() == std::set<std::string>{"x","y"}));
+	degree_truncation t3(t2);
+	BOOST_CHECK_EQUAL(t3.get_mode(),2);
+	BOOST_CHECK(t3.get_names() == t2.get_names());
+	degree_truncation t4(std::move(t3));
+	BOOST_CHECK_EQUAL(t4.get_mode(),2);
+	BOOST_CHECK_EQUAL(t3.get_mode(),0);
+	t4 = t1;
+	BOOST_CHECK_EQUAL(t4.get_mode(),1);
+	BOOST_CHECK(t4.get_names().empty());
+	// Global policy.
+	BOOST_CHECK_EQUAL(degree_truncation::get().get_mode(),0);
+	degree_truncation::set(t2);
+	BOOST_CHECK_EQUAL(degree_truncation::get().get_mode(),2);
+	BOOST_CHECK_EQUAL(degree_truncation::get().get_max_degree(),-3);
+	{
+		degree_truncation_guard g(t1);
+		BOOST_CHECK_EQUAL(degree_truncation::get().get_mode(),1);
+		BOOST_CHECK_EQUAL(degree_truncation::get().get_max_degree(),5);
+	}
+	BOOST_CHECK_EQUAL(degree_truncation::get().get_mode(),2);
+	degree_truncation::unset();
+	BOOST_CHECK_EQUAL(degree_truncation::get().get_mode(),0);
+	// Per-call policy is consumed once.
+	degree_truncation::_set_override(&t1);
+	BOOST_CHECK_EQUAL(degree_truncation::_consume().get_mode(),1);
+	BOOST_CHECK_EQUAL(degree_truncation::_consume().get_mode(),0);
+}
+
+// Compute the truncated product of two series given as lists of homogeneous components, via untruncated multiplications.
+template <typename P>
+static P homogeneous_product(const std::vector<P> &f, const std::vector<P> &g, int max_degree)
+{
+	P retval;
+	for (int i = 0; i < static_cast<int>(f.size()); ++i) {
+		for (int j = 0; j < static_cast<int>(g.size()); ++j) {
+			if (i + j <= max_degree) {
+				retval += f[static_cast<unsigned>(i)] * g[static_cast<unsigned>(j)];
+			}
+		}
+	}
+	return retval;
+}
+
+struct truncated_multiplication_tester
+{
+	template <typename P>
+	void operator()(const P &)
+	{
+		settings::set_n_threads(1u);
+		P x("x"), y("y"), z("z"), t("t");
+		// Homogeneous components in total degree.
+		std::vector<P> f, g;
+		for (int k = 0; k <= 10; ++k) {
+			f.push_back((k + 1) * (x + y + z + t).pow(k));
+		}
+		for (int k = 0; k <= 6; ++k) {
+			g.push_back((k + 2) * (x + y - z + t).pow(k) * (x * y.pow(-1) + 1));
+		}
+		P ff, gg;
+		for (const auto &p: f) {
+			ff += p;
+		}
+		for (const auto &p: g) {
+			gg += p;
+		}
+		const auto full = ff * gg;
+		// Homogeneous components in the partial degree with respect to x and y.
+		std::vector<P> fp, gp;
+		for (int k = 0; k <= 5; ++k) {
+			fp.push_back((k + 1) * (x + y).pow(k) * (1 + z + t).pow(3));
+		}
+		for (int k = 0; k <= 4; ++k) {
+			gp.push_back((k + 1) * (x - y).pow(k) * (z + t.pow(-1) + 2).pow(2));
+		}
+		P ffp, ggp;
+		for (const auto &p: fp) {
+			ffp += p;
+		}
+		for (const auto &p: gp) {
+			ggp += p;
+		}
+		const std::set<std::string> names{"x","y"};
+		for (unsigned n = 1u; n <= 4u; ++n) {
+			settings::set_n_threads(n);
+			for (int d : {-1,0,3,9,16,17}) {
+				const auto expected = homogeneous_product(f,g,d);
+				BOOST_CHECK(P::truncated_multiplication(ff,gg,integer(d)) == expected);
+				BOOST_CHECK(P::truncated_multiplication(gg,ff,integer(d)) == expected);
+				// Squaring.
+				BOOST_CHECK(P::truncated_multiplication(ff,ff,integer(d)) == homogeneous_product(f,f,d));
+				// The per-call policy affects only one multiplication.
+				BOOST_CHECK(ff * gg == full);
+				// Global policy.
+				{
+					degree_truncation_guard guard{degree_truncation(integer(d))};
+					BOOST_CHECK(ff * gg == expected);
+				}
+				BOOST_CHECK(ff * gg == full);
+			}
+			for (int d : {-1,0,2,9}) {
+				const auto expected = homogeneous_product(fp,gp,d);
+				BOOST_CHECK(P::truncated_multiplication(ffp,ggp,integer(d),names) == expected);
+				BOOST_CHECK(P::truncated_multiplication(ggp,ffp,integer(d),names) == expected);
+				degree_truncation_guard guard(degree_truncation(integer(d),names));
+				BOOST_CHECK(ffp * ggp == expected);
+				BOOST_CHECK(ffp * ffp == homogeneous_product(fp,fp,d));
+			}
+		}
+		settings::reset_n_threads();
+	}
+};
+
+BOOST_AUTO_TEST_CASE(degree_truncation_multiplication_test)
+{
+	boost::mpl::for_each<p_types>(truncated_multiplication_tester());
+}
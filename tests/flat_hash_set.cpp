@@ -0,0 +1,279 @@
+/***************************************************************************
+ *   Copyright (C) 2009-2011 by Francesco Biscani                          *
+ *   bluescarni@gmail.com                                                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include "../src/flat_hash_set.hpp"
+
+#define BOOST_TEST_MODULE flat_hash_set_test
+#include <boost/test/unit_test.hpp>
+
+#include <boost/lexical_cast.hpp>
+#include <boost/mpl/for_each.hpp>
+#include <boost/mpl/vector.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "../src/environment.hpp"
+#include "../src/exceptions.hpp"
+#include "../src/integer.hpp"
+#include "../src/kronecker_monomial.hpp"
+#include "../src/polynomial.hpp"
+#include "../src/settings.hpp"
+
+using namespace piranha;
+
+// Select the flat table as container for the terms of polynomials with default Kronecker monomials.
+namespace piranha
+{
+template <typename Cf>
+struct series_container<polynomial_term<Cf,kronecker_monomial<>>>
+{
+	typedef flat_hash_set<polynomial_term<Cf,kronecker_monomial<>>,detail::term_hasher<polynomial_term<Cf,kronecker_monomial<>>>> type;
+};
+}
+
+// Hasher with lots of collisions, so that the buckets need overflow groups and the hash bytes are all equal.
+struct bad_hasher
+{
+	std::size_t operator()(const integer &n) const noexcept(true)
+	{
+		return static_cast<std::size_t>(n % 3);
+	}
+};
+
+typedef boost::mpl::vector<std::hash<integer>,bad_hasher> hasher_types;
+
+const int N = 2000;
+
+struct basic_tester
+{
+	template <typename H>
+	void operator()(const H &)
+	{
+		typedef flat_hash_set<integer,H> set_type;
+		set_type h;
+		BOOST_CHECK(h.empty());
+		BOOST_CHECK_EQUAL(h.bucket_count(),0u);
+		BOOST_CHECK(h.begin() == h.end());
+		BOOST_CHECK(h.find(integer(1)) == h.end());
+		BOOST_CHECK_THROW(h.bucket(integer(1)),zero_division_error);
+		for (int i = 0; i < N; ++i) {
+			const auto r = h.insert(integer(i));
+			BOOST_CHECK(r.second);
+			BOOST_CHECK_EQUAL(*r.first,i);
+		}
+		BOOST_CHECK_EQUAL(h.size(),unsigned(N));
+		BOOST_CHECK(h.load_factor() <= h.max_load_factor());
+		for (int i = 0; i < N; ++i) {
+			const auto r = h.insert(integer(i));
+			BOOST_CHECK(!r.second);
+			BOOST_CHECK_EQUAL(*r.first,i);
+			BOOST_CHECK(h.find(integer(i)) != h.end());
+			BOOST_CHECK_EQUAL(*h.find(integer(i)),i);
+		}
+		BOOST_CHECK(h.find(integer(N)) == h.end());
+		// Iteration visits all the elements exactly once.
+		std::set<integer> s(h.begin(),h.end());
+		BOOST_CHECK_EQUAL(s.size(),unsigned(N));
+		BOOST_CHECK_EQUAL(*s.begin(),0);
+		BOOST_CHECK_EQUAL(*s.rbegin(),N - 1);
+		// Copy, move and assignment.
+		set_type h2(h);
+		BOOST_CHECK_EQUAL(h2.size(),unsigned(N));
+		BOOST_CHECK(std::set<integer>(h2.begin(),h2.end()) == s);
+		BOOST_CHECK(h2._stamp() != h._stamp());
+		const auto stamp = h2._stamp();
+		set_type h3(std::move(h2));
+		BOOST_CHECK(h3._stamp() == stamp);
+		BOOST_CHECK(h2.empty());
+		BOOST_CHECK_EQUAL(h2.bucket_count(),0u);
+		h2 = h3;
+		BOOST_CHECK(std::set<integer>(h2.begin(),h2.end()) == s);
+		h3 = std::move(h2);
+		BOOST_CHECK(std::set<integer>(h3.begin(),h3.end()) == s);
+		set_type h4(s.begin(),s.end(),10u);
+		BOOST_CHECK(std::set<integer>(h4.begin(),h4.end()) == s);
+		set_type h5({integer(1),integer(2),integer(3),integer(1)});
+		BOOST_CHECK_EQUAL(h5.size(),3u);
+		h5.swap(h4);
+		BOOST_CHECK_EQUAL(h4.size(),3u);
+		BOOST_CHECK_EQUAL(h5.size(),unsigned(N));
+		// Erase half of the elements.
+		for (auto it = h.begin(); it != h.end();) {
+			if (*it % 2 == 0) {
+				it = h.erase(it);
+			} else {
+				++it;
+			}
+		}
+		BOOST_CHECK_EQUAL(h.size(),unsigned(N / 2));
+		for (int i = 0; i < N; ++i) {
+			BOOST_CHECK_EQUAL(h.find(integer(i)) != h.end(),i % 2 == 1);
+		}
+		// Rehash.
+		const auto stamp2 = h._stamp();
+		h.rehash(h.bucket_count() * 4u);
+		BOOST_CHECK(h._stamp() == stamp2);
+		BOOST_CHECK_EQUAL(h.size(),unsigned(N / 2));
+		for (int i = 0; i < N; ++i) {
+			BOOST_CHECK_EQUAL(h.find(integer(i)) != h.end(),i % 2 == 1);
+		}
+		// No rehash if the load factor would be exceeded.
+		const auto b_count = h.bucket_count();
+		h.rehash(1u);
+		BOOST_CHECK_EQUAL(h.bucket_count(),b_count);
+		// Sparsity.
+		std::size_t n_occupied, n_max;
+		std::tie(n_occupied,n_max) = h.evaluate_sparsity();
+		BOOST_CHECK(n_occupied > 0u);
+		BOOST_CHECK(n_max > 0u);
+		// Erase everything.
+		for (auto it = h.begin(); it != h.end();) {
+			it = h.erase(it);
+		}
+		BOOST_CHECK(h.empty());
+		BOOST_CHECK(h.begin() == h.end());
+		BOOST_CHECK_EQUAL(std::get<0u>(h.evaluate_sparsity()),0u);
+		h.clear();
+		BOOST_CHECK_EQUAL(h.bucket_count(),0u);
+		h.rehash(0u);
+		BOOST_CHECK_EQUAL(h.bucket_count(),0u);
+	}
+};
+
+BOOST_AUTO_TEST_CASE(flat_hash_set_basic_test)
+{
+	environment env;
+	boost::mpl::for_each<hasher_types>(basic_tester());
+}
+
+struct low_level_tester
+{
+	template <typename H>
+	void operator()(const H &)
+	{
+		typedef flat_hash_set<integer,H> set_type;
+		set_type h(512u);
+		BOOST_CHECK_EQUAL(h.bucket_count(),512u);
+		for (int i = 0; i < N; ++i) {
+			const auto idx = h._bucket(integer(i));
+			BOOST_CHECK(h._find(integer(i),idx) == h.end());
+			h._unique_insert(integer(i),idx);
+			BOOST_CHECK(h._find(integer(i),idx) != h.end());
+		}
+		// The size is not updated by the low-level methods.
+		BOOST_CHECK_EQUAL(h.size(),0u);
+		const auto stamp = h._stamp();
+		h._update_size(unsigned(N));
+		BOOST_CHECK(h._stamp() != stamp);
+		BOOST_CHECK_EQUAL(h.size(),unsigned(N));
+		// Iterate over the buckets.
+		std::size_t count = 0u;
+		for (std::size_t i = 0u; i < h.bucket_count(); ++i) {
+			const auto &b = h._get_bucket_list(i);
+			for (auto it = b.begin(); it != b.end(); ++it) {
+				BOOST_CHECK_EQUAL(h._bucket(*it),i);
+				++count;
+			}
+			h._prefetch_bucket(i);
+		}
+		BOOST_CHECK_EQUAL(count,unsigned(N));
+		// Erase via the low-level method, bucket by bucket.
+		for (std::size_t i = 0u; i < h.bucket_count(); ++i) {
+			std::vector<integer> to_erase;
+			const auto &b = h._get_bucket_list(i);
+			for (auto it = b.begin(); it != b.end(); ++it) {
+				if (*it % 3 != 0) {
+					to_erase.push_back(*it);
+				}
+			}
+			for (const auto &n: to_erase) {
+				h._erase(h._find(n,i));
+			}
+		}
+		h._update_size(unsigned(N / 3 + 1));
+		for (int i = 0; i < N; ++i) {
+			BOOST_CHECK_EQUAL(h.find(integer(i)) != h.end(),i % 3 == 0);
+		}
+		// Mutable iterators.
+		std::size_t n_m = 0u;
+		for (auto it = h._m_begin(); it != h._m_end(); ++it, ++n_m) {}
+		BOOST_CHECK_EQUAL(n_m,h.size());
+		h._increase_size();
+		BOOST_CHECK_EQUAL(h.bucket_count(),1024u);
+		BOOST_CHECK_EQUAL(h.size(),unsigned(N / 3 + 1));
+	}
+};
+
+BOOST_AUTO_TEST_CASE(flat_hash_set_low_level_test)
+{
+	boost::mpl::for_each<hasher_types>(low_level_tester());
+}
+
+struct series_tester
+{
+	template <typename Cf>
+	void operator()(const Cf &)
+	{
+		typedef polynomial<Cf,kronecker_monomial<>> p_type;
+		typedef polynomial<Cf,kronecker_monomial<std::int_least32_t>> p_type_ref;
+		p_type x("x"), y("y"), z("z"), t("t");
+		p_type_ref xr("x"), yr("y"), zr("z"), tr("t");
+		const auto f = (x + y + z + t + 1).pow(6), g = (x - y + z - t + 1).pow(6);
+		const auto f_s = (x + y.pow(3) - z.pow(5) + t.pow(7) + 1).pow(3);
+		const auto fr = (xr + yr + zr + tr + 1).pow(6), gr = (xr - yr + zr - tr + 1).pow(6);
+		const auto f_sr = (xr + yr.pow(3) - zr.pow(5) + tr.pow(7) + 1).pow(3);
+		BOOST_CHECK(p_type(fr) == f);
+		BOOST_CHECK(p_type(f_sr) == f_s);
+		const std::vector<std::pair<p_type,p_type>> operands = {{f,g},{f,f},{f_s,g},{f_s,f_s},{x,p_type{}},{x + 1,x - 1}};
+		const std::vector<p_type_ref> results = {fr * gr,fr * fr,f_sr * gr,f_sr * f_sr,p_type_ref{},xr * xr - 1};
+		for (auto s: {multiplication_strategy::automatic,multiplication_strategy::sparse,multiplication_strategy::dense,
+			multiplication_strategy::heap,multiplication_strategy::sort_reduce})
+		{
+			settings::set_multiplication_strategy(s);
+			for (unsigned n: {1u,2u,3u}) {
+				settings::set_n_threads(n);
+				for (decltype(operands.size()) i = 0u; i < operands.size(); ++i) {
+					BOOST_CHECK(operands[i].first * operands[i].second == p_type(results[i]));
+				}
+			}
+		}
+		settings::reset_multiplication_strategy();
+		settings::reset_n_threads();
+		// Insertion and erasure through the series interface.
+		auto h = f;
+		h -= f;
+		BOOST_CHECK(h.empty());
+		h = f + g;
+		BOOST_CHECK(h == p_type(fr + gr));
+		BOOST_CHECK_EQUAL(f.degree(),6);
+	}
+};
+
+BOOST_AUTO_TEST_CASE(flat_hash_set_series_test)
+{
+	boost::mpl::for_each<boost::mpl::vector<double,integer>>(series_tester());
+}
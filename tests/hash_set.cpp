@@ -564,3 +564,62 @@ BOOST_AUTO_TEST_CASE(hash_set_type_traits_test)
 {
 	boost::mpl::for_each<key_types>(type_traits_tester());
 }
+
+struct stamp_tester
+{
+	template <typename T>
+	void operator()(const T &)
+	{
+		hash_set<T> h;
+		auto s = h._stamp();
+		BOOST_CHECK(s.first != 0u);
+		// Insertion of a new element changes the stamp, insertion of an existing one does not.
+		h.insert(boost::lexical_cast<T>(1));
+		BOOST_CHECK(h._stamp() != s);
+		s = h._stamp();
+		h.insert(boost::lexical_cast<T>(1));
+		BOOST_CHECK(h._stamp() == s);
+		// Rehash preserves the stamp.
+		h.rehash(1000u);
+		BOOST_CHECK(h._stamp() == s);
+		// Copies get a new stamp, moves transfer it.
+		hash_set<T> h2(h);
+		BOOST_CHECK(h2._stamp() != s);
+		BOOST_CHECK(h2._stamp().first != s.first);
+		hash_set<T> h3(std::move(h2));
+		BOOST_CHECK(h3._stamp() != s);
+		BOOST_CHECK(h2._stamp() != h3._stamp());
+		const auto s3 = h3._stamp();
+		h3 = std::move(h);
+		BOOST_CHECK(h3._stamp() == s);
+		BOOST_CHECK(h._stamp() != s);
+		BOOST_CHECK(h._stamp() != s3);
+		// Swap.
+		hash_set<T> h4;
+		const auto s4 = h4._stamp();
+		h4.swap(h3);
+		BOOST_CHECK(h4._stamp() == s);
+		BOOST_CHECK(h3._stamp() == s4);
+		// Erase, clear and _update_size().
+		h4.erase(h4.find(boost::lexical_cast<T>(1)));
+		BOOST_CHECK(h4._stamp() != s);
+		s = h4._stamp();
+		h4.clear();
+		BOOST_CHECK(h4._stamp() != s);
+		s = h4._stamp();
+		h4._update_size(0u);
+		BOOST_CHECK(h4._stamp() != s);
+		// _unique_insert() does not change the stamp.
+		h4.rehash(10u);
+		s = h4._stamp();
+		h4._unique_insert(boost::lexical_cast<T>(2),h4._bucket(boost::lexical_cast<T>(2)));
+		BOOST_CHECK(h4._stamp() == s);
+		h4._update_size(1u);
+		BOOST_CHECK(h4._stamp() != s);
+	}
+};
+
+BOOST_AUTO_TEST_CASE(hash_set_stamp_test)
+{
+	boost::mpl::for_each<key_types>(stamp_tester());
+}
@@ -819,6 +819,86 @@ BOOST_AUTO_TEST_CASE(integer_allocated_size_test)
 	BOOST_CHECK(k.allocated_size() == 100u);
 }
 
+BOOST_AUTO_TEST_CASE(integer_small_value_test)
+{
+	using piranha::integer;
+	// Values fitting in a single limb are stored inline.
+	const integer max(std::numeric_limits<unsigned long>::max());
+	BOOST_CHECK_EQUAL(integer().allocated_size(),0u);
+	BOOST_CHECK_EQUAL(integer(-42).allocated_size(),0u);
+	BOOST_CHECK_EQUAL(max.allocated_size(),0u);
+	BOOST_CHECK_EQUAL(integer(std::numeric_limits<long>::min()),-integer(std::numeric_limits<long>::max()) - 1);
+	// Overflow from inline storage.
+	const integer max_p1 = max + 1;
+	BOOST_CHECK(max_p1.allocated_size() > 0u);
+	BOOST_CHECK_EQUAL(max_p1,integer(boost::lexical_cast<std::string>(max) + "0") / 10 + 1);
+	BOOST_CHECK_EQUAL(max_p1 - 1,max);
+	BOOST_CHECK_EQUAL(-max - 1,-max_p1);
+	BOOST_CHECK_EQUAL(max * max,max_p1 * max_p1 - 2 * max_p1 + 1);
+	integer tmp(max);
+	tmp += 1;
+	BOOST_CHECK_EQUAL(tmp,max_p1);
+	tmp = -max;
+	tmp -= 1u;
+	BOOST_CHECK_EQUAL(tmp,-max_p1);
+	tmp = max;
+	tmp *= max;
+	BOOST_CHECK_EQUAL(tmp,max * max);
+	// Results fitting in a limb go back to inline storage.
+	tmp /= max;
+	BOOST_CHECK_EQUAL(tmp,max);
+	BOOST_CHECK_EQUAL(tmp.allocated_size(),0u);
+	tmp = max_p1;
+	tmp %= max;
+	BOOST_CHECK_EQUAL(tmp,1);
+	BOOST_CHECK_EQUAL(integer(max_p1).allocated_size(),max_p1.allocated_size());
+	const integer max_p1_m1 = max_p1 - 1;
+	BOOST_CHECK(max_p1_m1.allocated_size() > 0u);
+	BOOST_CHECK_EQUAL(integer(max_p1_m1).allocated_size(),0u);
+	// Division and modulo on inline values.
+	BOOST_CHECK_EQUAL(integer(-7) / integer(2),-3);
+	BOOST_CHECK_EQUAL(integer(7) / integer(-2),-3);
+	BOOST_CHECK_EQUAL(integer(1) / integer(-2),0);
+	BOOST_CHECK_EQUAL(integer(7) % integer(3),1);
+	BOOST_CHECK_EQUAL(integer(6) % integer(3),0);
+	BOOST_CHECK_EQUAL(max % integer(2),1);
+	// Comparisons across representations.
+	BOOST_CHECK(max < max_p1);
+	BOOST_CHECK(-max_p1 < -max);
+	BOOST_CHECK(integer(-1) < integer(0));
+	BOOST_CHECK(integer(-2) < integer(-1));
+	BOOST_CHECK(max_p1 - 1 == max);
+	BOOST_CHECK(max_p1 - 1 <= max);
+	// Multiply-accumulate across representations.
+	integer acc;
+	acc.multiply_accumulate(max,max);
+	BOOST_CHECK_EQUAL(acc,max * max);
+	acc.multiply_accumulate(-max,max);
+	BOOST_CHECK_EQUAL(acc,0);
+	acc = 5;
+	acc.multiply_accumulate(integer(-3),integer(2));
+	BOOST_CHECK_EQUAL(acc,-1);
+	acc.multiply_accumulate(integer(1),max);
+	BOOST_CHECK_EQUAL(acc,max - 1);
+	acc.multiply_accumulate(integer(1),integer(2));
+	BOOST_CHECK_EQUAL(acc,max_p1);
+	// The hash does not depend on the representation.
+	const integer big_one = (max_p1 * max_p1) / (max_p1 * max_p1);
+	BOOST_CHECK_EQUAL(big_one,1);
+	BOOST_CHECK_EQUAL((max_p1 - 1).hash(),max.hash());
+	BOOST_CHECK_EQUAL((max_p1 - max_p1).hash(),integer().hash());
+	BOOST_CHECK_EQUAL((max_p1 - max_p1 - 1).hash(),integer(-1).hash());
+	// Moved-from objects are zero.
+	integer a(42), b(max_p1);
+	integer c(std::move(a)), d(std::move(b));
+	BOOST_CHECK_EQUAL(a,0);
+	BOOST_CHECK_EQUAL(b,0);
+	BOOST_CHECK_EQUAL(c,42);
+	BOOST_CHECK_EQUAL(d,max_p1);
+	a += 1;
+	BOOST_CHECK_EQUAL(a,1);
+}
+
 BOOST_AUTO_TEST_CASE(integer_sqrt_test)
 {
 	piranha::integer n(0);
@@ -114,6 +114,21 @@ struct constructor_tester
 		k_type k18(k16,symbol_set({symbol("a")}));
 		BOOST_CHECK(k16 == k18);
 		BOOST_CHECK_THROW((k_type(k16,symbol_set({}))),std::invalid_argument);
+		// Converting constructor from other integer types.
+		typedef kronecker_monomial<long long> k_type_ll;
+		typedef kronecker_monomial<signed char> k_type_sc;
+		const symbol_set s2({symbol("a"),symbol("b")});
+		k_type_ll k19(k15,s2);
+		auto v_ll = k19.unpack(s2);
+		BOOST_CHECK(v_ll.size() == 2u);
+		BOOST_CHECK(v_ll[0u] == 1);
+		BOOST_CHECK(v_ll[1u] == -2);
+		BOOST_CHECK(k_type(k19,s2) == k15);
+		k_type_sc k20(k15,s2);
+		BOOST_CHECK(k_type(k20,s2) == k15);
+		BOOST_CHECK_THROW((k_type_ll(k15,symbol_set{})),std::invalid_argument);
+		k_type_ll k21({100,1});
+		BOOST_CHECK_THROW((k_type_sc(k21,s2)),std::invalid_argument);
 	}
 };
 
@@ -25,19 +25,27 @@
 
 #include <boost/mpl/for_each.hpp>
 #include <boost/mpl/vector.hpp>
+#include <algorithm>
 #include <cstddef>
+#include <iterator>
 #include <limits>
+#include <map>
 #include <stdexcept>
 #include <tuple>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
+#include "../src/debug_access.hpp"
 #include "../src/environment.hpp"
 #include "../src/integer.hpp"
 #include "../src/math.hpp"
 #include "../src/kronecker_array.hpp"
 #include "../src/kronecker_monomial.hpp"
 #include "../src/rational.hpp"
+#include "../src/series_multiplier.hpp"
 #include "../src/settings.hpp"
+#include "../src/symbol_set.hpp"
 
 using namespace piranha;
 
@@ -131,6 +139,48 @@ BOOST_AUTO_TEST_CASE(kronecker_polynomial_overflow_test)
 	boost::mpl::for_each<cf_types>(overflow_tester());
 }
 
+// Conversion between polynomials with Kronecker codes of different widths.
+struct width_conversion_tester
+{
+	template <typename Cf>
+	void operator()(const Cf &)
+	{
+		typedef polynomial<Cf,kronecker_monomial<std::int_least32_t>> p_type32;
+		typedef polynomial<Cf,kronecker_monomial<std::int_least64_t>> p_type64;
+		p_type32 x{"x"}, y{"y"}, z{"z"}, t{"t"}, u{"u"};
+		auto prod = x * y * z * t * u;
+		auto tmp_t(t);
+		auto l = std::get<0u>(kronecker_array<std::int_least32_t>::get_limits()[5u])[0u] / 2;
+		for (decltype(l) i = 1; i < l; ++i) {
+			prod *= t;
+			tmp_t *= t;
+		}
+		tmp_t *= tmp_t;
+		BOOST_CHECK_THROW((prod + tmp_t) * prod,std::overflow_error);
+		// The product can be computed after widening the keys.
+		const p_type64 prod64(prod), f64(prod + tmp_t);
+		BOOST_CHECK(prod64.get_symbol_set() == prod.get_symbol_set());
+		BOOST_CHECK_EQUAL(prod64.size(),prod.size());
+		BOOST_CHECK(p_type32(prod64) == prod);
+		const auto res64 = f64 * prod64;
+		BOOST_CHECK_EQUAL(res64.size(),2u);
+		p_type64 x64{"x"}, y64{"y"}, z64{"z"}, t64{"t"}, u64{"u"};
+		BOOST_CHECK(res64 == (x64 * y64 * z64 * u64).pow(2) * t64.pow(2 * l) + x64 * y64 * z64 * u64 * t64.pow(3 * l));
+		// The result does not fit in the narrow keys.
+		BOOST_CHECK_THROW(p_type32{res64},std::invalid_argument);
+		// Narrowing of a small polynomial.
+		typedef polynomial<Cf,kronecker_monomial<signed char>> p_type8;
+		const auto g = (x + y + 1).pow(2);
+		BOOST_CHECK(p_type32(p_type8(g)) == g);
+		BOOST_CHECK_THROW(p_type8{prod},std::invalid_argument);
+	}
+};
+
+BOOST_AUTO_TEST_CASE(kronecker_polynomial_width_conversion_test)
+{
+	boost::mpl::for_each<cf_types>(width_conversion_tester());
+}
+
 struct st_vs_mt_tester
 {
 	void operator()()
@@ -206,3 +256,362 @@ BOOST_AUTO_TEST_CASE(kronecker_polynomial_sparse_cancellation_mt_test)
 	auto retval = f * h;
 	BOOST_CHECK_EQUAL(retval.size(),5786u);
 }
+
+// Test multi-threaded multiplication with negative exponents and a number of threads
+// that does not divide evenly the output space.
+BOOST_AUTO_TEST_CASE(kronecker_polynomial_mt_ranges_test)
+{
+	settings::set_n_threads(1u);
+	typedef polynomial<integer,kronecker_monomial<>> p_type;
+	p_type x("x"), y("y"), z("z"), t("t");
+	auto f = 1 + x + y + z + t, g = x.pow(-1) + y - z.pow(-1) + t + 1;
+	auto h = g.pow(13);
+	f = f.pow(12);
+	g = g.pow(8);
+	const auto st_sparse = f * g, st_dense = h * h;
+	for (unsigned i : {2u,3u,5u,8u}) {
+		settings::set_n_threads(i);
+		BOOST_CHECK(f * g == st_sparse);
+		BOOST_CHECK(g * f == st_sparse);
+		BOOST_CHECK(h * h == st_dense);
+	}
+	settings::reset_n_threads();
+}
+
+// Squaring, compared against the multiplication by an equal but distinct series.
+BOOST_AUTO_TEST_CASE(kronecker_polynomial_square_test)
+{
+	typedef polynomial<integer,kronecker_monomial<>> p_type;
+	p_type x("x"), y("y"), z("z"), t("t");
+	// Dense and sparse operands, with negative exponents.
+	const auto dense = (x.pow(-1) + y - z.pow(-1) + t + 1).pow(13),
+		sparse = (1 + x + y * y + z * z * z + t.pow(5)).pow(9) - 3 * x.pow(-2) * t;
+	for (const auto &f: {dense,sparse}) {
+		const auto f_copy(f);
+		for (unsigned i : {1u,2u,3u,5u,8u}) {
+			settings::set_n_threads(i);
+			const auto retval = f * f_copy;
+			BOOST_CHECK(f * f == retval);
+			BOOST_CHECK(f.square() == retval);
+		}
+	}
+	settings::reset_n_threads();
+}
+
+// Dense multiplication of integer polynomials with coefficients of increasing size, so that the accumulation
+// is performed in 64-bit and 128-bit integers, and with the multi-modular algorithm. Checked against rational coefficients.
+BOOST_AUTO_TEST_CASE(kronecker_polynomial_fixed_width_dense_test)
+{
+	typedef polynomial<integer,kronecker_monomial<>> p_type;
+	typedef polynomial<rational,kronecker_monomial<>> q_type;
+	p_type x("x"), f, g;
+	for (int i = -500; i < 500; ++i) {
+		f += (i % 7 - 3) * x.pow(i);
+		g += (i % 11 + 5) * x.pow(i + 100);
+	}
+	for (const auto &c: {integer(1),integer(-1),integer(2).pow(40),-integer(2).pow(60),integer(2).pow(100),
+		-integer(3).pow(300)})
+	{
+		const auto f_c = f * c, g_c = g * c;
+		const q_type q_f_c(f_c), q_g_c(g_c);
+		const auto r_mult = q_f_c * q_g_c, r_square = q_f_c * q_type(f_c);
+		// NOTE: the dense algorithm is not selected automatically when the multi-modular algorithm is needed.
+		for (auto s: {multiplication_strategy::automatic,multiplication_strategy::dense}) {
+			settings::set_multiplication_strategy(s);
+			for (unsigned i : {1u,2u,3u,8u}) {
+				settings::set_n_threads(i);
+				BOOST_CHECK(q_type(f_c * g_c) == r_mult);
+				BOOST_CHECK(q_type(g_c * f_c) == r_mult);
+				BOOST_CHECK(q_type(f_c * f_c) == r_square);
+				// Operands with coefficients of very different sizes: the bound fits in 128 bits, but the
+				// coefficients of one operand do not fit in 64 bits.
+				BOOST_CHECK(q_type(f_c * g) == q_f_c * q_type(g));
+				BOOST_CHECK(q_type(g * f_c) == q_f_c * q_type(g));
+			}
+		}
+	}
+	settings::reset_multiplication_strategy();
+	settings::reset_n_threads();
+}
+
+BOOST_AUTO_TEST_CASE(kronecker_polynomial_dense_windows_test)
+{
+	// Sparse operands whose products span several windows of the dense multiplication.
+	typedef polynomial<rational,kronecker_monomial<>> p_type;
+	p_type x("x"), f, g;
+	std::map<int,rational> r_map;
+	for (int i = 0; i < 600; ++i) {
+		for (int j = 0; j < 600; ++j) {
+			r_map[50 * i + 49 * j] += rational(i % 7 - 3,i % 5 + 1) * (j % 11 + 5);
+		}
+	}
+	for (int i = 0; i < 600; ++i) {
+		f += rational(i % 7 - 3,i % 5 + 1) * x.pow(50 * i);
+		g += (i % 11 + 5) * x.pow(49 * i);
+	}
+	p_type r;
+	for (const auto &p: r_map) {
+		r += p.second * x.pow(p.first);
+	}
+	for (unsigned i : {1u,2u,3u,8u}) {
+		settings::set_n_threads(i);
+		BOOST_CHECK(f * g == r);
+		BOOST_CHECK(g * f == r);
+	}
+	settings::reset_n_threads();
+}
+
+BOOST_AUTO_TEST_CASE(kronecker_polynomial_floating_point_dense_test)
+{
+	// Dense products with floating-point coefficients, checked against integer coefficients. All the coefficients
+	// are exactly representable.
+	typedef polynomial<integer,kronecker_monomial<>> p_type;
+	typedef polynomial<double,kronecker_monomial<>> d_type;
+	typedef polynomial<float,kronecker_monomial<>> f_type;
+	p_type x("x"), y("y"), z("z"), t("t");
+	const auto f = (x + y - 2 * z + 3 * t + 1).pow(8), g = (x - y + z + t - 2).pow(8) + 1;
+	const auto r_mult = f * g, r_square = f * f;
+	const auto f_small = (x - y + 2 * z + 1).pow(4), g_small = (x + y + z - 1).pow(3);
+	const auto r_small = f_small * g_small;
+	for (unsigned i : {1u,2u,3u,8u}) {
+		settings::set_n_threads(i);
+		BOOST_CHECK(p_type(d_type(f) * d_type(g)) == r_mult);
+		BOOST_CHECK(p_type(d_type(g) * d_type(f)) == r_mult);
+		BOOST_CHECK(p_type(d_type(f) * d_type(f)) == r_square);
+		BOOST_CHECK(p_type(f_type(f_small) * f_type(g_small)) == r_small);
+		BOOST_CHECK(p_type(f_type(g_small) * f_type(f_small)) == r_small);
+	}
+	settings::reset_n_threads();
+}
+
+struct multiplication_strategy_tester
+{
+	template <typename Cf>
+	void operator()(const Cf &)
+	{
+		typedef polynomial<Cf,kronecker_monomial<>> p_type;
+		p_type x("x"), y("y"), z("z"), t("t");
+		// Dense case, sparse case, cancellations and squaring.
+		const auto f = (x + y + z + t + 1).pow(6), g = f + 1, h = (x - y + z - t + 1).pow(6);
+		const auto f_s = (x + y.pow(7) - z.pow(31) + t.pow(101) + 1).pow(5), g_s = (x.pow(3) - y + z.pow(11) + 1).pow(5);
+		const std::vector<std::pair<p_type,p_type>> operands = {{f,g},{f,h},{h,f},{f,f},{f_s,g_s},{g_s,f_s},{f_s,f_s},{f,g_s},
+			{x,p_type{}},{x + 1,x - 1}};
+		std::vector<p_type> results;
+		for (const auto &p: operands) {
+			results.push_back(p.first * p.second);
+		}
+		for (auto s: {multiplication_strategy::automatic,multiplication_strategy::sparse,multiplication_strategy::dense,
+			multiplication_strategy::heap,multiplication_strategy::sort_reduce})
+		{
+			settings::set_multiplication_strategy(s);
+			for (unsigned n : {1u,2u,3u,8u}) {
+				settings::set_n_threads(n);
+				for (decltype(operands.size()) i = 0u; i < operands.size(); ++i) {
+					BOOST_CHECK(operands[i].first * operands[i].second == results[i]);
+				}
+			}
+		}
+		settings::reset_multiplication_strategy();
+		settings::reset_n_threads();
+		// Sorted output.
+		auto sorted_check = [](const std::vector<typename p_type::term_type> &v, const symbol_set &args) -> bool {
+			return std::is_sorted(v.begin(),v.end(),[&args](const typename p_type::term_type &t1, const typename p_type::term_type &t2) {
+				const auto v1 = t1.m_key.unpack(args), v2 = t2.m_key.unpack(args);
+				typedef std::reverse_iterator<decltype(v1.begin())> r_it;
+				return std::lexicographical_compare(r_it(v1.end()),r_it(v1.begin()),r_it(v2.end()),r_it(v2.begin()));
+			});
+		};
+		// NOTE: the multiplier needs operands with identical symbol sets, adding and removing the symbols
+		// extends the symbol set of an operand to {x,y,z,t}.
+		auto extend = [&x,&y,&z,&t](const p_type &p) {return p + x + y + z + t - x - y - z - t;};
+		for (auto s: {multiplication_strategy::automatic,multiplication_strategy::heap,multiplication_strategy::sort_reduce})
+		{
+			settings::set_multiplication_strategy(s);
+			for (unsigned n : {1u,2u,3u,8u}) {
+				settings::set_n_threads(n);
+				for (decltype(operands.size()) i = 0u; i < operands.size(); ++i) {
+					const auto op1 = extend(operands[i].first), op2 = extend(operands[i].second);
+					series_multiplier<p_type,p_type> m(op1,op2);
+					const auto v = m.execute_sorted();
+					BOOST_CHECK_EQUAL(v.size(),results[i].size());
+					// NOTE: this will preserve the symbol set.
+					auto tmp = op1;
+					tmp -= op1;
+					BOOST_CHECK(tmp.empty());
+					for (const auto &term: v) {
+						BOOST_CHECK(!term.is_ignorable(op1.get_symbol_set()));
+						tmp.insert(term);
+					}
+					BOOST_CHECK(tmp == results[i]);
+					BOOST_CHECK(sorted_check(v,op1.get_symbol_set()));
+				}
+			}
+		}
+		settings::reset_multiplication_strategy();
+		settings::reset_n_threads();
+	}
+};
+
+BOOST_AUTO_TEST_CASE(kronecker_polynomial_multiplication_strategy_test)
+{
+	boost::mpl::for_each<cf_types>(multiplication_strategy_tester());
+}
+
+// Sparse multiplication with an output table large enough for the prefetching of the destination buckets
+// to be active, checked against the heap-based multiplication.
+BOOST_AUTO_TEST_CASE(kronecker_polynomial_prefetch_test)
+{
+	typedef polynomial<integer,kronecker_monomial<>> p_type;
+	p_type x("x"), y("y"), f, g;
+	for (int i = 0; i < 1000; ++i) {
+		f += (i % 7 + 1) * x.pow((i * 37) % 1009) * y.pow((i * 101) % 997);
+		g += (i % 5 - 7) * x.pow((i * 53) % 1013) * y.pow((i * 17) % 991);
+	}
+	settings::set_multiplication_strategy(multiplication_strategy::heap);
+	const auto ref = f * g;
+	BOOST_CHECK(ref.size() > 524288u);
+	settings::set_multiplication_strategy(multiplication_strategy::sparse);
+	for (unsigned i : {1u,2u,3u}) {
+		settings::set_n_threads(i);
+		BOOST_CHECK(f * g == ref);
+		BOOST_CHECK(g * f == ref);
+	}
+	settings::reset_multiplication_strategy();
+	settings::reset_n_threads();
+}
+
+BOOST_AUTO_TEST_CASE(kronecker_polynomial_skinny_test)
+{
+	typedef polynomial<integer,kronecker_monomial<>> p_type;
+	typedef polynomial<double,kronecker_monomial<>> pd_type;
+	p_type x("x"), y("y"), z("z"), t("t");
+	// Big operand with a result of about the same size, and a sparse one with a much larger result.
+	const auto f = (x + y + z + t + 1).pow(12);
+	p_type g;
+	for (int i = 0; i < 3000; ++i) {
+		g += (i % 7 - 3) * x.pow((i * 37) % 1009) * y.pow((i * 101) % 997);
+	}
+	p_type h;
+	for (int i = 0; i < 64; ++i) {
+		h += (i % 3 + 1) * x.pow(i % 5) * y.pow(i * 13) * z.pow(i % 4);
+	}
+	// Telescoping cancellation.
+	p_type c1, c2 = x - 1;
+	for (int i = 0; i < 1000; ++i) {
+		c1 += x.pow(i);
+	}
+	const p_type skinny[] = {p_type{2}, -3 * x * y.pow(2), x * y - 2 * z + t.pow(3) * x - 1, (x + y - z + 2 * t).pow(3), h};
+	for (unsigned n : {1u,2u,3u}) {
+		settings::set_n_threads(n);
+		for (const auto &s: skinny) {
+			for (const auto &b: {f,g}) {
+				settings::set_multiplication_strategy(multiplication_strategy::sparse);
+				const auto ref = b * s;
+				settings::reset_multiplication_strategy();
+				BOOST_CHECK(b * s == ref);
+				BOOST_CHECK(s * b == ref);
+				BOOST_CHECK(pd_type(b) * pd_type(s) == pd_type(ref));
+			}
+		}
+		BOOST_CHECK(c1 * c2 == x.pow(1000) - 1);
+		BOOST_CHECK(c2 * c1 == x.pow(1000) - 1);
+		BOOST_CHECK(p_type{0} * f == 0);
+	}
+	settings::reset_n_threads();
+}
+
+struct key_metadata_tag {};
+
+namespace piranha
+{
+template <>
+class debug_access<key_metadata_tag>
+{
+	public:
+		template <typename Cf>
+		void operator()(const Cf &)
+		{
+			typedef polynomial<Cf,kronecker_monomial<std::int_least32_t>> p_type;
+			p_type x("x"), y("y"), z("z");
+			// Degree computed by scanning the terms.
+			auto scan = [](const p_type &p, bool low) -> std::int_least32_t {
+				std::int_least32_t retval = 0;
+				bool first = true;
+				for (const auto &t: p.m_container) {
+					const auto d = t.m_key.degree(p.m_symbol_set);
+					if (first || (low ? d < retval : d > retval)) {
+						retval = d;
+					}
+					first = false;
+				}
+				return retval;
+			};
+			// Metadata maintained by insertion.
+			p_type p;
+			BOOST_CHECK(p.cached_key_metadata() != nullptr);
+			BOOST_CHECK_EQUAL(p.degree(),0);
+			p = x * y.pow(3) + 2 * z - x.pow(5);
+			auto md = p.cached_key_metadata();
+			BOOST_CHECK(md != nullptr);
+			BOOST_CHECK(md->complete());
+			BOOST_CHECK(md->m_exact);
+			BOOST_CHECK((md->m_min == std::vector<std::int_least32_t>{0,0,0}));
+			BOOST_CHECK((md->m_max == std::vector<std::int_least32_t>{5,3,1}));
+			BOOST_CHECK_EQUAL(p.degree(),5);
+			BOOST_CHECK_EQUAL(p.ldegree(),1);
+			// Cancellation: the bounds become conservative, the degree stays exact.
+			p += x.pow(5);
+			md = p.cached_key_metadata();
+			BOOST_CHECK(md != nullptr);
+			BOOST_CHECK(!md->m_exact);
+			BOOST_CHECK((md->m_max == std::vector<std::int_least32_t>{5,3,1}));
+			BOOST_CHECK_EQUAL(p.degree(),4);
+			BOOST_CHECK_EQUAL(p.degree(),scan(p,false));
+			BOOST_CHECK_EQUAL(p.ldegree(),scan(p,true));
+			// Copies and moves preserve the metadata.
+			auto p2(p);
+			BOOST_CHECK(p2.cached_key_metadata() != nullptr);
+			BOOST_CHECK_EQUAL(p2.degree(),4);
+			auto p3(std::move(p2));
+			BOOST_CHECK(p3.cached_key_metadata() != nullptr);
+			BOOST_CHECK_EQUAL(p3.degree(),4);
+			// Other modifications invalidate it.
+			p3.m_container.clear();
+			BOOST_CHECK(p3.cached_key_metadata() == nullptr);
+			BOOST_CHECK_EQUAL(p3.degree(),0);
+			// Result of multiplication: bounds only.
+			const auto f = (x + y + z + 1).pow(4), g = f * (x - 1);
+			md = g.cached_key_metadata();
+			BOOST_CHECK(md != nullptr);
+			BOOST_CHECK(!md->complete());
+			BOOST_CHECK((md->m_min == std::vector<std::int_least32_t>{0,0,0}));
+			BOOST_CHECK((md->m_max == std::vector<std::int_least32_t>{5,4,4}));
+			BOOST_CHECK_EQUAL(g.degree(),scan(g,false));
+			BOOST_CHECK_EQUAL(g.ldegree(),scan(g,true));
+			auto g2(g);
+			BOOST_CHECK(g2.refresh_key_metadata() != nullptr);
+			BOOST_CHECK(g2.cached_key_metadata()->complete());
+			BOOST_CHECK_EQUAL(g2.degree(),5);
+			BOOST_CHECK_EQUAL(g2.ldegree(),0);
+			// Conservative bounds exceeding the Kronecker limits must not prevent the multiplication.
+			const auto l = std::get<0u>(kronecker_array<std::int_least32_t>::get_limits()[2u])[0u];
+			auto a = (x.pow(l / 2 + 1) + 1) * (y + 1);
+			a -= x.pow(l / 2 + 1) * (y + 1);
+			BOOST_CHECK(a.cached_key_metadata() != nullptr);
+			BOOST_CHECK(!a.cached_key_metadata()->m_exact);
+			BOOST_CHECK((a.cached_key_metadata()->m_max == std::vector<std::int_least32_t>{l / 2 + 1,1}));
+			BOOST_CHECK(a * a == (y + 1) * (y + 1));
+			// Exact bounds exceeding the limits still produce an error.
+			auto b = x.pow(l / 2 + 1) * y;
+			b.refresh_key_metadata();
+			BOOST_CHECK_THROW(b * b,std::overflow_error);
+		}
+};
+}
+
+typedef debug_access<key_metadata_tag> key_metadata_tester;
+
+BOOST_AUTO_TEST_CASE(kronecker_polynomial_key_metadata_test)
+{
+	boost::mpl::for_each<cf_types>(key_metadata_tester());
+}
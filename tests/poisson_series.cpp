@@ -26,20 +26,27 @@
 #include <boost/lexical_cast.hpp>
 #include <boost/mpl/for_each.hpp>
 #include <boost/mpl/vector.hpp>
+#include <cstddef>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <tuple>
 #include <type_traits>
 #include <unordered_map>
+#include <vector>
 
+#include "../src/debug_access.hpp"
 #include "../src/environment.hpp"
 #include "../src/integer.hpp"
+#include "../src/kronecker_array.hpp"
 #include "../src/math.hpp"
 #include "../src/poisson_series.hpp"
 #include "../src/polynomial.hpp"
 #include "../src/power_series.hpp"
 #include "../src/rational.hpp"
 #include "../src/real.hpp"
+#include "../src/series_multiplier.hpp"
+#include "../src/settings.hpp"
 #include "../src/type_traits.hpp"
 
 using namespace piranha;
@@ -556,3 +563,128 @@ BOOST_AUTO_TEST_CASE(poisson_series_is_evaluable_test)
 	BOOST_CHECK((!is_evaluable<poisson_series<polynomial<mock_cf,short>>,double>::value));
 	BOOST_CHECK((!is_evaluable<poisson_series<mock_cf>,double>::value));
 }
+
+BOOST_AUTO_TEST_CASE(poisson_series_multiplier_test)
+{
+	typedef poisson_series<polynomial<rational,short>> p_type;
+	using math::sin;
+	using math::cos;
+	p_type x{"x"}, y{"y"}, z{"z"};
+	settings::set_n_threads(1u);
+	// Terms with negative multipliers and all combinations of flavours.
+	auto f = (1 + cos(x) + x * sin(y - z) + y * cos(2 * x - 3 * z) - z * sin(z - x + y)).pow(5),
+		g = (2 - sin(x) + y * cos(3 * y - z) - x * sin(2 * z - x) + cos(x + y + z)).pow(5);
+	// Reference results from the non-specialised multiplier.
+	const p_type fg(series_multiplier<p_type,p_type,int>(f,g)()), ff(series_multiplier<p_type,p_type,int>(f,f)());
+	BOOST_CHECK(f * g == fg);
+	BOOST_CHECK(g * f == fg);
+	BOOST_CHECK(f * f == ff);
+	for (unsigned i : {2u,3u,4u,7u}) {
+		settings::set_n_threads(i);
+		BOOST_CHECK(f * g == fg);
+		BOOST_CHECK(g * f == fg);
+		BOOST_CHECK(f * f == ff);
+	}
+	settings::reset_n_threads();
+	// Squaring, checked against the multiplication by an equal but distinct series.
+	const p_type f_copy(f);
+	const p_type ff_copy(series_multiplier<p_type,p_type,int>(f,f_copy)());
+	BOOST_CHECK(ff == ff_copy);
+	typedef poisson_series<polynomial<integer,short>> pi_type;
+	const pi_type ix{"x"}, iy{"y"};
+	const auto h = (3 + 2 * cos(ix) - 5 * sin(iy - ix) + 7 * cos(2 * iy)).pow(4), h_copy(h);
+	for (unsigned i : {1u,2u,3u,4u,7u}) {
+		settings::set_n_threads(i);
+		BOOST_CHECK(f * f == ff_copy);
+		BOOST_CHECK(f.square() == ff_copy);
+		BOOST_CHECK(h * h == h * h_copy);
+	}
+	settings::reset_n_threads();
+	// Cancellations to zero and to sin(0).
+	BOOST_CHECK_EQUAL(sin(x) * cos(x) - sin(2 * x) / 2,0);
+	BOOST_CHECK_EQUAL(sin(x) * sin(x) + cos(x) * cos(x),1);
+	// Multipliers out of the bounds of the Kronecker codification.
+	const auto l = std::get<0u>(kronecker_array<std::make_signed<std::size_t>::type>::get_limits()[1u])[0u];
+	BOOST_CHECK_THROW(cos(l * x) * cos(l * x),std::invalid_argument);
+}
+
+// Multiplication with an output table large enough for the prefetching of the destination buckets to be active.
+BOOST_AUTO_TEST_CASE(poisson_series_prefetch_test)
+{
+	typedef poisson_series<polynomial<integer,short>> p_type;
+	using math::sin;
+	using math::cos;
+	p_type x{"x"}, y{"y"}, f, g;
+	for (int i = 0; i < 560; ++i) {
+		f += (i % 7 + 1) * cos((i * 37) % 1009 * x + (i * 101) % 997 * y);
+		g += (i % 5 - 7) * sin((i * 53) % 1013 * x - (i * 17) % 991 * y);
+	}
+	settings::set_n_threads(1u);
+	const auto fg = f * g;
+	BOOST_CHECK(fg.size() > 524288u);
+	BOOST_CHECK(g * f == fg);
+	settings::set_n_threads(3u);
+	BOOST_CHECK(f * g == fg);
+	settings::reset_n_threads();
+}
+
+struct key_metadata_tag {};
+
+namespace piranha
+{
+template <>
+class debug_access<key_metadata_tag>
+{
+	public:
+		void operator()() const
+		{
+			typedef poisson_series<polynomial<rational,short>> p_type;
+			typedef std::make_signed<std::size_t>::type int_type;
+			using math::sin;
+			using math::cos;
+			p_type x{"x"}, y{"y"};
+			auto f = cos(3 * x - y) + sin(x + 2 * y) - cos(x);
+			auto md = f.cached_key_metadata();
+			BOOST_CHECK(md != nullptr && md->complete());
+			BOOST_CHECK((md->m_min == std::vector<int_type>{1,-1}));
+			BOOST_CHECK((md->m_max == std::vector<int_type>{3,2}));
+			BOOST_CHECK_EQUAL(f.t_degree(),3);
+			BOOST_CHECK_EQUAL(f.t_ldegree(),1);
+			BOOST_CHECK_EQUAL(f.t_order(),4);
+			BOOST_CHECK_EQUAL(f.t_lorder(),1);
+			// Cancellation.
+			f -= sin(x + 2 * y);
+			BOOST_CHECK(f.cached_key_metadata() != nullptr);
+			BOOST_CHECK_EQUAL(f.t_degree(),2);
+			BOOST_CHECK_EQUAL(f.t_order(),4);
+			BOOST_CHECK_EQUAL(f.t_lorder(),1);
+			// Result of the multiplication: symmetric bounds.
+			const auto g = f * (cos(x + y) + sin(2 * x));
+			md = g.cached_key_metadata();
+			BOOST_CHECK(md != nullptr && !md->complete());
+			BOOST_CHECK((md->m_min == std::vector<int_type>{-5,-3}));
+			BOOST_CHECK((md->m_max == std::vector<int_type>{5,3}));
+			p_type g2(g);
+			g2.refresh_key_metadata();
+			BOOST_CHECK(g2.cached_key_metadata()->complete());
+			BOOST_CHECK_EQUAL(g2.t_degree(),g.t_degree());
+			BOOST_CHECK_EQUAL(g2.t_ldegree(),g.t_ldegree());
+			BOOST_CHECK_EQUAL(g2.t_order(),g.t_order());
+			BOOST_CHECK_EQUAL(g2.t_lorder(),g.t_lorder());
+			// Conservative bounds exceeding the Kronecker limits do not prevent the multiplication via codes.
+			const auto l = std::get<0u>(kronecker_array<int_type>::get_limits()[2u])[0u];
+			auto h = (cos(l * x) + cos(y)) * cos(y);
+			h -= cos(l * x) * cos(y);
+			BOOST_CHECK(h.cached_key_metadata() != nullptr && !h.cached_key_metadata()->m_exact);
+			BOOST_CHECK(h * h == (cos(y) * cos(y)) * (cos(y) * cos(y)));
+		}
+};
+}
+
+typedef debug_access<key_metadata_tag> key_metadata_tester;
+
+BOOST_AUTO_TEST_CASE(poisson_series_key_metadata_test)
+{
+	key_metadata_tester t;
+	t();
+}
@@ -34,6 +34,7 @@
 #include <tuple>
 #include <type_traits>
 #include <unordered_map>
+#include <vector>
 
 #include "../src/debug_access.hpp"
 #include "../src/environment.hpp"
@@ -524,6 +525,51 @@ BOOST_AUTO_TEST_CASE(polynomial_pow_test)
 	BOOST_CHECK((!is_exponentiable<p_type2,std::string>::value));
 }
 
+struct pow_strategy_tester
+{
+	template <typename Cf>
+	struct runner
+	{
+		template <typename Expo>
+		void operator()(const Expo &)
+		{
+			typedef polynomial<Cf,Expo> p_type;
+			p_type x{"x"}, y{"y"}, z{"z"};
+			// Bases with and without the structure required by the recurrence.
+			const std::vector<p_type> bases = {1 + x + y + z, 3 - 2 * x + y * z - x * x * z, x + y - 2 * z, 2 * x + y * y,
+				1 + x * y - y.pow(-1) + z, 1 + x - x * y.pow(-1)};
+			for (const auto &b: bases) {
+				for (unsigned n : {1u,2u,3u,5u,8u,11u}) {
+					if (std::is_same<Cf,double>::value && n > 8u) {
+						continue;
+					}
+					p_type ref(b);
+					for (unsigned i = 1u; i < n; ++i) {
+						ref *= b;
+					}
+					for (auto s: {pow_strategy::automatic,pow_strategy::linear,pow_strategy::binary,
+						pow_strategy::recurrence,pow_strategy::split})
+					{
+						settings::set_pow_strategy(s);
+						BOOST_CHECK_EQUAL(b.pow(n),ref);
+					}
+				}
+			}
+			settings::reset_pow_strategy();
+		}
+	};
+	template <typename Cf>
+	void operator()(const Cf &)
+	{
+		boost::mpl::for_each<expo_types>(runner<Cf>());
+	}
+};
+
+BOOST_AUTO_TEST_CASE(polynomial_pow_strategy_test)
+{
+	boost::mpl::for_each<cf_types>(pow_strategy_tester());
+}
+
 BOOST_AUTO_TEST_CASE(polynomial_partial_test)
 {
 	using math::partial;
@@ -135,6 +135,21 @@ struct constructor_tester
 		k16 = k_type{-1,0};
 		symbol_set tmp_ss{symbol("a"),symbol("b")};
 		BOOST_CHECK_THROW((k_type(k16,tmp_ss)),std::invalid_argument);
+		// Converting constructor from other integer types.
+		typedef real_trigonometric_kronecker_monomial<long long> k_type_ll;
+		typedef real_trigonometric_kronecker_monomial<signed char> k_type_sc;
+		k_type k19({1,-2});
+		k19.set_flavour(false);
+		k_type_ll k20(k19,tmp_ss);
+		auto v_ll = k20.unpack(tmp_ss);
+		BOOST_CHECK(v_ll.size() == 2u);
+		BOOST_CHECK(v_ll[0u] == 1);
+		BOOST_CHECK(v_ll[1u] == -2);
+		BOOST_CHECK(!k20.get_flavour());
+		BOOST_CHECK(k_type(k20,tmp_ss) == k19);
+		BOOST_CHECK(k_type(k_type_sc(k19,tmp_ss),tmp_ss) == k19);
+		BOOST_CHECK_THROW((k_type_ll(k16,tmp_ss)),std::invalid_argument);
+		BOOST_CHECK_THROW((k_type_sc(k_type_ll({100,1}),tmp_ss)),std::invalid_argument);
 	}
 };
 
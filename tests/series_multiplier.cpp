@@ -23,6 +23,7 @@
 #define BOOST_TEST_MODULE series_multiplier_test
 #include <boost/test/unit_test.hpp>
 
+#include <boost/any.hpp>
 #include <boost/mpl/for_each.hpp>
 #include <boost/mpl/vector.hpp>
 #include <limits>
@@ -202,3 +203,160 @@ BOOST_AUTO_TEST_CASE(series_multiplier_multiplication_test)
 {
 	boost::mpl::for_each<p_types>(multiplication_tester());
 }
+
+struct shared_output_tag {};
+
+namespace piranha
+{
+template <>
+struct debug_access<shared_output_tag>
+{
+	template <typename T>
+	void operator()(const T &)
+	{
+		if (std::is_same<typename T::term_type::cf_type,double>::value && (!std::numeric_limits<double>::is_iec559 ||
+			std::numeric_limits<double>::digits < 53))
+		{
+			return;
+		}
+		T x("x"), y("y"), z("z"), t("t");
+		// Series with many cancellations and a number of rows not divisible by the number of threads.
+		auto f = (x + y - z + 2 * t + 1), g = (x - y + z - 2 * t - 1);
+		auto tmp_f(f), tmp_g(g);
+		for (int i = 1; i < 9; ++i) {
+			f *= tmp_f;
+			g *= tmp_g;
+		}
+		f += x * x * x * y;
+		settings::set_n_threads(1u);
+		const auto retval = f * g;
+		for (auto i = 2u; i <= 8u; i += 3u) {
+			settings::set_n_threads(i);
+			auto tmp = f * g;
+			BOOST_CHECK_EQUAL(tmp.size(),retval.size());
+			BOOST_CHECK(tmp == retval);
+			// All the terms must be non-ignorable and the load factor must be within the limit.
+			for (auto it = tmp.m_container.begin(); it != tmp.m_container.end(); ++it) {
+				BOOST_CHECK(!it->is_ignorable(tmp.m_symbol_set));
+			}
+			BOOST_CHECK(tmp.m_container.load_factor() <= tmp.m_container.max_load_factor());
+		}
+		settings::reset_n_threads();
+	}
+};
+}
+
+typedef debug_access<shared_output_tag> shared_output_tester;
+
+BOOST_AUTO_TEST_CASE(series_multiplier_shared_output_test)
+{
+	boost::mpl::for_each<p_types>(shared_output_tester());
+}
+
+struct square_tag {};
+
+namespace piranha
+{
+template <>
+struct debug_access<square_tag>
+{
+	template <typename T>
+	void operator()(const T &)
+	{
+		if (std::is_same<typename T::term_type::cf_type,double>::value && (!std::numeric_limits<double>::is_iec559 ||
+			std::numeric_limits<double>::digits < 53))
+		{
+			return;
+		}
+		T x("x"), y("y"), z("z"), t("t");
+		auto f = (x + y - 2 * z + 3 * t - 1), tmp_f(f);
+		for (int i = 1; i < 7; ++i) {
+			f *= tmp_f;
+		}
+		f += x * x * x * y;
+		// A copy of f is a different object, hence it is multiplied via the non-squaring path.
+		const auto f_copy(f);
+		for (auto i = 1u; i <= 8u; i += 3u) {
+			settings::set_n_threads(i);
+			const auto retval = f * f_copy;
+			auto tmp = f * f;
+			BOOST_CHECK_EQUAL(tmp.size(),retval.size());
+			BOOST_CHECK(tmp == retval);
+			BOOST_CHECK(f.square() == retval);
+			for (auto it = tmp.m_container.begin(); it != tmp.m_container.end(); ++it) {
+				BOOST_CHECK(!it->is_ignorable(tmp.m_symbol_set));
+			}
+			// The series multiplied by itself with cancellations to zero.
+			auto g = x - x;
+			BOOST_CHECK(g * g == 0);
+		}
+		settings::reset_n_threads();
+	}
+};
+}
+
+typedef debug_access<square_tag> square_tester;
+
+BOOST_AUTO_TEST_CASE(series_multiplier_square_test)
+{
+	boost::mpl::for_each<p_types>(square_tester());
+}
+
+struct estimate_tag {};
+
+namespace piranha
+{
+template <>
+struct debug_access<estimate_tag>
+{
+	template <typename T>
+	struct multiplier: series_multiplier<T,T>
+	{
+		typedef series_multiplier<T,T> base;
+		using base::base;
+		using base::estimate_final_series_size;
+		typedef typename base::default_functor functor;
+		std::size_t estimate(unsigned n_threads) const
+		{
+			T retval;
+			retval.m_symbol_set = this->m_s1->m_symbol_set;
+			return this->estimate_final_series_size(functor(&this->m_v1[0u],this->m_v1.size(),&this->m_v2[0u],this->m_v2.size(),retval),
+				n_threads);
+		}
+	};
+	template <typename T>
+	void operator()(const T &)
+	{
+		T x("x"), y("y"), z("z"), t("t");
+		// Small multiplication: all the term-by-term multiplications are sampled, the estimate is exact.
+		auto f = (x + y + z + 1).pow(3);
+		BOOST_CHECK_EQUAL(multiplier<T>(f,f).estimate(1u),84u);
+		// Larger multiplication: the estimate is extrapolated from a sample, and it does not depend
+		// on the number of threads.
+		auto g = (x + y + z + t + 1).pow(10), h = g + 1;
+		const auto real = (g * h).size();
+		const auto est = multiplier<T>(g,h).estimate(1u);
+		BOOST_CHECK(est >= real / 2u && est <= real * 4u);
+		for (auto i = 2u; i <= 4u; ++i) {
+			BOOST_CHECK_EQUAL(multiplier<T>(g,h).estimate(i),est);
+		}
+		// The outcome is reported to the tracing framework.
+		tracing::reset();
+		settings::set_n_threads(2u);
+		BOOST_CHECK_EQUAL((g * h).size(),real);
+		settings::reset_n_threads();
+		BOOST_CHECK(boost::any_cast<unsigned long long>(tracing::get("number_of_estimates")) == 1u);
+		BOOST_CHECK(boost::any_cast<unsigned long long>(tracing::get("number_of_correct_estimates")) <= 1u);
+		BOOST_CHECK(boost::any_cast<double>(tracing::get("accumulated_estimate_ratio")) > 0.);
+	}
+};
+}
+
+typedef debug_access<estimate_tag> estimate_tester;
+
+BOOST_AUTO_TEST_CASE(series_multiplier_estimate_test)
+{
+	settings::set_tracing(true);
+	boost::mpl::for_each<p_types>(estimate_tester());
+	settings::set_tracing(false);
+}
@@ -66,3 +66,21 @@ BOOST_AUTO_TEST_CASE(settings_max_term_output)
 	settings::reset_max_term_output();
 	BOOST_CHECK_EQUAL(20u,settings::get_max_term_output());
 }
+
+BOOST_AUTO_TEST_CASE(settings_pow_strategy)
+{
+	BOOST_CHECK(settings::get_pow_strategy() == pow_strategy::automatic);
+	settings::set_pow_strategy(pow_strategy::binary);
+	BOOST_CHECK(settings::get_pow_strategy() == pow_strategy::binary);
+	settings::reset_pow_strategy();
+	BOOST_CHECK(settings::get_pow_strategy() == pow_strategy::automatic);
+}
+
+BOOST_AUTO_TEST_CASE(settings_multiplication_strategy)
+{
+	BOOST_CHECK(settings::get_multiplication_strategy() == multiplication_strategy::automatic);
+	settings::set_multiplication_strategy(multiplication_strategy::heap);
+	BOOST_CHECK(settings::get_multiplication_strategy() == multiplication_strategy::heap);
+	settings::reset_multiplication_strategy();
+	BOOST_CHECK(settings::get_multiplication_strategy() == multiplication_strategy::automatic);
+}
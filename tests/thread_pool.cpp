@@ -24,9 +24,13 @@
 #include <boost/test/unit_test.hpp>
 
 #include <algorithm>
+#include <atomic>
 #include <boost/integer_traits.hpp>
 #include <chrono>
+#include <functional>
+#include <future>
 #include <list>
+#include <memory>
 #include <stdexcept>
 #include <thread>
 #include <utility>
@@ -49,89 +53,219 @@ struct noncopyable
 	noncopyable &operator=(noncopyable &&) = delete;
 };
 
-BOOST_AUTO_TEST_CASE(thread_pool_task_queue_test)
+template <typename F, typename ... Args>
+static auto pinned_push(detail::worker_pool &wp, unsigned n, F &&f, Args && ... args) -> decltype(f(args...),std::future<decltype(f(args...))>())
+{
+	std::unique_ptr<detail::worker_pool::task_type> task;
+	auto retval = detail::worker_pool::package(task,std::forward<F>(f),std::forward<Args>(args)...);
+	wp.push_pinned(n,std::move(task));
+	return retval;
+}
+
+template <typename F, typename ... Args>
+static auto any_push(detail::worker_pool &wp, F &&f, Args && ... args) -> decltype(f(args...),std::future<decltype(f(args...))>())
+{
+	std::unique_ptr<detail::worker_pool::task_type> task;
+	auto retval = detail::worker_pool::package(task,std::forward<F>(f),std::forward<Args>(args)...);
+	wp.push_any(std::move(task));
+	return retval;
+}
+
+BOOST_AUTO_TEST_CASE(thread_pool_work_stealing_deque_test)
 {
 	environment env;
+	// Single-thread semantics.
+	{
+	detail::work_stealing_deque<int> d(2);
+	BOOST_CHECK(d.empty());
+	BOOST_CHECK(d.pop() == nullptr);
+	BOOST_CHECK(d.steal() == nullptr);
+	std::vector<int> v(100);
+	for (auto &n: v) {
+		d.push(&n);
+	}
+	BOOST_CHECK(!d.empty());
+	// Owner pops from the bottom, thieves steal from the top.
+	BOOST_CHECK(d.pop() == &v.back());
+	BOOST_CHECK(d.steal() == &v.front());
+	BOOST_CHECK(d.steal() == &v[1u]);
+	for (std::size_t i = 0u; i < 97u; ++i) {
+		BOOST_CHECK(d.pop() == &v[98u - i]);
+	}
+	BOOST_CHECK(d.empty());
+	BOOST_CHECK(d.pop() == nullptr);
+	BOOST_CHECK(d.steal() == nullptr);
+	}
+	// Concurrent stealing: every element must be consumed exactly once.
+	{
+	detail::work_stealing_deque<int> d(4);
+	const int n_elements = 100000;
+	std::vector<int> v(static_cast<std::vector<int>::size_type>(n_elements));
+	std::vector<std::atomic<int>> counters(v.size());
+	for (auto &c: counters) {
+		c.store(0);
+	}
+	std::atomic<bool> done(false);
+	auto thief = [&]() {
+		while (true) {
+			const bool stop = done.load();
+			int *ptr = d.steal();
+			if (ptr) {
+				++counters[static_cast<std::vector<int>::size_type>(ptr - &v[0u])];
+			} else if (stop && d.empty()) {
+				break;
+			}
+		}
+	};
+	std::vector<std::thread> thieves;
+	for (int i = 0; i < 3; ++i) {
+		thieves.emplace_back(thief);
+	}
+	for (int i = 0; i < n_elements; ++i) {
+		d.push(&v[static_cast<std::vector<int>::size_type>(i)]);
+		if (i % 3 == 0) {
+			int *ptr = d.pop();
+			if (ptr) {
+				++counters[static_cast<std::vector<int>::size_type>(ptr - &v[0u])];
+			}
+		}
+	}
+	done.store(true);
+	for (auto &t: thieves) {
+		t.join();
+	}
+	BOOST_CHECK(std::all_of(counters.begin(),counters.end(),[](const std::atomic<int> &c) {return c.load() == 1;}));
+	}
+}
+
+BOOST_AUTO_TEST_CASE(thread_pool_worker_pool_test)
+{
 	auto slow_task = [](){std::this_thread::sleep_for(std::chrono::milliseconds(250));};
 	auto fast_task = [](int n) -> int {std::this_thread::sleep_for(std::chrono::milliseconds(1)); return n;};
 	auto instant_task = [](){};
+	BOOST_CHECK_THROW(detail::worker_pool{0u},std::invalid_argument);
 	{
-	detail::task_queue tq;
+	detail::worker_pool wp(1u);
 	}
 	{
-	detail::task_queue tq;
-	tq.stop();
-	tq.stop();
-	tq.stop();
+	detail::worker_pool wp(3u);
+	wp.stop();
+	wp.stop();
+	wp.stop();
 	}
 	{
-	detail::task_queue tq;
-	tq.enqueue([](){});
-	tq.stop();
-	tq.stop();
+	detail::worker_pool wp(1u);
+	pinned_push(wp,0u,[](){});
+	any_push(wp,[](){});
+	wp.stop();
+	wp.stop();
 	}
 	{
-	detail::task_queue tq;
-	tq.enqueue(slow_task);
-	tq.stop();
-	tq.stop();
+	detail::worker_pool wp(2u);
+	pinned_push(wp,0u,slow_task);
+	any_push(wp,slow_task);
+	wp.stop();
+	wp.stop();
 	}
 	{
-	detail::task_queue tq;
-	tq.enqueue(slow_task);
-	tq.enqueue(slow_task);
-	tq.enqueue(slow_task);
+	detail::worker_pool wp(2u);
+	pinned_push(wp,0u,slow_task);
+	pinned_push(wp,1u,slow_task);
+	any_push(wp,slow_task);
 	}
 	{
-	detail::task_queue tq;
-	auto f1 = tq.enqueue(slow_task);
-	auto f2 = tq.enqueue(slow_task);
-	auto f3 = tq.enqueue(slow_task);
+	detail::worker_pool wp(2u);
+	auto f1 = pinned_push(wp,0u,slow_task);
+	auto f2 = any_push(wp,slow_task);
+	auto f3 = any_push(wp,slow_task);
 	f3.get();
 	}
 	{
-	detail::task_queue tq;
-	auto f1 = tq.enqueue([](int) {throw std::runtime_error("");},1);
+	detail::worker_pool wp(2u);
+	auto f1 = pinned_push(wp,1u,[](int) {throw std::runtime_error("");},1);
 	BOOST_CHECK_THROW(f1.get(),std::runtime_error);
+	auto f2 = any_push(wp,[](int) {throw std::runtime_error("");},1);
+	BOOST_CHECK_THROW(f2.get(),std::runtime_error);
 	}
 	{
-	detail::task_queue tq;
-	auto f1 = tq.enqueue([](int n) {return n + n;},45);
+	detail::worker_pool wp(2u);
+	auto f1 = pinned_push(wp,0u,[](int n) {return n + n;},45);
 	BOOST_CHECK(f1.get() == 90);
+	auto f2 = any_push(wp,[](int n) {return n + n;},46);
+	BOOST_CHECK(f2.get() == 92);
 	}
 	{
-	detail::task_queue tq;
-	using f_type = decltype(tq.enqueue(fast_task,0));
+	detail::worker_pool wp(4u);
+	using f_type = decltype(any_push(wp,fast_task,0));
 	std::list<f_type> l;
 	for (int i = 0; i < 100; ++i) {
-		l.push_back(tq.enqueue(fast_task,i));
+		l.push_back(any_push(wp,fast_task,i));
+		l.push_back(pinned_push(wp,static_cast<unsigned>(i) % 4u,fast_task,i));
 	}
-	tq.stop();
+	wp.stop();
 	int result = 0;
 	for (f_type &f: l) {
 		result += f.get();
 	}
-	BOOST_CHECK(result == 4950);
+	BOOST_CHECK(result == 9900);
 	}
 	{
-	detail::task_queue tq;
+	detail::worker_pool wp(3u);
 	for (int i = 0; i < 10000; ++i) {
-		tq.enqueue(instant_task);
+		any_push(wp,instant_task);
+		pinned_push(wp,2u,instant_task);
 	}
-	tq.stop();
-	BOOST_CHECK_THROW(tq.enqueue(instant_task),std::runtime_error);
+	wp.stop();
+	BOOST_CHECK_THROW(any_push(wp,instant_task),std::runtime_error);
+	BOOST_CHECK_THROW(pinned_push(wp,0u,instant_task),std::runtime_error);
 	}
 	{
-	detail::task_queue tq;
+	detail::worker_pool wp(2u);
 	noncopyable nc;
-	tq.enqueue([](noncopyable &){},std::ref(nc));
-	tq.enqueue([](const noncopyable &){},std::cref(nc));
+	any_push(wp,[](noncopyable &){},std::ref(nc));
+	pinned_push(wp,1u,[](const noncopyable &){},std::cref(nc));
+	}
+	{
+	detail::worker_pool wp(2u);
+	for (int i = 0; i < 100; ++i) {
+		any_push(wp,[](){real{}.pi();});
+	}
 	}
 	{
-	detail::task_queue tq;
+	// Pinned tasks are always consumed by their thread, while a busy thread
+	// gets its shared tasks stolen.
+	detail::worker_pool wp(2u);
+	std::atomic<bool> flag(false);
+	auto blocker = pinned_push(wp,0u,[&flag](){
+		while (!flag.load()) {
+			std::this_thread::yield();
+		}
+	});
+	std::vector<std::future<void>> fl;
 	for (int i = 0; i < 100; ++i) {
-		tq.enqueue([](){real{}.pi();});
+		fl.push_back(any_push(wp,instant_task));
+	}
+	for (auto &f: fl) {
+		f.get();
 	}
+	flag.store(true);
+	blocker.get();
+	}
+	{
+	// Tasks pushing new tasks from inside the pool, also while the pool is being stopped.
+	detail::worker_pool wp(3u);
+	std::atomic<int> counter(0);
+	std::function<void(int)> spawner;
+	spawner = [&wp,&counter,&spawner](int depth) {
+		++counter;
+		if (depth) {
+			any_push(wp,spawner,depth - 1);
+			any_push(wp,spawner,depth - 1);
+		}
+	};
+	any_push(wp,spawner,10);
+	wp.stop();
+	BOOST_CHECK_EQUAL(counter.load(),2047);
 	}
 #if !defined(__APPLE_CC__)
 	// Check the binding.
@@ -142,13 +276,13 @@ BOOST_AUTO_TEST_CASE(thread_pool_task_queue_test)
 			throw std::runtime_error("");
 		}
 	};
-	for (unsigned i = 0u; i < hc; ++i) {
-		detail::task_queue tq(i);
-		BOOST_CHECK_NO_THROW(tq.enqueue(bind_checker,i).get());
-	}
 	if (hc != 0) {
-		detail::task_queue tq(hc);
-		BOOST_CHECK_THROW(tq.enqueue(bind_checker,hc).get(),std::runtime_error);
+		detail::worker_pool wp(hc);
+		for (unsigned i = 0u; i < hc; ++i) {
+			BOOST_CHECK_NO_THROW(pinned_push(wp,i,bind_checker,i).get());
+		}
+		detail::worker_pool wp2(hc + 1u);
+		BOOST_CHECK_THROW(pinned_push(wp2,hc,bind_checker,hc).get(),std::runtime_error);
 	}
 #endif
 }
@@ -251,3 +385,93 @@ BOOST_AUTO_TEST_CASE(thread_pool_future_list_test)
 	f4.get_all();
 	f4.get_all();
 }
+
+BOOST_AUTO_TEST_CASE(thread_pool_enqueue_any_test)
+{
+	thread_pool::resize(4u);
+	BOOST_CHECK(thread_pool::enqueue_any(adder,1,2).get() == 3);
+	BOOST_CHECK_THROW(thread_pool::enqueue_any([](){throw std::runtime_error("");}).get(),std::runtime_error);
+	future_list<decltype(thread_pool::enqueue_any(adder,1,2))> f_list;
+	for (int i = 0; i < 1000; ++i) {
+		f_list.push_back(thread_pool::enqueue_any(adder,i,i));
+	}
+	f_list.get_all();
+	// Nested submission from inside the pool.
+	auto nested = [](int n) {
+		return thread_pool::enqueue_any(adder,n,1).get();
+	};
+	BOOST_CHECK(thread_pool::enqueue_any(nested,41).get() == 42);
+	// Mixed with pinned tasks and resizes.
+	std::vector<std::future<int>> v;
+	for (int i = 0; i < 100; ++i) {
+		v.push_back(thread_pool::enqueue_any(adder,i,1));
+		v.push_back(thread_pool::enqueue(static_cast<unsigned>(i) % 4u,adder,i,1));
+	}
+	thread_pool::resize(2u);
+	int res = 0;
+	for (auto &f: v) {
+		res += f.get();
+	}
+	BOOST_CHECK_EQUAL(res,10100);
+	BOOST_CHECK(thread_pool::enqueue_any(adder,1,2).get() == 3);
+}
+
+BOOST_AUTO_TEST_CASE(thread_pool_task_group_test)
+{
+	thread_pool::resize(4u);
+	{
+	task_group tg;
+	tg.wait();
+	tg.wait();
+	}
+	{
+	std::atomic<int> counter(0);
+	task_group tg;
+	for (int i = 0; i < 1000; ++i) {
+		tg.run([&counter](int n) {counter += n;},i);
+	}
+	tg.wait();
+	BOOST_CHECK_EQUAL(counter.load(),499500);
+	}
+	{
+	// Destructor waits.
+	std::atomic<int> counter(0);
+	{
+	task_group tg;
+	for (int i = 0; i < 100; ++i) {
+		tg.run([&counter]() {std::this_thread::sleep_for(std::chrono::milliseconds(1));++counter;});
+	}
+	}
+	BOOST_CHECK_EQUAL(counter.load(),100);
+	}
+	{
+	// Exceptions.
+	task_group tg;
+	for (int i = 0; i < 100; ++i) {
+		tg.run([](int n) {if (n % 10 == 0) {throw std::runtime_error("");}},i);
+	}
+	BOOST_CHECK_THROW(tg.wait(),std::runtime_error);
+	BOOST_CHECK_NO_THROW(tg.wait());
+	tg.run([](){});
+	BOOST_CHECK_NO_THROW(tg.wait());
+	}
+	{
+	// Recursive fork/join, deeper than the number of threads.
+	std::function<long(long)> fib;
+	fib = [&fib](long n) -> long {
+		if (n < 2) {
+			return n;
+		}
+		long a = 0, b = 0;
+		task_group tg;
+		tg.run([&a,&fib,n]() {a = fib(n - 1);});
+		tg.run([&b,&fib,n]() {b = fib(n - 2);});
+		tg.wait();
+		return a + b;
+	};
+	BOOST_CHECK_EQUAL(fib(18),2584);
+	BOOST_CHECK_EQUAL(thread_pool::enqueue_any(fib,15).get(),610);
+	thread_pool::resize(1u);
+	BOOST_CHECK_EQUAL(thread_pool::enqueue_any(fib,12).get(),144);
+	}
+}